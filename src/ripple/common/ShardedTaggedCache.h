@@ -0,0 +1,365 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_SHARDEDTAGGEDCACHE_H_INCLUDED
+#define RIPPLE_SHARDEDTAGGEDCACHE_H_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "beast/beast/make_unique.h"
+
+#include "TaggedCache.h"
+
+namespace ripple {
+
+/** A TaggedCache split into independently locked partitions.
+
+    Keys are assigned to a partition using bits of their hash, and each
+    partition is a complete TaggedCache with its own mutex. Readers on
+    different partitions never contend, and a sweep locks only one
+    partition at a time so the remaining partitions stay available.
+
+    The strong/weak semantics are identical to TaggedCache. The target
+    size is divided evenly among the partitions.
+
+    Unlike TaggedCache there is no single mutex to expose, so callers
+    which need to perform compound operations atomically must continue
+    to use TaggedCache.
+*/
+template <
+    class Key,
+    class T,
+    class Hash = std::hash <Key>,
+    class KeyEqual = std::equal_to <Key>,
+    class Mutex = std::mutex
+>
+class ShardedTaggedCache
+{
+public:
+    typedef TaggedCache <Key, T, Hash, KeyEqual, Mutex> partition_type;
+    typedef Key key_type;
+    typedef T mapped_type;
+    typedef typename partition_type::weak_mapped_ptr weak_mapped_ptr;
+    typedef typename partition_type::mapped_ptr mapped_ptr;
+    typedef typename partition_type::clock_type clock_type;
+    typedef typename partition_type::expire_handler expire_handler;
+
+    enum
+    {
+        defaultPartitions = 16
+    };
+
+    ShardedTaggedCache (std::string const& name, int size,
+        typename clock_type::rep expiration_seconds, clock_type& clock,
+            Journal journal, insight::Collector::ptr const& collector =
+                insight::NullCollector::New (),
+                    std::size_t partitions = defaultPartitions)
+        : m_journal (journal)
+        , m_clock (clock)
+        , m_stats (name,
+            std::bind (&ShardedTaggedCache::collect_metrics, this),
+                collector)
+        , m_name (name)
+        , m_target_size (size)
+    {
+        bassert (partitions > 0);
+
+        m_partitions.reserve (partitions);
+
+        for (std::size_t i = 0; i < partitions; ++i)
+            m_partitions.push_back (std::make_unique <partition_type> (
+                name, partitionSize (size, partitions), expiration_seconds,
+                    clock, journal));
+    }
+
+    /** Return the clock associated with the cache. */
+    clock_type& clock ()
+    {
+        return m_clock;
+    }
+
+    /** Return the number of independently locked partitions. */
+    std::size_t partitions () const
+    {
+        return m_partitions.size ();
+    }
+
+    int getTargetSize () const
+    {
+        return m_target_size;
+    }
+
+    void setTargetSize (int s)
+    {
+        m_target_size = s;
+
+        for (auto& partition : m_partitions)
+            partition->setTargetSize (partitionSize (s, m_partitions.size ()));
+
+        if (m_journal.debug) m_journal.debug <<
+            m_name << " target size set to " << s;
+    }
+
+    typename clock_type::rep getTargetAge () const
+    {
+        return m_partitions.front ()->getTargetAge ();
+    }
+
+    void setTargetAge (typename clock_type::rep s)
+    {
+        for (auto& partition : m_partitions)
+            partition->setTargetAge (s);
+    }
+
+    int getCacheSize ()
+    {
+        int size (0);
+        for (auto& partition : m_partitions)
+            size += partition->getCacheSize ();
+        return size;
+    }
+
+    int getTrackSize ()
+    {
+        int size (0);
+        for (auto& partition : m_partitions)
+            size += partition->getTrackSize ();
+        return size;
+    }
+
+    float getHitRate ()
+    {
+        // Keys are spread uniformly so the mean is representative
+        float rate (0);
+        for (auto& partition : m_partitions)
+            rate += partition->getHitRate ();
+        return rate / m_partitions.size ();
+    }
+
+    uint64 getHits ()
+    {
+        uint64 hits (0);
+        for (auto& partition : m_partitions)
+            hits += partition->getHits ();
+        return hits;
+    }
+
+    uint64 getMisses ()
+    {
+        uint64 misses (0);
+        for (auto& partition : m_partitions)
+            misses += partition->getMisses ();
+        return misses;
+    }
+
+    void clearStats ()
+    {
+        for (auto& partition : m_partitions)
+            partition->clearStats ();
+    }
+
+    void clear ()
+    {
+        for (auto& partition : m_partitions)
+            partition->clear ();
+    }
+
+    /** Limit the work done under a partition's lock by each sweep slice.
+        @see TaggedCache::setSweepSlice
+    */
+    void setSweepSlice (int entries, std::chrono::microseconds budget)
+    {
+        for (auto& partition : m_partitions)
+            partition->setSweepSlice (entries, budget);
+    }
+
+    /** Spread each partition's sweep pass out over an interval.
+        @see TaggedCache::setSweepInterval
+    */
+    void setSweepInterval (std::chrono::seconds interval)
+    {
+        for (auto& partition : m_partitions)
+            partition->setSweepInterval (interval);
+    }
+
+    /** Set a function called with each object which expires.
+        @see TaggedCache::setExpireHandler
+    */
+    void setExpireHandler (expire_handler handler)
+    {
+        for (auto& partition : m_partitions)
+            partition->setExpireHandler (handler);
+    }
+
+    /** Sweep every partition, one at a time.
+        Only the partition being swept is locked.
+    */
+    void sweep ()
+    {
+        for (auto& partition : m_partitions)
+            partition->sweep ();
+    }
+
+    /** Sweep a single partition.
+        This allows callers to spread the work of a full sweep out over time.
+    */
+    void sweep (std::size_t index)
+    {
+        m_partitions [index]->sweep ();
+    }
+
+    bool del (key_type const& key, bool valid)
+    {
+        return partition (key).del (key, valid);
+    }
+
+    /** Replace aliased objects with originals.
+        @see TaggedCache::canonicalize
+    */
+    bool canonicalize (key_type const& key, mapped_ptr& data,
+        bool replace = false)
+    {
+        return partition (key).canonicalize (key, data, replace);
+    }
+
+    mapped_ptr fetch (key_type const& key)
+    {
+        return partition (key).fetch (key);
+    }
+
+    bool insert (key_type const& key, T const& value)
+    {
+        return partition (key).insert (key, value);
+    }
+
+    bool retrieve (key_type const& key, T& data)
+    {
+        return partition (key).retrieve (key, data);
+    }
+
+    bool refreshIfPresent (key_type const& key)
+    {
+        return partition (key).refreshIfPresent (key);
+    }
+
+    /** Retrieve recently used objects from every partition.
+        Keys are spread uniformly so each partition contributes an equal
+        share of the limit, most recently used first within the share.
+        @see TaggedCache::getRecent
+    */
+    std::vector <mapped_ptr> getRecent (std::size_t limit)
+    {
+        std::size_t const share (
+            (limit + m_partitions.size () - 1) / m_partitions.size ());
+        std::vector <mapped_ptr> result;
+        result.reserve (limit);
+        for (auto& partition : m_partitions)
+        {
+            std::vector <mapped_ptr> recent (partition->getRecent (
+                std::min (share, limit - result.size ())));
+            std::move (recent.begin (), recent.end (),
+                std::back_inserter (result));
+        }
+        return result;
+    }
+
+private:
+    static int partitionSize (int size, std::size_t partitions)
+    {
+        // A target size of zero means unlimited, keep it that way
+        if (size <= 0)
+            return size;
+        return std::max (1, static_cast <int> (
+            (size + partitions - 1) / partitions));
+    }
+
+    partition_type& partition (key_type const& key)
+    {
+        // The partitions share the hash function with their own buckets,
+        // so take the partition from the high bits of a multiplicative mix
+        // to avoid correlating partition with bucket.
+        uint64 const h (static_cast <uint64> (m_hash (key)) *
+            0x9E3779B97F4A7C15ull);
+        return *m_partitions [(h >> 32) % m_partitions.size ()];
+    }
+
+    void collect_metrics ()
+    {
+        m_stats.size.set (getCacheSize ());
+        m_stats.hit_rate.set (static_cast <insight::Gauge::value_type> (
+            getHitRate ()));
+        m_stats.report (getHits (), getMisses ());
+    }
+
+private:
+    struct Stats
+    {
+        template <class Handler>
+        Stats (std::string const& prefix, Handler const& handler,
+            insight::Collector::ptr const& collector)
+            : hook (collector->make_hook (handler))
+            , size (collector->make_gauge (prefix, "size"))
+            , hit_rate (collector->make_gauge (prefix, "hit_rate"))
+            , hits (collector->make_counter (prefix, "hits"))
+            , misses (collector->make_counter (prefix, "misses"))
+            , reported_hits (0)
+            , reported_misses (0)
+            { }
+
+        // Same as TaggedCache
+        void report (uint64 total_hits, uint64 total_misses)
+        {
+            hits.increment (total_hits >= reported_hits ?
+                total_hits - reported_hits : total_hits);
+            misses.increment (total_misses >= reported_misses ?
+                total_misses - reported_misses : total_misses);
+            reported_hits = total_hits;
+            reported_misses = total_misses;
+        }
+
+        insight::Hook hook;
+        insight::Gauge size;
+        insight::Gauge hit_rate;
+        insight::Counter hits;
+        insight::Counter misses;
+        uint64 reported_hits;
+        uint64 reported_misses;
+    };
+
+    Journal m_journal;
+    clock_type& m_clock;
+    Stats m_stats;
+    Hash m_hash;
+
+    // Used for logging
+    std::string m_name;
+
+    // Desired number of cache entries across all partitions (0 = ignore)
+    std::atomic <int> m_target_size;
+
+    std::vector <std::unique_ptr <partition_type>> m_partitions;
+};
+
+}
+
+#endif
@@ -20,8 +20,14 @@
 #ifndef RIPPLE_TAGGEDCACHE_H_INCLUDED
 #define RIPPLE_TAGGEDCACHE_H_INCLUDED
 
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <limits>
 #include <mutex>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include <boost/smart_ptr.hpp>
 
@@ -66,6 +72,14 @@ public:
     typedef boost::weak_ptr <mapped_type> weak_mapped_ptr;
     typedef boost::shared_ptr <mapped_type> mapped_ptr;
     typedef abstract_clock <std::chrono::seconds> clock_type;
+    typedef std::function <void (mapped_ptr const&)> expire_handler;
+
+    enum
+    {
+        // Default limits on the work done by each slice of a sweep
+        defaultSweepSliceEntries = 4096
+        ,defaultSweepSliceMicroseconds = 2000
+    };
 
 public:
     // VFALCO TODO Change expiration_seconds to clock_type::duration
@@ -83,6 +97,10 @@ public:
         , m_cache_count (0)
         , m_hits (0)
         , m_misses (0)
+        , m_sweep_slice_entries (defaultSweepSliceEntries)
+        , m_sweep_slice_budget (defaultSweepSliceMicroseconds)
+        , m_sweep_bucket (0)
+        , m_sweep_interval (0)
     {
     }
 
@@ -143,6 +161,20 @@ public:
         return (static_cast<float> (m_hits) * 100) / (1.0f + m_hits + m_misses);
     }
 
+    /** Return the number of lookups which found an object. */
+    uint64 getHits ()
+    {
+        lock_guard lock (m_mutex);
+        return m_hits;
+    }
+
+    /** Return the number of lookups which found nothing. */
+    uint64 getMisses ()
+    {
+        lock_guard lock (m_mutex);
+        return m_misses;
+    }
+
     void clearStats ()
     {
         lock_guard lock (m_mutex);
@@ -157,95 +189,94 @@ public:
         m_cache_count = 0;
     }
 
-    void sweep ()
+    /** Limit the work done under the lock by each slice of a sweep.
+
+        A sweep visits the table in slices of at most `entries` entries or
+        `budget` of elapsed time, whichever comes first, and releases the
+        lock between slices so that readers are not stalled for the whole
+        pass. A value of zero removes the corresponding limit, and setting
+        both to zero restores a single stop-the-world pass.
+    */
+    void setSweepSlice (int entries, std::chrono::microseconds budget)
     {
-        int cacheRemovals = 0;
-        int mapRemovals = 0;
-        int cc = 0;
+        lock_guard lock (m_mutex);
+        m_sweep_slice_entries = entries;
+        m_sweep_slice_budget = budget;
+    }
 
-        // Keep references to all the stuff we sweep
-        // so that we can destroy them outside the lock.
-        //
-        std::vector <mapped_ptr> stuffToSweep;
-    
-        {
-            clock_type::time_point const now (m_clock.now());
-            clock_type::time_point when_expire;
+    /** Spread each sweep pass out over an interval.
 
-            lock_guard lock (m_mutex);
+        Once set, each call to sweep visits only the part of the table
+        which is due given the time since the previous call, so calling
+        sweep every second completes a pass about once per interval
+        instead of all at once. Zero, the default, makes every call to
+        sweep perform a complete pass.
+    */
+    void setSweepInterval (std::chrono::seconds interval)
+    {
+        lock_guard lock (m_mutex);
+        m_sweep_interval = interval;
+    }
 
-            if (m_target_size == 0 ||
-                (static_cast<int> (m_cache.size ()) <= m_target_size))
-            {
-                when_expire = now - m_target_age;
-            }
-            else
-            {
-                when_expire = now - clock_type::duration (
-                    m_target_age.count() * m_target_size / m_cache.size ());
+    /** Set a function called with each object which expires.
 
-                clock_type::duration const minimumAge (
-                    std::chrono::seconds (1));
-                if (when_expire > (now - minimumAge))
-                    when_expire = now - minimumAge;
+        The handler is called by sweep, outside the lock, for every entry
+        which stops being strongly cached, whether or not the object is
+        still referenced elsewhere. This lets a caller demote objects to a
+        cheaper tier instead of losing them.
+    */
+    void setExpireHandler (expire_handler handler)
+    {
+        lock_guard lock (m_mutex);
+        m_on_expire = handler;
+    }
 
-                if (m_journal.trace) m_journal.trace <<
-                    m_name << " is growing fast " << m_cache.size () << " of " << m_target_size <<
-                        " aging at " << (now - when_expire) << " of " << m_target_age;
-            }
+    /** Remove expired entries.
+        The work is performed one slice at a time.
+        @see setSweepSlice, setSweepInterval
+    */
+    void sweep ()
+    {
+        std::size_t last (std::numeric_limits <std::size_t>::max ());
 
-            stuffToSweep.reserve (m_cache.size ());
+        {
+            lock_guard lock (m_mutex);
 
-            cache_iterator cit = m_cache.begin ();
+            std::chrono::steady_clock::time_point const now (
+                std::chrono::steady_clock::now ());
 
-            while (cit != m_cache.end ())
+            if (m_sweep_interval.count () > 0 &&
+                    now - m_sweep_last < m_sweep_interval)
             {
-                if (cit->second.isWeak ())
-                {
-                    // weak
-                    if (cit->second.isExpired ())
-                    {
-                        ++mapRemovals;
-                        cit = m_cache.erase (cit);
-                    }
-                    else
-                    {
-                        ++cit;
-                    }
-                }
-                else if (cit->second.last_access <= when_expire)
-                {
-                    // strong, expired
-                    --m_cache_count;
-                    ++cacheRemovals;
-                    if (cit->second.ptr.unique ())
-                    {
-                        stuffToSweep.push_back (cit->second.ptr);
-                        ++mapRemovals;
-                        cit = m_cache.erase (cit);
-                    }
-                    else
-                    {
-                        // remains weakly cached
-                        cit->second.ptr.reset ();
-                        ++cit;
-                    }
-                }
-                else
-                {
-                    // strong, not expired
-                    ++cc;
-                    ++cit;
-                }
+                std::size_t const buckets (m_cache.bucket_count ());
+                std::size_t const due (static_cast <std::size_t> (
+                    buckets * (now - m_sweep_last).count () /
+                        std::chrono::duration_cast <
+                            std::chrono::steady_clock::duration> (
+                                m_sweep_interval).count ()));
+
+                last = m_sweep_bucket + std::max <std::size_t> (due, 1);
             }
+
+            m_sweep_last = now;
         }
 
-        if (m_journal.trace && (mapRemovals || cacheRemovals)) m_journal.trace <<
-            m_name << ": cache = " << m_cache.size () << "-" << cacheRemovals <<
-                ", map-=" << mapRemovals;
+        while (! sweepSlice (last))
+            std::this_thread::yield ();
+    }
 
-        // At this point stuffToSweep will go out of scope outside the lock
-        // and decrement the reference count on each strong pointer.
+    /** Perform the next slice of a sweep.
+
+        Each slice resumes at the bucket where the previous one stopped,
+        so callers can spread a pass out over time. The expiration time
+        is computed when a pass starts. Entries inserted or rehashed
+        during a pass may be skipped until the next pass.
+
+        @return `true` if this slice completed the pass.
+    */
+    bool sweepSome ()
+    {
+        return sweepSlice (std::numeric_limits <std::size_t>::max ());
     }
 
     bool del (const key_type& key, bool valid)
@@ -462,6 +493,39 @@ public:
         return found;
     }
 
+    /** Retrieve the most recently used objects in the cache.
+        Only strongly held objects are considered.
+
+        @param limit The most objects to return.
+        @return The objects, most recently used first.
+    */
+    std::vector <mapped_ptr> getRecent (std::size_t limit)
+    {
+        typedef std::pair <clock_type::time_point, mapped_ptr> item_type;
+        std::vector <item_type> items;
+
+        {
+            lock_guard lock (m_mutex);
+            items.reserve (m_cache_count);
+            for (auto const& v : m_cache)
+                if (v.second.isCached ())
+                    items.push_back (item_type (v.second.last_access, v.second.ptr));
+        }
+
+        limit = std::min (limit, items.size ());
+        std::partial_sort (items.begin (), items.begin () + limit, items.end (),
+            [] (item_type const& lhs, item_type const& rhs)
+            {
+                return lhs.first > rhs.first;
+            });
+
+        std::vector <mapped_ptr> result;
+        result.reserve (limit);
+        for (std::size_t i = 0; i < limit; ++i)
+            result.push_back (std::move (items [i].second));
+        return result;
+    }
+
     mutex_type& peekMutex ()
     {
         return m_mutex;
@@ -474,13 +538,18 @@ private:
 
         {
             insight::Gauge::value_type hit_rate (0);
+            uint64 hits;
+            uint64 misses;
             {
                 lock_guard lock (m_mutex);
                 auto const total (m_hits + m_misses);
                 if (total != 0)
                     hit_rate = (m_hits * 100) / total;
+                hits = m_hits;
+                misses = m_misses;
             }
             m_stats.hit_rate.set (hit_rate);
+            m_stats.report (hits, misses);
         }
     }
 
@@ -493,11 +562,37 @@ private:
             : hook (collector->make_hook (handler))
             , size (collector->make_gauge (prefix, "size"))
             , hit_rate (collector->make_gauge (prefix, "hit_rate"))
+            , sweep_examined (collector->make_counter (prefix, "sweep_examined"))
+            , sweep_evicted (collector->make_counter (prefix, "sweep_evicted"))
+            , sweep_lock (collector->make_event (prefix, "sweep_lock"))
+            , hits (collector->make_counter (prefix, "hits"))
+            , misses (collector->make_counter (prefix, "misses"))
+            , reported_hits (0)
+            , reported_misses (0)
             { }
 
+        // Counts the lookups since the previous report. The totals
+        // start over when clearStats is called.
+        void report (uint64 total_hits, uint64 total_misses)
+        {
+            hits.increment (total_hits >= reported_hits ?
+                total_hits - reported_hits : total_hits);
+            misses.increment (total_misses >= reported_misses ?
+                total_misses - reported_misses : total_misses);
+            reported_hits = total_hits;
+            reported_misses = total_misses;
+        }
+
         insight::Hook hook;
         insight::Gauge size;
         insight::Gauge hit_rate;
+        insight::Counter sweep_examined;
+        insight::Counter sweep_evicted;
+        insight::Event sweep_lock;
+        insight::Counter hits;
+        insight::Counter misses;
+        uint64 reported_hits;
+        uint64 reported_misses;
     };
 
     class Entry
@@ -525,6 +620,157 @@ private:
     typedef std::pair <key_type, Entry> cache_pair;
     typedef std::unordered_map <key_type, Entry, Hash, KeyEqual> cache_type;
     typedef typename cache_type::iterator cache_iterator;
+    typedef typename cache_type::local_iterator local_iterator;
+
+    // Sweeps one slice, stopping early at the bucket numbered `last`.
+    // Returns `true` if the slice reached `last` or completed the pass.
+    bool sweepSlice (std::size_t last)
+    {
+        int examined = 0;
+        int cacheRemovals = 0;
+        int mapRemovals = 0;
+        std::size_t mapSize = 0;
+        bool finished = false;
+        std::chrono::steady_clock::duration held;
+
+        // Keep references to all the stuff we sweep
+        // so that we can destroy them outside the lock.
+        //
+        std::vector <mapped_ptr> stuffToSweep;
+        expire_handler onExpire;
+
+        {
+            lock_guard lock (m_mutex);
+
+            onExpire = m_on_expire;
+
+            std::chrono::steady_clock::time_point const start (
+                std::chrono::steady_clock::now ());
+
+            if (m_sweep_bucket == 0)
+                m_sweep_when_expire = whenExpire ();
+
+            std::vector <key_type> toErase;
+
+            while (m_sweep_bucket < std::min (last, m_cache.bucket_count ()))
+            {
+                for (local_iterator it (m_cache.begin (m_sweep_bucket));
+                    it != m_cache.end (m_sweep_bucket); ++it)
+                {
+                    ++examined;
+                    if (sweepEntry (it->second, stuffToSweep, cacheRemovals))
+                        toErase.push_back (it->first);
+                }
+
+                // Erasing invalidates the local iterators so it is deferred
+                for (auto const& key : toErase)
+                    m_cache.erase (key);
+                mapRemovals += toErase.size ();
+                toErase.clear ();
+
+                ++m_sweep_bucket;
+
+                if (m_sweep_slice_entries > 0 &&
+                        examined >= m_sweep_slice_entries)
+                    break;
+
+                if (m_sweep_slice_budget.count () > 0 &&
+                        std::chrono::steady_clock::now () - start >=
+                            m_sweep_slice_budget)
+                    break;
+            }
+
+            if (m_sweep_bucket >= m_cache.bucket_count ())
+            {
+                m_sweep_bucket = 0;
+                finished = true;
+            }
+            else if (m_sweep_bucket >= last)
+            {
+                finished = true;
+            }
+
+            mapSize = m_cache.size ();
+            held = std::chrono::steady_clock::now () - start;
+        }
+
+        m_stats.sweep_examined.increment (examined);
+        m_stats.sweep_evicted.increment (mapRemovals);
+        m_stats.sweep_lock.notify (held);
+
+        if (m_journal.trace && (mapRemovals || cacheRemovals)) m_journal.trace <<
+            m_name << ": cache = " << mapSize << "-" << cacheRemovals <<
+                ", map-=" << mapRemovals;
+
+        if (onExpire)
+            for (auto const& object : stuffToSweep)
+                onExpire (object);
+
+        // At this point stuffToSweep will go out of scope outside the lock
+        // and decrement the reference count on each strong pointer.
+
+        return finished;
+    }
+
+    // Returns the access time before which strong entries expire.
+    // Called with the lock held at the start of each sweep pass.
+    clock_type::time_point whenExpire ()
+    {
+        clock_type::time_point const now (m_clock.now());
+
+        if (m_target_size == 0 ||
+            (static_cast<int> (m_cache.size ()) <= m_target_size))
+        {
+            return now - m_target_age;
+        }
+
+        clock_type::time_point when_expire (now - clock_type::duration (
+            m_target_age.count() * m_target_size / m_cache.size ()));
+
+        clock_type::duration const minimumAge (
+            std::chrono::seconds (1));
+        if (when_expire > (now - minimumAge))
+            when_expire = now - minimumAge;
+
+        if (m_journal.trace) m_journal.trace <<
+            m_name << " is growing fast " << m_cache.size () << " of " << m_target_size <<
+                " aging at " << (now - when_expire) << " of " << m_target_age;
+
+        return when_expire;
+    }
+
+    // Ages a single entry during a sweep, with the lock held.
+    // Returns `true` if the entry should be removed from the map.
+    bool sweepEntry (Entry& entry, std::vector <mapped_ptr>& stuffToSweep,
+        int& cacheRemovals)
+    {
+        if (entry.isWeak ())
+        {
+            // weak
+            return entry.isExpired ();
+        }
+
+        if (entry.last_access > m_sweep_when_expire)
+        {
+            // strong, not expired
+            return false;
+        }
+
+        // strong, expired
+        --m_cache_count;
+        ++cacheRemovals;
+        if (entry.ptr.unique ())
+        {
+            stuffToSweep.push_back (entry.ptr);
+            return true;
+        }
+
+        // remains weakly cached
+        if (m_on_expire)
+            stuffToSweep.push_back (entry.ptr);
+        entry.ptr.reset ();
+        return false;
+    }
 
     Journal m_journal;
     clock_type& m_clock;
@@ -546,6 +792,22 @@ private:
     cache_type m_cache;  // Hold strong reference to recent objects
     uint64 m_hits;
     uint64 m_misses;
+
+    // Limits on the work done by each slice of a sweep (0 = unlimited)
+    int m_sweep_slice_entries;
+    std::chrono::microseconds m_sweep_slice_budget;
+
+    // Bucket where the next sweep slice resumes, and the expiration
+    // time computed at the start of the current pass.
+    std::size_t m_sweep_bucket;
+    clock_type::time_point m_sweep_when_expire;
+
+    // Time over which a pass is spread, and when sweep was last called
+    std::chrono::seconds m_sweep_interval;
+    std::chrono::steady_clock::time_point m_sweep_last;
+
+    // Called with objects which expire from the cache
+    expire_handler m_on_expire;
 };
 
 }
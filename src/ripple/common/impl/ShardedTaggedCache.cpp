@@ -0,0 +1,237 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include "../ShardedTaggedCache.h"
+#include "../seconds_clock.h"
+
+#include <atomic>
+#include <thread>
+
+namespace ripple {
+
+class ShardedTaggedCacheTests : public UnitTest
+{
+public:
+    void runTest ()
+    {
+        Journal const j;
+
+        beginTestCase ("Insert");
+
+        manual_clock <std::chrono::seconds> clock;
+        clock.set (0);
+
+        typedef int Key;
+        typedef std::string Value;
+        typedef ShardedTaggedCache <Key, Value> Cache;
+
+        Cache c ("test", 64, 1, clock, j, insight::NullCollector::New (), 4);
+
+        expect (c.partitions () == 4);
+
+        // Insert items across all partitions, then age them out.
+        {
+            for (int i = 0; i < 32; ++i)
+                expect (! c.insert (i, std::to_string (i)));
+            expect (c.getCacheSize () == 32);
+            expect (c.getTrackSize () == 32);
+
+            for (int i = 0; i < 32; ++i)
+            {
+                std::string s;
+                expect (c.retrieve (i, s));
+                expect (s == std::to_string (i));
+            }
+
+            ++clock;
+            c.sweep ();
+            expect (c.getCacheSize () == 0);
+            expect (c.getTrackSize () == 0);
+        }
+
+        // A strong pointer held outside the cache keeps the entry tracked.
+        {
+            expect (! c.insert (2, "two"));
+
+            {
+                Cache::mapped_ptr p (c.fetch (2));
+                expect (p != nullptr);
+                ++clock;
+                c.sweep ();
+                expect (c.getCacheSize () == 0);
+                expect (c.getTrackSize () == 1);
+
+                // Canonicalizing a copy returns the original object
+                Cache::mapped_ptr p2 (boost::make_shared <Value> ("two"));
+                expect (c.canonicalize (2, p2));
+                expect (p.get () == p2.get ());
+                expect (c.getCacheSize () == 1);
+            }
+
+            ++clock;
+            c.sweep ();
+            expect (c.getCacheSize () == 0);
+            expect (c.getTrackSize () == 0);
+        }
+
+        // Sweeping one partition leaves the others alone.
+        {
+            for (int i = 0; i < 32; ++i)
+                c.insert (i, std::to_string (i));
+            ++clock;
+            c.sweep (0);
+            int const remaining (c.getTrackSize ());
+            expect (remaining < 32);
+            for (std::size_t i = 1; i < c.partitions (); ++i)
+                c.sweep (i);
+            expect (c.getTrackSize () == 0);
+        }
+
+        beginTestCase ("Recent");
+
+        // Recently used objects come back first, up to the limit.
+        {
+            for (int i = 0; i < 32; ++i)
+                c.insert (i, std::to_string (i));
+            expect (c.getRecent (64).size () == 32);
+            expect (c.getRecent (8).size () == 8);
+
+            Cache one ("test", 64, 10, clock, j, insight::NullCollector::New (), 1);
+            for (int i = 0; i < 32; ++i)
+                one.insert (i, std::to_string (i));
+            ++clock;
+            one.fetch (7);
+            ++clock;
+            one.fetch (3);
+
+            std::vector <Cache::mapped_ptr> const recent (one.getRecent (2));
+            expect (recent.size () == 2);
+            expect (*recent [0] == "3");
+            expect (*recent [1] == "7");
+        }
+    }
+
+    ShardedTaggedCacheTests () : UnitTest (
+        "ShardedTaggedCache", "ripple")
+    {
+    }
+};
+
+static ShardedTaggedCacheTests shardedTaggedCacheTests;
+
+//------------------------------------------------------------------------------
+
+/** Compares TaggedCache and ShardedTaggedCache under contention.
+
+    Each thread performs a mix of fetches and canonicalizations over a
+    shared key space while a separate thread sweeps continuously.
+*/
+class TaggedCacheContentionTests : public UnitTest
+{
+public:
+    enum
+    {
+        numKeys = 100000,
+        opsPerThread = 1000000
+    };
+
+    typedef int Key;
+    typedef std::string Value;
+
+    template <class Cache>
+    double measure (Cache& cache, int threads)
+    {
+        std::atomic <bool> done (false);
+        std::thread sweeper ([&]
+        {
+            while (! done)
+            {
+                cache.sweep ();
+                std::this_thread::yield ();
+            }
+        });
+
+        int64 const start (Time::getHighResolutionTicks ());
+
+        std::vector <std::thread> workers;
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back ([&cache, t]
+            {
+                Random r (t + 1);
+                for (int i = 0; i < opsPerThread; ++i)
+                {
+                    Key const key (r.nextInt (numKeys));
+                    if (cache.fetch (key) == nullptr)
+                    {
+                        typename Cache::mapped_ptr value (
+                            boost::make_shared <Value> ("value"));
+                        cache.canonicalize (key, value);
+                    }
+                }
+            });
+        }
+
+        for (auto& worker : workers)
+            worker.join ();
+
+        double const elapsed (Time::highResolutionTicksToSeconds (
+            Time::getHighResolutionTicks () - start));
+
+        done = true;
+        sweeper.join ();
+
+        return (double (threads) * opsPerThread) / elapsed;
+    }
+
+    void runTest ()
+    {
+        beginTestCase ("contention");
+
+        Journal const j;
+
+        for (int threads = 1; threads <= 32; threads *= 2)
+        {
+            TaggedCache <Key, Value> single ("single", numKeys / 2, 60,
+                get_seconds_clock (), j);
+            ShardedTaggedCache <Key, Value> sharded ("sharded", numKeys / 2, 60,
+                get_seconds_clock (), j);
+
+            double const singleRate (measure (single, threads));
+            double const shardedRate (measure (sharded, threads));
+
+            String s;
+            s << String (threads) << " threads: " <<
+                "TaggedCache " << String (int64 (singleRate)) << " ops/s, " <<
+                "ShardedTaggedCache " << String (int64 (shardedRate)) << " ops/s";
+            logMessage (s);
+        }
+
+        pass ();
+    }
+
+    TaggedCacheContentionTests () : UnitTest (
+        "TaggedCacheContention", "ripple", runManual)
+    {
+    }
+};
+
+static TaggedCacheContentionTests taggedCacheContentionTests;
+
+}
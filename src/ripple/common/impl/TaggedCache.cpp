@@ -143,6 +143,54 @@ public:
             expect (c.getCacheSize() == 0);
             expect (c.getTrackSize() == 0);
         }
+
+        beginTestCase ("Sweep slices");
+
+        // Sweep one entry at a time and make sure the pass still
+        // visits everything.
+        {
+            Cache c ("test", 0, 1, clock, j);
+            c.setSweepSlice (1, std::chrono::microseconds (0));
+
+            for (int i = 0; i < 64; ++i)
+                expect (! c.insert (i, "value"));
+            expect (c.getCacheSize() == 64);
+
+            ++clock;
+            int slices = 0;
+            while (! c.sweepSome ())
+                ++slices;
+            expect (slices > 0);
+            expect (c.getCacheSize() == 0);
+            expect (c.getTrackSize() == 0);
+        }
+
+        beginTestCase ("Expire handler");
+
+        // Every object leaving the cache is handed over, including
+        // ones which stay weakly cached.
+        {
+            Cache c ("test", 0, 1, clock, j);
+            std::vector <std::string> expired;
+            c.setExpireHandler ([&expired] (Cache::mapped_ptr const& p)
+            {
+                expired.push_back (*p);
+            });
+
+            expect (! c.insert (1, "one"));
+            expect (! c.insert (2, "two"));
+            Cache::mapped_ptr const p (c.fetch (2));
+
+            ++clock;
+            c.sweep ();
+            expect (expired.size () == 2);
+            expect (c.getTrackSize() == 1);
+
+            // Weak entries are not handed over again
+            ++clock;
+            c.sweep ();
+            expect (expired.size () == 2);
+        }
     }
 
     TaggedCacheTests () : UnitTest (
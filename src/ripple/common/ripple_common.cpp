@@ -24,6 +24,7 @@
 #include "impl/counted_bind.cpp"
 #include "impl/KeyCache.cpp"
 #include "impl/TaggedCache.cpp"
+#include "impl/ShardedTaggedCache.cpp"
 
 using namespace beast;
 
@@ -83,6 +83,17 @@ public:
     virtual void write (void const* buffer, std::size_t bytes) = 0;
     /** @} */
 
+    /** Wait until no more than `bytes` of the data written remain unsent.
+        This lets a handler which produces a large response a piece at a
+        time bound the amount of it held in memory. It must not be called
+        from an io_service thread. If the client accepts no data for a
+        while the connection is closed, so a client which stops reading
+        can't hold the calling thread.
+        @return `false` if the connection failed or timed out, and nothing
+                more will be sent.
+    */
+    virtual bool waitForWrites (std::size_t bytes) = 0;
+
     /** Output support using ostream. */
     /** @{ */
     ScopedStream operator<< (std::ostream& manip (std::ostream&))
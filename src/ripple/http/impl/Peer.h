@@ -20,7 +20,11 @@
 #ifndef RIPPLE_HTTP_PEER_H_INCLUDED
 #define RIPPLE_HTTP_PEER_H_INCLUDED
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
 
 namespace ripple {
 namespace HTTP {
@@ -49,7 +53,10 @@ public:
         dataTimeoutSeconds = 10,
 
         // Max seconds without completing the request
-        requestTimeoutSeconds = 30
+        requestTimeoutSeconds = 30,
+
+        // Max seconds waitForWrites waits without any data being sent
+        writeTimeoutSeconds = 30
 
     };
 
@@ -63,6 +70,7 @@ public:
     MemoryBlock m_buffer;
     HTTPRequestParser m_parser;
     int m_writesPending;
+    std::deque <SharedBuffer> m_writeQueue;     // Sent one at a time, in order
     bool m_closed;
     bool m_callClose;
     SharedPtr <Peer> m_detach_ref;
@@ -70,6 +78,12 @@ public:
     int m_errorCode;
     std::atomic <int> m_detached;
 
+    // Bytes written by the handler and not yet sent, for waitForWrites
+    std::mutex m_unsentMutex;
+    std::condition_variable m_unsentCond;
+    std::size_t m_unsentBytes;
+    bool m_writeFailed;
+
     //--------------------------------------------------------------------------
 
     Peer (ServerImpl& impl, Port const& port)
@@ -83,6 +97,8 @@ public:
         , m_callClose (false)
         , m_errorCode (0)
         , m_detached (0)
+        , m_unsentBytes (0)
+        , m_writeFailed (false)
     {
         tag = nullptr;
 
@@ -157,6 +173,11 @@ public:
     // Send a copy of the data.
     void write (void const* buffer, std::size_t bytes)
     {
+        {
+            std::lock_guard <std::mutex> lock (m_unsentMutex);
+            m_unsentBytes += bytes;
+        }
+
         // Make sure this happens on an io_service thread.
         m_impl.get_io_service().dispatch (m_strand.wrap (
             boost::bind (&Peer::handle_write, Ptr (this),
@@ -164,6 +185,45 @@ public:
                     CompletionCounter (this))));
     }
 
+    bool waitForWrites (std::size_t bytes)
+    {
+        typedef std::chrono::steady_clock clock_type;
+
+        std::unique_lock <std::mutex> lock (m_unsentMutex);
+
+        // The deadline is pushed back whenever some data is sent, so only
+        // a client which stops reading runs out of time.
+        std::size_t unsent (m_unsentBytes);
+        clock_type::time_point deadline (clock_type::now () +
+            std::chrono::seconds (writeTimeoutSeconds));
+
+        while (! m_writeFailed && m_unsentBytes > bytes)
+        {
+            if (m_unsentCond.wait_until (lock, deadline) == std::cv_status::timeout)
+            {
+                if (m_unsentBytes >= unsent)
+                {
+                    m_writeFailed = true;
+                    lock.unlock ();
+
+                    m_impl.get_io_service().dispatch (m_strand.wrap (
+                        boost::bind (&Peer::handle_write_timeout, Ptr (this),
+                            CompletionCounter (this))));
+                    return false;
+                }
+            }
+
+            if (m_unsentBytes < unsent)
+            {
+                unsent = m_unsentBytes;
+                deadline = clock_type::now () +
+                    std::chrono::seconds (writeTimeoutSeconds);
+            }
+        }
+
+        return ! m_writeFailed;
+    }
+
     // Make the Session asynchronous
     void detach ()
     {
@@ -300,19 +360,52 @@ public:
             boost::system::errc::timed_out));
     }
 
+    // Called when waitForWrites gives up on the client.
+    //
+    void handle_write_timeout (CompletionCounter)
+    {
+        // Aborting the pending write releases the queued buffers
+        failed (boost::system::errc::make_error_code (
+            boost::system::errc::timed_out));
+    }
+
     // Called when async_write completes.
     void handle_write (error_code ec, std::size_t bytes_transferred,
         SharedBuffer buf, CompletionCounter)
     {
-        if (ec == boost::asio::error::operation_aborted)
-            return;
+        bassert (! m_writeQueue.empty ());
+        m_writeQueue.pop_front ();
 
         if (ec != 0)
         {
-            failed (ec);
+            // Nothing queued behind a failed write will be sent
+            std::size_t unsent (buf->size ());
+            for (auto const& queued : m_writeQueue)
+                unsent += queued->size ();
+            m_writesPending -= m_writeQueue.size ();
+            m_writeQueue.clear ();
+
+            {
+                std::lock_guard <std::mutex> lock (m_unsentMutex);
+                m_unsentBytes -= unsent;
+                m_writeFailed = true;
+            }
+            m_unsentCond.notify_all ();
+
+            if (ec != boost::asio::error::operation_aborted)
+                failed (ec);
             return;
         }
 
+        {
+            std::lock_guard <std::mutex> lock (m_unsentMutex);
+            m_unsentBytes -= buf->size ();
+        }
+        m_unsentCond.notify_all ();
+
+        if (! m_writeQueue.empty ())
+            start_write ();
+
         bassert (m_writesPending > 0);
         if (--m_writesPending == 0 && m_closed)
             m_socket->shutdown (socket::shutdown_send);
@@ -478,6 +571,17 @@ public:
 
         ++m_writesPending;
 
+        // Writes to a stream must not overlap, so each waits its turn
+        m_writeQueue.push_back (buf);
+        if (m_writeQueue.size () == 1)
+            start_write ();
+    }
+
+    // Send the buffer at the front of the write queue
+    void start_write ()
+    {
+        SharedBuffer const& buf (m_writeQueue.front ());
+
         // Send the copy. We pass the SharedBuffer in the last parameter
         // so that a reference is maintained as the handler gets copied.
         // When the final completion function returns, the reference
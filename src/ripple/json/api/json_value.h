@@ -150,8 +150,10 @@ private:
         CZString ( int index );
         CZString ( const char* cstr, DuplicationPolicy allocate );
         CZString ( const CZString& other );
+        CZString ( CZString&& other ) noexcept;
         ~CZString ();
         CZString& operator = ( const CZString& other );
+        CZString& operator = ( CZString&& other ) noexcept;
         bool operator< ( const CZString& other ) const;
         bool operator== ( const CZString& other ) const;
         int index () const;
@@ -164,11 +166,183 @@ private:
     };
 
 public:
-#  ifndef JSON_USE_CPPTL_SMALLMAP
-    typedef std::map<CZString, Value> ObjectValues;
-#  else
-    typedef CppTL::SmallMap<CZString, Value> ObjectValues;
-#  endif // ifndef JSON_USE_CPPTL_SMALLMAP
+    /** The members of an object, or the elements of an array.
+
+        The members are kept in one vector as two runs sorted by key: the
+        members which were present at the last merge, followed by a short
+        run of members added since. A new key is inserted into the short
+        run, which is merged into the long one once it grows past about
+        the square root of the size, so building an object costs far less
+        than keeping a single run sorted. Iterators visit both runs
+        together in key order, and lookups never reorder anything, so a
+        Value may still be read from several threads at once. An array
+        built by append only grows at the end of the long run.
+
+        Each value is allocated on its own so references to it stay valid
+        while members are added, as they would in a map. Iterators do not.
+    */
+    class ObjectValues
+    {
+    public:
+        typedef std::pair<CZString, Value*> value_type;
+
+        // Walks both runs in key order
+        template <class Member>
+        class basic_iterator
+        {
+        public:
+            basic_iterator ()
+                : begin_ ( nullptr ), split_ ( nullptr ), end_ ( nullptr )
+                , first_ ( nullptr ), second_ ( nullptr )
+            {
+            }
+
+            basic_iterator ( Member* begin, Member* split, Member* end,
+                             Member* first, Member* second )
+                : begin_ ( begin ), split_ ( split ), end_ ( end )
+                , first_ ( first ), second_ ( second )
+            {
+            }
+
+            template <class Other>
+            basic_iterator ( const basic_iterator<Other>& other )
+                : begin_ ( other.begin_ ), split_ ( other.split_ ), end_ ( other.end_ )
+                , first_ ( other.first_ ), second_ ( other.second_ )
+            {
+            }
+
+            Member& operator* () const
+            {
+                return *current ();
+            }
+            Member* operator-> () const
+            {
+                return current ();
+            }
+
+            basic_iterator& operator++ ()
+            {
+                if ( current () == first_ )
+                    ++first_;
+                else
+                    ++second_;
+
+                return *this;
+            }
+
+            basic_iterator& operator-- ()
+            {
+                // Step back in whichever run holds the larger previous key
+                if ( first_ == begin_ )
+                    --second_;
+                else if ( second_ == split_ )
+                    --first_;
+                else if ( ( first_ - 1 )->first < ( second_ - 1 )->first )
+                    --second_;
+                else
+                    --first_;
+
+                return *this;
+            }
+
+            bool operator== ( const basic_iterator& other ) const
+            {
+                return first_ == other.first_  &&  second_ == other.second_;
+            }
+            bool operator!= ( const basic_iterator& other ) const
+            {
+                return !( *this == other );
+            }
+
+            std::ptrdiff_t operator- ( const basic_iterator& other ) const
+            {
+                return ( first_ - other.first_ ) + ( second_ - other.second_ );
+            }
+
+            /// Return the position of the member in the vector.
+            std::size_t offset () const
+            {
+                return current () - begin_;
+            }
+
+        private:
+            template <class> friend class basic_iterator;
+
+            Member* current () const
+            {
+                if ( first_ == split_ )
+                    return second_;
+
+                if ( second_ == end_  ||  first_->first < second_->first )
+                    return first_;
+
+                return second_;
+            }
+
+            Member* begin_;
+            Member* split_;
+            Member* end_;
+            Member* first_;     // Position in the long run
+            Member* second_;    // Position in the short run
+        };
+
+        typedef basic_iterator<value_type> iterator;
+        typedef basic_iterator<const value_type> const_iterator;
+
+        ObjectValues ();
+        ObjectValues ( const ObjectValues& other );
+        ~ObjectValues ();
+
+        iterator begin ()
+        {
+            return makeIterator ( 0, sorted_ );
+        }
+        iterator end ()
+        {
+            return makeIterator ( sorted_, members_.size () );
+        }
+        const_iterator begin () const
+        {
+            return const_cast<ObjectValues*> ( this )->begin ();
+        }
+        const_iterator end () const
+        {
+            return const_cast<ObjectValues*> ( this )->end ();
+        }
+
+        std::size_t size () const
+        {
+            return members_.size ();
+        }
+        bool empty () const
+        {
+            return members_.empty ();
+        }
+        void clear ();
+
+        iterator find ( const CZString& key );
+        const_iterator find ( const CZString& key ) const;
+
+        /// Return the value with the key, adding a null value if there is none.
+        Value& resolve ( const CZString& key );
+
+        void erase ( iterator it );
+
+        bool operator== ( const ObjectValues& other ) const;
+        bool operator< ( const ObjectValues& other ) const;
+
+    private:
+        ObjectValues& operator= ( const ObjectValues& other );
+
+        static bool lessKey ( const value_type& member, const CZString& key );
+        static bool lessMember ( const value_type& lhs, const value_type& rhs );
+
+        iterator makeIterator ( std::size_t first, std::size_t second );
+
+        // Members before this index form the long run
+        std::size_t sorted_;
+        std::vector<value_type> members_;
+    };
 # endif // ifndef JSON_VALUE_USE_INTERNAL_MAP
 #endif // ifndef JSONCPP_DOC_EXCLUDE_IMPLEMENTATION
 
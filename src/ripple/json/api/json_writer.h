@@ -172,6 +172,74 @@ private:
     bool addChildValues_;
 };
 
+/** \brief Writes <a HREF="http://www.json.org">JSON</a> in the same format as FastWriter,
+ *  a piece at a time.
+ *
+ * A large document can be produced without building the Value tree for all
+ * of it, or holding all of its text: objects and arrays are opened and
+ * closed with explicit calls, and the text is passed to the output in
+ * pieces of about the chunk size as it is produced.
+ *
+ * The output is only called from the member functions, never from the
+ * destructor, so it may throw to abandon the document.
+ *
+ * \sa FastWriter
+ */
+class JSON_API StreamWriter
+{
+public:
+    typedef std::function <void (char const* data, std::size_t bytes)> Output;
+
+    explicit StreamWriter ( Output const& output, std::size_t chunkSize = 16384 );
+
+    /** Start an object or array as the next value. */
+    void startObject ();
+    void startArray ();
+
+    /** Start an object or array as a member of the current object. */
+    void startObject ( std::string const& name );
+    void startArray ( std::string const& name );
+
+    /** Finish the innermost object or array. */
+    void end ();
+
+    /** Name the next value, which becomes a member of the current object. */
+    void key ( std::string const& name );
+
+    /** Write a value. */
+    void value ( const Value& value );
+
+    /** Write a member of the current object. */
+    void member ( std::string const& name, const Value& value );
+
+    /** Write each member of an object as a member of the current object. */
+    void members ( const Value& object );
+
+    /** Pass any text held to the output.
+        Call this once the document is finished.
+    */
+    void flush ();
+
+private:
+    void separate ();
+    void writeValue ( const Value& value );
+    void append ( std::string const& text );
+
+    Output output_;
+    std::size_t chunkSize_;
+    std::string buffer_;
+
+    // An object or array being written
+    struct Level
+    {
+        bool isObject;
+        bool empty;
+    };
+
+    std::vector <Level> levels_;
+    bool named_;
+};
+
 std::string JSON_API valueToString ( Int value );
 std::string JSON_API valueToString ( UInt value );
 std::string JSON_API valueToString ( double value );
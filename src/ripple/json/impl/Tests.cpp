@@ -38,9 +38,114 @@ public:
         pass ();
     }
 
+    void testStreamWriter ()
+    {
+        beginTestCase ("stream writer");
+
+        Json::Value item (Json::objectValue);
+        item["name"] = "a \"quoted\" string";
+        item["count"] = 42;
+        item["balance"] = -7;
+        item["ratio"] = 0.5;
+        item["flag"] = true;
+        item["none"] = Json::Value ();
+        item["list"].append (1);
+        item["list"].append (Json::Value (Json::objectValue));
+        item["list"].append (Json::Value (Json::arrayValue));
+
+        Json::Value root (Json::objectValue);
+        root["header"] = item;
+        for (int i = 0; i < 20; ++i)
+            root["items"].append (item);
+
+        std::string expected (Json::FastWriter ().write (root));
+        expected.erase (expected.size () - 1); // trailing newline
+
+        // A small chunk size exercises the splitting of the output
+        std::string text;
+        std::size_t largest (0);
+        Json::StreamWriter writer ([&] (char const* data, std::size_t bytes)
+        {
+            text.append (data, bytes);
+            largest = std::max (largest, bytes);
+        }, 64);
+
+        writer.startObject ();
+        writer.member ("header", item);
+        writer.startArray ("items");
+        for (int i = 0; i < 20; ++i)
+            writer.value (item);
+        writer.end ();
+        writer.end ();
+        writer.flush ();
+
+        expect (text == expected, "Should match FastWriter");
+        expect (largest < 2 * 64, "Should pass the output in chunks");
+
+        text.clear ();
+        Json::StreamWriter whole ([&] (char const* data, std::size_t bytes)
+        {
+            text.append (data, bytes);
+        });
+        whole.value (root);
+        whole.flush ();
+        expect (text == expected, "Should match FastWriter");
+    }
+
+    void testMembers ()
+    {
+        beginTestCase ("members");
+
+        Json::Value object (Json::objectValue);
+        Json::Value& first (object["m"]);
+        for (int i = 0; i < 100; ++i)
+            object[std::string (1, char ('a' + i % 26)) + std::to_string (i)] = i;
+        first = "still here";
+        expect (object["m"] == "still here", "References should stay valid");
+
+        std::string previous;
+        bool sorted (true);
+        for (Json::Value::iterator it = object.begin (); it != object.end (); ++it)
+        {
+            sorted = sorted && previous < it.memberName ();
+            previous = it.memberName ();
+        }
+        expect (sorted, "Members should be in order");
+
+        // Keys added out of order wait in the short run until a merge
+        object["zz"] = 1;
+        object["aa"] = 2;
+        Json::Value::iterator last (object.end ());
+        --last;
+        expect (std::string (last.memberName ()) == "zz", "Should step back in order");
+        expect (object.removeMember ("aa") == 2 && ! object.isMember ("aa"));
+        expect (object.isMember ("zz") && object.size () == 102);
+
+        static Json::StaticString const key ("static");
+        object[key] = 1;
+        expect (object.isMember ("static") && object["static"] == 1);
+        expect (object.removeMember ("static") == 1 && ! object.isMember ("static"));
+
+        Json::Value array (Json::arrayValue);
+        array[3u] = 3;
+        expect (array.size () == 4 && array[1u].isNull (), "Missing elements are null");
+        array[1u] = 1;
+        array.append (4);
+        expect (array.size () == 5 && array[1u] == 1 && array[4u] == 4);
+        array.resize (2);
+        expect (array.size () == 2 && array[1u] == 1);
+
+        Json::Value copy (object);
+        expect (copy == object, "A copy should be equal");
+        copy["m"] = "changed";
+        expect (copy != object && object["m"] == "still here", "A copy should be deep");
+    }
+
     void runTest ()
     {
         testBadJson ();
+        testStreamWriter ();
+        testMembers ();
     }
 
     JsonCppTests () : UnitTest ("JsonCpp", "ripple")
@@ -50,4 +155,197 @@ public:
 
 static JsonCppTests jsonCppTests;
 
+//------------------------------------------------------------------------------
+
+// Compares building a response with a million entries as a Value tree
+// against writing it with the StreamWriter.
+//
+class JsonStreamTests : public UnitTest
+{
+public:
+    enum
+    {
+        entries = 1000000
+    };
+
+    static Json::Value makeEntry (int i)
+    {
+        Json::Value entry (Json::objectValue);
+        entry["index"] = i;
+        entry["Account"] = "rHb9CJAWyB4rj91VRWn96DkukG4bwdtyTh";
+        entry["Balance"] = "99999999999999990";
+        entry["Flags"] = 0;
+        return entry;
+    }
+
+    void runTest ()
+    {
+        beginTestCase ("million entries");
+
+        std::size_t treeBytes (0);
+        {
+            auto const start (std::chrono::steady_clock::now ());
+
+            Json::Value root (Json::objectValue);
+            Json::Value& state (root["accountState"] = Json::arrayValue);
+            for (int i = 0; i < entries; ++i)
+                state.append (makeEntry (i));
+            std::string const text (Json::FastWriter ().write (root));
+            treeBytes = text.size ();
+
+            std::chrono::duration <double> const elapsed (
+                std::chrono::steady_clock::now () - start);
+
+            String s;
+            s << "Value tree: " << String (int64 (elapsed.count () * 1000)) <<
+                "ms, " << String (int64 (text.size ())) << " bytes held at once";
+            logMessage (s);
+        }
+
+        std::size_t streamBytes (0);
+        {
+            auto const start (std::chrono::steady_clock::now ());
+
+            std::size_t largest (0);
+            Json::StreamWriter writer ([&] (char const* data, std::size_t bytes)
+            {
+                streamBytes += bytes;
+                largest = std::max (largest, bytes);
+            });
+            writer.startObject ();
+            writer.startArray ("accountState");
+            for (int i = 0; i < entries; ++i)
+                writer.value (makeEntry (i));
+            writer.end ();
+            writer.end ();
+            writer.flush ();
+
+            std::chrono::duration <double> const elapsed (
+                std::chrono::steady_clock::now () - start);
+
+            String s;
+            s << "StreamWriter: " << String (int64 (elapsed.count () * 1000)) <<
+                "ms, " << String (int64 (largest)) << " bytes held at once";
+            logMessage (s);
+        }
+
+        // FastWriter adds a newline
+        expect (streamBytes + 1 == treeBytes, "Should produce the same text");
+    }
+
+    JsonStreamTests () : UnitTest ("JsonStream", "ripple", runManual)
+    {
+    }
+};
+
+static JsonStreamTests jsonStreamTests;
+
+//------------------------------------------------------------------------------
+
+// Measures parsing, building and serializing the JSON of a typical
+// transaction with its metadata.
+//
+class JsonValueTests : public UnitTest
+{
+public:
+    enum
+    {
+        iterations = 20000
+    };
+
+    static Json::Value makeNode (char const* type, char const* index)
+    {
+        Json::Value node (Json::objectValue);
+        Json::Value& fields (node[type]);
+        fields["LedgerEntryType"] = "AccountRoot";
+        fields["LedgerIndex"] = index;
+        fields["PreviousTxnID"] = "D9C8E0B0D4E0A2C54B5DE6E6A5E7C94F9A2F0E8F63B2B5C1B7B8B2A4E7E51B6C";
+        fields["PreviousTxnLgrSeq"] = 3510290;
+        Json::Value& finalFields (fields["FinalFields"]);
+        finalFields["Account"] = "rHb9CJAWyB4rj91VRWn96DkukG4bwdtyTh";
+        finalFields["Balance"] = "99999989999999990";
+        finalFields["Flags"] = 0;
+        finalFields["OwnerCount"] = 2;
+        finalFields["Sequence"] = 42;
+        fields["PreviousFields"]["Balance"] = "99999999999999990";
+        fields["PreviousFields"]["Sequence"] = 41;
+        return node;
+    }
+
+    static Json::Value makeTransaction ()
+    {
+        Json::Value tx (Json::objectValue);
+        tx["Account"] = "rHb9CJAWyB4rj91VRWn96DkukG4bwdtyTh";
+        tx["Amount"]["currency"] = "USD";
+        tx["Amount"]["issuer"] = "rvYAfWj5gh67oV6fW32ZzP3Aw4Eubs59B";
+        tx["Amount"]["value"] = "1000";
+        tx["Destination"] = "rPMh7Pi9ct699iZUTWaytJUoHcJ7cgyziK";
+        tx["Fee"] = "10";
+        tx["Flags"] = 0;
+        tx["Sequence"] = 41;
+        tx["SigningPubKey"] = "0330E7FC9D56BB25D6893BA3F317AE5BCF33B3291BD63DB32654A313222F7FD020";
+        tx["TransactionType"] = "Payment";
+        tx["TxnSignature"] = "3045022100D64A32A506B86E880480CCB846EFA3F9665C9B11FDCA35D7124F53C486CC1D0402206EC8663308D91C928D355ADEF2F3B4D44F2BA7F7A1E8B5E8D3B0E2B6E06C6B6E";
+        tx["hash"] = "0F84F1BB0B7C2D2B2A5D4CA9F6D1D3B7E1B0C8A9E9D4A7C3B9F5E2D1C0B4A3F2";
+        tx["ledger_index"] = 3510291;
+
+        Json::Value& meta (tx["metaData"]);
+        meta["TransactionIndex"] = 3;
+        meta["TransactionResult"] = "tesSUCCESS";
+        Json::Value& nodes (meta["AffectedNodes"]);
+        nodes.append (makeNode ("ModifiedNode", "13F1A95D7AAB7108D5CE7EEAF504B2894B8C674E6D68499076441C4837282BF8"));
+        nodes.append (makeNode ("ModifiedNode", "4EFC10F0C11B7B56D5A5AE29A9D55AE6F5A9D3E1F2B2C4D6E8F0A1B3C5D7E9F0"));
+        nodes.append (makeNode ("ModifiedNode", "7A8B9C0D1E2F3A4B5C6D7E8F9A0B1C2D3E4F5A6B7C8D9E0F1A2B3C4D5E6F7A8B"));
+        return tx;
+    }
+
+    template <class Function>
+    void measure (char const* name, Function f)
+    {
+        auto const start (std::chrono::steady_clock::now ());
+        for (int i = 0; i < iterations; ++i)
+            f ();
+        std::chrono::duration <double, std::micro> const elapsed (
+            std::chrono::steady_clock::now () - start);
+
+        String s;
+        s << name << ": " << String (elapsed.count () / iterations, 2) << "us";
+        logMessage (s);
+    }
+
+    void runTest ()
+    {
+        beginTestCase ("transaction");
+
+        Json::Value const tx (makeTransaction ());
+        std::string const text (Json::FastWriter ().write (tx));
+
+        measure ("parse", [&]
+        {
+            Json::Value value;
+            Json::Reader ().parse (text, value);
+        });
+
+        measure ("build", [&]
+        {
+            makeTransaction ();
+        });
+
+        measure ("serialize", [&]
+        {
+            Json::FastWriter ().write (tx);
+        });
+
+        Json::Value parsed;
+        expect (Json::Reader ().parse (text, parsed) && parsed == tx,
+            "Should parse what was written");
+    }
+
+    JsonValueTests () : UnitTest ("JsonValue", "ripple", runManual)
+    {
+    }
+};
+
+static JsonValueTests jsonValueTests;
+
 }
@@ -569,11 +569,13 @@ Reader::readObject ( Token& tokenStart )
                                         tokenObjectEnd );
         }
 
-        // Reject duplicate names
-        if (currentValue ().isMember (name))
+        // Reject duplicate names, which would not add a member
+        Value::UInt const size = currentValue ().size ();
+        Value& value = currentValue ()[ name ];
+
+        if (currentValue ().size () == size)
             return addError ( "Key '" + name + "' appears twice.", tokenName );
 
-        Value& value = currentValue ()[ name ];
         nodes_.push ( &value );
         bool ok = readValue ();
         nodes_.pop ();
@@ -749,12 +751,24 @@ Reader::decodeDouble( Token &token )
 bool
 Reader::decodeString ( Token& token )
 {
+    Location begin = token.start_ + 1;  // skip '"'
+    Location end = token.end_ - 1;      // do not include '"'
+
+    // A string without escapes is copied straight from the document
+    if ( std::find ( begin, end, '\\' ) == end )
+    {
+        Value value ( begin, end );
+        currentValue ().swap ( value );
+        return true;
+    }
+
     std::string decoded;
 
     if ( !decodeString ( token, decoded ) )
         return false;
 
-    currentValue () = decoded;
+    Value value ( decoded );
+    currentValue ().swap ( value );
     return true;
 }
 
@@ -762,10 +776,17 @@ Reader::decodeString ( Token& token )
 bool
 Reader::decodeString ( Token& token, std::string& decoded )
 {
-    decoded.reserve ( token.end_ - token.start_ - 2 );
     Location current = token.start_ + 1; // skip '"'
     Location end = token.end_ - 1;      // do not include '"'
 
+    if ( std::find ( current, end, '\\' ) == end )
+    {
+        decoded.assign ( current, end );
+        return true;
+    }
+
+    decoded.reserve ( token.end_ - token.start_ - 2 );
+
     while ( current != end )
     {
         Char c = *current++;
@@ -196,6 +196,13 @@ Value::CZString::CZString ( const CZString& other )
 {
 }
 
+Value::CZString::CZString ( CZString&& other ) noexcept
+    : cstr_ ( other.cstr_ )
+    , index_ ( other.index_ )
+{
+    other.cstr_ = 0;
+}
+
 Value::CZString::~CZString ()
 {
     if ( cstr_  &&  index_ == duplicate )
@@ -217,11 +224,21 @@ Value::CZString::operator = ( const CZString& other )
     return *this;
 }
 
+Value::CZString&
+Value::CZString::operator = ( CZString&& other ) noexcept
+{
+    swap ( other );
+    return *this;
+}
+
+// A static key is usually compared with itself, which
+// the pointer comparison settles without strcmp.
+
 bool
 Value::CZString::operator< ( const CZString& other ) const
 {
     if ( cstr_ )
-        return strcmp ( cstr_, other.cstr_ ) < 0;
+        return cstr_ != other.cstr_ && strcmp ( cstr_, other.cstr_ ) < 0;
 
     return index_ < other.index_;
 }
@@ -230,7 +247,7 @@ bool
 Value::CZString::operator== ( const CZString& other ) const
 {
     if ( cstr_ )
-        return strcmp ( cstr_, other.cstr_ ) == 0;
+        return cstr_ == other.cstr_ || strcmp ( cstr_, other.cstr_ ) == 0;
 
     return index_ == other.index_;
 }
@@ -255,6 +272,194 @@ Value::CZString::isStaticString () const
     return index_ == noDuplication;
 }
 
+
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class Value::ObjectValues
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+Value::ObjectValues::ObjectValues ()
+    : sorted_ ( 0 )
+{
+}
+
+Value::ObjectValues::ObjectValues ( const ObjectValues& other )
+    : sorted_ ( 0 )
+{
+    members_.reserve ( other.members_.size () );
+
+    // The copy is a single run
+    for ( const_iterator it = other.begin (); it != other.end (); ++it )
+    {
+        std::unique_ptr<Value> value ( new Value ( *it->second ) );
+        members_.push_back ( value_type ( it->first, value.get () ) );
+        value.release ();
+        ++sorted_;
+    }
+}
+
+Value::ObjectValues::~ObjectValues ()
+{
+    clear ();
+}
+
+void
+Value::ObjectValues::clear ()
+{
+    for ( std::vector<value_type>::iterator it = members_.begin (); it != members_.end (); ++it )
+        delete it->second;
+
+    members_.clear ();
+    sorted_ = 0;
+}
+
+bool
+Value::ObjectValues::lessKey ( const value_type& member, const CZString& key )
+{
+    return member.first < key;
+}
+
+bool
+Value::ObjectValues::lessMember ( const value_type& lhs, const value_type& rhs )
+{
+    return lhs.first < rhs.first;
+}
+
+Value::ObjectValues::iterator
+Value::ObjectValues::makeIterator ( std::size_t first, std::size_t second )
+{
+    value_type* const data = members_.data ();
+
+    return iterator ( data, data + sorted_, data + members_.size (),
+        data + first, data + second );
+}
+
+Value::ObjectValues::iterator
+Value::ObjectValues::find ( const CZString& key )
+{
+    std::vector<value_type>::iterator const split = members_.begin () + sorted_;
+
+    // Arrays are usually dense, so each index is at its own position
+    if ( !key.c_str () )
+    {
+        std::size_t const index = key.index ();
+
+        if ( index < sorted_  &&  members_[index].first.index () == key.index () )
+            return makeIterator ( index, std::lower_bound (
+                split, members_.end (), key, lessKey ) - members_.begin () );
+    }
+
+    std::vector<value_type>::iterator const first = std::lower_bound (
+        members_.begin (), split, key, lessKey );
+    std::vector<value_type>::iterator const second = std::lower_bound (
+        split, members_.end (), key, lessKey );
+
+    if ( ( first != split  &&  first->first == key )  ||
+         ( second != members_.end ()  &&  second->first == key ) )
+        return makeIterator ( first - members_.begin (), second - members_.begin () );
+
+    return end ();
+}
+
+Value::ObjectValues::const_iterator
+Value::ObjectValues::find ( const CZString& key ) const
+{
+    return const_cast<ObjectValues*> ( this )->find ( key );
+}
+
+Value&
+Value::ObjectValues::resolve ( const CZString& key )
+{
+    std::unique_ptr<Value> value;
+
+    if ( sorted_ == members_.size ()  &&
+         ( members_.empty ()  ||  members_.back ().first < key ) )
+    {
+        // Appending to an array adds the largest key
+        value.reset ( new Value () );
+        members_.push_back ( value_type ( key, value.get () ) );
+        ++sorted_;
+        return *value.release ();
+    }
+
+    iterator it = find ( key );
+
+    if ( it != end () )
+        return *it->second;
+
+    // New keys go into the short run, which only moves the members after
+    // them in that run.
+    value.reset ( new Value () );
+    members_.insert ( std::lower_bound ( members_.begin () + sorted_,
+        members_.end (), key, lessKey ), value_type ( key, value.get () ) );
+
+    std::size_t const recent = members_.size () - sorted_;
+
+    if ( recent > 16  &&  recent * recent > members_.size () )
+    {
+        std::inplace_merge ( members_.begin (), members_.begin () + sorted_,
+            members_.end (), lessMember );
+        sorted_ = members_.size ();
+    }
+
+    return *value.release ();
+}
+
+void
+Value::ObjectValues::erase ( iterator it )
+{
+    std::size_t const offset = it.offset ();
+
+    delete it->second;
+    members_.erase ( members_.begin () + offset );
+
+    if ( offset < sorted_ )
+        --sorted_;
+}
+
+bool
+Value::ObjectValues::operator== ( const ObjectValues& other ) const
+{
+    if ( size () != other.size () )
+        return false;
+
+    for ( const_iterator it = begin (), otherIt = other.begin (); it != end (); ++it, ++otherIt )
+    {
+        if ( !( it->first == otherIt->first )  ||  !( *it->second == *otherIt->second ) )
+            return false;
+    }
+
+    return true;
+}
+
+bool
+Value::ObjectValues::operator< ( const ObjectValues& other ) const
+{
+    // The same order as std::map
+    const_iterator it = begin ();
+    const_iterator otherIt = other.begin ();
+
+    for ( ; it != end ()  &&  otherIt != other.end (); ++it, ++otherIt )
+    {
+        if ( it->first < otherIt->first )
+            return true;
+
+        if ( otherIt->first < it->first )
+            return false;
+
+        if ( *it->second < *otherIt->second )
+            return true;
+
+        if ( *otherIt->second < *it->second )
+            return false;
+    }
+
+    return it == end ()  &&  otherIt != other.end ();
+}
+
 #endif // ifndef JSON_VALUE_USE_INTERNAL_MAP
 
 
@@ -1092,7 +1297,12 @@ Value::resize ( UInt newSize )
     else
     {
         for ( UInt index = newSize; index < oldSize; ++index )
-            value_.map_->erase ( index );
+        {
+            ObjectValues::iterator it = value_.map_->find ( CZString ( index ) );
+
+            if ( it != value_.map_->end () )
+                value_.map_->erase ( it );
+        }
 
         assert ( size () == newSize );
     }
@@ -1113,14 +1323,7 @@ Value::operator[] ( UInt index )
 
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
     CZString key ( index );
-    ObjectValues::iterator it = value_.map_->lower_bound ( key );
-
-    if ( it != value_.map_->end ()  &&  (*it).first == key )
-        return (*it).second;
-
-    ObjectValues::value_type defaultValue ( key, null );
-    it = value_.map_->insert ( it, defaultValue );
-    return (*it).second;
+    return value_.map_->resolve ( key );
 #else
     return value_.array_->resolveReference ( index );
 #endif
@@ -1142,7 +1345,7 @@ Value::operator[] ( UInt index ) const
     if ( it == value_.map_->end () )
         return null;
 
-    return (*it).second;
+    return *(*it).second;
 #else
     Value* value = value_.array_->find ( index );
     return value ? *value : null;
@@ -1169,15 +1372,7 @@ Value::resolveReference ( const char* key,
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
     CZString actualKey ( key, isStatic ? CZString::noDuplication
                          : CZString::duplicateOnCopy );
-    ObjectValues::iterator it = value_.map_->lower_bound ( actualKey );
-
-    if ( it != value_.map_->end ()  &&  (*it).first == actualKey )
-        return (*it).second;
-
-    ObjectValues::value_type defaultValue ( actualKey, null );
-    it = value_.map_->insert ( it, defaultValue );
-    Value& value = (*it).second;
-    return value;
+    return value_.map_->resolve ( actualKey );
 #else
     return value_.map_->resolveReference ( key, isStatic );
 #endif
@@ -1216,7 +1411,7 @@ Value::operator[] ( const char* key ) const
     if ( it == value_.map_->end () )
         return null;
 
-    return (*it).second;
+    return *(*it).second;
 #else
     const Value* value = value_.map_->find ( key );
     return value ? *value : null;
@@ -1298,7 +1493,7 @@ Value::removeMember ( const char* key )
     if ( it == value_.map_->end () )
         return null;
 
-    Value old (it->second);
+    Value old (*it->second);
     value_.map_->erase (it);
     return old;
 #else
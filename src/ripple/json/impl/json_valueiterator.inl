@@ -70,7 +70,7 @@ Value&
 ValueIteratorBase::deref () const
 {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-    return current_->second;
+    return *current_->second;
 #else
 
     if ( isArray_ )
@@ -115,34 +115,17 @@ ValueIteratorBase::difference_type
 ValueIteratorBase::computeDistance ( const SelfType& other ) const
 {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-# ifdef JSON_USE_CPPTL_SMALLMAP
-    return current_ - other.current_;
-# else
 
     // Iterator for null value are initialized using the default
-    // constructor, which initialize current_ to the default
-    // std::map::iterator. As begin() and end() are two instance
-    // of the default std::map::iterator, they can not be compared.
+    // constructor, which leaves current_ singular. As begin() and
+    // end() are two such iterators, they can not be compared.
     // To allow this, we handle this comparison specifically.
     if ( isNull_  &&  other.isNull_ )
     {
         return 0;
     }
 
-
-    // Usage of std::distance is not portable (does not compile with Sun Studio 12 RogueWave STL,
-    // which is the one used by default).
-    // Using a portable hand-made version for non random iterator instead:
-    //   return difference_type( std::distance( current_, other.current_ ) );
-    difference_type myDistance = 0;
-
-    for ( Value::ObjectValues::iterator it = current_; it != other.current_; ++it )
-    {
-        ++myDistance;
-    }
-
-    return myDistance;
-# endif
+    return difference_type ( other.current_ - current_ );
 #else
 
     if ( isArray_ )
@@ -252,22 +252,19 @@ FastWriter::writeValue ( const Value& value )
 
     case objectValue:
     {
-        Value::Members members ( value.getMemberNames () );
         document_ += "{";
 
-        for ( Value::Members::iterator it = members.begin ();
-                it != members.end ();
+        for ( Value::const_iterator it = value.begin ();
+                it != value.end ();
                 ++it )
         {
-            const std::string& name = *it;
-
-            if ( it != members.begin () )
+            if ( it != value.begin () )
                 document_ += ",";
 
-            document_ += valueToQuotedString ( name.c_str () );
+            document_ += valueToQuotedString ( it.memberName () );
             document_ += yamlCompatiblityEnabled_ ? ": "
                          : ":";
-            writeValue ( value[name] );
+            writeValue ( *it );
         }
 
         document_ += "}";
@@ -277,6 +274,217 @@ FastWriter::writeValue ( const Value& value )
 }
 
 
+// Class StreamWriter
+// //////////////////////////////////////////////////////////////////
+
+StreamWriter::StreamWriter ( Output const& output, std::size_t chunkSize )
+    : output_ ( output )
+    , chunkSize_ ( chunkSize )
+    , named_ ( false )
+{
+    buffer_.reserve ( chunkSize_ );
+}
+
+
+void
+StreamWriter::startObject ()
+{
+    separate ();
+    append ( "{" );
+    Level const level = { true, true };
+    levels_.push_back ( level );
+}
+
+
+void
+StreamWriter::startArray ()
+{
+    separate ();
+    append ( "[" );
+    Level const level = { false, true };
+    levels_.push_back ( level );
+}
+
+
+void
+StreamWriter::startObject ( std::string const& name )
+{
+    key ( name );
+    startObject ();
+}
+
+
+void
+StreamWriter::startArray ( std::string const& name )
+{
+    key ( name );
+    startArray ();
+}
+
+
+void
+StreamWriter::end ()
+{
+    JSON_ASSERT_MESSAGE ( !levels_.empty () && !named_, "StreamWriter::end unmatched" );
+
+    append ( levels_.back ().isObject ? "}" : "]" );
+    levels_.pop_back ();
+}
+
+
+void
+StreamWriter::key ( std::string const& name )
+{
+    JSON_ASSERT_MESSAGE ( !levels_.empty () && levels_.back ().isObject && !named_,
+                          "StreamWriter::key outside an object" );
+
+    if ( !levels_.back ().empty )
+        append ( "," );
+
+    levels_.back ().empty = false;
+    append ( valueToQuotedString ( name.c_str () ) );
+    append ( ":" );
+    named_ = true;
+}
+
+
+void
+StreamWriter::value ( const Value& value )
+{
+    separate ();
+    writeValue ( value );
+}
+
+
+void
+StreamWriter::member ( std::string const& name, const Value& value )
+{
+    key ( name );
+    this->value ( value );
+}
+
+
+void
+StreamWriter::members ( const Value& object )
+{
+    for ( Value::const_iterator it = object.begin (); it != object.end (); ++it )
+        member ( it.memberName (), *it );
+}
+
+
+void
+StreamWriter::flush ()
+{
+    if ( !buffer_.empty () )
+    {
+        output_ ( buffer_.data (), buffer_.size () );
+        buffer_.clear ();
+    }
+}
+
+
+// Emit the comma before a value, unless it follows its name
+void
+StreamWriter::separate ()
+{
+    if ( named_ )
+    {
+        named_ = false;
+        return;
+    }
+
+    if ( levels_.empty () )
+        return;
+
+    JSON_ASSERT_MESSAGE ( !levels_.back ().isObject,
+                          "StreamWriter value in an object without a name" );
+
+    if ( !levels_.back ().empty )
+        append ( "," );
+
+    levels_.back ().empty = false;
+}
+
+
+void
+StreamWriter::writeValue ( const Value& value )
+{
+    switch ( value.type () )
+    {
+    case nullValue:
+        append ( "null" );
+        break;
+
+    case intValue:
+        append ( valueToString ( value.asInt () ) );
+        break;
+
+    case uintValue:
+        append ( valueToString ( value.asUInt () ) );
+        break;
+
+    case realValue:
+        append ( valueToString ( value.asDouble () ) );
+        break;
+
+    case stringValue:
+        append ( valueToQuotedString ( value.asCString () ) );
+        break;
+
+    case booleanValue:
+        append ( valueToString ( value.asBool () ) );
+        break;
+
+    case arrayValue:
+    {
+        append ( "[" );
+        int size = value.size ();
+
+        for ( int index = 0; index < size; ++index )
+        {
+            if ( index > 0 )
+                append ( "," );
+
+            writeValue ( value[index] );
+        }
+
+        append ( "]" );
+    }
+    break;
+
+    case objectValue:
+    {
+        append ( "{" );
+
+        for ( Value::const_iterator it = value.begin ();
+                it != value.end ();
+                ++it )
+        {
+            if ( it != value.begin () )
+                append ( "," );
+
+            append ( valueToQuotedString ( it.memberName () ) );
+            append ( ":" );
+            writeValue ( *it );
+        }
+
+        append ( "}" );
+    }
+    break;
+    }
+}
+
+
+void
+StreamWriter::append ( std::string const& text )
+{
+    buffer_ += text;
+
+    if ( buffer_.size () >= chunkSize_ )
+        flush ();
+}
+
+
 // Class StyledWriter
 // //////////////////////////////////////////////////////////////////
 
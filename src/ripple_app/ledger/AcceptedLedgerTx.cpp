@@ -27,20 +27,17 @@ AcceptedLedgerTx::AcceptedLedgerTx (uint32 seq, SerializerIterator& sit)
     mMeta =     boost::make_shared<TransactionMetaSet> (mTxn->getTransactionID (), seq, mRawMeta);
     mAffected = mMeta->getAffectedAccounts ();
     mResult =   mMeta->getResultTER ();
-    buildJson ();
 }
 
 AcceptedLedgerTx::AcceptedLedgerTx (SerializedTransaction::ref txn, TransactionMetaSet::ref met) :
     mTxn (txn), mMeta (met), mAffected (met->getAffectedAccounts ())
 {
     mResult = mMeta->getResultTER ();
-    buildJson ();
 }
 
 AcceptedLedgerTx::AcceptedLedgerTx (SerializedTransaction::ref txn, TER result) :
     mTxn (txn), mResult (result), mAffected (txn->getMentionedAccounts ())
 {
-    buildJson ();
 }
 
 std::string AcceptedLedgerTx::getEscMeta () const
@@ -49,26 +46,28 @@ std::string AcceptedLedgerTx::getEscMeta () const
     return sqlEscape (mRawMeta);
 }
 
-void AcceptedLedgerTx::buildJson ()
+Json::Value AcceptedLedgerTx::getJson () const
 {
-    mJson = Json::objectValue;
-    mJson["transaction"] = mTxn->getJson (0);
+    Json::Value jvObj (Json::objectValue);
+    jvObj["transaction"] = mTxn->getJson (0);
 
     if (mMeta)
     {
-        mJson["meta"] = mMeta->getJson (0);
-        mJson["raw_meta"] = strHex (mRawMeta);
+        jvObj["meta"] = mMeta->getJson (0);
+        jvObj["raw_meta"] = strHex (mRawMeta);
     }
 
-    mJson["result"] = transHuman (mResult);
+    jvObj["result"] = transHuman (mResult);
 
     if (!mAffected.empty ())
     {
-        Json::Value& affected = (mJson["affected"] = Json::arrayValue);
+        Json::Value& affected = (jvObj["affected"] = Json::arrayValue);
         BOOST_FOREACH (const RippleAddress & ra, mAffected)
         {
             affected.append (ra.humanAccountID ());
         }
     }
+
+    return jvObj;
 }
 
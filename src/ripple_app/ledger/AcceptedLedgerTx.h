@@ -91,10 +91,11 @@ public:
         return mMeta ? mMeta->getIndex () : 0;
     }
     std::string getEscMeta () const;
-    Json::Value getJson () const
-    {
-        return mJson;
-    }
+
+    /** Describe the transaction for logging.
+        This is built on each call, publishing doesn't use it.
+    */
+    Json::Value getJson () const;
 
 private:
     SerializedTransaction::pointer  mTxn;
@@ -102,9 +103,6 @@ private:
     TER                             mResult;
     std::vector <RippleAddress>     mAffected;
     Blob        mRawMeta;
-    Json::Value                     mJson;
-
-    void buildJson ();
 };
 
 #endif
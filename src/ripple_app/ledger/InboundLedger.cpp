@@ -30,8 +30,38 @@ enum
 
     // how many timeouts before we get aggressive
     ,ledgerBecomeAggressiveThreshold = 6
+
+    // most and fewest missing nodes to ask for at once
+    ,missingNodesRequestMax = 256
+    ,missingNodesRequestMin = 32
+
+    // node store writes pending when we start asking for fewer nodes
+    ,writeLoadThrottleStart = 4096
+
+    // node store writes pending when we ask for the fewest
+    ,writeLoadThrottleFull = 32768
 };
 
+/** Returns the number of missing nodes to ask for in one request.
+    Every node received has to be written, so while the node store is
+    behind on writing we ask for fewer.
+*/
+static int getMissingNodesRequestLimit ()
+{
+    int const load (getApp().getNodeStore ().getWriteLoad ());
+
+    if (load <= writeLoadThrottleStart)
+        return missingNodesRequestMax;
+
+    if (load >= writeLoadThrottleFull)
+        return missingNodesRequestMin;
+
+    return missingNodesRequestMax - static_cast <int> (
+        int64 (missingNodesRequestMax - missingNodesRequestMin) *
+            (load - writeLoadThrottleStart) /
+                (writeLoadThrottleFull - writeLoadThrottleStart));
+}
+
 InboundLedger::InboundLedger (uint256 const& hash, uint32 seq,
     clock_type& clock)
     : PeerSet (hash, ledgerAcquireTimeoutMillis, false, clock,
@@ -108,6 +138,9 @@ bool InboundLedger::tryLocal ()
         // Nothing we can do without the ledger base
         NodeObject::pointer node = getApp().getNodeStore ().fetch (mHash);
 
+        if (!node && (mSeq != 0) && (getApp().getShardStore () != nullptr))
+            node = getApp().getShardStore ()->fetch (mHash, mSeq);
+
         if (!node)
         {
             Blob data;
@@ -123,8 +156,9 @@ bool InboundLedger::tryLocal ()
         }
         else
         {
-            mLedger = boost::make_shared<Ledger> (
-                strCopy (node->getData ()), true);
+            mLedger = boost::make_shared<Ledger> (std::string (
+                reinterpret_cast <char const*> (node->getData ()),
+                    node->getSize ()), true);
         }
 
         if (mLedger->getHash () != mHash)
@@ -136,6 +170,10 @@ bool InboundLedger::tryLocal ()
             return true;
         }
 
+        // Anything missing from the node store may be in the shard
+        mLedger->peekTransactionMap ()->setShardSeq (mLedger->getLedgerSeq ());
+        mLedger->peekAccountStateMap ()->setShardSeq (mLedger->getLedgerSeq ());
+
         mHaveBase = true;
     }
 
@@ -541,12 +579,12 @@ void InboundLedger::trigger (Peer::ref peer)
         {
             std::vector<SHAMapNode> nodeIDs;
             std::vector<uint256> nodeHashes;
-            // VFALCO Why 256? Make this a constant
-            nodeIDs.reserve (256);
-            nodeHashes.reserve (256);
+            int const limit (getMissingNodesRequestLimit ());
+            nodeIDs.reserve (limit);
+            nodeHashes.reserve (limit);
             AccountStateSF filter (mSeq);
             mLedger->peekAccountStateMap ()->getMissingNodes (
-                nodeIDs, nodeHashes, 256, &filter);
+                nodeIDs, nodeHashes, limit, &filter);
 
             if (nodeIDs.empty ())
             {
@@ -562,10 +600,9 @@ void InboundLedger::trigger (Peer::ref peer)
             }
             else
             {
-                // VFALCO Why 128? Make this a constant
                 if (!mAggressive)
                     filterNodes (nodeIDs, nodeHashes, mRecentASNodes,
-                        128, !isProgress ());
+                        limit / 2, !isProgress ());
 
                 if (!nodeIDs.empty ())
                 {
@@ -609,11 +646,12 @@ void InboundLedger::trigger (Peer::ref peer)
         {
             std::vector<SHAMapNode> nodeIDs;
             std::vector<uint256> nodeHashes;
-            nodeIDs.reserve (256);
-            nodeHashes.reserve (256);
+            int const limit (getMissingNodesRequestLimit ());
+            nodeIDs.reserve (limit);
+            nodeHashes.reserve (limit);
             TransactionStateSF filter (mSeq);
             mLedger->peekTransactionMap ()->getMissingNodes (
-                nodeIDs, nodeHashes, 256, &filter);
+                nodeIDs, nodeHashes, limit, &filter);
 
             if (nodeIDs.empty ())
             {
@@ -631,7 +669,7 @@ void InboundLedger::trigger (Peer::ref peer)
             {
                 if (!mAggressive)
                     filterNodes (nodeIDs, nodeHashes, mRecentTXNodes,
-                        128, !isProgress ());
+                        limit / 2, !isProgress ());
 
                 if (!nodeIDs.empty ())
                 {
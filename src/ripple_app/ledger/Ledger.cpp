@@ -753,6 +753,42 @@ Ledger::pointer Ledger::loadByHash (uint256 const& ledgerHash)
 
 #endif
 
+Ledger::pointer Ledger::loadFromShard (NodeStore::ShardStore& shards,
+    uint256 const& ledgerHash, uint32 ledgerIndex)
+{
+    // This is a low-level function with no caching
+    NodeObject::pointer node (shards.fetch (ledgerHash, ledgerIndex));
+    if (!node)
+        return Ledger::pointer ();
+
+    Ledger::pointer ledger (boost::make_shared <Ledger> (std::string (
+        reinterpret_cast <char const*> (node->getData ()),
+            node->getSize ()), true));
+
+    if ((ledger->getHash () != ledgerHash) || (ledger->getLedgerSeq () != ledgerIndex))
+    {
+        WriteLog (lsWARNING, Ledger) << "Shard holds a bad header for ledger " << ledgerIndex;
+        return Ledger::pointer ();
+    }
+
+    // The maps need the shard sequence before their roots can be read
+    ledger->setFull ();
+
+    ShardSF filter (shards, ledgerIndex);
+
+    if (!ledger->mTransactionMap->fetchRoot (ledger->mTransHash, &filter) ||
+        !ledger->mAccountStateMap->fetchRoot (ledger->mAccountHash, &filter))
+    {
+        WriteLog (lsWARNING, Ledger) << "Shard is missing a root for ledger " << ledgerIndex;
+        return Ledger::pointer ();
+    }
+
+    ledger->setClosed ();
+    ledger->setImmutable ();
+    ledger->setAccepted ();
+    return ledger;
+}
+
 Ledger::pointer Ledger::getSQL (const std::string& sql)
 {
     // only used with sqlite3 prepared statements not used
@@ -1011,14 +1047,11 @@ static void stateItemFullAppender(Json::Value& value, SLE::ref sle)
     value.append (sle->getJson (0));
 }
 
-Json::Value Ledger::getJson (int options)
+// Called with the ledger lock held
+void Ledger::addHeaderJson (Json::Value& ledger, int options)
 {
-    Json::Value ledger (Json::objectValue);
-
     bool bFull = isSetBit (options, LEDGER_JSON_FULL);
 
-    ScopedLockType sl (mLock, __FILE__, __LINE__);
-
     ledger["seqNum"]                = lexicalCastThrow <std::string> (mLedgerSeq); // DEPRECATED
 
     ledger["parent_hash"]           = mParentHash.GetHex ();
@@ -1052,6 +1085,52 @@ Json::Value Ledger::getJson (int options)
     {
         ledger["closed"] = false;
     }
+}
+
+Json::Value Ledger::getTransactionJson (SHAMapItem::ref item,
+    SHAMapTreeNode::TNType type, int options)
+{
+    if (isSetBit (options, LEDGER_JSON_FULL) || isSetBit (options, LEDGER_JSON_EXPAND))
+    {
+        if (type == SHAMapTreeNode::tnTRANSACTION_NM)
+        {
+            SerializerIterator sit (item->peekSerializer ());
+            SerializedTransaction txn (sit);
+            return txn.getJson (0);
+        }
+        else if (type == SHAMapTreeNode::tnTRANSACTION_MD)
+        {
+            SerializerIterator sit (item->peekSerializer ());
+            Serializer sTxn (sit.getVL ());
+
+            SerializerIterator tsit (sTxn);
+            SerializedTransaction txn (tsit);
+
+            TransactionMetaSet meta (item->getTag (), mLedgerSeq, sit.getVL ());
+            Json::Value txJson = txn.getJson (0);
+            txJson["metaData"] = meta.getJson (0);
+            return txJson;
+        }
+        else
+        {
+            Json::Value error = Json::objectValue;
+            error[item->getTag ().GetHex ()] = type;
+            return error;
+        }
+    }
+
+    return item->getTag ().GetHex ();
+}
+
+Json::Value Ledger::getJson (int options)
+{
+    Json::Value ledger (Json::objectValue);
+
+    bool bFull = isSetBit (options, LEDGER_JSON_FULL);
+
+    ScopedLockType sl (mLock, __FILE__, __LINE__);
+
+    addHeaderJson (ledger, options);
 
     if (mTransactionMap && (bFull || isSetBit (options, LEDGER_JSON_DUMP_TXRP)))
     {
@@ -1061,35 +1140,7 @@ Json::Value Ledger::getJson (int options)
         for (SHAMapItem::pointer item = mTransactionMap->peekFirstItem (type); !!item;
                 item = mTransactionMap->peekNextItem (item->getTag (), type))
         {
-            if (bFull || isSetBit (options, LEDGER_JSON_EXPAND))
-            {
-                if (type == SHAMapTreeNode::tnTRANSACTION_NM)
-                {
-                    SerializerIterator sit (item->peekSerializer ());
-                    SerializedTransaction txn (sit);
-                    txns.append (txn.getJson (0));
-                }
-                else if (type == SHAMapTreeNode::tnTRANSACTION_MD)
-                {
-                    SerializerIterator sit (item->peekSerializer ());
-                    Serializer sTxn (sit.getVL ());
-
-                    SerializerIterator tsit (sTxn);
-                    SerializedTransaction txn (tsit);
-
-                    TransactionMetaSet meta (item->getTag (), mLedgerSeq, sit.getVL ());
-                    Json::Value txJson = txn.getJson (0);
-                    txJson["metaData"] = meta.getJson (0);
-                    txns.append (txJson);
-                }
-                else
-                {
-                    Json::Value error = Json::objectValue;
-                    error[item->getTag ().GetHex ()] = type;
-                    txns.append (error);
-                }
-            }
-            else txns.append (item->getTag ().GetHex ());
+            txns.append (getTransactionJson (item, type, options));
         }
 
         ledger["transactions"] = txns;
@@ -1107,6 +1158,62 @@ Json::Value Ledger::getJson (int options)
     return ledger;
 }
 
+void Ledger::addJson (Json::StreamWriter& writer, int options)
+{
+    bool bFull = isSetBit (options, LEDGER_JSON_FULL);
+
+    // Only the header is read under the lock, the
+    // maps are written from snapshots of themselves.
+    Json::Value header (Json::objectValue);
+    SHAMap::pointer txMap;
+    {
+        ScopedLockType sl (mLock, __FILE__, __LINE__);
+
+        addHeaderJson (header, options);
+
+        if (mTransactionMap && (bFull || isSetBit (options, LEDGER_JSON_DUMP_TXRP)))
+            txMap = mTransactionMap->snapShot (false);
+    }
+
+    writer.startObject ("ledger");
+    writer.members (header);
+
+    if (txMap)
+    {
+        SHAMapTreeNode::TNType type;
+
+        writer.startArray ("transactions");
+        for (SHAMapItem::pointer item = txMap->peekFirstItem (type); !!item;
+                item = txMap->peekNextItem (item->getTag (), type))
+        {
+            writer.value (getTransactionJson (item, type, options));
+        }
+        writer.end ();
+    }
+
+    if (mAccountStateMap && (bFull || isSetBit (options, LEDGER_JSON_DUMP_STATE)))
+    {
+        writer.startArray ("accountState");
+        if (bFull || isSetBit (options, LEDGER_JSON_EXPAND))
+        {
+            visitStateItems ([&writer] (SLE::ref sle)
+            {
+                writer.value (sle->getJson (0));
+            });
+        }
+        else
+        {
+            mAccountStateMap->visitLeaves ([&writer] (SHAMapItem::ref item)
+            {
+                writer.value (item->getTag ().GetHex ());
+            });
+        }
+        writer.end ();
+    }
+
+    writer.end ();
+}
+
 void Ledger::setAcquiring (void)
 {
     if (!mTransactionMap || !mAccountStateMap) throw std::runtime_error ("invalid map");
@@ -2048,7 +2155,7 @@ public:
     {
     }
 
-    void runTest ()
+    void testQuality ()
     {
         beginTestCase ("uint256");
 
@@ -2057,6 +2164,96 @@ public:
         // VFALCO NOTE This fails in the original version as well.
         expect (6125895493223874560 == Ledger::getQuality (uBig));
     }
+
+    void testShard ()
+    {
+        beginTestCase ("shard");
+
+        std::unique_ptr <NodeStore::Manager> manager (NodeStore::make_Manager ());
+        NodeStore::DummyScheduler scheduler;
+
+        File const path (File::createTempFile ("node_db"));
+        StringPairArray params;
+        params.set ("type", "leveldb");
+        params.set ("path", path.getFullPathName ());
+
+        uint32 const ledgerIndex (5);
+
+        {
+            std::unique_ptr <NodeStore::ShardStore> shards (manager->make_ShardStore (
+                "test", scheduler, journal (), params));
+
+            // A state map with a few entries
+            SHAMap state (smtSTATE, getApp().getFullBelowCache ());
+            std::vector <SHAMapItem::pointer> items;
+            for (int i = 0; i < 8; ++i)
+            {
+                Serializer s;
+                s.add32 (i);
+                s.add32 (ledgerIndex);
+                items.push_back (boost::make_shared <SHAMapItem> (
+                    s.getSHA512Half (), s.peekData ()));
+                state.addItem (*items.back (), false, false);
+            }
+
+            state.getFetchPack (nullptr, true, 1000000,
+                [&shards, ledgerIndex] (uint256 const& hash, Blob const& blob)
+                {
+                    shards->store (NodeObject::createObject (
+                        hotACCOUNT_NODE, ledgerIndex, blob, hash), ledgerIndex);
+                });
+
+            // A header with no transactions
+            Serializer s;
+            s.add32 (HashPrefix::ledgerMaster);
+            s.add32 (ledgerIndex);
+            s.add64 (SYSTEM_CURRENCY_START);
+            s.add256 (uint256 ());
+            s.add256 (uint256 ());
+            s.add256 (state.getHash ());
+            s.add32 (0);
+            s.add32 (0);
+            s.add8 (LEDGER_TIME_ACCURACY);
+            s.add8 (0);
+            uint256 const hash (Ledger (s.getString (), true).getHash ());
+            shards->store (NodeObject::createObject (
+                hotLEDGER, ledgerIndex, s.peekData (), hash), ledgerIndex);
+            shards->setStored (ledgerIndex);
+
+            Ledger::pointer const ledger (Ledger::loadFromShard (*shards, hash, ledgerIndex));
+            expect (ledger != nullptr, "Should load the ledger");
+
+            if (ledger != nullptr)
+            {
+                expect (ledger->isAccepted (), "Should be accepted");
+                expect (ledger->getAccountHash () == state.getHash (), "Should have the state root");
+
+                // The running server reads the other nodes through the node
+                // store, which also looks in the shard. Here it is asked directly.
+                ShardSF filter (*shards, ledgerIndex);
+                expect (ledger->peekAccountStateMap ()->getNeededHashes (256, &filter).empty (),
+                    "Should find every node");
+
+                SHAMapItem::pointer const item (
+                    ledger->peekAccountStateMap ()->peekItem (items [3]->getTag ()));
+                expect (item && (item->peekData () == items [3]->peekData ()),
+                    "Should read the state entry");
+            }
+
+            // The wrong hash is refused
+            expect (Ledger::loadFromShard (*shards, state.getHash (), ledgerIndex) == nullptr,
+                "Should refuse a bad header");
+        }
+
+        path.deleteRecursively ();
+    }
+
+    void runTest ()
+    {
+        testQuality ();
+
+        testShard ();
+    }
 };
 
 static LedgerTests ledgerTests;
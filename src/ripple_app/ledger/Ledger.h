@@ -158,6 +158,8 @@ public:
     {
         mTransactionMap->setLedgerSeq (mLedgerSeq);
         mAccountStateMap->setLedgerSeq (mLedgerSeq);
+        mTransactionMap->setShardSeq (mLedgerSeq);
+        mAccountStateMap->setShardSeq (mLedgerSeq);
     }
 
     // ledger signature operations
@@ -270,6 +272,8 @@ public:
     // database functions (low-level)
     static Ledger::pointer loadByIndex (uint32 ledgerIndex);
     static Ledger::pointer loadByHash (uint256 const & ledgerHash);
+    static Ledger::pointer loadFromShard (NodeStore::ShardStore & shards,
+        uint256 const & ledgerHash, uint32 ledgerIndex);
     static uint256 getHashByIndex (uint32 index);
     static bool getHashesByIndex (uint32 index, uint256 & ledgerHash, uint256 & parentHash);
     static std::map< uint32, std::pair<uint256, uint256> > getHashesByIndex (uint32 minSeq, uint32 maxSeq);
@@ -463,6 +467,13 @@ public:
     Json::Value getJson (int options);
     void addJson (Json::Value&, int options);
 
+    /** Write the ledger as the member "ledger" of the current object.
+        The result is the same as addJson, but the transactions and
+        account state are written as they are visited instead of being
+        collected first.
+    */
+    void addJson (Json::StreamWriter& writer, int options);
+
     bool walkLedger ();
     bool assertSane ();
 
@@ -483,6 +494,10 @@ protected:
 private:
     void initializeFees ();
 
+    void addHeaderJson (Json::Value& ledger, int options);
+    Json::Value getTransactionJson (SHAMapItem::ref item,
+        SHAMapTreeNode::TNType type, int options);
+
 private:
     // The basic Ledger structure, can be opened, closed, or synching
     uint256     mHash;
@@ -29,11 +29,13 @@
 
 // FIXME: Need to clean up ledgers by index at some point
 
-LedgerHistory::LedgerHistory ()
+LedgerHistory::LedgerHistory (insight::Collector::ptr const& collector)
     : m_ledgers_by_hash ("LedgerCache", CACHED_LEDGER_NUM, CACHED_LEDGER_AGE,
-        get_seconds_clock (), LogPartition::getJournal <TaggedCacheLog> ())
+        get_seconds_clock (), LogPartition::getJournal <TaggedCacheLog> (),
+            collector)
     , m_consensus_validated ("ConsensusValidated", 64, 300,
-        get_seconds_clock (), LogPartition::getJournal <TaggedCacheLog> ())
+        get_seconds_clock (), LogPartition::getJournal <TaggedCacheLog> (),
+            collector)
 {
 }
 
@@ -24,7 +24,7 @@
 class LedgerHistory : LeakChecked <LedgerHistory>
 {
 public:
-    LedgerHistory ();
+    explicit LedgerHistory (insight::Collector::ptr const& collector);
 
     void addLedger (Ledger::pointer ledger, bool validated);
 
@@ -41,6 +41,12 @@ public:
 
     void tune (int size, int age);
 
+    void setSweepInterval (std::chrono::seconds interval)
+    {
+        m_ledgers_by_hash.setSweepInterval (interval);
+        m_consensus_validated.setSweepInterval (interval);
+    }
+
     void sweep ()
     {
         m_ledgers_by_hash.sweep ();
@@ -75,12 +75,17 @@ public:
     std::atomic <uint32> mValidLedgerClose;
     std::atomic <uint32> mValidLedgerSeq;
 
+    // When we started, to report how long the first validated ledger took
+    std::chrono::steady_clock::time_point const mStartTime;
+
     //--------------------------------------------------------------------------
 
-    explicit LedgerMasterImp (Stoppable& parent, Journal journal)
+    LedgerMasterImp (Stoppable& parent, Journal journal,
+        insight::Collector::ptr const& collector)
         : LedgerMaster (parent)
         , m_journal (journal)
         , m_mutex (this, "LedgerMaster", __FILE__, __LINE__)
+        , mLedgerHistory (collector)
         , mHeldTransactions (uint256 ())
         , mLedgerCleaner (LedgerCleaner::New(*this, LogPartition::getJournal<LedgerCleanerLog>()))
         , mMinValidations (0)
@@ -94,6 +99,7 @@ public:
         , mPubLedgerSeq (0)
         , mValidLedgerClose (0)
         , mValidLedgerSeq (0)
+        , mStartTime (std::chrono::steady_clock::now ())
     {
     }
 
@@ -351,6 +357,17 @@ public:
         return mCompleteLedgers.clearValue (seq);
     }
 
+    void clearPriorLedgers (uint32 seq)
+    {
+        ScopedLockType sl (mCompleteLock, __FILE__, __LINE__);
+
+        for (uint32 i = mCompleteLedgers.getFirst ();
+            (i != RangeSet::absent) && (i < seq); i = mCompleteLedgers.getNext (i))
+        {
+            mCompleteLedgers.clearValue (i);
+        }
+    }
+
     // returns Ledgers we have all the nodes for
     bool getFullValidatedRange (uint32& minVal, uint32& maxVal)
     {
@@ -690,6 +707,11 @@ public:
         setValidLedger(ledger);
         if (!mPubLedger)
         {
+            WriteLog (lsINFO, LedgerMaster) << "First validated ledger " <<
+                ledger->getLedgerSeq() << " after " <<
+                    std::chrono::duration_cast <std::chrono::milliseconds> (
+                        std::chrono::steady_clock::now () - mStartTime).count () << "ms";
+
             ledger->pendSaveValidated(true, true);
             setPubLedger(ledger);
             getApp().getOrderBookDB().setup(ledger);
@@ -1227,10 +1249,38 @@ public:
         if (ret && (ret->getLedgerSeq () == index))
             return ret;
 
+        ret = getLedgerFromShard (index);
+        if (ret)
+            return ret;
+
         clearLedger (index);
         return ret;
     }
 
+    /** Load a ledger whose nodes have been copied into a shard.
+        The shards only hold validated ledgers, so the ledger is
+        accepted and its maps look in the shard for missing nodes.
+    */
+    Ledger::pointer getLedgerFromShard (uint32 index)
+    {
+        Ledger::pointer ledger;
+
+        NodeStore::ShardStore* const shards (getApp().getShardStore ());
+        if ((shards == nullptr) || !shards->hasLedger (index))
+            return ledger;
+
+        uint256 const hash (getHashBySeq (index));
+        if (hash.isZero ())
+            return ledger;
+
+        ledger = Ledger::loadFromShard (*shards, hash, index);
+        if (!ledger)
+            return ledger;
+
+        mLedgerHistory.addLedger (ledger, true);
+        return ledger;
+    }
+
     Ledger::pointer getLedgerByHash (uint256 const& hash)
     {
         if (hash.isZero ())
@@ -1266,6 +1316,11 @@ public:
         mLedgerHistory.tune (size, age);
     }
 
+    void setSweepInterval (std::chrono::seconds interval)
+    {
+        mLedgerHistory.setSweepInterval (interval);
+    }
+
     void sweep ()
     {
         mLedgerHistory.sweep ();
@@ -1313,7 +1368,8 @@ bool LedgerMaster::shouldAcquire (
 }
 
 
-LedgerMaster* LedgerMaster::New (Stoppable& parent, Journal journal)
+LedgerMaster* LedgerMaster::New (Stoppable& parent, Journal journal,
+    insight::Collector::ptr const& collector)
 {
-    return new LedgerMasterImp (parent, journal);
+    return new LedgerMasterImp (parent, journal, collector);
 }
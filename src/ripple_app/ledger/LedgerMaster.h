@@ -41,7 +41,8 @@ public:
     typedef LockType::ScopedLockType ScopedLockType;
     typedef LockType::ScopedUnlockType ScopedUnlockType;
 
-    static LedgerMaster* New (Stoppable& parent, Journal journal);
+    static LedgerMaster* New (Stoppable& parent, Journal journal,
+        insight::Collector::ptr const& collector);
 
     virtual ~LedgerMaster () = 0;
 
@@ -115,10 +116,17 @@ public:
     virtual bool haveLedgerRange (uint32 from, uint32 to) = 0;
     virtual bool haveLedger (uint32 seq) = 0;
     virtual void clearLedger (uint32 seq) = 0;
+    /** Forget every complete ledger older than the given one. */
+    virtual void clearPriorLedgers (uint32 seq) = 0;
     virtual bool getValidatedRange (uint32& minVal, uint32& maxVal) = 0;
     virtual bool getFullValidatedRange (uint32& minVal, uint32& maxVal) = 0;
 
     virtual void tune (int size, int age) = 0;
+
+    /** Spread sweeps of the ledger caches over an interval.
+        @see TaggedCache::setSweepInterval
+    */
+    virtual void setSweepInterval (std::chrono::seconds interval) = 0;
     virtual void sweep () = 0;
     virtual float getCacheHitRate () = 0;
     virtual void addValidateCallback (callback& c) = 0;
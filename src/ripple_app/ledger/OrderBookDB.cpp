@@ -317,8 +317,8 @@ void BookListeners::removeSubscriber (uint64 seq)
 
 void BookListeners::publish (Json::Value const& jvObj)
 {
-    Json::FastWriter jfwWriter;
-    std::string sObj = jfwWriter.write (jvObj);
+    // Rendered for the first subscriber which is still connected
+    InfoSub::Message message;
 
     ScopedLockType sl (mLock, __FILE__, __LINE__);
     NetworkOPs::SubMapType::const_iterator it = mListeners.begin ();
@@ -329,7 +329,10 @@ void BookListeners::publish (Json::Value const& jvObj)
 
         if (p)
         {
-            p->send (jvObj, sObj, true);
+            if (! message)
+                message = InfoSub::makeMessage (jvObj);
+
+            p->send (jvObj, message, true);
             ++it;
         }
         else
@@ -56,6 +56,12 @@ class PathRequestLog;
 template <> char const* LogPartition::getPartitionName <PathRequestLog> () { return "PathRequest"; }
 class RPCManagerLog;
 template <> char const* LogPartition::getPartitionName <RPCManagerLog> () { return "RPCManager"; }
+class SigVerifierLog;
+template <> char const* LogPartition::getPartitionName <SigVerifierLog> () { return "SigVerifier"; }
+class NodeStoreRotatorLog;
+template <> char const* LogPartition::getPartitionName <NodeStoreRotatorLog> () { return "NodeStoreRotator"; }
+class ShardWriterLog;
+template <> char const* LogPartition::getPartitionName <ShardWriterLog> () { return "ShardWriter"; }
 
 template <> char const* LogPartition::getPartitionName <CollectorManager> () { return "Collector"; }
 
@@ -108,12 +114,13 @@ public:
     // These are not Stoppable-derived
     std::unique_ptr <NodeStore::Manager> m_nodeStoreManager;
 
+    std::unique_ptr <CollectorManager> m_collectorManager;
+
     NodeCache m_tempNodeCache;
     SLECache m_sleCache;
     LocalCredentials m_localCredentials;
     TransactionMaster m_txMaster;
 
-    std::unique_ptr <CollectorManager> m_collectorManager;
     std::unique_ptr <Resource::Manager> m_resourceManager;
     std::unique_ptr <FullBelowCache> m_fullBelowCache;
 
@@ -133,6 +140,9 @@ public:
     std::unique_ptr <RPCHTTPServer> m_rpcHTTPServer;
     RPCServerHandler m_rpcServerHandler;
     std::unique_ptr <NodeStore::Database> m_nodeStore;
+    std::unique_ptr <NodeStoreRotator> m_nodeStoreRotator;
+    std::unique_ptr <NodeStore::ShardStore> m_shardStore;
+    std::unique_ptr <ShardWriter> m_shardWriter;
     std::unique_ptr <SNTPClient> m_sntpClient;
     std::unique_ptr <TxQueue> m_txQueue;
     std::unique_ptr <Validators::Manager> m_validators;
@@ -140,10 +150,12 @@ public:
     std::unique_ptr <IFeeVote> mFeeVote;
     std::unique_ptr <LoadFeeTrack> mFeeTrack;
     std::unique_ptr <IHashRouter> mHashRouter;
+    std::unique_ptr <SigVerifier> m_sigVerifier;
     std::unique_ptr <Validations> mValidations;
     std::unique_ptr <ProofOfWorkFactory> mProofOfWorkFactory;
     std::unique_ptr <LoadManager> m_loadManager;
     DeadlineTimer m_sweepTimer;
+    DeadlineTimer m_cacheSweepTimer;
     bool volatile mShutdown;
 
     std::unique_ptr <DatabaseCon> mRpcDB;
@@ -213,15 +225,19 @@ public:
         , m_nodeStoreManager (NodeStore::make_Manager (
             std::move (make_Factories ())))
 
+        , m_collectorManager (CollectorManager::New (
+            getConfig().insightSettings,
+                LogPartition::getJournal <CollectorManager> ()))
+
         , m_tempNodeCache ("NodeCache", 16384, 90, get_seconds_clock (),
-            LogPartition::getJournal <TaggedCacheLog> ())
+            LogPartition::getJournal <TaggedCacheLog> (),
+                m_collectorManager->collector ())
 
         , m_sleCache ("LedgerEntryCache", 4096, 120, get_seconds_clock (),
-            LogPartition::getJournal <TaggedCacheLog> ())
+            LogPartition::getJournal <TaggedCacheLog> (),
+                m_collectorManager->collector ())
 
-        , m_collectorManager (CollectorManager::New (
-            getConfig().insightSettings,
-                LogPartition::getJournal <CollectorManager> ()))
+        , m_txMaster (m_collectorManager->collector ())
 
         , m_resourceManager (Resource::make_Manager (
             m_collectorManager->collector(),
@@ -259,7 +275,8 @@ public:
             LogPartition::getJournal <PathRequestLog> (), m_collectorManager->collector ()))
 
         , m_ledgerMaster (LedgerMaster::New (
-            *m_jobQueue, LogPartition::getJournal <LedgerMaster> ()))
+            *m_jobQueue, LogPartition::getJournal <LedgerMaster> (),
+                m_collectorManager->collector ()))
 
         // VFALCO NOTE must come before NetworkOPs to prevent a crash due
         //             to dependencies in the destructor.
@@ -281,7 +298,22 @@ public:
 
         , m_nodeStore (m_nodeStoreManager->make_Database ("NodeStore.main", m_nodeStoreScheduler,
             LogPartition::getJournal <NodeObject> (),
-                getConfig ().nodeDatabase, getConfig ().ephemeralNodeDatabase))
+                NodeStoreRotator::getCurrentParameters (getConfig ().nodeDatabase),
+                    getConfig ().ephemeralNodeDatabase,
+                        m_collectorManager->collector ()))
+
+        , m_nodeStoreRotator (NodeStoreRotator::New (*m_jobQueue, *m_nodeStoreManager,
+            m_nodeStoreScheduler, *m_nodeStore, getConfig ().nodeDatabase,
+                LogPartition::getJournal <NodeStoreRotatorLog> ()))
+
+        , m_shardStore ((getConfig ().shardDatabase.size () > 0)
+            ? m_nodeStoreManager->make_ShardStore ("NodeStore.shards",
+                m_nodeStoreScheduler, LogPartition::getJournal <NodeObject> (),
+                    getConfig ().shardDatabase)
+            : nullptr)
+
+        , m_shardWriter (ShardWriter::New (*m_jobQueue, m_shardStore.get (),
+            *m_nodeStore, LogPartition::getJournal <ShardWriterLog> ()))
 
         , m_sntpClient (SNTPClient::New (*this))
 
@@ -298,7 +330,12 @@ public:
 
         , mHashRouter (IHashRouter::New (IHashRouter::getDefaultHoldTime ()))
 
-        , mValidations (Validations::New ())
+        // Verdicts are handed off with addJob, so this is a JobQueue child
+        , m_sigVerifier (make_SigVerifier (*mHashRouter,
+            m_collectorManager->group ("sigv"), *m_jobQueue,
+                LogPartition::getJournal <SigVerifierLog> ()))
+
+        , mValidations (Validations::New (m_collectorManager->collector ()))
 
         , mProofOfWorkFactory (ProofOfWorkFactory::New ())
 
@@ -306,6 +343,8 @@ public:
 
         , m_sweepTimer (this)
 
+        , m_cacheSweepTimer (this)
+
         , mShutdown (false)
 
         , m_resolver (ResolverAsio::New (m_mainIoPool.getService (), Journal ()))
@@ -333,6 +372,8 @@ public:
         m_nodeStoreScheduler.setJobQueue (*m_jobQueue);
 
         add (m_ledgerMaster->getPropertySource ());
+        add (*m_nodeStoreRotator);
+        add (*m_shardWriter);
 
         // VFALCO TODO remove these once the call is thread safe.
         HashMaps::getInstance ().initializeNonce <size_t> ();
@@ -405,6 +446,11 @@ public:
         return *m_nodeStore;
     }
 
+    NodeStore::ShardStore* getShardStore ()
+    {
+        return m_shardStore.get ();
+    }
+
     Application::LockType& getMasterLock ()
     {
         return m_masterMutex;
@@ -465,6 +511,11 @@ public:
         return *mHashRouter;
     }
 
+    SigVerifier& getSigVerifier ()
+    {
+        return *m_sigVerifier;
+    }
+
     Validations& getValidations ()
     {
         return *mValidations;
@@ -562,6 +613,10 @@ public:
     {
         // VFALCO NOTE: 0 means use heuristics to determine the thread count.
         m_jobQueue->setThreadCount (0, getConfig ().RUN_STANDALONE);
+        m_sigVerifier->setThreadCount (0, getConfig ().RUN_STANDALONE);
+
+        if (! getConfig ().JOB_PERCENTILES.empty ())
+            m_jobQueue->setLatencyPercentiles (getConfig ().JOB_PERCENTILES);
 
     #if ! BEAST_WIN32
     #ifdef SIGINT
@@ -614,6 +669,8 @@ public:
 
         m_ledgerMaster->setMinValidations (getConfig ().VALIDATION_QUORUM);
 
+        loadHotSnapshot ();
+
         if (getConfig ().START_UP == Config::FRESH)
         {
             m_journal.info << "Starting new Ledger";
@@ -664,6 +721,20 @@ public:
         m_sleCache.setTargetAge (getConfig ().getSize (siSLECacheAge));
         SHAMap::setTreeCache (getConfig ().getSize (siTreeCacheSize), getConfig ().getSize (siTreeCacheAge));
 
+        // The large caches are swept a little every second, so that each
+        // pass is spread over the sweep interval instead of done at once.
+        {
+            std::chrono::seconds const interval (
+                getConfig ().getSize (siSweepInterval));
+
+            m_tempNodeCache.setSweepInterval (interval);
+            m_sleCache.setSweepInterval (interval);
+            m_txMaster.setSweepInterval (interval);
+            m_nodeStore->setSweepInterval (interval);
+            m_ledgerMaster->setSweepInterval (interval);
+            mValidations->setSweepInterval (interval);
+        }
+
 
         //----------------------------------------------------------------------
         //
@@ -845,6 +916,7 @@ public:
         m_journal.debug << "Application starting";
 
         m_sweepTimer.setExpiration (10);
+        m_cacheSweepTimer.setExpiration (cacheSweepSeconds);
 
         m_probe.sample (sample_io_service_latency (
             m_collectorManager->collector()->make_event (
@@ -876,6 +948,7 @@ public:
         m_resolver->stop ();
 
         m_sweepTimer.cancel ();
+        m_cacheSweepTimer.cancel ();
 
         // VFALCO TODO get rid of this flag
         mShutdown = true;
@@ -941,6 +1014,8 @@ public:
 
         doStop ();
 
+        saveHotSnapshot ();
+
         {
             // These two asssignment should no longer be necessary
             // once the WSDoor cancels its pending I/O correctly
@@ -997,17 +1072,16 @@ public:
             m_jobQueue->addJob(jtSWEEP, "sweep",
                 BIND_TYPE(&ApplicationImp::doSweep, this, P_1));
         }
+        else if (timer == m_cacheSweepTimer)
+        {
+            m_jobQueue->addJob(jtSWEEP, "sweepCaches",
+                BIND_TYPE(&ApplicationImp::doSweepCaches, this, P_1));
+        }
     }
 
-    void doSweep (Job& j)
+    // Each call sweeps the share of the caches due since the last one
+    void doSweepCaches (Job& j)
     {
-        // VFALCO NOTE Does the order of calls matter?
-        // VFALCO TODO fix the dependency inversion using an observer,
-        //         have listeners register for "onSweep ()" notification.
-        //
-
-        m_fullBelowCache->sweep ();
-
         logTimedCall (m_journal.warning, "TransactionMaster::sweep", __FILE__, __LINE__, boost::bind (
             &TransactionMaster::sweep, &m_txMaster));
 
@@ -1023,12 +1097,24 @@ public:
         logTimedCall (m_journal.warning, "Validations::sweep", __FILE__, __LINE__, boost::bind (
             &Validations::sweep, mValidations.get ()));
 
-        logTimedCall (m_journal.warning, "InboundLedgers::sweep", __FILE__, __LINE__, boost::bind (
-            &InboundLedgers::sweep, &getInboundLedgers ()));
-
         logTimedCall (m_journal.warning, "SLECache::sweep", __FILE__, __LINE__, boost::bind (
             &SLECache::sweep, &m_sleCache));
 
+        m_cacheSweepTimer.setExpiration (cacheSweepSeconds);
+    }
+
+    void doSweep (Job& j)
+    {
+        // VFALCO NOTE Does the order of calls matter?
+        // VFALCO TODO fix the dependency inversion using an observer,
+        //         have listeners register for "onSweep ()" notification.
+        //
+
+        m_fullBelowCache->sweep ();
+
+        logTimedCall (m_journal.warning, "InboundLedgers::sweep", __FILE__, __LINE__, boost::bind (
+            &InboundLedgers::sweep, &getInboundLedgers ()));
+
         logTimedCall (m_journal.warning, "AcceptedLedger::sweep", __FILE__, __LINE__,
             &AcceptedLedger::sweep);
 
@@ -1044,6 +1130,48 @@ public:
 
 
 private:
+    // Returns the file named by the node_db 'hot_snapshot' key
+    File getHotSnapshotFile ()
+    {
+        String const path (getConfig ().nodeDatabase ["hot_snapshot"]);
+
+        if (path.isEmpty ())
+            return File::nonexistent ();
+
+        return File::getCurrentWorkingDirectory ().getChildFile (path);
+    }
+
+    void loadHotSnapshot ()
+    {
+        File const file (getHotSnapshotFile ());
+
+        if (file != File::nonexistent ())
+            HotSnapshot::load (file, *m_nodeStore,
+                LogPartition::getJournal <NodeObject> ());
+    }
+
+    void saveHotSnapshot ()
+    {
+        File const file (getHotSnapshotFile ());
+
+        if (file == File::nonexistent ())
+            return;
+
+        uint256 stateRoot;
+        Ledger::pointer const ledger (m_ledgerMaster->getClosedLedger ());
+        if (ledger)
+            stateRoot = ledger->getAccountHash ();
+
+        // Save no more than the cache would have held
+        std::size_t limit (hotSnapshotObjects);
+        if (getConfig ().getSize (siNodeCacheSize) > 0)
+            limit = std::min <std::size_t> (limit,
+                getConfig ().getSize (siNodeCacheSize));
+
+        HotSnapshot::save (file, *m_nodeStore, stateRoot,
+            hotSnapshotLevels, limit, LogPartition::getJournal <NodeObject> ());
+    }
+
     void updateTables ();
     void startNewLedger ();
     bool loadOldLedger (const std::string&, bool);
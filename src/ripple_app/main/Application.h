@@ -35,6 +35,7 @@ class CollectorManager;
 class IFeatures;
 class IFeeVote;
 class IHashRouter;
+class SigVerifier;
 class LoadFeeTrack;
 class Peers;
 class UniqueNodeList;
@@ -92,6 +93,7 @@ public:
     virtual IFeatures&              getFeatureTable () = 0;
     virtual IFeeVote&               getFeeVote () = 0;
     virtual IHashRouter&            getHashRouter () = 0;
+    virtual SigVerifier&            getSigVerifier () = 0;
     virtual LoadFeeTrack&           getFeeTrack () = 0;
     virtual LoadManager&            getLoadManager () = 0;
     virtual Peers&                  getPeers () = 0;
@@ -99,6 +101,8 @@ public:
     virtual UniqueNodeList&         getUNL () = 0;
     virtual Validations&            getValidations () = 0;
     virtual NodeStore::Database&    getNodeStore () = 0;
+    /** Returns nullptr if there is no [shard_db] section. */
+    virtual NodeStore::ShardStore*  getShardStore () = 0;
     virtual InboundLedgers&         getInboundLedgers () = 0;
     virtual LedgerMaster&           getLedgerMaster () = 0;
     virtual NetworkOPs&             getOPs () = 0;
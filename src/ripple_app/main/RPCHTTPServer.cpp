@@ -152,8 +152,32 @@ public:
 
     void processSession (Job& job, HTTP::Session& session)
     {
-        session.write (m_deprecatedHandler.processRequest (
-            session.content(), session.remoteAddress().at_port(0)));
+        // HTTP/1.0 clients, like our own command line, don't understand
+        // chunks, so their replies end when the connection closes.
+        beast::HTTPVersion const& version (session.request()->version());
+        bool const chunked (version.vmajor() > 1 ||
+            (version.vmajor() == 1 && version.vminor() >= 1));
+
+        try
+        {
+            m_deprecatedHandler.processRequest (
+                session.content(), session.remoteAddress().at_port(0),
+                    chunked ? RPCServerHandler::framingChunked
+                            : RPCServerHandler::framingClose,
+                [&session] (char const* data, std::size_t bytes)
+                {
+                    session.write (data, bytes);
+
+                    // Keep the reply from getting far ahead of the client
+                    if (! session.waitForWrites (rpcUnsentBytesLimit))
+                        throw std::runtime_error ("connection failed");
+                });
+        }
+        catch (std::exception const& e)
+        {
+            // The reply is cut short, which the client sees as an error
+            m_journal.info << "RPC reply abandoned: " << e.what();
+        }
 
         session.close();
     }
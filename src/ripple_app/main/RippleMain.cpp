@@ -191,6 +191,7 @@ private:
         config->nodeDatabase = parseDelimitedKeyValueString ("type=memory");
         config->ephemeralNodeDatabase = StringPairArray ();
         config->importNodeDatabase = StringPairArray ();
+        config->shardDatabase = StringPairArray ();
     }
 
 private:
@@ -27,6 +27,37 @@ enum
     fullBelowTargetSize = 524288
 
     ,fullBelowExpirationSeconds = 240
+
+    // How often a share of each large cache is swept
+    ,cacheSweepSeconds = 1
+
+    // The fewest ledgers online_delete may be set to keep
+    ,onlineDeleteMinimumLedgers = 256
+
+    // Node store writes pending above which rotation stops copying
+    ,rotationWriteLoadLimit = 4096
+
+    // Objects read from the retiring backend at a time
+    ,rotationBatchSize = 256
+
+    // How often the rotator checks the validated ledger
+    ,rotationPollMilliseconds = 5000
+
+    // Shard store writes pending above which the shard writer waits
+    ,shardWriteLoadLimit = 4096
+
+    // How often the shard writer checks the validated ledger
+    ,shardPollMilliseconds = 5000
+
+    // Levels of the account state map saved in the hot snapshot
+    ,hotSnapshotLevels = 3
+
+    // Most objects saved in the hot snapshot
+    ,hotSnapshotObjects = 131072
+
+    // Bytes of an RPC reply which may wait to be sent before
+    // the reply stops being produced
+    ,rpcUnsentBytesLimit = 262144
 };
 
 }
@@ -0,0 +1,459 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+AccountSubscriptions::AccountSubscriptions ()
+    : m_size (0)
+{
+}
+
+void AccountSubscriptions::insert (InfoSub::ref subscriber,
+    boost::unordered_set <RippleAddress> const& accounts)
+{
+    uint64 const seq (subscriber->getSeq ());
+
+    BOOST_FOREACH (RippleAddress const& account, accounts)
+    {
+        uint160 const id (account.getAccountID ());
+        Shard& shard (getShard (id));
+        std::lock_guard <std::mutex> lock (shard.mutex);
+        std::shared_ptr <List const>& current (shard.map [id]);
+        std::shared_ptr <List> list;
+
+        if (current)
+        {
+            list = std::make_shared <List> (*current);
+        }
+        else
+        {
+            list = std::make_shared <List> ();
+            ++m_size;
+        }
+
+        auto item (std::find_if (list->begin (), list->end (),
+            [seq] (List::value_type const& item)
+            {
+                return item.first == seq;
+            }));
+
+        if (item != list->end ())
+            item->second = subscriber;
+        else
+            list->push_back (std::make_pair (seq, InfoSub::wptr (subscriber)));
+
+        current = list;
+    }
+}
+
+void AccountSubscriptions::erase (uint64 seq,
+    boost::unordered_set <RippleAddress> const& accounts)
+{
+    BOOST_FOREACH (RippleAddress const& account, accounts)
+    {
+        uint160 const id (account.getAccountID ());
+        Shard& shard (getShard (id));
+        std::lock_guard <std::mutex> lock (shard.mutex);
+        Map::iterator const found (shard.map.find (id));
+
+        if (found == shard.map.end ())
+            continue;
+
+        List const& current (*found->second);
+        std::shared_ptr <List> list (std::make_shared <List> ());
+        list->reserve (current.size ());
+        for (auto const& item : current)
+            if (item.first != seq)
+                list->push_back (item);
+
+        if (list->size () == current.size ())
+            continue;
+
+        if (list->empty ())
+        {
+            shard.map.erase (found);
+            --m_size;
+        }
+        else
+        {
+            found->second = list;
+        }
+    }
+}
+
+int AccountSubscriptions::collect (std::vector <RippleAddress> const& accounts,
+    SubscriberSet& subscribers) const
+{
+    int count (0);
+
+    BOOST_FOREACH (RippleAddress const& account, accounts)
+    {
+        uint160 const id (account.getAccountID ());
+        std::shared_ptr <List const> list;
+
+        {
+            Shard& shard (getShard (id));
+            std::lock_guard <std::mutex> lock (shard.mutex);
+            Map::const_iterator const found (shard.map.find (id));
+
+            if (found == shard.map.end ())
+                continue;
+
+            list = found->second;
+        }
+
+        for (auto const& item : *list)
+        {
+            InfoSub::pointer subscriber (item.second.lock ());
+
+            if (subscriber)
+            {
+                subscribers.insert (subscriber);
+                ++count;
+            }
+        }
+    }
+
+    return count;
+}
+
+bool AccountSubscriptions::empty () const
+{
+    return m_size.load () == 0;
+}
+
+std::size_t AccountSubscriptions::size () const
+{
+    return m_size.load ();
+}
+
+// Account IDs are hashes, so their first byte spreads them evenly
+AccountSubscriptions::Shard& AccountSubscriptions::getShard (uint160 const& account) const
+{
+    return m_shards [*account.begin ()];
+}
+
+//------------------------------------------------------------------------------
+
+class AccountSubscriptionsTests : public UnitTest
+{
+public:
+    struct TestSource : InfoSub::Source
+    {
+        explicit TestSource (Stoppable& parent)
+            : InfoSub::Source ("TestSource", parent)
+        {
+        }
+
+        void subAccount (InfoSub::ref, const boost::unordered_set<RippleAddress>&, uint32, bool) { }
+        void unsubAccount (uint64, const boost::unordered_set<RippleAddress>&, bool) { }
+        bool subLedger (InfoSub::ref, Json::Value&) { return true; }
+        bool unsubLedger (uint64) { return true; }
+        bool subServer (InfoSub::ref, Json::Value&) { return true; }
+        bool unsubServer (uint64) { return true; }
+        bool subBook (InfoSub::ref, RippleCurrency const&, RippleCurrency const&,
+            RippleIssuer const&, RippleIssuer const&) { return true; }
+        bool unsubBook (uint64, RippleCurrency const&, RippleCurrency const&,
+            RippleIssuer const&, RippleIssuer const&) { return true; }
+        bool subTransactions (InfoSub::ref) { return true; }
+        bool unsubTransactions (uint64) { return true; }
+        bool subRTTransactions (InfoSub::ref) { return true; }
+        bool unsubRTTransactions (uint64) { return true; }
+        InfoSub::pointer findRpcSub (const std::string&) { return InfoSub::pointer (); }
+        InfoSub::pointer addRpcSub (const std::string&, InfoSub::ref) { return InfoSub::pointer (); }
+    };
+
+    struct TestSubscriber : InfoSub
+    {
+        explicit TestSubscriber (Source& source)
+            : InfoSub (source, Consumer ())
+        {
+        }
+
+        void send (const Json::Value&, bool)
+        {
+        }
+    };
+
+    static RippleAddress makeAccount (uint64 n)
+    {
+        // Spread the test accounts over the shards like real ones
+        return RippleAddress::createAccountID (
+            uint160 (n * 0x9E3779B97F4A7C15ULL + 1));
+    }
+
+    static boost::unordered_set <RippleAddress> makeAccounts (
+        uint64 first, uint64 count)
+    {
+        boost::unordered_set <RippleAddress> accounts;
+        for (uint64 n = first; n < first + count; ++n)
+            accounts.insert (makeAccount (n));
+        return accounts;
+    }
+
+    void runTest ()
+    {
+        beginTestCase ("index");
+
+        RootStoppable stoppable ("AccountSubscriptionsTests");
+        TestSource source (stoppable);
+        AccountSubscriptions index;
+
+        InfoSub::pointer const a (boost::make_shared <TestSubscriber> (
+            boost::ref (source)));
+        InfoSub::pointer b (boost::make_shared <TestSubscriber> (
+            boost::ref (source)));
+
+        expect (index.empty ());
+
+        index.insert (a, makeAccounts (1, 2));
+        index.insert (b, makeAccounts (2, 2));
+        index.insert (b, makeAccounts (2, 1));
+        expect (index.size () == 3, "Should count each account once");
+
+        {
+            AccountSubscriptions::SubscriberSet subscribers;
+            std::vector <RippleAddress> accounts;
+            accounts.push_back (makeAccount (2));
+            expect (index.collect (accounts, subscribers) == 2);
+            expect (subscribers.size () == 2);
+        }
+
+        {
+            AccountSubscriptions::SubscriberSet subscribers;
+            std::vector <RippleAddress> accounts;
+            accounts.push_back (makeAccount (1));
+            accounts.push_back (makeAccount (3));
+            accounts.push_back (makeAccount (4));
+            expect (index.collect (accounts, subscribers) == 2);
+            expect (subscribers.size () == 2);
+        }
+
+        index.erase (a->getSeq (), makeAccounts (1, 2));
+        expect (index.size () == 2);
+
+        {
+            AccountSubscriptions::SubscriberSet subscribers;
+            std::vector <RippleAddress> accounts;
+            accounts.push_back (makeAccount (1));
+            accounts.push_back (makeAccount (2));
+            expect (index.collect (accounts, subscribers) == 1);
+            expect (subscribers.count (b) == 1, "Should find the remaining subscriber");
+        }
+
+        {
+            // A subscriber which is gone is skipped
+            b.reset ();
+            AccountSubscriptions::SubscriberSet subscribers;
+            std::vector <RippleAddress> accounts;
+            accounts.push_back (makeAccount (2));
+            expect (index.collect (accounts, subscribers) == 0);
+            expect (subscribers.empty ());
+        }
+    }
+
+    AccountSubscriptionsTests () : UnitTest ("AccountSubscriptions", "ripple")
+    {
+    }
+};
+
+static AccountSubscriptionsTests accountSubscriptionsTests;
+
+//------------------------------------------------------------------------------
+
+/** Measures looking up account subscribers while subscriptions change. */
+class AccountSubscriptionsTimingTests : public UnitTest
+{
+public:
+    typedef AccountSubscriptionsTests::TestSubscriber TestSubscriber;
+
+    enum
+    {
+        numAccounts = 100000
+        ,accountsPerSubscriber = 10
+        ,affectedPerTransaction = 4
+        ,churnAccounts = 1000
+        ,millisecondsPerRun = 1000
+    };
+
+    // The index NetworkOPs used before, for comparison
+    class LockedIndex
+    {
+    public:
+        void insert (InfoSub::ref subscriber,
+            boost::unordered_set <RippleAddress> const& accounts)
+        {
+            std::lock_guard <std::mutex> lock (m_mutex);
+            BOOST_FOREACH (RippleAddress const& account, accounts)
+                m_map [account.getAccountID ()][subscriber->getSeq ()] = subscriber;
+        }
+
+        void erase (uint64 seq,
+            boost::unordered_set <RippleAddress> const& accounts)
+        {
+            std::lock_guard <std::mutex> lock (m_mutex);
+            BOOST_FOREACH (RippleAddress const& account, accounts)
+            {
+                Map::iterator const found (m_map.find (account.getAccountID ()));
+                if (found != m_map.end ())
+                {
+                    found->second.erase (seq);
+                    if (found->second.empty ())
+                        m_map.erase (found);
+                }
+            }
+        }
+
+        int collect (std::vector <RippleAddress> const& accounts,
+            AccountSubscriptions::SubscriberSet& subscribers)
+        {
+            int count (0);
+            std::lock_guard <std::mutex> lock (m_mutex);
+            BOOST_FOREACH (RippleAddress const& account, accounts)
+            {
+                Map::iterator const found (m_map.find (account.getAccountID ()));
+                if (found == m_map.end ())
+                    continue;
+                for (auto const& item : found->second)
+                {
+                    InfoSub::pointer subscriber (item.second.lock ());
+                    if (subscriber)
+                    {
+                        subscribers.insert (subscriber);
+                        ++count;
+                    }
+                }
+            }
+            return count;
+        }
+
+    private:
+        typedef boost::unordered_map <uint160, NetworkOPs::SubMapType> Map;
+
+        std::mutex m_mutex;
+        Map m_map;
+    };
+
+    AccountSubscriptionsTimingTests ()
+        : UnitTest ("AccountSubscriptionsTiming", "ripple", runManual)
+    {
+    }
+
+    template <class Index>
+    void subscribe (String const& name, Index& index,
+        std::vector <InfoSub::pointer> const& subscribers)
+    {
+        int64 const start (Time::getHighResolutionTicks ());
+        for (std::size_t i = 0; i < subscribers.size (); ++i)
+            index.insert (subscribers [i], AccountSubscriptionsTests::makeAccounts (
+                i * accountsPerSubscriber, accountsPerSubscriber));
+        double const elapsed (Time::highResolutionTicksToSeconds (
+            Time::getHighResolutionTicks () - start));
+
+        logMessage (name + " subscribe: " +
+            String (int64 (elapsed * 1000)) + " ms");
+    }
+
+    // Publishes on this thread while another keeps subscribing and
+    // unsubscribing a client to many accounts.
+    template <class Index>
+    void publish (String const& name, Index& index, InfoSub::ref churn,
+        boost::unordered_set <RippleAddress> const& churnAccounts)
+    {
+        std::atomic <bool> done (false);
+        std::size_t changes (0);
+
+        std::thread writer ([&]
+        {
+            while (! done)
+            {
+                index.insert (churn, churnAccounts);
+                index.erase (churn->getSeq (), churnAccounts);
+                ++changes;
+            }
+        });
+
+        std::size_t total (0);
+        int64 const start (Time::getHighResolutionTicks ());
+        double elapsed (0);
+        for (uint64 n (0); elapsed * 1000 < millisecondsPerRun; ++total)
+        {
+            // Half the affected accounts have no subscribers
+            std::vector <RippleAddress> accounts;
+            for (int i = 0; i < affectedPerTransaction; ++i)
+                accounts.push_back (AccountSubscriptionsTests::makeAccount (
+                    (n++ * 7919) % (2 * numAccounts)));
+
+            AccountSubscriptions::SubscriberSet found;
+            index.collect (accounts, found);
+
+            elapsed = Time::highResolutionTicksToSeconds (
+                Time::getHighResolutionTicks () - start);
+        }
+
+        done = true;
+        writer.join ();
+
+        logMessage (name + ": " +
+            String (int64 (total / elapsed)) + " transactions/s, " +
+            String (int64 (changes / elapsed)) + " subscription changes/s");
+    }
+
+    template <class Index>
+    void measure (String const& name, Index& index,
+        std::vector <InfoSub::pointer> const& subscribers, InfoSub::ref churn)
+    {
+        subscribe (name, index, subscribers);
+
+        // Accounts which other clients watch, and accounts which nobody does
+        publish (name + " churning watched accounts", index, churn,
+            AccountSubscriptionsTests::makeAccounts (0, churnAccounts));
+        publish (name + " churning new accounts", index, churn,
+            AccountSubscriptionsTests::makeAccounts (numAccounts, churnAccounts));
+    }
+
+    void runTest ()
+    {
+        beginTestCase ("timing");
+
+        RootStoppable stoppable ("AccountSubscriptionsTimingTests");
+        AccountSubscriptionsTests::TestSource source (stoppable);
+
+        std::vector <InfoSub::pointer> subscribers;
+        for (int i = 0; i < numAccounts / accountsPerSubscriber; ++i)
+            subscribers.push_back (boost::make_shared <TestSubscriber> (
+                boost::ref (source)));
+        InfoSub::pointer const churn (boost::make_shared <TestSubscriber> (
+            boost::ref (source)));
+
+        logMessage (String (int (numAccounts)) + " accounts, " +
+            String (int (subscribers.size ())) + " subscribers");
+
+        {
+            LockedIndex index;
+            measure ("locked map", index, subscribers, churn);
+        }
+
+        {
+            AccountSubscriptions index;
+            measure ("AccountSubscriptions", index, subscribers, churn);
+            expect (index.size () == numAccounts);
+        }
+    }
+};
+
+static AccountSubscriptionsTimingTests accountSubscriptionsTimingTests;
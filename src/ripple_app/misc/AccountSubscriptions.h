@@ -0,0 +1,87 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_APP_ACCOUNTSUBSCRIPTIONS_H_INCLUDED
+#define RIPPLE_APP_ACCOUNTSUBSCRIPTIONS_H_INCLUDED
+
+/** Index from accounts to the subscribers watching them.
+
+    The index is split into shards by account, each with its own mutex.
+    An account's subscribers are an immutable list which is replaced when
+    they change, so a lookup holds the shard's mutex only long enough to
+    find the list and never while visiting the subscribers.
+*/
+class AccountSubscriptions : public Uncopyable
+{
+public:
+    typedef boost::unordered_set <InfoSub::pointer> SubscriberSet;
+
+    AccountSubscriptions ();
+
+    /** Subscribe to each of a set of accounts. */
+    void insert (InfoSub::ref subscriber,
+        boost::unordered_set <RippleAddress> const& accounts);
+
+    /** Remove a subscriber from each of a set of accounts. */
+    void erase (uint64 seq,
+        boost::unordered_set <RippleAddress> const& accounts);
+
+    /** Add the subscribers to any of the accounts to a set.
+        Subscribers which no longer exist are skipped.
+
+        @note This can be called concurrently.
+        @return The number of subscriptions which matched.
+    */
+    int collect (std::vector <RippleAddress> const& accounts,
+        SubscriberSet& subscribers) const;
+
+    /** Returns `true` if no account has a subscriber. */
+    bool empty () const;
+
+    /** Returns the number of accounts which have subscribers. */
+    std::size_t size () const;
+
+private:
+    enum
+    {
+        // One shard for each value of an account's first byte
+        shardCount = 256
+    };
+
+    // The subscribers to one account, by sequence number
+    typedef std::vector <std::pair <uint64, InfoSub::wptr> > List;
+
+    // Accounts and their subscribers
+    typedef boost::unordered_map <uint160,
+        std::shared_ptr <List const> > Map;
+
+    struct Shard
+    {
+        std::mutex mutex;
+        Map map;
+    };
+
+    Shard& getShard (uint160 const& account) const;
+
+    // Lookups lock the shards too
+    mutable Shard m_shards [shardCount];
+    std::atomic <std::size_t> m_size;
+};
+
+#endif
@@ -20,6 +20,7 @@
 class NetworkOPsImp
     : public NetworkOPs
     , public DeadlineTimer::Listener
+    , private Thread
     , public LeakChecked <NetworkOPsImp>
 {
 public:
@@ -30,12 +31,25 @@ public:
         NO_NETWORK  = 2,
     };
 
+    enum
+    {
+        // Most proposed transactions waiting for the publisher thread.
+        // Each holds the open ledger it applied to, so a slow publisher
+        // would otherwise keep every recent ledger in memory.
+        publishTransactionLimit = 2000
+
+        // Most accepted ledgers waiting for the publisher thread,
+        // beyond which the caller waits for room
+        ,publishLedgerLimit = 8
+    };
+
 public:
     // VFALCO TODO Make LedgerMaster a SharedPtr or a reference.
     //
     NetworkOPsImp (clock_type& clock, LedgerMaster& ledgerMaster,
         Stoppable& parent, Journal journal)
         : NetworkOPs (parent)
+        , Thread ("NetworkOPs")
         , m_clock (clock)
         , m_journal (journal)
         , mLock (this, "NetOPs", __FILE__, __LINE__)
@@ -62,6 +76,7 @@ public:
 
     ~NetworkOPsImp ()
     {
+        stopThread ();
     }
 
     // network information
@@ -148,6 +163,7 @@ public:
     //
     typedef std::function<void (Transaction::pointer, TER)> stCallback; // must complete immediately
     void submitTransaction (Job&, SerializedTransaction::pointer, stCallback callback = stCallback ());
+    void onSubmitVerified (SerializedTransaction::pointer, bool good, stCallback callback);
     Transaction::pointer submitTransactionSync (Transaction::ref tpTrans, bool bAdmin, bool bFailHard, bool bSubmit);
 
     void runTransactionQueue ();
@@ -380,12 +396,25 @@ public:
     //
     // Stoppable
     
+    void onStart ()
+    {
+        startThread ();
+    }
+
     void onStop ()
     {
         m_heartbeatTimer.cancel();
         m_clusterTimer.cancel();
 
-        stopped ();
+        if (isThreadRunning ())
+        {
+            signalThreadShouldExit ();
+            notify ();
+        }
+        else
+        {
+            stopped ();
+        }
     }
 
 private:
@@ -407,12 +436,17 @@ private:
 
     void pubServer ();
 
+    void publish (std::function <void ()> const& work, bool isLedger);
+    void runPublish (std::function <void ()> const& work);
+    void doPubLedger (Ledger::pointer lpAccepted);
+    void doPubProposedTransaction (Ledger::pointer lpCurrent,
+        SerializedTransaction::pointer stTxn, TER terResult);
+
+    void run ();
+
 private:
     clock_type& m_clock;
 
-    typedef boost::unordered_map <uint160, SubMapType>               SubInfoMapType;
-    typedef boost::unordered_map <uint160, SubMapType>::iterator     SubInfoMapIterator;
-
     typedef boost::unordered_map<std::string, InfoSub::pointer>     subRpcMapType;
 
     // XXX Split into more locks.
@@ -448,8 +482,8 @@ private:
     // Recent positions taken
     std::map<uint256, std::pair<int, SHAMap::pointer> > mRecentPositions;
 
-    SubInfoMapType                                      mSubAccount;
-    SubInfoMapType                                      mSubRTAccount;
+    AccountSubscriptions                                mSubAccount;
+    AccountSubscriptions                                mSubRTAccount;
 
     subRpcMapType                                       mRpcSubMap;
 
@@ -463,6 +497,31 @@ private:
 
     uint32                                              mLastLoadBase;
     uint32                                              mLastLoadFactor;
+
+    // Publishing waiting for the publisher thread
+    struct PublishState
+    {
+        PublishState ()
+            : ledgers (0)
+            , transactions (0)
+            , dropped (0)
+            , stopped (false)
+        {
+        }
+
+        // Work and whether it publishes a ledger, oldest first
+        std::deque <std::pair <std::function <void ()>, bool> > queue;
+
+        int ledgers;                    // Ledgers in the queue
+        int transactions;               // Transactions in the queue
+        std::size_t dropped;            // Transactions dropped since last reported
+        bool stopped;                   // The publisher thread has exited
+    };
+
+    std::mutex                                          m_publishMutex;
+    // Signalled when a ledger leaves the queue
+    std::condition_variable                             m_publishSpace;
+    PublishState                                        m_publish;
 };
 
 //------------------------------------------------------------------------------
@@ -731,22 +790,23 @@ void NetworkOPsImp::submitTransaction (Job&, SerializedTransaction::pointer iTra
 
     if ((flags & SF_SIGGOOD) == 0)
     {
-        try
-        {
-            if (!trans->checkSign ())
-            {
-                m_journal.warning << "Submitted transaction has bad signature";
-                getApp().getHashRouter ().setFlag (suppress, SF_BAD);
-                return;
-            }
+        // The verifier caches the verdict in the HashRouter
+        getApp().getSigVerifier ().verify (trans, std::bind (
+            &NetworkOPsImp::onSubmitVerified, this, std::placeholders::_1,
+                std::placeholders::_2, callback));
+        return;
+    }
 
-            getApp().getHashRouter ().setFlag (suppress, SF_SIGGOOD);
-        }
-        catch (...)
-        {
-            m_journal.warning << "Exception checking transaction " << suppress;
-            return;
-        }
+    onSubmitVerified (trans, true, callback);
+}
+
+void NetworkOPsImp::onSubmitVerified (SerializedTransaction::pointer trans,
+    bool good, stCallback callback)
+{
+    if (! good)
+    {
+        m_journal.warning << "Submitted transaction has bad signature";
+        return;
     }
 
     getApp().getJobQueue().addJob (jtTRANSACTION, "submitTxn",
@@ -1624,8 +1684,7 @@ void NetworkOPsImp::pubServer ()
         jvObj ["load_base"]     = (mLastLoadBase = getApp().getFeeTrack ().getLoadBase ());
         jvObj ["load_factor"]   = (mLastLoadFactor = getApp().getFeeTrack ().getLoadFactor ());
 
-        Json::FastWriter w;
-        std::string sObj = w.write (jvObj);
+        InfoSub::Message const message (InfoSub::makeMessage (jvObj));
 
         NetworkOPsImp::SubMapType::const_iterator it = mSubServer.begin ();
 
@@ -1637,7 +1696,7 @@ void NetworkOPsImp::pubServer ()
             //             the deletion of subscribers with the sending of JSON data.
             if (p)
             {
-                p->send (jvObj, sObj, true);
+                p->send (jvObj, message, true);
 
                 ++it;
             }
@@ -2157,8 +2216,16 @@ Json::Value NetworkOPsImp::getServerInfo (bool human, bool admin)
     //      info["consensus"] = mConsensus->getJson();
 
     if (admin)
+    {
         info["load"] = getApp().getJobQueue ().getJson ();
 
+        Json::Value& nodeCache (info["node_cache"] = Json::objectValue);
+        nodeCache["hit_rate"] =
+            getApp().getNodeStore ().getCacheHitRate ();
+        nodeCache["compressed_hit_rate"] =
+            getApp().getNodeStore ().getCompressedCacheHitRate ();
+    }
+
     if (!human)
     {
         info["load_base"] = getApp().getFeeTrack ().getLoadBase ();
@@ -2272,33 +2339,169 @@ Json::Value NetworkOPsImp::pubBootstrapAccountInfo (Ledger::ref lpAccepted, cons
     return jvObj;
 }
 
+// When the publisher falls behind, new proposed transactions are dropped
+// and callers publishing a ledger wait for room. Validated ledgers are
+// never dropped, so subscribers see every one of them in order.
+void NetworkOPsImp::publish (std::function <void ()> const& work, bool isLedger)
+{
+    {
+        std::unique_lock <std::mutex> lock (m_publishMutex);
+
+        if (isLedger)
+        {
+            m_publishSpace.wait (lock, [this] {
+                return (m_publish.ledgers < publishLedgerLimit) ||
+                    m_publish.stopped; });
+
+            if (m_publish.stopped)
+            {
+                // Nobody is left to run it, so it runs here
+                lock.unlock ();
+                runPublish (work);
+                return;
+            }
+
+            ++m_publish.ledgers;
+        }
+        else
+        {
+            if (m_publish.stopped ||
+                (m_publish.transactions >= publishTransactionLimit))
+            {
+                ++m_publish.dropped;
+                return;
+            }
+
+            ++m_publish.transactions;
+        }
+
+        m_publish.queue.push_back (std::make_pair (work, isLedger));
+    }
+
+    notify ();
+}
+
+void NetworkOPsImp::runPublish (std::function <void ()> const& work)
+{
+    try
+    {
+        work ();
+    }
+    catch (std::exception const& e)
+    {
+        m_journal.warning << "Publishing failed: " << e.what ();
+    }
+}
+
+// Subscribers are notified on the publisher thread, in the order events
+// are published, so that closing and accepting ledgers never waits on them.
+// When stopping, everything already queued is published before it exits.
+void NetworkOPsImp::run ()
+{
+    for (;;)
+    {
+        std::function <void ()> work;
+        std::size_t dropped (0);
+        bool stopping (false);
+
+        {
+            std::lock_guard <std::mutex> lock (m_publishMutex);
+
+            if (! m_publish.queue.empty ())
+            {
+                work = std::move (m_publish.queue.front ().first);
+
+                if (m_publish.queue.front ().second)
+                {
+                    --m_publish.ledgers;
+                    m_publishSpace.notify_all ();
+                }
+                else
+                {
+                    --m_publish.transactions;
+                }
+
+                m_publish.queue.pop_front ();
+            }
+            else if (threadShouldExit ())
+            {
+                m_publish.stopped = true;
+                m_publishSpace.notify_all ();
+                stopping = true;
+            }
+
+            std::swap (dropped, m_publish.dropped);
+        }
+
+        if (dropped != 0)
+            m_journal.warning << "Publishing fell behind, dropped " <<
+                dropped << " proposed transactions";
+
+        if (stopping)
+            break;
+
+        if (! work)
+        {
+            wait ();
+            continue;
+        }
+
+        runPublish (work);
+    }
+
+    stopped ();
+}
+
 void NetworkOPsImp::pubProposedTransaction (Ledger::ref lpCurrent, SerializedTransaction::ref stTxn, TER terResult)
 {
-    Json::Value jvObj   = transJson (*stTxn, terResult, false, lpCurrent);
+    publish (std::bind (&NetworkOPsImp::doPubProposedTransaction, this,
+        lpCurrent, stTxn, terResult), false);
+}
 
+void NetworkOPsImp::doPubProposedTransaction (Ledger::pointer lpCurrent,
+    SerializedTransaction::pointer stTxn, TER terResult)
+{
     {
         ScopedLockType sl (mLock, __FILE__, __LINE__);
-        NetworkOPsImp::SubMapType::const_iterator it = mSubRTTransactions.begin ();
 
-        while (it != mSubRTTransactions.end ())
+        if (!mSubRTTransactions.empty ())
         {
-            InfoSub::pointer p = it->second.lock ();
+            Json::Value jvObj   = transJson (*stTxn, terResult, false, lpCurrent);
 
-            if (p)
+            // Rendered for the first subscriber which is still connected
+            InfoSub::Message message;
+
+            NetworkOPsImp::SubMapType::const_iterator it = mSubRTTransactions.begin ();
+
+            while (it != mSubRTTransactions.end ())
             {
-                p->send (jvObj, true);
-                ++it;
+                InfoSub::pointer p = it->second.lock ();
+
+                if (p)
+                {
+                    if (! message)
+                        message = InfoSub::makeMessage (jvObj);
+
+                    p->send (jvObj, message, true);
+                    ++it;
+                }
+                else
+                    it = mSubRTTransactions.erase (it);
             }
-            else
-                it = mSubRTTransactions.erase (it);
         }
     }
     AcceptedLedgerTx alt (stTxn, terResult);
-    m_journal.trace << "pubProposed: " << alt.getJson ();
+    if (m_journal.trace)
+        m_journal.trace << "pubProposed: " << alt.getJson ();
     pubAccountTransaction (lpCurrent, alt, false);
 }
 
 void NetworkOPsImp::pubLedger (Ledger::ref accepted)
+{
+    publish (std::bind (&NetworkOPsImp::doPubLedger, this, accepted), true);
+}
+
+void NetworkOPsImp::doPubLedger (Ledger::pointer accepted)
 {
     // Ledgers are published only when they acquire sufficient validations
     // Holes are filled across connection loss or other catastrophe
@@ -2328,6 +2531,8 @@ void NetworkOPsImp::pubLedger (Ledger::ref accepted)
             if (mMode >= omSYNCING)
                 jvObj["validated_ledgers"]  = getApp().getLedgerMaster ().getCompleteLedgers ();
 
+            InfoSub::Message const message (InfoSub::makeMessage (jvObj));
+
             NetworkOPsImp::SubMapType::const_iterator it = mSubLedger.begin ();
 
             while (it != mSubLedger.end ())
@@ -2336,7 +2541,7 @@ void NetworkOPsImp::pubLedger (Ledger::ref accepted)
 
                 if (p)
                 {
-                    p->send (jvObj, true);
+                    p->send (jvObj, message, true);
                     ++it;
                 }
                 else
@@ -2348,7 +2553,8 @@ void NetworkOPsImp::pubLedger (Ledger::ref accepted)
     // Don't lock since pubAcceptedTransaction is locking.
     BOOST_FOREACH (const AcceptedLedger::value_type & vt, alpAccepted->getMap ())
     {
-        m_journal.trace << "pubAccepted: " << vt.second->getJson ();
+        if (m_journal.trace)
+            m_journal.trace << "pubAccepted: " << vt.second->getJson ();
         pubValidatedTransaction (lpAccepted, *vt.second);
     }
 }
@@ -2404,8 +2610,8 @@ void NetworkOPsImp::pubValidatedTransaction (Ledger::ref alAccepted, const Accep
     Json::Value jvObj   = transJson (*alTx.getTxn (), alTx.getResult (), true, alAccepted);
     jvObj["meta"] = alTx.getMeta ()->getJson (0);
 
-    Json::FastWriter w;
-    std::string sObj = w.write (jvObj);
+    // Rendered for the first subscriber which is still connected
+    InfoSub::Message message;
 
     {
         ScopedLockType sl (mLock, __FILE__, __LINE__);
@@ -2418,7 +2624,10 @@ void NetworkOPsImp::pubValidatedTransaction (Ledger::ref alAccepted, const Accep
 
             if (p)
             {
-                p->send (jvObj, sObj, true);
+                if (! message)
+                    message = InfoSub::makeMessage (jvObj);
+
+                p->send (jvObj, message, true);
                 ++it;
             }
             else
@@ -2433,7 +2642,10 @@ void NetworkOPsImp::pubValidatedTransaction (Ledger::ref alAccepted, const Accep
 
             if (p)
             {
-                p->send (jvObj, sObj, true);
+                if (! message)
+                    message = InfoSub::makeMessage (jvObj);
+
+                p->send (jvObj, message, true);
                 ++it;
             }
             else
@@ -2446,66 +2658,13 @@ void NetworkOPsImp::pubValidatedTransaction (Ledger::ref alAccepted, const Accep
 
 void NetworkOPsImp::pubAccountTransaction (Ledger::ref lpCurrent, const AcceptedLedgerTx& alTx, bool bAccepted)
 {
-    boost::unordered_set<InfoSub::pointer>  notify;
-    int                             iProposed   = 0;
-    int                             iAccepted   = 0;
-
-    {
-        ScopedLockType sl (mLock, __FILE__, __LINE__);
-
-        if (!bAccepted && mSubRTAccount.empty ()) return;
-
-        if (!mSubAccount.empty () || (!mSubRTAccount.empty ()) )
-        {
-            BOOST_FOREACH (const RippleAddress & affectedAccount, alTx.getAffected ())
-            {
-                SubInfoMapIterator  simiIt  = mSubRTAccount.find (affectedAccount.getAccountID ());
-
-                if (simiIt != mSubRTAccount.end ())
-                {
-                    NetworkOPsImp::SubMapType::const_iterator it = simiIt->second.begin ();
-
-                    while (it != simiIt->second.end ())
-                    {
-                        InfoSub::pointer p = it->second.lock ();
-
-                        if (p)
-                        {
-                            notify.insert (p);
-                            ++it;
-                            ++iProposed;
-                        }
-                        else
-                            it = simiIt->second.erase (it);
-                    }
-                }
-
-                if (bAccepted)
-                {
-                    simiIt  = mSubAccount.find (affectedAccount.getAccountID ());
+    if (mSubRTAccount.empty () && (!bAccepted || mSubAccount.empty ()))
+        return;
 
-                    if (simiIt != mSubAccount.end ())
-                    {
-                        NetworkOPsImp::SubMapType::const_iterator it = simiIt->second.begin ();
+    AccountSubscriptions::SubscriberSet notify;
+    int iProposed   = mSubRTAccount.collect (alTx.getAffected (), notify);
+    int iAccepted   = bAccepted ? mSubAccount.collect (alTx.getAffected (), notify) : 0;
 
-                        while (it != simiIt->second.end ())
-                        {
-                            InfoSub::pointer p = it->second.lock ();
-
-                            if (p)
-                            {
-                                notify.insert (p);
-                                ++it;
-                                ++iAccepted;
-                            }
-                            else
-                                it = simiIt->second.erase (it);
-                        }
-                    }
-                }
-            }
-        }
-    }
     m_journal.info << boost::str (boost::format ("pubAccountTransaction: iProposed=%d iAccepted=%d") % iProposed % iAccepted);
 
     if (!notify.empty ())
@@ -2515,12 +2674,11 @@ void NetworkOPsImp::pubAccountTransaction (Ledger::ref lpCurrent, const Accepted
         if (alTx.isApplied ())
             jvObj["meta"] = alTx.getMeta ()->getJson (0);
 
-        Json::FastWriter w;
-        std::string sObj = w.write (jvObj);
+        InfoSub::Message const message (InfoSub::makeMessage (jvObj));
 
         BOOST_FOREACH (InfoSub::ref isrListener, notify)
         {
-            isrListener->send (jvObj, sObj, true);
+            isrListener->send (jvObj, message, true);
         }
     }
 }
@@ -2531,8 +2689,6 @@ void NetworkOPsImp::pubAccountTransaction (Ledger::ref lpCurrent, const Accepted
 
 void NetworkOPsImp::subAccount (InfoSub::ref isrListener, const boost::unordered_set<RippleAddress>& vnaAccountIDs, uint32 uLedgerIndex, bool rt)
 {
-    SubInfoMapType& subMap = rt ? mSubRTAccount : mSubAccount;
-
     // For the connection, monitor each account.
     BOOST_FOREACH (const RippleAddress & naAccountID, vnaAccountIDs)
     {
@@ -2541,31 +2697,11 @@ void NetworkOPsImp::subAccount (InfoSub::ref isrListener, const boost::unordered
         isrListener->insertSubAccountInfo (naAccountID, uLedgerIndex);
     }
 
-    ScopedLockType sl (mLock, __FILE__, __LINE__);
-
-    BOOST_FOREACH (const RippleAddress & naAccountID, vnaAccountIDs)
-    {
-        SubInfoMapType::iterator    simIterator = subMap.find (naAccountID.getAccountID ());
-
-        if (simIterator == subMap.end ())
-        {
-            // Not found, note that account has a new single listner.
-            SubMapType  usisElement;
-            usisElement[isrListener->getSeq ()] = isrListener;
-            subMap.insert (simIterator, make_pair (naAccountID.getAccountID (), usisElement));
-        }
-        else
-        {
-            // Found, note that the account has another listener.
-            simIterator->second[isrListener->getSeq ()] = isrListener;
-        }
-    }
+    (rt ? mSubRTAccount : mSubAccount).insert (isrListener, vnaAccountIDs);
 }
 
 void NetworkOPsImp::unsubAccount (uint64 uSeq, const boost::unordered_set<RippleAddress>& vnaAccountIDs, bool rt)
 {
-    SubInfoMapType& subMap = rt ? mSubRTAccount : mSubAccount;
-
     // For the connection, unmonitor each account.
     // FIXME: Don't we need to unsub?
     // BOOST_FOREACH(const RippleAddress& naAccountID, vnaAccountIDs)
@@ -2573,30 +2709,7 @@ void NetworkOPsImp::unsubAccount (uint64 uSeq, const boost::unordered_set<Ripple
     //  isrListener->deleteSubAccountInfo(naAccountID);
     // }
 
-    ScopedLockType sl (mLock, __FILE__, __LINE__);
-
-    BOOST_FOREACH (const RippleAddress & naAccountID, vnaAccountIDs)
-    {
-        SubInfoMapType::iterator    simIterator = subMap.find (naAccountID.getAccountID ());
-
-
-        if (simIterator == subMap.end ())
-        {
-            // Not found.  Done.
-            nothing ();
-        }
-        else
-        {
-            // Found
-            simIterator->second.erase (uSeq);
-
-            if (simIterator->second.empty ())
-            {
-                // Don't need hash entry.
-                subMap.erase (simIterator);
-            }
-        }
-    }
+    (rt ? mSubRTAccount : mSubAccount).erase (uSeq, vnaAccountIDs);
 }
 
 bool NetworkOPsImp::subBook (InfoSub::ref isrListener, RippleCurrency const& currencyPays, RippleCurrency const& currencyGets,
@@ -0,0 +1,490 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+class SigVerifierImp
+    : public SigVerifier
+    , private Workers::Callback
+{
+public:
+    struct Stats
+    {
+        template <class Handler>
+        Stats (Handler const& handler, insight::Collector::ptr const& collector)
+            : hook (collector->make_hook (handler))
+            , pending (collector->make_gauge ("pending"))
+            , verified (collector->make_counter ("verified"))
+            , cached (collector->make_counter ("cached"))
+            , batch (collector->make_event ("batch"))
+        {
+        }
+
+        insight::Hook hook;
+        insight::Gauge pending;     // transactions waiting
+        insight::Counter verified;  // signatures checked
+        insight::Counter cached;    // verdicts taken from the HashRouter
+        insight::Event batch;       // time to verify one batch
+    };
+
+    struct Item
+    {
+        Item (SerializedTransaction::pointer const& transaction_,
+            handler_type const& handler_)
+            : transaction (transaction_)
+            , handler (handler_)
+        {
+        }
+
+        SerializedTransaction::pointer transaction;
+        handler_type handler;
+    };
+
+    typedef std::deque <Item> Items;
+    typedef std::lock_guard <std::mutex> ScopedLock;
+
+    IHashRouter& m_router;
+    Journal m_journal;
+    Stats m_stats;
+    std::mutex m_mutex;
+
+    // Transactions waiting to be verified, in arrival order
+    Items m_pending;
+
+    // Number of tasks signaled but not yet started
+    int m_signaled;
+
+    // Number of calls to processTask in progress
+    int m_running;
+
+    Workers m_workers;
+
+    //--------------------------------------------------------------------------
+
+    SigVerifierImp (IHashRouter& router,
+        insight::Collector::ptr const& collector, Stoppable& parent,
+            Journal journal)
+        : SigVerifier (parent)
+        , m_router (router)
+        , m_journal (journal)
+        , m_stats (std::bind (&SigVerifierImp::collect, this), collector)
+        , m_signaled (0)
+        , m_running (0)
+        , m_workers (*this, "SigVerifier", 0)
+    {
+    }
+
+    ~SigVerifierImp ()
+    {
+        // Must unhook before destroying
+        m_stats.hook = insight::Hook ();
+    }
+
+    void collect ()
+    {
+        ScopedLock lock (m_mutex);
+        m_stats.pending = m_pending.size ();
+    }
+
+    //--------------------------------------------------------------------------
+
+    void verify (SerializedTransaction::pointer const& transaction,
+        handler_type const& handler)
+    {
+        ScopedLock lock (m_mutex);
+
+        // Once stopping, nothing will drain the queue
+        if (isStopping ())
+            return;
+
+        m_pending.emplace_back (transaction, handler);
+        signal (lock);
+    }
+
+    int getPendingCount ()
+    {
+        ScopedLock lock (m_mutex);
+        return m_pending.size ();
+    }
+
+    void setThreadCount (int threads, bool standaloneMode)
+    {
+        if (standaloneMode)
+        {
+            threads = 1;
+        }
+        else if (threads == 0)
+        {
+            // Verification is pure CPU work, so one thread per processor
+            threads = std::max (1, SystemStats::getNumCpus ());
+        }
+
+        m_journal.info << "Using " << threads << " signature verification threads";
+
+        m_workers.setNumberOfThreads (threads);
+    }
+
+    //--------------------------------------------------------------------------
+
+    // Signal enough tasks that every pending transaction will be taken
+    // by some task, without signaling one task per transaction.
+    //
+    void signal (ScopedLock const&)
+    {
+        while ((m_signaled * int (batchSize)) < int (m_pending.size ()))
+        {
+            ++m_signaled;
+            m_workers.addTask ();
+        }
+    }
+
+    // Returns the verdict for one transaction, verifying it if needed.
+    //
+    bool check (SerializedTransaction const& transaction, uint256 const& txID)
+    {
+        int const flags (m_router.getFlags (txID));
+
+        if ((flags & SF_BAD) != 0)
+        {
+            ++m_stats.cached;
+            transaction.setBad ();
+            return false;
+        }
+
+        if ((flags & SF_SIGGOOD) != 0)
+        {
+            ++m_stats.cached;
+            transaction.setGood ();
+            return true;
+        }
+
+        ++m_stats.verified;
+
+        bool const good (transaction.checkSign ());
+        m_router.setFlag (txID, good ? SF_SIGGOOD : SF_BAD);
+        return good;
+    }
+
+    void processTask ()
+    {
+        Items batch;
+
+        {
+            ScopedLock lock (m_mutex);
+
+            --m_signaled;
+            ++m_running;
+
+            while (! m_pending.empty () && batch.size () < batchSize)
+            {
+                batch.push_back (std::move (m_pending.front ()));
+                m_pending.pop_front ();
+            }
+
+            // Tasks which already started may have taken more than their
+            // share, make sure what remains is still covered.
+            signal (lock);
+        }
+
+        if (! batch.empty ())
+        {
+            auto const start (std::chrono::steady_clock::now ());
+
+            // The same transaction can arrive from several sources at once,
+            // remember verdicts so each is only verified once per batch.
+            std::unordered_map <uint256, bool> verdicts;
+
+            for (auto& item : batch)
+            {
+                bool good;
+
+                try
+                {
+                    uint256 const txID (item.transaction->getTransactionID ());
+                    auto const iter (verdicts.find (txID));
+
+                    if (iter != verdicts.end ())
+                    {
+                        ++m_stats.cached;
+                        good = iter->second;
+
+                        if (good)
+                            item.transaction->setGood ();
+                        else
+                            item.transaction->setBad ();
+                    }
+                    else
+                    {
+                        good = check (*item.transaction, txID);
+                        verdicts.emplace (txID, good);
+                    }
+                }
+                catch (...)
+                {
+                    good = false;
+                }
+
+                item.handler (item.transaction, good);
+            }
+
+            m_stats.batch.notify (ceil <std::chrono::milliseconds> (
+                std::chrono::steady_clock::now () - start));
+        }
+
+        {
+            ScopedLock lock (m_mutex);
+            --m_running;
+            checkStopped (lock);
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    //
+    // Stoppable
+    //
+
+    void checkStopped (ScopedLock const&)
+    {
+        if (isStopping () && areChildrenStopped () && (m_running == 0))
+            stopped ();
+    }
+
+    void onStop ()
+    {
+        ScopedLock lock (m_mutex);
+
+        // Discard whatever has not been verified. The tasks already
+        // signaled will find nothing to do.
+        m_pending.clear ();
+        checkStopped (lock);
+    }
+
+    void onChildrenStopped ()
+    {
+        ScopedLock lock (m_mutex);
+        checkStopped (lock);
+    }
+};
+
+//------------------------------------------------------------------------------
+
+SigVerifier::SigVerifier (Stoppable& parent)
+    : Stoppable ("SigVerifier", parent)
+{
+}
+
+std::unique_ptr <SigVerifier> make_SigVerifier (IHashRouter& router,
+    insight::Collector::ptr const& collector, Stoppable& parent,
+        Journal journal)
+{
+    return std::make_unique <SigVerifierImp> (router, collector, parent,
+        journal);
+}
+
+//------------------------------------------------------------------------------
+
+class SigVerifierTests : public UnitTest
+{
+public:
+    SigVerifierTests () : UnitTest ("SigVerifier", "ripple")
+    {
+    }
+
+    // Collects the verdicts delivered by the verifier
+    struct Results
+    {
+        Results (int expected_)
+            : expected (expected_)
+            , good (0)
+            , bad (0)
+        {
+        }
+
+        void on_verify (SerializedTransaction::pointer, bool verdict)
+        {
+            std::lock_guard <std::mutex> lock (mutex);
+            if (verdict)
+                ++good;
+            else
+                ++bad;
+            if (good + bad == expected)
+                done.signal ();
+        }
+
+        std::mutex mutex;
+        WaitableEvent done;
+        int expected;
+        int good;
+        int bad;
+    };
+
+    static std::vector <SerializedTransaction::pointer> make_transactions (
+        int count)
+    {
+        RippleAddress seed;
+        seed.setSeedRandom ();
+        RippleAddress const generator (RippleAddress::createGeneratorPublic (seed));
+        RippleAddress const publicAcct (RippleAddress::createAccountPublic (generator, 1));
+        RippleAddress const privateAcct (RippleAddress::createAccountPrivate (generator, seed, 1));
+
+        std::vector <SerializedTransaction::pointer> list;
+        list.reserve (count);
+
+        for (int i = 0; i < count; ++i)
+        {
+            SerializedTransaction::pointer const transaction (
+                boost::make_shared <SerializedTransaction> (ttACCOUNT_SET));
+            transaction->setSourceAccount (publicAcct);
+            transaction->setSigningPubKey (publicAcct);
+            transaction->setSequence (i + 1);
+            transaction->sign (privateAcct);
+            list.push_back (transaction);
+        }
+
+        return list;
+    }
+
+    void runTest ()
+    {
+        beginTestCase ("verify");
+
+        RootStoppable stoppable ("SigVerifierTests");
+        std::unique_ptr <IHashRouter> router (IHashRouter::New (
+            IHashRouter::getDefaultHoldTime ()));
+        std::unique_ptr <SigVerifier> verifier (make_SigVerifier (
+            *router, insight::NullCollector::New (), stoppable, Journal ()));
+        verifier->setThreadCount (2, false);
+        stoppable.prepare ();
+        stoppable.start ();
+
+        std::vector <SerializedTransaction::pointer> const good (
+            make_transactions (100));
+
+        // Changing a field after signing invalidates the signature
+        std::vector <SerializedTransaction::pointer> const bad (
+            make_transactions (10));
+        for (auto const& transaction : bad)
+            transaction->setSequence (transaction->getSequence () + 1000);
+
+        {
+            Results results (good.size () + bad.size ());
+
+            for (auto const& transaction : good)
+                verifier->verify (transaction, std::bind (&Results::on_verify,
+                    &results, std::placeholders::_1, std::placeholders::_2));
+            for (auto const& transaction : bad)
+                verifier->verify (transaction, std::bind (&Results::on_verify,
+                    &results, std::placeholders::_1, std::placeholders::_2));
+
+            expect (results.done.wait (10000), "Timed out");
+            expect (results.good == int (good.size ()));
+            expect (results.bad == int (bad.size ()));
+        }
+
+        // Verdicts are cached in the HashRouter
+        expect ((router->getFlags (good.front ()->getTransactionID ()) &
+            SF_SIGGOOD) != 0);
+        expect ((router->getFlags (bad.front ()->getTransactionID ()) &
+            SF_BAD) != 0);
+
+        stoppable.stop ();
+    }
+};
+
+static SigVerifierTests sigVerifierTests;
+
+//------------------------------------------------------------------------------
+
+/** Measures signature verification throughput. */
+class SigVerifierTimingTests : public UnitTest
+{
+public:
+    enum
+    {
+        numTransactions = 20000
+    };
+
+    SigVerifierTimingTests () : UnitTest ("SigVerifierTiming", "ripple", runManual)
+    {
+    }
+
+    void runTest ()
+    {
+        beginTestCase ("timing");
+
+        std::vector <SerializedTransaction::pointer> const transactions (
+            SigVerifierTests::make_transactions (numTransactions));
+
+        // Copies without the cached verdict, so each run does the work
+        auto const fresh ([&transactions] ()
+        {
+            std::vector <SerializedTransaction::pointer> list;
+            list.reserve (transactions.size ());
+            for (auto const& transaction : transactions)
+                list.push_back (boost::make_shared <SerializedTransaction> (
+                    *transaction));
+            return list;
+        });
+
+        {
+            std::vector <SerializedTransaction::pointer> const list (fresh ());
+            int64 const start (Time::getHighResolutionTicks ());
+            for (auto const& transaction : list)
+                transaction->checkSign ();
+            double const elapsed (Time::highResolutionTicksToSeconds (
+                Time::getHighResolutionTicks () - start));
+
+            logMessage ("checkSign: " +
+                String (int64 (numTransactions / elapsed)) + " verifications/s");
+        }
+
+        for (int threads = 1; threads <= SystemStats::getNumCpus (); threads *= 2)
+        {
+            RootStoppable stoppable ("SigVerifierTimingTests");
+            std::unique_ptr <IHashRouter> router (IHashRouter::New (
+                IHashRouter::getDefaultHoldTime ()));
+            std::unique_ptr <SigVerifier> verifier (make_SigVerifier (
+                *router, insight::NullCollector::New (), stoppable, Journal ()));
+            verifier->setThreadCount (threads, false);
+            stoppable.prepare ();
+            stoppable.start ();
+
+            std::vector <SerializedTransaction::pointer> const list (fresh ());
+            SigVerifierTests::Results results (list.size ());
+
+            int64 const start (Time::getHighResolutionTicks ());
+            for (auto const& transaction : list)
+                verifier->verify (transaction, std::bind (
+                    &SigVerifierTests::Results::on_verify, &results,
+                        std::placeholders::_1, std::placeholders::_2));
+            results.done.wait ();
+            double const elapsed (Time::highResolutionTicksToSeconds (
+                Time::getHighResolutionTicks () - start));
+
+            double const rate (numTransactions / elapsed);
+            logMessage (String (threads) + " threads: " +
+                String (int64 (rate)) + " verifications/s, " +
+                String (int64 (rate / threads)) + " per core");
+
+            stoppable.stop ();
+        }
+
+        pass ();
+    }
+};
+
+static SigVerifierTimingTests sigVerifierTimingTests;
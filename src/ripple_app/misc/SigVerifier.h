@@ -0,0 +1,71 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_APP_SIGVERIFIER_H_INCLUDED
+#define RIPPLE_APP_SIGVERIFIER_H_INCLUDED
+
+/** Verifies transaction signatures in batches on a dedicated thread pool.
+
+    Transactions arriving from peers or clients are queued here instead of
+    each taking a job which calls checkSign. Worker threads take the
+    pending transactions in batches, so that a burst costs one task per
+    batch instead of one job per transaction, and duplicates within a
+    batch are verified only once.
+
+    The verdict is cached in the HashRouter as SF_SIGGOOD or SF_BAD, and a
+    transaction whose verdict is already cached is not verified again.
+*/
+class SigVerifier : public Stoppable
+{
+protected:
+    explicit SigVerifier (Stoppable& parent);
+
+public:
+    /** Called with the verdict once a transaction has been verified.
+        The call is made on one of the verifier's threads and must
+        complete quickly, typically by adding a job.
+    */
+    typedef std::function <void (SerializedTransaction::pointer, bool)> handler_type;
+
+    enum
+    {
+        /** The largest number of transactions verified by one task. */
+        batchSize = 64
+    };
+
+    virtual ~SigVerifier () { }
+
+    /** Queue a transaction to have its signature verified. */
+    virtual void verify (SerializedTransaction::pointer const& transaction,
+        handler_type const& handler) = 0;
+
+    /** Returns the number of transactions waiting to be verified. */
+    virtual int getPendingCount () = 0;
+
+    /** Set the number of verifier threads.
+        Zero means choose based on the number of processors.
+    */
+    virtual void setThreadCount (int threads, bool standaloneMode) = 0;
+};
+
+std::unique_ptr <SigVerifier> make_SigVerifier (IHashRouter& router,
+    insight::Collector::ptr const& collector, Stoppable& parent,
+        Journal journal);
+
+#endif
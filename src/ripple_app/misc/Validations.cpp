@@ -58,10 +58,10 @@ private:
     }
 
 public:
-    ValidationsImp ()
+    explicit ValidationsImp (insight::Collector::ptr const& collector)
         : mLock (this, "Validations", __FILE__, __LINE__)
         , mValidations ("Validations", 128, 600, get_seconds_clock (),
-            LogPartition::getJournal <TaggedCacheLog> ())
+            LogPartition::getJournal <TaggedCacheLog> (), collector)
         , mWriting (false)
     {
         mStaleValidations.reserve (512);
@@ -451,6 +451,11 @@ private:
         mWriting = false;
     }
 
+    void setSweepInterval (std::chrono::seconds interval)
+    {
+        mValidations.setSweepInterval (interval);
+    }
+
     void sweep ()
     {
         ScopedLockType sl (mLock, __FILE__, __LINE__);
@@ -458,9 +463,9 @@ private:
     }
 };
 
-Validations* Validations::New ()
+Validations* Validations::New (insight::Collector::ptr const& collector)
 {
-    return new ValidationsImp;
+    return new ValidationsImp (collector);
 }
 
 // vim:ts=4
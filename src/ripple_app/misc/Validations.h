@@ -27,7 +27,7 @@ typedef std::pair<int, uint160> currentValidationCount; // nodes validating and
 class Validations : LeakChecked <Validations>
 {
 public:
-    static Validations* New ();
+    static Validations* New (insight::Collector::ptr const& collector);
 
     virtual ~Validations () { }
 
@@ -55,6 +55,11 @@ public:
 
     virtual void flush () = 0;
 
+    /** Spread sweeps of the validation cache over an interval.
+        @see TaggedCache::setSweepInterval
+    */
+    virtual void setSweepInterval (std::chrono::seconds interval) = 0;
+
     virtual void sweep () = 0;
 };
 
@@ -0,0 +1,227 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+namespace ripple {
+
+// The snapshot is a header followed by one record per object:
+//
+//  Header
+//      uint32      magic
+//      uint32      version
+//      string      name of the backend, null terminated
+//
+//  Record
+//      uint8       type
+//      uint32      ledger index
+//      uint256     hash
+//      uint32      size of the data
+//      bytes       data
+//
+// Integers are little endian.
+//
+enum
+{
+    snapshotMagic = 0x544f4852  // "RHOT"
+    ,snapshotVersion = 1
+
+    ,recordHeaderBytes = 1 + 4 + 32 + 4
+};
+
+std::size_t HotSnapshot::save (File const& file,
+    NodeStore::Database& database, uint256 const& stateRoot,
+        int levels, std::size_t limit, Journal journal)
+{
+    NodeStore::Batch objects;
+    objects.reserve (limit);
+
+    std::unordered_set <uint256> seen;
+
+    // The top of the state map, one level at a time, root first
+    std::vector <uint256> level;
+    if (stateRoot.isNonZero ())
+        level.push_back (stateRoot);
+
+    for (int depth = 0; (depth <= levels) && ! level.empty (); ++depth)
+    {
+        NodeStore::Batch const found (database.fetchBatch (level));
+
+        std::vector <uint256> next;
+
+        for (auto const& object : found)
+        {
+            if ((object == nullptr) || (objects.size () >= limit) ||
+                ! seen.insert (object->getHash ()).second)
+                continue;
+
+            objects.push_back (object);
+
+            if (isInnerNodeObject (*object))
+            {
+                for (int branch = 0; branch < 16; ++branch)
+                {
+                    uint256 const child (getInnerNodeChild (*object, branch));
+                    if (child.isNonZero ())
+                        next.push_back (child);
+                }
+            }
+        }
+
+        level.swap (next);
+    }
+
+    // Then whatever else was in use
+    for (auto& object : database.getRecentObjects (limit))
+    {
+        if (objects.size () >= limit)
+            break;
+
+        if (seen.insert (object->getHash ()).second)
+            objects.push_back (std::move (object));
+    }
+
+    // Write to the side so a failure leaves no partial snapshot behind
+    File const partial (file.getSiblingFile (file.getFileName () + ".partial"));
+    partial.deleteFile ();
+
+    bool ok;
+
+    {
+        FileOutputStream out (partial);
+
+        ok = ! out.failedToOpen () &&
+            out.writeInt (snapshotMagic) &&
+            out.writeInt (snapshotVersion) &&
+            out.writeString (database.getName ());
+
+        for (auto const& object : objects)
+        {
+            if (! ok)
+                break;
+
+            ok = out.writeByte (char (object->getType ())) &&
+                out.writeInt (object->getIndex ()) &&
+                out.write (object->getHash ().begin (), 32) &&
+                out.writeInt (object->getSize ()) &&
+                out.write (object->getData (), object->getSize ());
+        }
+
+        out.flush ();
+        ok = ok && out.getStatus ().wasOk ();
+    }
+
+    if (! ok || ! partial.moveFileTo (file))
+    {
+        partial.deleteFile ();
+
+        if (journal.warning) journal.warning <<
+            "Unable to write the hot snapshot " << file.getFullPathName ();
+
+        return 0;
+    }
+
+    if (journal.info) journal.info <<
+        "Saved " << objects.size () << " objects to the hot snapshot";
+
+    return objects.size ();
+}
+
+std::size_t HotSnapshot::load (File const& file,
+    NodeStore::Database& database, Journal journal)
+{
+    if (! file.existsAsFile ())
+        return 0;
+
+    MemoryBlock block;
+    bool const read (file.loadFileAsData (block));
+
+    // A snapshot is only good for the run after the one which wrote it
+    file.deleteFile ();
+
+    if (! read)
+    {
+        if (journal.warning) journal.warning <<
+            "Unable to read the hot snapshot " << file.getFullPathName ();
+        return 0;
+    }
+
+    MemoryInputStream in (block, false);
+
+    if ((in.readInt () != snapshotMagic) || (in.readInt () != snapshotVersion))
+    {
+        if (journal.warning) journal.warning <<
+            "Ignoring hot snapshot " << file.getFullPathName () <<
+                " with an unknown format";
+        return 0;
+    }
+
+    if (in.readString () != database.getName ())
+    {
+        if (journal.info) journal.info <<
+            "Ignoring hot snapshot of a different backend";
+        return 0;
+    }
+
+    unsigned char const* const data (
+        static_cast <unsigned char const*> (block.getData ()));
+
+    NodeStore::Batch objects;
+    std::size_t corrupt (0);
+
+    while (in.getNumBytesRemaining () >= recordHeaderBytes)
+    {
+        NodeObjectType const type (NodeObjectType (in.readByte ()));
+        LedgerIndex const index (in.readInt ());
+        uint256 hash;
+        in.read (hash.begin (), 32);
+        int const size (in.readInt ());
+
+        if ((size < 0) || (size > in.getNumBytesRemaining ()))
+        {
+            ++corrupt;
+            break;
+        }
+
+        unsigned char const* const payload (data + in.getPosition ());
+        in.skipNextBytes (size);
+
+        if (Serializer::getSHA512Half (payload, size) != hash)
+        {
+            ++corrupt;
+            continue;
+        }
+
+        objects.push_back (NodeObject::createObject (
+            type, index, payload, size, hash));
+    }
+
+    if (corrupt != 0)
+    {
+        if (journal.warning) journal.warning <<
+            "Hot snapshot has " << corrupt << " damaged objects";
+    }
+
+    database.warm (objects);
+
+    if (journal.info) journal.info <<
+        "Loaded " << objects.size () << " objects from the hot snapshot";
+
+    return objects.size ();
+}
+
+}
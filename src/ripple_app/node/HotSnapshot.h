@@ -0,0 +1,65 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_APP_HOTSNAPSHOT_H_INCLUDED
+#define RIPPLE_APP_HOTSNAPSHOT_H_INCLUDED
+
+namespace ripple {
+
+/** Saves the node objects a restarted server needs first.
+
+    On shutdown the top levels of the account state map and the most
+    recently used objects in the node store cache are written to a single
+    file, one after another. On startup the file is read back with one
+    sequential read and placed in the cache, instead of each object costing
+    a random read while the state map warms up.
+
+    The snapshot names the backend it was taken from and is ignored if the
+    node store has since moved to a different one. Each object is checked
+    against its hash, and the file is removed once it has been loaded.
+*/
+class HotSnapshot
+{
+public:
+    /** Write a snapshot, replacing any existing one.
+
+        @param file The file to write.
+        @param database The node store whose cache is saved.
+        @param stateRoot The root of the account state map, or zero.
+        @param levels The number of levels of the map to save.
+        @param limit The most objects to save.
+        @return The number of objects written.
+    */
+    static std::size_t save (File const& file,
+        NodeStore::Database& database, uint256 const& stateRoot,
+            int levels, std::size_t limit, Journal journal);
+
+    /** Read a snapshot into the node store cache and remove it.
+
+        @param file The file to read.
+        @param database The node store whose cache is warmed.
+        @return The number of objects placed in the cache.
+    */
+    static std::size_t load (File const& file,
+        NodeStore::Database& database, Journal journal);
+};
+
+}
+
+#endif
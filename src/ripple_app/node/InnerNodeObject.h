@@ -0,0 +1,52 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_APP_INNERNODEOBJECT_H_INCLUDED
+#define RIPPLE_APP_INNERNODEOBJECT_H_INCLUDED
+
+namespace ripple {
+
+/** Returns `true` if the object holds an inner node of a SHAMap.
+    Such objects are a prefix followed by the hashes of sixteen children.
+*/
+inline bool isInnerNodeObject (NodeObject const& object)
+{
+    if (object.getSize () != 4 + 16 * 32)
+        return false;
+
+    unsigned char const* const data (object.getData ());
+    uint32 const prefix ((uint32 (data [0]) << 24) | (uint32 (data [1]) << 16) |
+        (uint32 (data [2]) << 8) | uint32 (data [3]));
+
+    return prefix == HashPrefix::innerNode;
+}
+
+/** Returns the hash of a child of an inner node object.
+    The hash is zero if the branch is empty.
+*/
+inline uint256 getInnerNodeChild (NodeObject const& object, int branch)
+{
+    uint256 child;
+    memcpy (child.begin (), object.getData () + 4 + 32 * branch, 32);
+    return child;
+}
+
+}
+
+#endif
@@ -0,0 +1,523 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include "../main/Tuning.h"
+
+namespace ripple {
+
+class NodeStoreRotatorImp
+    : public NodeStoreRotator
+    , public Thread
+    , public LeakChecked <NodeStoreRotatorImp>
+{
+public:
+    struct State
+    {
+        State ()
+            : generation (0)
+            , lastRotation (0)
+            , minRange (0)
+            , maxRange (0)
+            , ledgerIndex (0)
+            , missing (0)
+        {
+        }
+
+        int          generation;    // The backend in use, or being retired
+        LedgerIndex  lastRotation;  // The validated ledger when the last rotation began
+        LedgerIndex  minRange;      // The oldest ledger being copied forward
+        LedgerIndex  maxRange;      // The newest ledger being copied forward
+        LedgerIndex  ledgerIndex;   // The ledger being copied now
+        std::size_t  missing;       // Objects which couldn't be found
+    };
+
+    typedef SharedData <State> SharedState;
+
+    NodeStore::Manager& m_manager;
+    NodeStore::Scheduler& m_scheduler;
+    NodeStore::Database& m_database;
+    NodeStore::Parameters const m_parameters;
+    Journal m_journal;
+    File const m_path;
+    LedgerIndex m_ledgersToKeep;    // Zero when online delete is off
+    bool m_rotating;                // Only used on the thread
+    SharedState m_state;
+
+    //--------------------------------------------------------------------------
+
+    NodeStoreRotatorImp (
+        Stoppable& parent,
+        NodeStore::Manager& manager,
+        NodeStore::Scheduler& scheduler,
+        NodeStore::Database& database,
+        NodeStore::Parameters const& parameters,
+        Journal journal)
+        : NodeStoreRotator (parent)
+        , Thread ("NodeStoreRotator")
+        , m_manager (manager)
+        , m_scheduler (scheduler)
+        , m_database (database)
+        , m_parameters (parameters)
+        , m_journal (journal)
+        , m_path (getPath (parameters))
+        , m_ledgersToKeep (std::max (0, parameters ["online_delete"].getIntValue ()))
+        , m_rotating (false)
+    {
+        if (m_ledgersToKeep != 0 && m_ledgersToKeep < onlineDeleteMinimumLedgers)
+        {
+            m_journal.warning <<
+                "online_delete must keep at least " << onlineDeleteMinimumLedgers << " ledgers";
+            m_ledgersToKeep = onlineDeleteMinimumLedgers;
+        }
+    }
+
+    ~NodeStoreRotatorImp ()
+    {
+        stopThread ();
+    }
+
+    /** Return the configured path of the backend. */
+    static File getPath (NodeStore::Parameters const& parameters)
+    {
+        return File::getCurrentWorkingDirectory ().getChildFile (
+            parameters ["path"]);
+    }
+
+    /** Return the path of the backend with the given generation. */
+    static File getGenerationPath (File const& path, int generation)
+    {
+        if (generation == 0)
+            return path;
+
+        return path.getSiblingFile (path.getFileName () + "." + String (generation));
+    }
+
+    /** Return the generations on disk, oldest first. */
+    static std::vector <int> findGenerations (File const& path)
+    {
+        std::vector <int> generations;
+
+        if (path.exists ())
+            generations.push_back (0);
+
+        Array <File> files;
+        path.getParentDirectory ().findChildFiles (files,
+            File::findFilesAndDirectories, false, path.getFileName () + ".*");
+
+        for (int i = 0; i < files.size (); ++i)
+        {
+            String const suffix (files [i].getFileExtension ().substring (1));
+
+            if (suffix.isNotEmpty () && suffix.containsOnly ("0123456789"))
+                generations.push_back (suffix.getIntValue ());
+        }
+
+        std::sort (generations.begin (), generations.end ());
+
+        return generations;
+    }
+
+    //--------------------------------------------------------------------------
+    //
+    // Stoppable
+    //
+    //--------------------------------------------------------------------------
+
+    void onPrepare ()
+    {
+    }
+
+    void onStart ()
+    {
+        if (m_ledgersToKeep != 0)
+            startThread ();
+    }
+
+    void onStop ()
+    {
+        if (isThreadRunning ())
+        {
+            m_journal.info << "Stopping";
+            signalThreadShouldExit ();
+            notify ();
+        }
+        else
+        {
+            stopped ();
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    //
+    // PropertyStream
+    //
+    //--------------------------------------------------------------------------
+
+    void onWrite (PropertyStream::Map& map)
+    {
+        SharedState::Access state (m_state);
+
+        if (m_ledgersToKeep == 0)
+        {
+            map ["status"] = "disabled";
+            return;
+        }
+
+        map ["generation"] = state->generation;
+        map ["ledgers_kept"] = m_ledgersToKeep;
+
+        if (state->maxRange == 0)
+        {
+            map ["status"] = "idle";
+            if (state->lastRotation != 0)
+                map ["ledger_last_rotation"] = state->lastRotation;
+        }
+        else
+        {
+            NodeStore::Database::RotationStats const stats (
+                m_database.getRotationStats ());
+
+            map ["status"] = "rotating";
+            map ["ledger_min"] = state->minRange;
+            map ["ledger_max"] = state->maxRange;
+            map ["ledger_current"] = state->ledgerIndex;
+            map ["objects_copied"] = stats.copied;
+            map ["objects_carried"] = stats.carried;
+            if (state->missing > 0)
+                map ["objects_missing"] = state->missing;
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    //
+    // NodeStoreRotatorImp
+    //
+    //--------------------------------------------------------------------------
+
+    void run ()
+    {
+        m_journal.debug << "Started";
+
+        // Finish removing anything retired before a restart
+        Array <File> retired;
+        m_path.getParentDirectory ().findChildFiles (retired,
+            File::findFilesAndDirectories, false, m_path.getFileName () + "*.retired");
+        for (int i = 0; i < retired.size (); ++i)
+            retired [i].deleteRecursively ();
+
+        std::vector <int> const generations (findGenerations (m_path));
+
+        if (! generations.empty ())
+        {
+            SharedState::Access state (m_state);
+            state->generation = generations.front ();
+        }
+
+        // A second generation on disk means a rotation was interrupted.
+        // Objects written since are only in the newer one, so both are
+        // read from right away.
+        if (generations.size () > 1)
+            beginRotation ();
+
+        while (! this->threadShouldExit ())
+        {
+            Ledger::pointer const ledger (
+                getApp().getLedgerMaster ().getValidatedLedger ());
+
+            if (ledger != nullptr && shouldRotate (ledger->getLedgerSeq ()))
+                rotate (ledger->getLedgerSeq ());
+
+            this->wait (rotationPollMilliseconds);
+        }
+
+        stopped ();
+    }
+
+    bool shouldRotate (LedgerIndex validated)
+    {
+        SharedState::Access state (m_state);
+
+        if (state->lastRotation == 0)
+        {
+            // History starts counting from the first validated ledger
+            state->lastRotation = validated;
+            return m_rotating;
+        }
+
+        return m_rotating || (validated >= state->lastRotation + m_ledgersToKeep);
+    }
+
+    /** Start writing to the next generation. */
+    void beginRotation ()
+    {
+        File const next (getGenerationPath (m_path, getGeneration () + 1));
+        NodeStore::Parameters parameters (m_parameters);
+        parameters.set ("path", next.getFullPathName ());
+
+        m_journal.info << "Rotating to " << next.getFullPathName ();
+
+        m_database.beginRotation (m_manager.make_Backend (
+            parameters, m_scheduler, m_journal));
+
+        m_rotating = true;
+    }
+
+    int getGeneration ()
+    {
+        SharedState::Access state (m_state);
+        return state->generation;
+    }
+
+    /** Move onto the next backend, keeping ledgers up to the given one. */
+    void rotate (LedgerIndex maxRange)
+    {
+        LedgerIndex const minRange ((maxRange > m_ledgersToKeep)
+            ? (maxRange - m_ledgersToKeep + 1) : 1);
+
+        {
+            SharedState::Access state (m_state);
+            state->lastRotation = maxRange;
+            state->minRange = minRange;
+            state->maxRange = maxRange;
+            state->ledgerIndex = maxRange;
+            state->missing = 0;
+        }
+
+        if (! m_rotating)
+            beginRotation ();
+
+        m_journal.info << "Keeping ledgers " << minRange << " through " << maxRange;
+
+        // Inner nodes whose children were queued, ledgers share most of them
+        std::unordered_set <uint256> expanded;
+
+        // Newest first, so the most useful history is kept if we stop early
+        for (LedgerIndex index (maxRange);
+            index >= minRange && ! this->threadShouldExit (); --index)
+        {
+            {
+                SharedState::Access state (m_state);
+                state->ledgerIndex = index;
+            }
+
+            Ledger::pointer const ledger (
+                getApp().getLedgerMaster ().getLedgerBySeq (index));
+
+            if (ledger == nullptr || ledger->getLedgerSeq () != index)
+            {
+                m_journal.debug << "Ledger " << index << " not available";
+                continue;
+            }
+
+            copyLedger (*ledger, expanded);
+        }
+
+        // Ledgers newer than the range may have been built before the
+        // rotation began, so some of their nodes are only in the backend
+        // being retired. Walk them too, until no more are closing.
+        LedgerIndex copied (maxRange);
+        while (! this->threadShouldExit ())
+        {
+            Ledger::pointer const closed (
+                getApp().getLedgerMaster ().getClosedLedger ());
+
+            if (closed == nullptr || closed->getLedgerSeq () <= copied)
+                break;
+
+            LedgerIndex const newest (closed->getLedgerSeq ());
+
+            for (LedgerIndex index (copied + 1);
+                index < newest && ! this->threadShouldExit (); ++index)
+            {
+                {
+                    SharedState::Access state (m_state);
+                    state->ledgerIndex = index;
+                }
+
+                Ledger::pointer const ledger (
+                    getApp().getLedgerMaster ().getLedgerBySeq (index));
+
+                if (ledger != nullptr && ledger->getLedgerSeq () == index)
+                    copyLedger (*ledger, expanded);
+            }
+
+            copyLedger (*closed, expanded);
+            copied = newest;
+        }
+
+        if (this->threadShouldExit ())
+        {
+            // Both backends are still on disk, so it resumes on restart
+            m_journal.info << "Rotation interrupted";
+            return;
+        }
+
+        m_database.endRotation ();
+        m_rotating = false;
+
+        // Nothing older than the range survives, so stop offering it
+        clearPriorLedgers (minRange);
+
+        int const generation (getGeneration ());
+        File const next (getGenerationPath (m_path, generation + 1));
+
+        // Rename first so a partial delete is never mistaken for a backend
+        File const old (getGenerationPath (m_path, generation));
+        File const retired (old.getSiblingFile (old.getFileName () + ".retired"));
+        if (! old.moveFileTo (retired) || ! retired.deleteRecursively ())
+            m_journal.warning << "Unable to remove " << old.getFullPathName ();
+
+        NodeStore::Database::RotationStats const stats (
+            m_database.getRotationStats ());
+
+        std::size_t missing;
+        {
+            SharedState::Access state (m_state);
+            state->generation = generation + 1;
+            state->minRange = state->maxRange = state->ledgerIndex = 0;
+            missing = state->missing;
+        }
+
+        m_journal.info << "Rotated to " << next.getFullPathName () <<
+            ", copied " << stats.copied << " objects, carried " << stats.carried <<
+                ", missing " << missing;
+    }
+
+    /** Forget ledgers older than the given one, which are about to be deleted. */
+    void clearPriorLedgers (LedgerIndex minRange)
+    {
+        getApp().getLedgerMaster ().clearPriorLedgers (minRange);
+
+        {
+            DeprecatedScopedLock sl (getApp().getLedgerDB ()->getDBLock ());
+            getApp().getLedgerDB ()->getDB ()->executeSQL (boost::str (
+                boost::format ("DELETE FROM Ledgers WHERE LedgerSeq < %u;") % minRange));
+        }
+
+        {
+            Database* db (getApp().getTxnDB ()->getDB ());
+            DeprecatedScopedLock sl (getApp().getTxnDB ()->getDBLock ());
+            db->executeSQL (boost::str (
+                boost::format ("DELETE FROM Transactions WHERE LedgerSeq < %u;") % minRange));
+            db->executeSQL (boost::str (
+                boost::format ("DELETE FROM AccountTransactions WHERE LedgerSeq < %u;") % minRange));
+        }
+
+        m_journal.debug << "Cleared ledgers before " << minRange;
+    }
+
+    /** Copy a ledger and everything reachable from it to the new backend. */
+    void copyLedger (Ledger& ledger, std::unordered_set <uint256>& expanded)
+    {
+        std::vector <uint256> pending;
+        pending.push_back (ledger.getHash ());
+        pending.push_back (ledger.getAccountHash ());
+        if (ledger.getTransHash ().isNonZero ())
+            pending.push_back (ledger.getTransHash ());
+
+        while (! pending.empty () && ! this->threadShouldExit ())
+        {
+            // Let the server's own writes drain before adding to them
+            while (m_database.getWriteLoad () > rotationWriteLoadLimit &&
+                ! this->threadShouldExit ())
+                this->wait (100);
+
+            std::size_t const count (std::min (pending.size (),
+                std::size_t (rotationBatchSize)));
+            std::vector <uint256> const hashes (pending.end () - count, pending.end ());
+            pending.resize (pending.size () - count);
+
+            // Objects written since the rotation began are returned too,
+            // their children might still only be in the old backend.
+            NodeStore::Batch const objects (m_database.copyForward (hashes));
+
+            std::size_t missing (0);
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                if (objects [i] == nullptr)
+                    ++missing;
+                else if (isInnerNodeObject (*objects [i]) && expanded.insert (hashes [i]).second)
+                    addChildren (*objects [i], expanded, pending);
+            }
+
+            if (missing > 0)
+            {
+                SharedState::Access state (m_state);
+                state->missing += missing;
+            }
+        }
+    }
+
+    static void addChildren (NodeObject const& object,
+        std::unordered_set <uint256> const& expanded, std::vector <uint256>& pending)
+    {
+        for (int branch = 0; branch < 16; ++branch)
+        {
+            uint256 const child (getInnerNodeChild (object, branch));
+
+            if (child.isNonZero () && expanded.count (child) == 0)
+                pending.push_back (child);
+        }
+    }
+};
+
+//------------------------------------------------------------------------------
+
+NodeStoreRotator::NodeStoreRotator (Stoppable& parent)
+    : Stoppable ("NodeStoreRotator", parent)
+    , PropertyStream::Source ("nodestorerotator")
+{
+}
+
+NodeStoreRotator::~NodeStoreRotator ()
+{
+}
+
+NodeStoreRotator* NodeStoreRotator::New (
+    Stoppable& parent,
+    NodeStore::Manager& manager,
+    NodeStore::Scheduler& scheduler,
+    NodeStore::Database& database,
+    NodeStore::Parameters const& parameters,
+    Journal journal)
+{
+    return new NodeStoreRotatorImp (parent, manager, scheduler,
+        database, parameters, journal);
+}
+
+NodeStore::Parameters NodeStoreRotator::getCurrentParameters (
+    NodeStore::Parameters const& parameters)
+{
+    NodeStore::Parameters result (parameters);
+
+    if (parameters ["path"].isNotEmpty ())
+    {
+        File const path (NodeStoreRotatorImp::getPath (parameters));
+        std::vector <int> const generations (
+            NodeStoreRotatorImp::findGenerations (path));
+
+        if (! generations.empty () && generations.front () != 0)
+            result.set ("path", NodeStoreRotatorImp::getGenerationPath (
+                path, generations.front ()).getFullPathName ());
+    }
+
+    return result;
+}
+
+}
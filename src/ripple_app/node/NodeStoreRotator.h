@@ -0,0 +1,71 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_APP_NODESTOREROTATOR_H_INCLUDED
+#define RIPPLE_APP_NODESTOREROTATOR_H_INCLUDED
+
+namespace ripple {
+
+/** Keeps the node store to a bounded span of recent history.
+
+    When the [node_db] section sets online_delete to a number of ledgers,
+    the node store is moved onto a fresh backend each time that many
+    ledgers have been validated. Backends live beside the configured path,
+    the first at the path itself and later ones with a numbered suffix.
+
+    While a rotation runs, new objects go to the fresh backend and
+    everything reachable from the most recent validated ledgers is copied
+    forward in the background, pausing while the store has a backlog of
+    writes. Then the old backend is closed and its files are removed.
+*/
+class NodeStoreRotator
+    : public Stoppable
+    , public PropertyStream::Source
+{
+protected:
+    explicit NodeStoreRotator (Stoppable& parent);
+
+public:
+    /** Create a new object.
+        The caller receives ownership and must delete the object when done.
+        @param parameters The [node_db] section used to open the database.
+    */
+    static NodeStoreRotator* New (
+        Stoppable& parent,
+        NodeStore::Manager& manager,
+        NodeStore::Scheduler& scheduler,
+        NodeStore::Database& database,
+        NodeStore::Parameters const& parameters,
+        Journal journal);
+
+    /** Destroy the object. */
+    virtual ~NodeStoreRotator () = 0;
+
+    /** Return the parameters which open the current backend.
+        This is the oldest backend still on disk. If a rotation was
+        interrupted, it is resumed when the rotator starts.
+        @param parameters The [node_db] section from the configuration.
+    */
+    static NodeStore::Parameters getCurrentParameters (
+        NodeStore::Parameters const& parameters);
+};
+
+}
+
+#endif
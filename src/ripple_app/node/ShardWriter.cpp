@@ -0,0 +1,325 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include "../main/Tuning.h"
+
+namespace ripple {
+
+class ShardWriterImp
+    : public ShardWriter
+    , public Thread
+    , public LeakChecked <ShardWriterImp>
+{
+public:
+    struct State
+    {
+        State ()
+            : ledgerIndex (0)
+            , copied (0)
+            , failed (0)
+        {
+        }
+
+        LedgerIndex  ledgerIndex;   // The ledger being copied now
+        std::size_t  copied;        // Ledgers copied since starting
+        std::size_t  failed;        // Copies stopped by a missing node
+    };
+
+    typedef SharedData <State> SharedState;
+
+    // A node waiting to be stored, once its children are
+    struct Entry
+    {
+        explicit Entry (uint256 const& hash_)
+            : hash (hash_)
+        {
+        }
+
+        uint256 hash;
+        NodeObject::pointer object;     // Set when its children are queued
+    };
+
+    NodeStore::ShardStore* m_shards;
+    NodeStore::Database& m_database;
+    Journal m_journal;
+    SharedState m_state;
+
+    //--------------------------------------------------------------------------
+
+    ShardWriterImp (
+        Stoppable& parent,
+        NodeStore::ShardStore* shards,
+        NodeStore::Database& database,
+        Journal journal)
+        : ShardWriter (parent)
+        , Thread ("ShardWriter")
+        , m_shards (shards)
+        , m_database (database)
+        , m_journal (journal)
+    {
+    }
+
+    ~ShardWriterImp ()
+    {
+        stopThread ();
+    }
+
+    //--------------------------------------------------------------------------
+    //
+    // Stoppable
+    //
+    //--------------------------------------------------------------------------
+
+    void onPrepare ()
+    {
+    }
+
+    void onStart ()
+    {
+        if (m_shards != nullptr)
+            startThread ();
+    }
+
+    void onStop ()
+    {
+        if (isThreadRunning ())
+        {
+            m_journal.info << "Stopping";
+            signalThreadShouldExit ();
+            notify ();
+        }
+        else
+        {
+            stopped ();
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    //
+    // PropertyStream
+    //
+    //--------------------------------------------------------------------------
+
+    void onWrite (PropertyStream::Map& map)
+    {
+        if (m_shards == nullptr)
+        {
+            map ["status"] = "disabled";
+            return;
+        }
+
+        {
+            SharedState::Access state (m_state);
+
+            if (state->ledgerIndex == 0)
+            {
+                map ["status"] = "idle";
+            }
+            else
+            {
+                map ["status"] = "copying";
+                map ["ledger_current"] = state->ledgerIndex;
+            }
+
+            map ["ledgers_copied"] = state->copied;
+            if (state->failed > 0)
+                map ["ledgers_failed"] = state->failed;
+        }
+
+        map ["complete_ledgers"] = m_shards->getCompleteLedgers ();
+        map ["final_shards"] = m_shards->getFinalShards ().size ();
+    }
+
+    //--------------------------------------------------------------------------
+    //
+    // ShardWriterImp
+    //
+    //--------------------------------------------------------------------------
+
+    void run ()
+    {
+        m_journal.debug << "Started";
+
+        while (! this->threadShouldExit ())
+        {
+            Ledger::pointer const ledger (
+                getApp().getLedgerMaster ().getValidatedLedger ());
+
+            if (ledger != nullptr)
+                copyLedgers (ledger->getLedgerSeq ());
+
+            this->wait (shardPollMilliseconds);
+        }
+
+        stopped ();
+    }
+
+    /** Copy the ledgers missing from the shards, newest first. */
+    void copyLedgers (LedgerIndex validated)
+    {
+        for (LedgerIndex index (m_shards->prevMissing (validated + 1));
+            index != RangeSet::absent && index != 0 && ! this->threadShouldExit ();
+            index = m_shards->prevMissing (index))
+        {
+            // Older history has to be acquired first
+            if (! getApp().getLedgerMaster ().haveLedger (index))
+                break;
+
+            {
+                SharedState::Access state (m_state);
+                state->ledgerIndex = index;
+            }
+
+            bool const copied (copyLedger (index));
+
+            {
+                SharedState::Access state (m_state);
+                if (copied)
+                    ++state->copied;
+                else if (! this->threadShouldExit ())
+                    ++state->failed;
+            }
+
+            // Try again on the next pass
+            if (! copied)
+                break;
+        }
+
+        SharedState::Access state (m_state);
+        state->ledgerIndex = 0;
+    }
+
+    /** Copy a ledger and everything reachable from it to its shard. */
+    bool copyLedger (LedgerIndex index)
+    {
+        Ledger::pointer const ledger (
+            getApp().getLedgerMaster ().getLedgerBySeq (index));
+
+        if (ledger == nullptr || ledger->getLedgerSeq () != index)
+        {
+            m_journal.debug << "Ledger " << index << " not available";
+            return false;
+        }
+
+        NodeObject::pointer const header (m_database.fetch (ledger->getHash ()));
+
+        if (header == nullptr)
+        {
+            m_journal.debug << "Ledger " << index << " header not found";
+            return false;
+        }
+
+        if (! copyTree (ledger->getAccountHash (), index))
+            return false;
+
+        if (ledger->getTransHash ().isNonZero () &&
+            ! copyTree (ledger->getTransHash (), index))
+            return false;
+
+        m_shards->store (header, index);
+        m_shards->setStored (index);
+
+        return true;
+    }
+
+    /** Copy a SHAMap to the shard, storing each node after its children.
+        A node already in the shard is skipped along with all below it.
+    */
+    bool copyTree (uint256 const& root, LedgerIndex index)
+    {
+        std::vector <Entry> stack (1, Entry (root));
+
+        while (! stack.empty ())
+        {
+            // Let the shard's writes drain before adding to them
+            while (m_shards->getWriteLoad () > shardWriteLoadLimit &&
+                ! this->threadShouldExit ())
+                this->wait (100);
+
+            if (this->threadShouldExit ())
+                return false;
+
+            if (stack.back ().object != nullptr)
+            {
+                m_shards->store (stack.back ().object, index);
+                stack.pop_back ();
+                continue;
+            }
+
+            uint256 const hash (stack.back ().hash);
+
+            if (m_shards->fetch (hash, index) != nullptr)
+            {
+                stack.pop_back ();
+                continue;
+            }
+
+            // Most of a ledger's history is cold, keep it out of the caches
+            NodeObject::pointer const object (m_database.fetchUncached (hash));
+
+            if (object == nullptr)
+            {
+                m_journal.debug << "Ledger " << index << " is missing node " << hash;
+                return false;
+            }
+
+            if (! isInnerNodeObject (*object))
+            {
+                m_shards->store (object, index);
+                stack.pop_back ();
+                continue;
+            }
+
+            stack.back ().object = object;
+
+            for (int branch = 0; branch < 16; ++branch)
+            {
+                uint256 const child (getInnerNodeChild (*object, branch));
+
+                if (child.isNonZero ())
+                    stack.push_back (Entry (child));
+            }
+        }
+
+        return true;
+    }
+};
+
+//------------------------------------------------------------------------------
+
+ShardWriter::ShardWriter (Stoppable& parent)
+    : Stoppable ("ShardWriter", parent)
+    , PropertyStream::Source ("shardwriter")
+{
+}
+
+ShardWriter::~ShardWriter ()
+{
+}
+
+ShardWriter* ShardWriter::New (
+    Stoppable& parent,
+    NodeStore::ShardStore* shards,
+    NodeStore::Database& database,
+    Journal journal)
+{
+    return new ShardWriterImp (parent, shards, database, journal);
+}
+
+}
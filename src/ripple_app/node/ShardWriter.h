@@ -0,0 +1,58 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_APP_SHARDWRITER_H_INCLUDED
+#define RIPPLE_APP_SHARDWRITER_H_INCLUDED
+
+namespace ripple {
+
+/** Copies validated ledgers from the node store into the shard store.
+
+    Starting at the newest validated ledger and working back through
+    history until it reaches a ledger the server doesn't have, each ledger
+    missing from the shard store is copied along with everything reachable
+    from it. Nodes are stored after their children, so a node already in
+    the shard means the whole subtree below it is too, and copying the
+    next ledger costs about as much as the nodes it changed.
+*/
+class ShardWriter
+    : public Stoppable
+    , public PropertyStream::Source
+{
+protected:
+    explicit ShardWriter (Stoppable& parent);
+
+public:
+    /** Create a new object.
+        The caller receives ownership and must delete the object when done.
+        @param shards The shard store, or nullptr if there is none.
+    */
+    static ShardWriter* New (
+        Stoppable& parent,
+        NodeStore::ShardStore* shards,
+        NodeStore::Database& database,
+        Journal journal);
+
+    /** Destroy the object. */
+    virtual ~ShardWriter () = 0;
+};
+
+}
+
+#endif
@@ -197,7 +197,7 @@ public:
         statement.bind(1, object->getHash().GetHex());
         statement.bind(2, type);
         statement.bind(3, object->getIndex());
-        statement.bindStatic(4, object->getData());
+        statement.bindStatic(4, object->getData(), object->getSize());
     }
 
     NodeObjectType getTypeFromString (std::string const& s)
@@ -50,6 +50,8 @@
 
 #include "misc/ProofOfWorkFactory.h"
 
+#include "main/Tuning.h"
+
 namespace ripple {
 # include "main/NodeStoreScheduler.h"
 #include "main/NodeStoreScheduler.cpp"
@@ -89,6 +91,13 @@ namespace ripple {
 
 # include "node/SqliteFactory.h"
 #include "node/SqliteFactory.cpp"
+# include "node/InnerNodeObject.h"
+# include "node/NodeStoreRotator.h"
+#include "node/NodeStoreRotator.cpp"
+# include "node/ShardWriter.h"
+#include "node/ShardWriter.cpp"
+# include "node/HotSnapshot.h"
+#include "node/HotSnapshot.cpp"
 
 #include "main/Application.cpp"
 
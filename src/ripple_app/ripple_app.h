@@ -47,6 +47,13 @@
 #include <boost/weak_ptr.hpp>
 #include <boost/thread/shared_mutex.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
 //------------------------------------------------------------------------------
 
 #include "../ripple_basics/ripple_basics.h"
@@ -64,6 +71,7 @@
 
 #include "../../ripple/common/KeyCache.h"
 #include "../../ripple/common/TaggedCache.h"
+#include "../../ripple/common/ShardedTaggedCache.h"
 
 #include "../../ripple_overlay/ripple_overlay.h"
 
@@ -79,6 +87,7 @@ namespace ripple {
 //             get the specialization for std::hash, et. al.
 #include "shamap/SHAMapNode.h"
 #include "shamap/SHAMapTreeNode.h"
+#include "shamap/SHAMapHashPool.h"
 #include "shamap/SHAMapMissingNode.h"
 #include "shamap/SHAMapSyncFilter.h"
 #include "shamap/SHAMapAddNode.h"
@@ -99,6 +108,7 @@ namespace ripple {
 #include "misc/IFeatures.h"
 #include "misc/IFeeVote.h"
 #include "misc/IHashRouter.h"
+#include "misc/SigVerifier.h"
 #include "peers/ClusterNodeStatus.h"
 #include "peers/UniqueNodeList.h"
 #include "misc/Validations.h"
@@ -119,6 +129,7 @@ namespace ripple {
 #include "ledger/LedgerCleaner.h"
 #include "ledger/LedgerMaster.h"
 #include "ledger/LedgerProposal.h"
+#include "misc/AccountSubscriptions.h"
 #include "misc/NetworkOPs.h"
 #include "tx/TransactionMaster.h"
 #include "main/LocalCredentials.h"
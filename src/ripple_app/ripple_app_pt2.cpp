@@ -23,9 +23,14 @@
 
 #include "../ripple/common/seconds_clock.h"
 
+#include <atomic>
+#include <exception>
+#include <thread>
+
 namespace ripple {
 
 #include "shamap/SHAMap.cpp" // Uses theApp
+#include "shamap/SHAMapHashPool.cpp"
 #include "shamap/SHAMapItem.cpp"
 #include "shamap/SHAMapSync.cpp"
 #include "shamap/SHAMapMissingNode.cpp"
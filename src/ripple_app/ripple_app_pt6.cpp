@@ -23,6 +23,10 @@
 
 #include "../ripple/common/seconds_clock.h"
 
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
 namespace ripple {
 
 #include "ledger/LedgerEntrySet.cpp"
@@ -31,6 +35,7 @@ namespace ripple {
 #include "ledger/OrderBookIterator.cpp"
 #include "consensus/DisputedTx.cpp"
 #include "misc/HashRouter.cpp"
+#include "misc/SigVerifier.cpp"
 #include "misc/Offer.cpp"
 #include "paths/Pathfinder.cpp"
 #include "misc/Features.cpp"
@@ -25,6 +25,9 @@
 
 #include "../ripple/common/seconds_clock.h"
 
+#include <chrono>
+#include <thread>
+
 namespace ripple
 {
 
@@ -35,6 +38,7 @@ namespace ripple
 
 # include "tx/TxQueueEntry.h"
 # include "tx/TxQueue.h"
+#include "misc/AccountSubscriptions.cpp"
 #include "misc/NetworkOPs.cpp"
 
 }
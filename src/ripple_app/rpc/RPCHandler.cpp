@@ -26,6 +26,7 @@ SETUP_LOG (RPCHandler)
 RPCHandler::RPCHandler (NetworkOPs* netOps)
     : mNetOps (netOps)
     , mRole (Config::FORBID)
+    , mDeferLargeResults (false)
 {
 }
 
@@ -33,9 +34,24 @@ RPCHandler::RPCHandler (NetworkOPs* netOps, InfoSub::pointer infoSub)
     : mNetOps (netOps)
     , mInfoSub (infoSub)
     , mRole (Config::FORBID)
+    , mDeferLargeResults (false)
 {
 }
 
+void RPCHandler::deferLargeResults ()
+{
+    mDeferLargeResults = true;
+}
+
+void RPCHandler::writeDeferred (Json::StreamWriter& writer)
+{
+    if (mDeferred)
+    {
+        mDeferred (writer);
+        mDeferred = nullptr;
+    }
+}
+
 class LegacyPathFind
 {
 public:
@@ -700,9 +716,8 @@ Json::Value RPCHandler::accountFromString (Ledger::ref lrLedger, RippleAddress&
     return Json::Value (Json::objectValue);
 }
 
-Json::Value RPCHandler::doAccountCurrencies (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
+Json::Value RPCHandler::doAccountCurrencies (Json::Value params, Resource::Charge& loadType)
 {
-    masterLockHolder.unlock ();
     // Get the current ledger
     Ledger::pointer lpLedger;
     Json::Value jvResult (lookupLedger (params, lpLedger));
@@ -770,10 +785,8 @@ Json::Value RPCHandler::doAccountCurrencies (Json::Value params, Resource::Charg
 //   ledger_hash : <ledger>
 //   ledger_index : <ledger_index>
 // }
-Json::Value RPCHandler::doAccountInfo (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
+Json::Value RPCHandler::doAccountInfo (Json::Value params, Resource::Charge& loadType)
 {
-    masterLockHolder.unlock ();
-
     Ledger::pointer     lpLedger;
     Json::Value         jvResult    = lookupLedger (params, lpLedger);
 
@@ -1267,10 +1280,37 @@ Json::Value RPCHandler::doProofVerify (Json::Value params, Resource::Charge& loa
 //   ledger_hash : <ledger>
 //   ledger_index : <ledger_index>
 // }
-Json::Value RPCHandler::doAccountLines (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
+static Json::Value getLineJson (RippleState& line)
 {
-    masterLockHolder.unlock ();
+    const STAmount&     saBalance   = line.getBalance ();
+    const STAmount&     saLimit     = line.getLimit ();
+    const STAmount&     saLimitPeer = line.getLimitPeer ();
+
+    Json::Value         jPeer (Json::objectValue);
+
+    jPeer["account"]        = RippleAddress::createHumanAccountID (line.getAccountIDPeer ());
+    // Amount reported is positive if current account holds other account's IOUs.
+    // Amount reported is negative if other account holds current account's IOUs.
+    jPeer["balance"]        = saBalance.getText ();
+    jPeer["currency"]       = saBalance.getHumanCurrency ();
+    jPeer["limit"]          = saLimit.getText ();
+    jPeer["limit_peer"]     = saLimitPeer.getText ();
+    jPeer["quality_in"]     = static_cast<Json::UInt> (line.getQualityIn ());
+    jPeer["quality_out"]    = static_cast<Json::UInt> (line.getQualityOut ());
+    if (line.getAuth())
+        jPeer["authorized"] = true;
+    if (line.getAuthPeer())
+        jPeer["peer_authorized"] = true;
+    if (line.getNoRipple())
+        jPeer["no_ripple"]  = true;
+    if (line.getNoRipplePeer())
+        jPeer["no_ripple_peer"] = true;
+
+    return jPeer;
+}
 
+Json::Value RPCHandler::doAccountLines (Json::Value params, Resource::Charge& loadType)
+{
     Ledger::pointer     lpLedger;
     Json::Value         jvResult    = lookupLedger (params, lpLedger);
 
@@ -1315,39 +1355,33 @@ Json::Value RPCHandler::doAccountLines (Json::Value params, Resource::Charge& lo
         AccountItems rippleLines (raAccount.getAccountID (), lpLedger, AccountItem::pointer (new RippleState ()));
 
         jvResult["account"] = raAccount.humanAccountID ();
-        Json::Value& jsonLines = (jvResult["lines"] = Json::arrayValue);
-
 
+        AccountItems::Container lines;
         BOOST_FOREACH (AccountItem::ref item, rippleLines.getItems ())
         {
             RippleState* line = (RippleState*)item.get ();
 
             if (!raPeer.isValid () || raPeer.getAccountID () == line->getAccountIDPeer ())
+                lines.push_back (item);
+        }
+
+        // An account can have a great many lines, write them as the reply is sent
+        if (mDeferLargeResults)
+        {
+            mDeferred = [lines] (Json::StreamWriter& writer)
             {
-                const STAmount&     saBalance   = line->getBalance ();
-                const STAmount&     saLimit     = line->getLimit ();
-                const STAmount&     saLimitPeer = line->getLimitPeer ();
-
-                Json::Value&    jPeer   = jsonLines.append (Json::objectValue);
-
-                jPeer["account"]        = RippleAddress::createHumanAccountID (line->getAccountIDPeer ());
-                // Amount reported is positive if current account holds other account's IOUs.
-                // Amount reported is negative if other account holds current account's IOUs.
-                jPeer["balance"]        = saBalance.getText ();
-                jPeer["currency"]       = saBalance.getHumanCurrency ();
-                jPeer["limit"]          = saLimit.getText ();
-                jPeer["limit_peer"]     = saLimitPeer.getText ();
-                jPeer["quality_in"]     = static_cast<Json::UInt> (line->getQualityIn ());
-                jPeer["quality_out"]    = static_cast<Json::UInt> (line->getQualityOut ());
-                if (line->getAuth())
-                    jPeer["authorized"] = true;
-                if (line->getAuthPeer())
-                    jPeer["peer_authorized"] = true;
-                if (line->getNoRipple())
-                    jPeer["no_ripple"]  = true;
-                if (line->getNoRipplePeer())
-                    jPeer["no_ripple_peer"] = true;
-            }
+                writer.startArray ("lines");
+                BOOST_FOREACH (AccountItem::ref item, lines)
+                    writer.value (getLineJson (*(RippleState*)item.get ()));
+                writer.end ();
+            };
+        }
+        else
+        {
+            Json::Value& jsonLines = (jvResult["lines"] = Json::arrayValue);
+
+            BOOST_FOREACH (AccountItem::ref item, lines)
+                jsonLines.append (getLineJson (*(RippleState*)item.get ()));
         }
 
         loadType = Resource::feeMediumBurdenRPC;
@@ -1378,10 +1412,8 @@ static void offerAdder (Json::Value& jvLines, SLE::ref offer)
 //   ledger_hash : <ledger>
 //   ledger_index : <ledger_index>
 // }
-Json::Value RPCHandler::doAccountOffers (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
+Json::Value RPCHandler::doAccountOffers (Json::Value params, Resource::Charge& loadType)
 {
-    masterLockHolder.unlock ();
-
     Ledger::pointer     lpLedger;
     Json::Value         jvResult    = lookupLedger (params, lpLedger);
 
@@ -1457,10 +1489,8 @@ inline uint160 const& neutral_issuer ()
 //   "limit" : integer,                  // Optional.
 //   "proof" : boolean                   // Defaults to false.
 // }
-Json::Value RPCHandler::doBookOffers (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
+Json::Value RPCHandler::doBookOffers (Json::Value params, Resource::Charge& loadType)
 {
-    masterLockHolder.unlock ();
-
     // VFALCO TODO Here is a terrible place for this kind of business
     //             logic. It needs to be moved elsewhere and documented,
     //             and encapsulated into a function.
@@ -2219,9 +2249,8 @@ Json::Value RPCHandler::doTx (Json::Value params, Resource::Charge& loadType, Ap
     return rpcError (rpcNOT_IMPL);
 }
 
-Json::Value RPCHandler::doLedgerClosed (Json::Value, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
+Json::Value RPCHandler::doLedgerClosed (Json::Value, Resource::Charge& loadType)
 {
-    masterLockHolder.unlock ();
     Json::Value jvResult;
 
     uint256 uLedger = mNetOps->getClosedLedgerHash ();
@@ -2233,9 +2262,8 @@ Json::Value RPCHandler::doLedgerClosed (Json::Value, Resource::Charge& loadType,
     return jvResult;
 }
 
-Json::Value RPCHandler::doLedgerCurrent (Json::Value, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
+Json::Value RPCHandler::doLedgerCurrent (Json::Value, Resource::Charge& loadType)
 {
-    masterLockHolder.unlock ();
     Json::Value jvResult;
 
     jvResult["ledger_current_index"]    = mNetOps->getCurrentLedgerID ();
@@ -2287,6 +2315,17 @@ Json::Value RPCHandler::doLedger (Json::Value params, Resource::Charge& loadType
             return rpcError(rpcTOO_BUSY);
         }
         loadType = Resource::feeHighBurdenRPC;
+
+        // A full ledger is written as it is visited rather than built here
+        if (mDeferLargeResults)
+        {
+            mDeferred = [lpLedger, iOptions] (Json::StreamWriter& writer)
+            {
+                lpLedger->addJson (writer, iOptions);
+            };
+
+            return Json::Value (Json::objectValue);
+        }
     }
 
 
@@ -2544,47 +2583,74 @@ Json::Value RPCHandler::doAccountTx (Json::Value params, Resource::Charge& loadT
         Json::Value ret (Json::objectValue);
 
         ret["account"] = raAccount.humanAccountID ();
-        Json::Value& jvTxns = (ret["transactions"] = Json::arrayValue);
+
+        // Calls the adder with each transaction's entry in the reply
+        typedef std::function <void (Json::Value const&)> Adder;
+        std::function <void (Adder const&)> visitTxns;
 
         if (bBinary)
         {
             std::vector<NetworkOPs::txnMetaLedgerType> txns =
                 mNetOps->getTxsAccountB (raAccount, uLedgerMin, uLedgerMax, bForward, resumeToken, limit, mRole == Config::ADMIN);
 
-            for (std::vector<NetworkOPs::txnMetaLedgerType>::const_iterator it = txns.begin (), end = txns.end ();
-                    it != end; ++it)
+            visitTxns = [txns, bValidated, uValidatedMin, uValidatedMax] (Adder const& add)
             {
-                Json::Value& jvObj = jvTxns.append (Json::objectValue);
+                for (std::vector<NetworkOPs::txnMetaLedgerType>::const_iterator it = txns.begin (), end = txns.end ();
+                        it != end; ++it)
+                {
+                    Json::Value jvObj (Json::objectValue);
 
-                uint32  uLedgerIndex    = it->get<2> ();
-                jvObj["tx_blob"]        = it->get<0> ();
-                jvObj["meta"]           = it->get<1> ();
-                jvObj["ledger_index"]   = uLedgerIndex;
-                jvObj["validated"]      = bValidated && uValidatedMin <= uLedgerIndex && uValidatedMax >= uLedgerIndex;
+                    uint32  uLedgerIndex    = it->get<2> ();
+                    jvObj["tx_blob"]        = it->get<0> ();
+                    jvObj["meta"]           = it->get<1> ();
+                    jvObj["ledger_index"]   = uLedgerIndex;
+                    jvObj["validated"]      = bValidated && uValidatedMin <= uLedgerIndex && uValidatedMax >= uLedgerIndex;
 
-            }
+                    add (jvObj);
+                }
+            };
         }
         else
         {
             std::vector< std::pair<Transaction::pointer, TransactionMetaSet::pointer> > txns =
                  mNetOps->getTxsAccount (raAccount, uLedgerMin, uLedgerMax, bForward, resumeToken, limit, mRole == Config::ADMIN);
 
-            for (std::vector< std::pair<Transaction::pointer, TransactionMetaSet::pointer> >::iterator it = txns.begin (), end = txns.end (); it != end; ++it)
+            visitTxns = [txns, bValidated, uValidatedMin, uValidatedMax] (Adder const& add)
             {
-                Json::Value&    jvObj = jvTxns.append (Json::objectValue);
+                for (std::vector< std::pair<Transaction::pointer, TransactionMetaSet::pointer> >::const_iterator it = txns.begin (), end = txns.end (); it != end; ++it)
+                {
+                    Json::Value jvObj (Json::objectValue);
 
-                if (it->first)
-                    jvObj["tx"]             = it->first->getJson (1);
+                    if (it->first)
+                        jvObj["tx"]             = it->first->getJson (1);
 
-                if (it->second)
-                {
-                    uint32 uLedgerIndex = it->second->getLgrSeq ();
+                    if (it->second)
+                    {
+                        uint32 uLedgerIndex = it->second->getLgrSeq ();
 
-                    jvObj["meta"]           = it->second->getJson (0);
-                    jvObj["validated"]      = bValidated && uValidatedMin <= uLedgerIndex && uValidatedMax >= uLedgerIndex;
+                        jvObj["meta"]           = it->second->getJson (0);
+                        jvObj["validated"]      = bValidated && uValidatedMin <= uLedgerIndex && uValidatedMax >= uLedgerIndex;
+                    }
+
+                    add (jvObj);
                 }
+            };
+        }
 
-            }
+        // A page can hold thousands of transactions, write them as the reply is sent
+        if (mDeferLargeResults)
+        {
+            mDeferred = [visitTxns] (Json::StreamWriter& writer)
+            {
+                writer.startArray ("transactions");
+                visitTxns ([&writer] (Json::Value const& txn) { writer.value (txn); });
+                writer.end ();
+            };
+        }
+        else
+        {
+            Json::Value& jvTxns = (ret["transactions"] = Json::arrayValue);
+            visitTxns ([&jvTxns] (Json::Value const& txn) { jvTxns.append (txn); });
         }
 
         //Add information about the original query
@@ -2933,12 +2999,31 @@ Json::Value RPCHandler::doGetCounts (Json::Value params, Resource::Charge& loadT
 
     ret["SLE_hit_rate"] = getApp().getSLECache ().getHitRate ();
     ret["node_hit_rate"] = getApp().getNodeStore ().getCacheHitRate ();
+    ret["node_compressed_hit_rate"] =
+        getApp().getNodeStore ().getCompressedCacheHitRate ();
+
+    {
+        NodeStore::WriteStats const stats (
+            getApp().getNodeStore ().getWriteStats ());
+        Json::Value& writes (ret["node_writes"] = Json::objectValue);
+        writes["batches"] = static_cast <Json::UInt> (stats.batches);
+        writes["objects"] = static_cast <Json::UInt> (stats.objects);
+        writes["stalls"] = static_cast <Json::UInt> (stats.stalls);
+        writes["last_us"] = static_cast <Json::UInt> (stats.lastMicroseconds);
+        writes["max_us"] = static_cast <Json::UInt> (stats.maxMicroseconds);
+        if (stats.batches > 0)
+            writes["average_us"] = static_cast <Json::UInt> (
+                stats.totalMicroseconds / stats.batches);
+    }
+
     ret["ledger_hit_rate"] = getApp().getLedgerMaster ().getCacheHitRate ();
     ret["AL_hit_rate"] = AcceptedLedger::getCacheHitRate ();
 
     ret["fullbelow_size"] = int(getApp().getFullBelowCache().size());
     ret["treenode_size"] = SHAMap::getTreeNodeSize ();
 
+    ret["job_types"] = getApp().getJobQueue ().getJson ()["job_types"];
+
     std::string uptime;
     int s = UptimeTimer::getInstance ().getElapsedSeconds ();
     textTime (uptime, s, "year", 365 * 24 * 60 * 60);
@@ -3143,10 +3228,8 @@ Json::Value RPCHandler::doLedgerCleaner (Json::Value parameters, Resource::Charg
 //   ledger_index : <ledger_index>
 // }
 // XXX In this case, not specify either ledger does not mean ledger current. It means any ledger.
-Json::Value RPCHandler::doTransactionEntry (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
+Json::Value RPCHandler::doTransactionEntry (Json::Value params, Resource::Charge& loadType)
 {
-    masterLockHolder.unlock ();
-
     Ledger::pointer     lpLedger;
     Json::Value         jvResult    = lookupLedger (params, lpLedger);
 
@@ -3351,10 +3434,8 @@ Json::Value RPCHandler::lookupLedger (Json::Value const& params, Ledger::pointer
 //   ledger_index : <ledger_index>
 //   ...
 // }
-Json::Value RPCHandler::doLedgerEntry (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
+Json::Value RPCHandler::doLedgerEntry (Json::Value params, Resource::Charge& loadType)
 {
-    masterLockHolder.unlock ();
-
     Ledger::pointer     lpLedger;
     Json::Value         jvResult    = lookupLedger (params, lpLedger);
 
@@ -3556,10 +3637,8 @@ Json::Value RPCHandler::doLedgerEntry (Json::Value params, Resource::Charge& loa
 //   ledger_hash : <ledger>
 //   ledger_index : <ledger_index>
 // }
-Json::Value RPCHandler::doLedgerHeader (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
+Json::Value RPCHandler::doLedgerHeader (Json::Value params, Resource::Charge& loadType)
 {
-    masterLockHolder.unlock ();
-
     Ledger::pointer     lpLedger;
     Json::Value         jvResult    = lookupLedger (params, lpLedger);
 
@@ -4170,13 +4249,8 @@ Json::Value RPCHandler::doCommand (const Json::Value& params, int iRole, Resourc
     } commandsA[] =
     {
         // Request-response methods
-        {   "account_info",         &RPCHandler::doAccountInfo,         false,  optCurrent  },
-        {   "account_currencies",   &RPCHandler::doAccountCurrencies,   false,  optCurrent  },
-        {   "account_lines",        &RPCHandler::doAccountLines,        false,  optCurrent  },
-        {   "account_offers",       &RPCHandler::doAccountOffers,       false,  optCurrent  },
         {   "account_tx",           &RPCHandler::doAccountTxSwitch,     false,  optNetwork  },
         {   "blacklist",            &RPCHandler::doBlackList,           true,   optNone     },
-        {   "book_offers",          &RPCHandler::doBookOffers,          false,  optCurrent  },
         {   "connect",              &RPCHandler::doConnect,             true,   optNone     },
         {   "consensus_info",       &RPCHandler::doConsensusInfo,       true,   optNone     },
         {   "get_counts",           &RPCHandler::doGetCounts,           true,   optNone     },
@@ -4186,10 +4260,6 @@ Json::Value RPCHandler::doCommand (const Json::Value& params, int iRole, Resourc
         {   "ledger",               &RPCHandler::doLedger,              false,  optNetwork  },
         {   "ledger_accept",        &RPCHandler::doLedgerAccept,        true,   optCurrent  },
         {   "ledger_cleaner",       &RPCHandler::doLedgerCleaner,       true,   optNetwork  },
-        {   "ledger_closed",        &RPCHandler::doLedgerClosed,        false,  optClosed   },
-        {   "ledger_current",       &RPCHandler::doLedgerCurrent,       false,  optCurrent  },
-        {   "ledger_entry",         &RPCHandler::doLedgerEntry,         false,  optCurrent  },
-        {   "ledger_header",        &RPCHandler::doLedgerHeader,        false,  optCurrent  },
         {   "log_level",            &RPCHandler::doLogLevel,            true,   optNone     },
         {   "logrotate",            &RPCHandler::doLogRotate,           true,   optNone     },
 //      {   "nickname_info",        &RPCHandler::doNicknameInfo,        false,  optCurrent  },
@@ -4210,7 +4280,6 @@ Json::Value RPCHandler::doCommand (const Json::Value& params, int iRole, Resourc
         {   "server_state",         &RPCHandler::doServerState,         false,  optNone     },
         {   "sms",                  &RPCHandler::doSMS,                 true,   optNone     },
         {   "stop",                 &RPCHandler::doStop,                true,   optNone     },
-        {   "transaction_entry",    &RPCHandler::doTransactionEntry,    false,  optCurrent  },
         {   "tx",                   &RPCHandler::doTx,                  false,  optNetwork  },
         {   "tx_history",           &RPCHandler::doTxHistory,           false,  optNone     },
         {   "unl_add",              &RPCHandler::doUnlAdd,              true,   optNone     },
@@ -4239,6 +4308,48 @@ Json::Value RPCHandler::doCommand (const Json::Value& params, int iRole, Resourc
         {   "unsubscribe",          &RPCHandler::doUnsubscribe,         false,  optNone     },
     };
 
+    // Read-only methods. These look up an immutable ledger through the
+    // LedgerMaster, which has its own locks, so they run without taking
+    // the master lock and don't wait behind ledger close or each other.
+    static struct
+    {
+        const char*         pCommand;
+        doReadOnlyFuncPtr   dfpFunc;
+        unsigned int        iOptions;
+    } commandsR[] =
+    {
+        {   "account_currencies",   &RPCHandler::doAccountCurrencies,   optCurrent  },
+        {   "account_info",         &RPCHandler::doAccountInfo,         optCurrent  },
+        {   "account_lines",        &RPCHandler::doAccountLines,        optCurrent  },
+        {   "account_offers",       &RPCHandler::doAccountOffers,       optCurrent  },
+        {   "book_offers",          &RPCHandler::doBookOffers,          optCurrent  },
+        {   "ledger_closed",        &RPCHandler::doLedgerClosed,        optClosed   },
+        {   "ledger_current",       &RPCHandler::doLedgerCurrent,       optCurrent  },
+        {   "ledger_entry",         &RPCHandler::doLedgerEntry,         optCurrent  },
+        {   "ledger_header",        &RPCHandler::doLedgerHeader,        optCurrent  },
+        {   "transaction_entry",    &RPCHandler::doTransactionEntry,    optCurrent  },
+    };
+
+    int     r = NUMBER (commandsR);
+
+    while (r-- && strCommand != commandsR[r].pCommand)
+        ;
+
+    if (r >= 0)
+    {
+        Json::Value jvError = checkOptions (commandsR[r].iOptions);
+
+        if (!jvError.isNull ())
+            return jvError;
+
+        doReadOnlyFuncPtr const dfpFunc = commandsR[r].dfpFunc;
+
+        return runCommand (strCommand, loadType, [&] ()
+        {
+            return (this->* dfpFunc) (params, loadType);
+        });
+    }
+
     int     i = NUMBER (commandsA);
 
     while (i-- && strCommand != commandsA[i].pCommand)
@@ -4256,55 +4367,77 @@ Json::Value RPCHandler::doCommand (const Json::Value& params, int iRole, Resourc
     {
         Application::ScopedLockType lock (getApp().getMasterLock (), __FILE__, __LINE__);
 
-        if ((commandsA[i].iOptions & optNetwork) && (mNetOps->getOperatingMode () < NetworkOPs::omSYNCING))
-        {
-            WriteLog (lsINFO, RPCHandler) << "Insufficient network mode for RPC: " << mNetOps->strOperatingMode ();
+        Json::Value jvError = checkOptions (commandsA[i].iOptions);
 
-            return rpcError (rpcNO_NETWORK);
-        }
+        if (!jvError.isNull ())
+            return jvError;
+
+        doFuncPtr const dfpFunc = commandsA[i].dfpFunc;
 
-        if (!getConfig ().RUN_STANDALONE && (commandsA[i].iOptions & optCurrent) && (getApp().getLedgerMaster().getValidatedLedgerAge() > 120))
+        return runCommand (strCommand, loadType, [&] ()
         {
-            return rpcError (rpcNO_CURRENT);
-        }
-        else if ((commandsA[i].iOptions & optClosed) && !mNetOps->getClosedLedger ())
+            return (this->* dfpFunc) (params, loadType, lock);
+        });
+    }
+}
+
+// Returns an error if the server isn't in a state to run a command with
+// the given options, or null if it is.
+Json::Value RPCHandler::checkOptions (unsigned int iOptions)
+{
+    if ((iOptions & optNetwork) && (mNetOps->getOperatingMode () < NetworkOPs::omSYNCING))
+    {
+        WriteLog (lsINFO, RPCHandler) << "Insufficient network mode for RPC: " << mNetOps->strOperatingMode ();
+
+        return rpcError (rpcNO_NETWORK);
+    }
+
+    if (!getConfig ().RUN_STANDALONE && (iOptions & optCurrent) && (getApp().getLedgerMaster().getValidatedLedgerAge() > 120))
+    {
+        return rpcError (rpcNO_CURRENT);
+    }
+    else if ((iOptions & optClosed) && !mNetOps->getClosedLedger ())
+    {
+        return rpcError (rpcNO_CLOSED);
+    }
+
+    return Json::Value ();
+}
+
+template <class Handler>
+Json::Value RPCHandler::runCommand (std::string const& strCommand,
+    Resource::Charge& loadType, Handler const& handler)
+{
+    try
+    {
+        LoadEvent::autoptr ev   = getApp().getJobQueue().getLoadEventAP(
+            jtGENERIC, std::string("cmd:") + strCommand);
+        Json::Value jvRaw       = handler ();
+
+        // Regularize result.
+        if (jvRaw.isObject ())
         {
-            return rpcError (rpcNO_CLOSED);
+            // Got an object.
+            return jvRaw;
         }
         else
         {
-            try
-            {
-                LoadEvent::autoptr ev   = getApp().getJobQueue().getLoadEventAP(
-                    jtGENERIC, std::string("cmd:") + strCommand);
-                Json::Value jvRaw       = (this->* (commandsA[i].dfpFunc)) (params, loadType, lock);
-
-                // Regularize result.
-                if (jvRaw.isObject ())
-                {
-                    // Got an object.
-                    return jvRaw;
-                }
-                else
-                {
-                    // Probably got a string.
-                    Json::Value jvResult (Json::objectValue);
+            // Probably got a string.
+            Json::Value jvResult (Json::objectValue);
 
-                    jvResult["message"] = jvRaw;
+            jvResult["message"] = jvRaw;
 
-                    return jvResult;
-                }
-            }
-            catch (std::exception& e)
-            {
-                WriteLog (lsINFO, RPCHandler) << "Caught throw: " << e.what ();
+            return jvResult;
+        }
+    }
+    catch (std::exception& e)
+    {
+        WriteLog (lsINFO, RPCHandler) << "Caught throw: " << e.what ();
 
-                if (loadType == Resource::feeReferenceRPC)
-                    loadType = Resource::feeExceptionRPC;
+        if (loadType == Resource::feeReferenceRPC)
+            loadType = Resource::feeExceptionRPC;
 
-                return rpcError (rpcINTERNAL);
-            }
-        }
+        return rpcError (rpcINTERNAL);
     }
 }
 
@@ -4386,3 +4519,175 @@ public:
 };
 
 static JSONRPCTests jsonRPCTests;
+
+//------------------------------------------------------------------------------
+
+/** Measures read-only RPC throughput as client threads are added.
+
+    Each client thread calls doCommand directly, cycling through read-only
+    methods against a genesis ledger, while another thread holds the master
+    lock a quarter of the time the way ledger close does. Every thread
+    count is measured twice: once taking the master lock around each
+    request, as all commands used to, and once as dispatched now.
+*/
+class RPCLoadTests : public UnitTest
+{
+public:
+    enum
+    {
+        millisecondsPerRun = 1000
+        ,closeHoldMilliseconds = 5
+        ,closeIdleMilliseconds = 15
+    };
+
+    double measure (std::vector <Json::Value> const& requests,
+        int threads, bool locked)
+    {
+        std::atomic <bool> done (false);
+        std::atomic <std::size_t> total (0);
+
+        std::thread closer ([&]
+        {
+            while (! done)
+            {
+                {
+                    Application::ScopedLockType lock (
+                        getApp().getMasterLock (), __FILE__, __LINE__);
+                    std::this_thread::sleep_for (
+                        std::chrono::milliseconds (closeHoldMilliseconds));
+                }
+                std::this_thread::sleep_for (
+                    std::chrono::milliseconds (closeIdleMilliseconds));
+            }
+        });
+
+        auto const start (std::chrono::steady_clock::now ());
+
+        std::vector <std::thread> clients;
+        for (int t = 0; t < threads; ++t)
+        {
+            clients.emplace_back ([&, t]
+            {
+                std::size_t count (0);
+                for (std::size_t i = t; ! done; ++i)
+                {
+                    RPCHandler handler (&getApp().getOPs ());
+                    Resource::Charge loadType = Resource::feeReferenceRPC;
+                    Json::Value const& request (requests [i % requests.size ()]);
+
+                    if (locked)
+                    {
+                        Application::ScopedLockType lock (
+                            getApp().getMasterLock (), __FILE__, __LINE__);
+                        handler.doCommand (request, Config::ADMIN, loadType);
+                    }
+                    else
+                    {
+                        handler.doCommand (request, Config::ADMIN, loadType);
+                    }
+
+                    ++count;
+                }
+                total += count;
+            });
+        }
+
+        std::this_thread::sleep_for (
+            std::chrono::milliseconds (millisecondsPerRun));
+        done = true;
+
+        for (auto& client : clients)
+            client.join ();
+        closer.join ();
+
+        std::chrono::duration <double> const elapsed (
+            std::chrono::steady_clock::now () - start);
+
+        return total / elapsed.count ();
+    }
+
+    void runTest ()
+    {
+        beginTestCase ("read-only load");
+
+        RippleAddress rootSeedMaster      = RippleAddress::createSeedGeneric ("masterpassphrase");
+        RippleAddress rootGeneratorMaster = RippleAddress::createGeneratorPublic (rootSeedMaster);
+        RippleAddress rootAddress         = RippleAddress::createAccountPublic (rootGeneratorMaster, 0);
+
+        // Install a closed and an open ledger. The validation quorum is
+        // set out of reach so the closed ledger is never accepted, which
+        // would try to save it.
+        Ledger::pointer closed (boost::make_shared <Ledger> (
+            rootAddress, SYSTEM_CURRENCY_START));
+        closed->updateHash ();
+        closed->setClosed ();
+        closed->setAccepted ();
+
+        getApp().getLedgerMaster ().setMinValidations (1 << 30);
+        getApp().getLedgerMaster ().switchLedgers (closed,
+            boost::make_shared <Ledger> (true, boost::ref (*closed)));
+        getApp().getOPs ().setStandAlone ();
+
+        bool const standalone (getConfig ().RUN_STANDALONE);
+        getConfig ().RUN_STANDALONE = true;
+
+        std::vector <Json::Value> requests;
+        {
+            std::string const account (rootAddress.humanAccountID ());
+
+            Json::Value request (Json::objectValue);
+            request["command"] = "account_info";
+            request["account"] = account;
+            requests.push_back (request);
+
+            request = Json::Value (Json::objectValue);
+            request["command"] = "account_lines";
+            request["account"] = account;
+            requests.push_back (request);
+
+            request = Json::Value (Json::objectValue);
+            request["command"] = "ledger_entry";
+            request["account_root"] = account;
+            request["ledger_index"] = "closed";
+            requests.push_back (request);
+
+            request = Json::Value (Json::objectValue);
+            request["command"] = "book_offers";
+            request["taker_pays"]["currency"] = "XRP";
+            request["taker_gets"]["currency"] = "USD";
+            request["taker_gets"]["issuer"] = account;
+            requests.push_back (request);
+        }
+
+        // Every request must succeed, or we'd be timing errors
+        for (auto const& request : requests)
+        {
+            RPCHandler handler (&getApp().getOPs ());
+            Resource::Charge loadType = Resource::feeReferenceRPC;
+            Json::Value const result (handler.doCommand (
+                request, Config::ADMIN, loadType));
+            expect (! RPC::contains_error (result),
+                request["command"].asString () + " should succeed");
+        }
+
+        for (int threads = 1; threads <= 32; threads *= 2)
+        {
+            double const lockedRate (measure (requests, threads, true));
+            double const lockFreeRate (measure (requests, threads, false));
+
+            String s;
+            s << String (threads) << " threads: " <<
+                "locked " << String (int64 (lockedRate)) << " requests/s, " <<
+                "lock-free " << String (int64 (lockFreeRate)) << " requests/s";
+            logMessage (s);
+        }
+
+        getConfig ().RUN_STANDALONE = standalone;
+    }
+
+    RPCLoadTests () : UnitTest ("RPCLoad", "ripple", runManual)
+    {
+    }
+};
+
+static RPCLoadTests rpcLoadTests;
@@ -41,12 +41,29 @@ public:
 
     Json::Value doRpcCommand    (const std::string& strCommand, Json::Value const& jvParams, int iRole, Resource::Charge& loadType);
 
+    /** Let commands leave the largest parts of their results to writeDeferred.
+        The results returned by doCommand are then incomplete, so this
+        is only for callers which write them with a Json::StreamWriter.
+    */
+    void deferLargeResults ();
+
+    /** Write the members which a command left out of its result.
+        This is called while the result object is being written, after
+        doCommand returns a result which is not an error.
+    */
+    void writeDeferred (Json::StreamWriter& writer);
+
 private:
     typedef Json::Value (RPCHandler::*doFuncPtr) (
         Json::Value params,
         Resource::Charge& loadType,
         Application::ScopedLockType& MasterLockHolder);
 
+    // Handlers for read-only methods, which never take the master lock
+    typedef Json::Value (RPCHandler::*doReadOnlyFuncPtr) (
+        Json::Value params,
+        Resource::Charge& loadType);
+
     // VFALCO TODO Document these and give the enumeration a label.
     enum
     {
@@ -66,6 +83,12 @@ private:
 
     Json::Value lookupLedger (Json::Value const& jvRequest, Ledger::pointer& lpLedger);
 
+    Json::Value checkOptions (unsigned int iOptions);
+
+    template <class Handler>
+    Json::Value runCommand (std::string const& strCommand,
+        Resource::Charge& loadType, Handler const& handler);
+
     Json::Value getMasterGenerator (
         Ledger::ref lrLedger,
         const RippleAddress& naRegularSeed,
@@ -94,14 +117,14 @@ private:
         const int iIndex,
         const bool bStrict);
 
-    Json::Value doAccountCurrencies     (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
-    Json::Value doAccountInfo           (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
-    Json::Value doAccountLines          (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
-    Json::Value doAccountOffers         (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
+    Json::Value doAccountCurrencies     (Json::Value params, Resource::Charge& loadType);
+    Json::Value doAccountInfo           (Json::Value params, Resource::Charge& loadType);
+    Json::Value doAccountLines          (Json::Value params, Resource::Charge& loadType);
+    Json::Value doAccountOffers         (Json::Value params, Resource::Charge& loadType);
     Json::Value doAccountTx             (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
     Json::Value doAccountTxSwitch       (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
     Json::Value doAccountTxOld          (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
-    Json::Value doBookOffers            (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
+    Json::Value doBookOffers            (Json::Value params, Resource::Charge& loadType);
     Json::Value doBlackList             (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
     Json::Value doConnect               (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
     Json::Value doConsensusInfo         (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
@@ -112,10 +135,10 @@ private:
     Json::Value doLedger                (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
     Json::Value doLedgerAccept          (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
     Json::Value doLedgerCleaner         (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
-    Json::Value doLedgerClosed          (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
-    Json::Value doLedgerCurrent         (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
-    Json::Value doLedgerEntry           (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
-    Json::Value doLedgerHeader          (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
+    Json::Value doLedgerClosed          (Json::Value params, Resource::Charge& loadType);
+    Json::Value doLedgerCurrent         (Json::Value params, Resource::Charge& loadType);
+    Json::Value doLedgerEntry           (Json::Value params, Resource::Charge& loadType);
+    Json::Value doLedgerHeader          (Json::Value params, Resource::Charge& loadType);
     Json::Value doLogLevel              (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
     Json::Value doLogRotate             (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
     Json::Value doNicknameInfo          (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
@@ -139,7 +162,7 @@ private:
     Json::Value doStop                  (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
     Json::Value doSubmit                (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
     Json::Value doSubscribe             (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
-    Json::Value doTransactionEntry      (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
+    Json::Value doTransactionEntry      (Json::Value params, Resource::Charge& loadType);
     Json::Value doTx                    (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
     Json::Value doTxHistory             (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
     Json::Value doUnlAdd                (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& mlh);
@@ -173,6 +196,10 @@ private:
 
     // VFALCO TODO Create an enumeration for this.
     int                 mRole;
+
+    // What a command left for writeDeferred
+    bool                mDeferLargeResults;
+    std::function <void (Json::StreamWriter&)> mDeferred;
 };
 
 class RPCInternalHandler
@@ -37,6 +37,25 @@ bool RPCServerHandler::isAuthorized (
 }
 
 std::string RPCServerHandler::processRequest (std::string const& request, IP::Endpoint const& remoteIPAddress)
+{
+    std::string response;
+
+    processRequest (request, remoteIPAddress, framingLength,
+        [&response] (char const* data, std::size_t bytes)
+        {
+            response.append (data, bytes);
+        });
+
+    return response;
+}
+
+static void respond (Json::StreamWriter::Output const& output, std::string const& response)
+{
+    output (response.data (), response.size ());
+}
+
+void RPCServerHandler::processRequest (std::string const& request, IP::Endpoint const& remoteIPAddress,
+    Framing framing, Json::StreamWriter::Output const& output)
 {
     Json::Value jsonRequest;
     {
@@ -47,7 +66,8 @@ std::string RPCServerHandler::processRequest (std::string const& request, IP::En
             jsonRequest.isNull () ||
             ! jsonRequest.isObject ())
         {
-            return createResponse (400, "Unable to parse request");
+            respond (output, createResponse (400, "Unable to parse request"));
+            return;
         }
     }
     
@@ -61,23 +81,22 @@ std::string RPCServerHandler::processRequest (std::string const& request, IP::En
         usage = m_resourceManager.newInboundEndpoint (remoteIPAddress);
 
     if (usage.disconnect ())
-        return createResponse (503, "Server is overloaded");
-
-    // Parse id now so errors from here on will have the id
-    //
-    // VFALCO NOTE Except that "id" isn't included in the following errors...
-    //
-    Json::Value const& id = jsonRequest ["id"];
+    {
+        respond (output, createResponse (503, "Server is overloaded"));
+        return;
+    }
 
     Json::Value const& method = jsonRequest ["method"];
 
     if (method.isNull ())
     {
-        return createResponse (400, "Null method");
+        respond (output, createResponse (400, "Null method"));
+        return;
     }
     else if (! method.isString ())
     {
-        return createResponse (400, "method is not string");
+        respond (output, createResponse (400, "method is not string"));
+        return;
     }
 
     std::string strMethod = method.asString ();
@@ -89,7 +108,10 @@ std::string RPCServerHandler::processRequest (std::string const& request, IP::En
     Json::Value& params = jsonRequest ["params"];
 
     if (!params.isArray ())
-        return HTTPReply (400, "params unparseable");
+    {
+        respond (output, HTTPReply (400, "params unparseable"));
+        return;
+    }
 
     // VFALCO TODO Shouldn't we handle this earlier?
     //
@@ -98,7 +120,8 @@ std::string RPCServerHandler::processRequest (std::string const& request, IP::En
         // VFALCO TODO Needs implementing
         // FIXME Needs implementing
         // XXX This needs rate limiting to prevent brute forcing password.
-        return HTTPReply (403, "Forbidden");
+        respond (output, HTTPReply (403, "Forbidden"));
+        return;
     }
 
     // This code does all the work on the io_service thread and
@@ -106,11 +129,10 @@ std::string RPCServerHandler::processRequest (std::string const& request, IP::En
     // This is a temporary safety
     if ((role != Config::ADMIN) && (getApp().getFeeTrack().isLoadedLocal()))
     {
-        return HTTPReply (503, "Unable to service at this time");
+        respond (output, HTTPReply (503, "Unable to service at this time"));
+        return;
     }
 
-    std::string response;
-   
     WriteLog (lsDEBUG, RPCServer) << "Query: " << strMethod << params;
 
     {
@@ -125,14 +147,18 @@ std::string RPCServerHandler::processRequest (std::string const& request, IP::En
         {
             usage.charge (req.fee);
             WriteLog (lsDEBUG, RPCServer) << "Reply: " << req.result;
-            return createResponse (200,
-                JSONRPCReply (req.result, Json::Value (), id));
+            writeReply (framing, output, [&req] (Json::StreamWriter& writer)
+            {
+                writer.value (req.result);
+            });
+            return;
         }
     }
 
     // legacy dispatcher
     Resource::Charge fee (Resource::feeReferenceRPC);
     RPCHandler rpcHandler (&m_networkOPs);
+    rpcHandler.deferLargeResults ();
     Json::Value const result = rpcHandler.doRpcCommand (
         strMethod, params, role, fee);
 
@@ -140,7 +166,55 @@ std::string RPCServerHandler::processRequest (std::string const& request, IP::En
 
     WriteLog (lsDEBUG, RPCServer) << "Reply: " << result;
 
-    response = JSONRPCReply (result, Json::Value (), id);
+    writeReply (framing, output, [&] (Json::StreamWriter& writer)
+    {
+        writer.startObject ();
+        writer.members (result);
+        rpcHandler.writeDeferred (writer);
+        writer.end ();
+    });
+}
+
+// Write {"result":...} as the body of the reply, framed as requested
+void RPCServerHandler::writeReply (Framing framing, Json::StreamWriter::Output const& output,
+    std::function <void (Json::StreamWriter&)> const& writeResult)
+{
+    std::string body;
+    Json::StreamWriter::Output bodyOutput;
+
+    if (framing == framingLength)
+    {
+        bodyOutput = [&body] (char const* data, std::size_t bytes)
+        {
+            body.append (data, bytes);
+        };
+    }
+    else if (framing == framingChunked)
+    {
+        respond (output, HTTPStreamReply (200, true));
+        bodyOutput = [&output] (char const* data, std::size_t bytes)
+        {
+            respond (output, HTTPChunk (data, bytes));
+        };
+    }
+    else
+    {
+        respond (output, HTTPStreamReply (200, false));
+        bodyOutput = output;
+    }
+
+    Json::StreamWriter writer (bodyOutput);
+    writer.startObject ();
+    writer.key ("result");
+    writeResult (writer);
+    writer.end ();
+    writer.flush ();
+
+    // The same ending as JSONRPCReply
+    bodyOutput ("\n\n", 2);
 
-    return createResponse (200, response);
+    if (framing == framingLength)
+        respond (output, createResponse (200, body));
+    else if (framing == framingChunked)
+        respond (output, HTTPChunk ("", 0));
 }
@@ -35,7 +35,31 @@ public:
 
     std::string processRequest (std::string const& request, IP::Endpoint const& remoteIPAddress);
 
+    /** How the body of a successful reply is delimited. */
+    enum Framing
+    {
+        // Content-Length is sent, so the whole reply is built first
+        framingLength,
+
+        // The body is sent in chunks as it is produced
+        framingChunked,
+
+        // The body is sent as it is produced and ends with the connection
+        framingClose
+    };
+
+    /** Process a request, passing the reply to the output.
+        Unless the framing is framingLength, a reply with a large result
+        is passed in pieces as the result is produced. The output may
+        throw to abandon the reply.
+    */
+    void processRequest (std::string const& request, IP::Endpoint const& remoteIPAddress,
+        Framing framing, Json::StreamWriter::Output const& output);
+
 private:
+    void writeReply (Framing framing, Json::StreamWriter::Output const& output,
+        std::function <void (Json::StreamWriter&)> const& writeResult);
+
     NetworkOPs& m_networkOPs;
     Resource::Manager& m_resourceManager;
 };
@@ -31,6 +31,9 @@ SHAMap::SHAMap (SHAMapType t, FullBelowCache& fullBelowCache, uint32 seq,
     : m_fullBelowCache (fullBelowCache)
     , mSeq (seq)
     , mLedgerSeq (0)
+    , mShardSeq (0)
+    , mDeferHashes (false)
+    , mStaleNodes (0)
     , mState (smsModifying)
     , mType (t)
     , m_missing_node_handler (missing_node_handler)
@@ -49,6 +52,9 @@ SHAMap::SHAMap (SHAMapType t, uint256 const& hash, FullBelowCache& fullBelowCach
     : m_fullBelowCache (fullBelowCache)
     , mSeq (1)
     , mLedgerSeq (0)
+    , mShardSeq (0)
+    , mDeferHashes (false)
+    , mStaleNodes (0)
     , mState (smsSynching)
     , mType (t)
     , m_missing_node_handler (missing_node_handler)
@@ -61,7 +67,7 @@ SHAMap::SHAMap (SHAMapType t, uint256 const& hash, FullBelowCache& fullBelowCach
     mTNByID.replace(*root, root);
 }
 
-TaggedCache< SHAMap::TNIndex, SHAMapTreeNode>
+ShardedTaggedCache <SHAMap::TNIndex, SHAMapTreeNode>
     SHAMap::treeNodeCache ("TreeNodeCache", 65536, 60,
         get_seconds_clock (),
             LogPartition::getJournal <TaggedCacheLog> ());
@@ -114,35 +120,45 @@ SHAMap::pointer SHAMap::snapShot (bool isMutable)
         std::ref (m_fullBelowCache));
     SHAMap& newMap = *ret;
 
-    // Return a new SHAMap that is a snapshot of this one
-    // Initially most nodes are shared and CoW is forced where needed
+    // Return a new SHAMap that is a snapshot of this one. The whole tree is
+    // shared: neither map modifies a node whose sequence is below its own, so
+    // nodes are copied on write along the path to each change.
+    uint32 seq;
+
+    if (mState != smsImmutable)
     {
-        ScopedReadLockType sl (mLock);
-        newMap.mSeq = mSeq;
-        newMap.mTNByID = mTNByID;
-        newMap.root = root;
+        ScopedWriteLockType sl (mLock);
 
-        if (!isMutable)
-            newMap.mState = smsImmutable;
+        // The snapshot must not share nodes whose hashes are deferred
+        updateHashes ();
 
-        // If the existing map has any nodes it might modify, unshare ours now
-        if (mState != smsImmutable)
+        // Nodes we could have modified in place are shared from now on
+        seq = ++mSeq;
+        newMap.root = root;
+        newMap.mLedgerSeq = mLedgerSeq;
+        newMap.mShardSeq = mShardSeq;
+    }
+    else
+    {
+        if (root->isHashStale ())
         {
-            BOOST_FOREACH(NodeMap::value_type& nodeIt, mTNByID.peekMap())
-            {
-                if (nodeIt.second->getSeq() == mSeq)
-                { // We might modify this node, so duplicate it in the snapShot
-                    SHAMapTreeNode::pointer newNode = boost::make_shared<SHAMapTreeNode> (*nodeIt.second, mSeq);
-                    newMap.mTNByID.replace (*newNode, newNode);
-                    if (newNode->isRoot ())
-                        newMap.root = newNode;
-                }
-            }
+            ScopedWriteLockType sl (mLock);
+            updateHashes ();
         }
-        else if (isMutable) // Need to unshare on changes to the snapshot
-            ++newMap.mSeq;
+
+        ScopedReadLockType sl (mLock);
+        seq = mSeq;
+        newMap.root = root;
+        newMap.mLedgerSeq = mLedgerSeq;
+        newMap.mShardSeq = mShardSeq;
     }
 
+    newMap.mSeq = seq + 1;
+    newMap.mTNByID.replace (*newMap.root, newMap.root);
+
+    if (!isMutable)
+        newMap.mState = smsImmutable;
+
     return ret;
 }
 
@@ -165,7 +181,7 @@ std::stack<SHAMapTreeNode::pointer> SHAMap::getStack (uint256 const& id, bool in
 
         try
         {
-            node = getNode (node->getChildNodeID (branch), node->getChildHash (branch), false);
+            node = descend (node, branch);
         }
         catch (SHAMapMissingNode& mn)
         {
@@ -180,10 +196,10 @@ std::stack<SHAMapTreeNode::pointer> SHAMap::getStack (uint256 const& id, bool in
     return stack;
 }
 
-void SHAMap::dirtyUp (std::stack<SHAMapTreeNode::pointer>& stack, uint256 const& target, uint256 prevHash)
+void SHAMap::dirtyUp (std::stack<SHAMapTreeNode::pointer>& stack, uint256 const& target, SHAMapTreeNode::pointer child)
 {
     // walk the tree up from through the inner nodes to the root
-    // update linking hashes and add nodes to dirty list
+    // update linking hashes and child links and add nodes to dirty list
 
     assert ((mState != smsSynching) && (mState != smsImmutable));
 
@@ -198,18 +214,36 @@ void SHAMap::dirtyUp (std::stack<SHAMapTreeNode::pointer>& stack, uint256 const&
 
         returnNode (node, true);
 
-        if (!node->setChildHash (branch, prevHash))
+        if (mDeferHashes)
         {
-            WriteLog (lsFATAL, SHAMap) << "dirtyUp terminates early";
-            assert (false);
-            return;
+            bool const wasFresh = setChildStale (node, branch);
+            node->setChild (branch, child);
+
+            // If the branch was already stale, so is the rest of the path
+            if (!wasFresh)
+                return;
         }
+        else
+        {
+            uint256 const& prevHash = child->getNodeHash ();
+            assert (prevHash.isNonZero ());
+
+            bool const changed = node->setChildHash (branch, prevHash);
+            node->setChild (branch, child);
+
+            if (!changed)
+            {
+                WriteLog (lsFATAL, SHAMap) << "dirtyUp terminates early";
+                assert (false);
+                return;
+            }
 
 #ifdef ST_DEBUG
-        WriteLog (lsTRACE, SHAMap) << "dirtyUp sets branch " << branch << " to " << prevHash;
+            WriteLog (lsTRACE, SHAMap) << "dirtyUp sets branch " << branch << " to " << prevHash;
 #endif
-        prevHash = node->getNodeHash ();
-        assert (prevHash.isNonZero ());
+        }
+
+        child = node;
     }
 }
 
@@ -236,7 +270,7 @@ SHAMapTreeNode::pointer SHAMap::walkTo (uint256 const& id, bool modify)
 
         try
         {
-            inNode = getNode (inNode->getChildNodeID (branch), inNode->getChildHash (branch), false);
+            inNode = descend (inNode, branch);
         }
         catch (SHAMapMissingNode& mn)
         {
@@ -265,7 +299,7 @@ SHAMapTreeNode* SHAMap::walkToPointer (uint256 const& id)
         if (inNode->isEmptyBranch (branch))
             return NULL;
 
-        inNode = getNodePointer (inNode->getChildNodeID (branch), inNode->getChildHash (branch));
+        inNode = descendPointer (inNode, branch);
         assert (inNode);
     }
 
@@ -281,7 +315,7 @@ SHAMapTreeNode::pointer SHAMap::getNode (const SHAMapNode& id, uint256 const& ha
     {
 #if BEAST_DEBUG
 
-        if (node->getNodeHash () != hash)
+        if (!mDeferHashes && (node->getNodeHash () != hash))
         {
             WriteLog (lsFATAL, SHAMap) << "Attempt to get node, hash not in tree";
             WriteLog (lsFATAL, SHAMap) << "ID: " << id;
@@ -317,6 +351,27 @@ SHAMapTreeNode* SHAMap::getNodePointerNT (const SHAMapNode& id, uint256 const& h
     return ret ? ret.get() : nullptr;
 }
 
+SHAMapTreeNode::pointer SHAMap::descend (SHAMapTreeNode::ref parent, int branch)
+{
+    // follow the link to the child if there is one, otherwise look it up
+    SHAMapTreeNode::pointer ret = parent->getChild (branch);
+
+    if (!ret)
+        ret = getNode (parent->getChildNodeID (branch), parent->getChildHash (branch), false);
+
+    return ret;
+}
+
+SHAMapTreeNode* SHAMap::descendPointer (SHAMapTreeNode* parent, int branch)
+{
+    SHAMapTreeNode* ret = parent->peekChild (branch);
+
+    if (!ret)
+        ret = getNodePointer (parent->getChildNodeID (branch), parent->getChildHash (branch));
+
+    return ret;
+}
+
 SHAMapTreeNode* SHAMap::getNodePointer (const SHAMapNode& id, uint256 const& hash, SHAMapSyncFilter* filter)
 {
     SHAMapTreeNode* ret = getNodePointerNT (id, hash, filter);
@@ -400,7 +455,7 @@ SHAMapTreeNode* SHAMap::firstBelow (SHAMapTreeNode* node)
         for (int i = 0; i < 16; ++i)
             if (!node->isEmptyBranch (i))
             {
-                node = getNodePointer (node->getChildNodeID (i), node->getChildHash (i));
+                node = descendPointer (node, i);
                 foundNode = true;
                 break;
             }
@@ -424,7 +479,7 @@ SHAMapTreeNode* SHAMap::lastBelow (SHAMapTreeNode* node)
         for (int i = 15; i >= 0; ++i)
             if (!node->isEmptyBranch (i))
             {
-                node = getNodePointer (node->getChildNodeID (i), node->getChildHash (i));
+                node = descendPointer (node, i);
                 foundNode = true;
                 break;
             }
@@ -448,7 +503,7 @@ SHAMapItem::pointer SHAMap::onlyBelow (SHAMapTreeNode* node)
                 if (nextNode)
                     return SHAMapItem::pointer (); // two leaves below
 
-                nextNode = getNodePointer (node->getChildNodeID (i), node->getChildHash (i));
+                nextNode = descendPointer (node, i);
             }
 
         if (!nextNode)
@@ -475,7 +530,7 @@ void SHAMap::eraseChildren (SHAMapTreeNode::pointer node)
         for (int i = 0; i < 16; ++i)
             if (!node->isEmptyBranch (i))
             {
-                SHAMapTreeNode::pointer nextNode = getNode (node->getChildNodeID (i), node->getChildHash (i), false);
+                SHAMapTreeNode::pointer nextNode = descend (node, i);
 
                 if (erase)
                 {
@@ -569,7 +624,7 @@ SHAMapItem::pointer SHAMap::peekNextItem (uint256 const& id, SHAMapTreeNode::TNT
             for (int i = node->selectBranch (id) + 1; i < 16; ++i)
                 if (!node->isEmptyBranch (i))
                 {
-                    SHAMapTreeNode* firstNode = getNodePointer (node->getChildNodeID (i), node->getChildHash (i));
+                    SHAMapTreeNode* firstNode = descendPointer (node.get (), i);
                     assert (firstNode);
                     firstNode = firstBelow (firstNode);
 
@@ -608,7 +663,7 @@ SHAMapItem::pointer SHAMap::peekPrevItem (uint256 const& id)
             {
                 if (!node->isEmptyBranch (i))
                 {
-                    node = getNode (node->getChildNodeID (i), node->getChildHash (i), false);
+                    node = descend (node, i);
                     SHAMapTreeNode* item = firstBelow (node.get ());
 
                     if (!item)
@@ -696,6 +751,8 @@ bool SHAMap::delItem (uint256 const& id)
         assert (false);
 
     uint256 prevHash;
+    bool prevStale = false; // the hash of the node below is deferred
+    SHAMapTreeNode::pointer prevNode; // the node below, if it is still in the tree
 
     while (!stack.empty ())
     {
@@ -704,12 +761,21 @@ bool SHAMap::delItem (uint256 const& id)
         returnNode (node, true);
         assert (node->isInner ());
 
-        if (!node->setChildHash (node->selectBranch (id), prevHash))
+        int const branch = node->selectBranch (id);
+
+        if (prevStale)
+            setChildStale (node, branch);
+        else if (!setChildHash (node, branch, prevHash))
         {
             assert (false);
             return true;
         }
 
+        if (prevNode)
+            node->setChild (branch, prevNode);
+
+        prevNode = node;
+
         if (!node->isRoot ())
         {
             // we may have made this a node with 1 or 0 children
@@ -718,6 +784,8 @@ bool SHAMap::delItem (uint256 const& id)
             if (bc == 0)
             {
                 prevHash = uint256 ();
+                prevStale = false;
+                prevNode.reset ();
 
                 if (!mTNByID.erase (*node))
                     assert (false);
@@ -734,13 +802,23 @@ bool SHAMap::delItem (uint256 const& id)
                     node->setItem (item, type);
                 }
 
-                prevHash = node->getNodeHash ();
-                assert (prevHash.isNonZero ());
+                prevStale = node->isHashStale ();
+
+                if (!prevStale)
+                {
+                    prevHash = node->getNodeHash ();
+                    assert (prevHash.isNonZero ());
+                }
             }
             else
             {
-                prevHash = node->getNodeHash ();
-                assert (prevHash.isNonZero ());
+                prevStale = node->isHashStale ();
+
+                if (!prevStale)
+                {
+                    prevHash = node->getNodeHash ();
+                    assert (prevHash.isNonZero ());
+                }
             }
         }
         else assert (stack.empty ());
@@ -791,7 +869,8 @@ bool SHAMap::addGiveItem (SHAMapItem::ref item, bool isTransaction, bool hasMeta
         }
 
         trackNewNode (newNode);
-        node->setChildHash (branch, newNode->getNodeHash ());
+        setChildHash (node, branch, newNode->getNodeHash ());
+        node->setChild (branch, newNode);
     }
     else
     {
@@ -827,7 +906,8 @@ bool SHAMap::addGiveItem (SHAMapItem::ref item, bool isTransaction, bool hasMeta
         if (!mTNByID.peekMap().emplace (SHAMapNode (*newNode), newNode).second)
             assert (false);
 
-        node->setChildHash (b1, newNode->getNodeHash ()); // OPTIMIZEME hash op not needed
+        setChildHash (node, b1, newNode->getNodeHash ()); // OPTIMIZEME hash op not needed
+        node->setChild (b1, newNode);
         trackNewNode (newNode);
 
         newNode = boost::make_shared<SHAMapTreeNode> (node->getChildNodeID (b2), otherItem, type, mSeq);
@@ -836,11 +916,12 @@ bool SHAMap::addGiveItem (SHAMapItem::ref item, bool isTransaction, bool hasMeta
         if (!mTNByID.peekMap().emplace (SHAMapNode (*newNode), newNode).second)
             assert (false);
 
-        node->setChildHash (b2, newNode->getNodeHash ());
+        setChildHash (node, b2, newNode->getNodeHash ());
+        node->setChild (b2, newNode);
         trackNewNode (newNode);
     }
 
-    dirtyUp (stack, tag, node->getNodeHash ());
+    dirtyUp (stack, tag, node);
     return true;
 }
 
@@ -880,7 +961,7 @@ bool SHAMap::updateGiveItem (SHAMapItem::ref item, bool isTransaction, bool hasM
         return true;
     }
 
-    dirtyUp (stack, tag, node->getNodeHash ());
+    dirtyUp (stack, tag, node);
     return true;
 }
 
@@ -922,6 +1003,10 @@ SHAMapTreeNode::pointer SHAMap::fetchNodeExternalNT (const SHAMapNode& id, uint2
     else
     { // Check the back end
         NodeObject::pointer obj (getApp ().getNodeStore ().fetch (hash));
+
+        if (!obj && (mShardSeq != 0) && (getApp ().getShardStore () != nullptr))
+            obj = getApp ().getShardStore ()->fetch (hash, mShardSeq);
+
         if (!obj)
         {
             if (mLedgerSeq != 0)
@@ -933,46 +1018,130 @@ SHAMapTreeNode::pointer SHAMap::fetchNodeExternalNT (const SHAMapNode& id, uint2
             return ret;
         }
 
-        try
-        {
-            // We make this node immutable (seq == 0) so that it can be shared
-            // CoW is needed if it is modified
-            ret = boost::make_shared<SHAMapTreeNode> (id, obj->getData (), 0, snfPREFIX, hash, true);
+        ret = makeSharedNode (id, hash, obj);
+        if (!ret)
+            return ret;
+    }
 
-            if (id != *ret)
-            {
-                WriteLog (lsFATAL, SHAMap) << "id:" << id << ", got:" << *ret;
-                assert (false);
-                return SHAMapTreeNode::pointer ();
-            }
+    if (id.isRoot ()) // it is legal to replace an existing root
+    {
+        mTNByID.replace(id, ret);
+        root = ret;
+    }
+    else // Make sure other threads get pointers to the same underlying object
+       mTNByID.canonicalize (id, &ret);
+    return ret;
+}
 
-            if (ret->getNodeHash () != hash)
-            {
-                WriteLog (lsFATAL, SHAMap) << "Hashes don't match";
-                assert (false);
-                return SHAMapTreeNode::pointer ();
-            }
+/** Construct an immutable tree node from an object in the node store.
+    The node is placed in the TreeNodeCache so it can be shared.
+    If the object does not hold the expected node, nullptr is returned.
+*/
+SHAMapTreeNode::pointer SHAMap::makeSharedNode (SHAMapNode const& id,
+    uint256 const& hash, NodeObject::ref object)
+{
+    SHAMapTreeNode::pointer ret;
 
-            // Share this immutable tree node in thre TreeNodeCache
-            canonicalize (hash, ret);
+    try
+    {
+        // We make this node immutable (seq == 0) so that it can be shared
+        // CoW is needed if it is modified
+        Blob const data (object->getData (),
+            object->getData () + object->getSize ());
+        ret = boost::make_shared<SHAMapTreeNode> (id, data, 0, snfPREFIX, hash, true);
+
+        if (id != *ret)
+        {
+            WriteLog (lsFATAL, SHAMap) << "id:" << id << ", got:" << *ret;
+            assert (false);
+            return SHAMapTreeNode::pointer ();
         }
-        catch (...)
+
+        if (ret->getNodeHash () != hash)
         {
-            WriteLog (lsWARNING, SHAMap) << "fetchNodeExternal gets an invalid node: " << hash;
+            WriteLog (lsFATAL, SHAMap) << "Hashes don't match";
+            assert (false);
             return SHAMapTreeNode::pointer ();
         }
-    }
 
-    if (id.isRoot ()) // it is legal to replace an existing root
+        // Share this immutable tree node in thre TreeNodeCache
+        canonicalize (hash, ret);
+    }
+    catch (...)
     {
-        mTNByID.replace(id, ret);
-        root = ret;
+        WriteLog (lsWARNING, SHAMap) << "fetchNodeExternal gets an invalid node: " << hash;
+        return SHAMapTreeNode::pointer ();
     }
-    else // Make sure other threads get pointers to the same underlying object
-       mTNByID.canonicalize (id, &ret);
+
     return ret;
 }
 
+/** Make the children of a group of inner nodes available in mTNByID.
+    Children which are neither linked, tracked, nor in the TreeNodeCache
+    are requested from the node store with a single batched fetch, so
+    the backend can order the reads instead of taking them one at a time.
+    Children that can't be found are left alone; the caller discovers
+    them as usual when it descends. Only a read lock is required.
+*/
+void SHAMap::prefetchChildren (std::vector <SHAMapTreeNode*> const& parents,
+    bool skipFullBelow)
+{
+    if (!getApp().running ())
+        return;
+
+    std::vector <SHAMapNode> ids;
+    std::vector <uint256> hashes;
+
+    for (SHAMapTreeNode* parent : parents)
+    {
+        if (!parent->isInner ())
+            continue;
+
+        for (int branch = 0; branch < 16; ++branch)
+        {
+            if (parent->isEmptyBranch (branch) || parent->peekChild (branch))
+                continue;
+
+            uint256 const& childHash = parent->getChildHash (branch);
+
+            if (skipFullBelow && m_fullBelowCache.touch_if_exists (childHash))
+                continue;
+
+            SHAMapNode const childID = parent->getChildNodeID (branch);
+
+            if (mTNByID.retrieve (childID))
+                continue;
+
+            SHAMapTreeNode::pointer node = getCache (childHash, childID);
+
+            if (node)
+            {
+                mTNByID.canonicalize (childID, &node);
+                continue;
+            }
+
+            ids.push_back (childID);
+            hashes.push_back (childHash);
+        }
+    }
+
+    if (hashes.empty ())
+        return;
+
+    NodeStore::Batch const objects (getApp ().getNodeStore ().fetchBatch (hashes));
+
+    for (std::size_t i = 0; i < objects.size (); ++i)
+    {
+        if (objects [i])
+        {
+            SHAMapTreeNode::pointer node = makeSharedNode (ids [i], hashes [i], objects [i]);
+
+            if (node)
+                mTNByID.canonicalize (ids [i], &node);
+        }
+    }
+}
+
 bool SHAMap::fetchRoot (uint256 const& hash, SHAMapSyncFilter* filter)
 {
     if (hash == root->getNodeHash ())
@@ -1015,6 +1184,7 @@ int SHAMap::armDirty ()
 {
     // begin saving dirty nodes
     mDirtyNodes = boost::make_shared< boost::unordered_map<SHAMapNode, SHAMapTreeNode::pointer> > ();
+    mDeferHashes = true;
     return ++mSeq;
 }
 
@@ -1056,11 +1226,176 @@ boost::shared_ptr<SHAMap::NodeMap> SHAMap::disarmDirty ()
     // stop saving dirty nodes
     ScopedWriteLockType sl (mLock);
 
+    updateHashes ();
+    mDeferHashes = false;
+
     boost::shared_ptr<NodeMap> ret;
     ret.swap (mDirtyNodes);
+
+    if (ret)
+    {
+        // Nodes that were removed from the tree before their hashes
+        // were computed are not part of it and need not be written
+        for (NodeMap::iterator it = ret->begin (); it != ret->end ();)
+        {
+            if (it->second->isHashStale ())
+                it = ret->erase (it);
+            else
+                ++it;
+        }
+    }
+
     return ret;
 }
 
+//------------------------------------------------------------------------------
+
+uint256 SHAMap::getHash ()
+{
+    if (root->isHashStale ())
+    {
+        ScopedWriteLockType sl (mLock);
+        updateHashes ();
+    }
+
+    return root->getNodeHash ();
+}
+
+uint256 SHAMap::getHash () const
+{
+    // Computing deferred hashes does not change the contents of the map
+    return const_cast <SHAMap*> (this)->getHash ();
+}
+
+bool SHAMap::setChildHash (SHAMapTreeNode::ref node, int branch, uint256 const& hash)
+{
+    if (!mDeferHashes)
+        return node->setChildHash (branch, hash);
+
+    if (!node->isHashStale ())
+        ++mStaleNodes;
+
+    node->setChildHashDeferred (branch, hash);
+    return true;
+}
+
+bool SHAMap::setChildStale (SHAMapTreeNode::ref node, int branch)
+{
+    // Returns false if the branch was already stale
+    assert (mDeferHashes);
+
+    if (!node->isHashStale ())
+        ++mStaleNodes;
+
+    bool const wasStale = (node->getStaleBranches () & (1 << branch)) != 0;
+    node->setChildStale (branch);
+    return !wasStale;
+}
+
+SHAMapTreeNode& SHAMap::getStaleChild (SHAMapTreeNode& node, int branch)
+{
+    // Modified children are normally linked
+    SHAMapTreeNode* const child = node.peekChild (branch);
+
+    if (child)
+        return *child;
+
+    // Stale nodes were modified in this map, so they are always in mTNByID.
+    // Nothing inserts or erases while hashes are computed, so the lookup
+    // needs no lock even when called from several threads.
+    NodeMap::iterator it = mTNByID.peekMap ().find (node.getChildNodeID (branch));
+
+    if (it == mTNByID.peekMap ().end ())
+    {
+        WriteLog (lsFATAL, SHAMap) << "Stale child missing: " << node;
+        assert (false);
+        throw std::runtime_error ("stale child missing");
+    }
+
+    return *it->second;
+}
+
+void SHAMap::updateSubtreeHash (SHAMapTreeNode& node, SHAMapHashPool::Stack& stack)
+{
+    // Post-order walk of the stale nodes, children before their parents
+    SHAMapHashPool::Frame const top = { &node, 0 };
+    stack.clear ();
+    stack.push_back (top);
+
+    while (!stack.empty ())
+    {
+        SHAMapTreeNode& parent = *stack.back ().node;
+        int const branches = parent.getStaleBranches ();
+        int branch = stack.back ().branch;
+
+        while ((branch < 16) && !(branches & (1 << branch)))
+            ++branch;
+
+        if (branch == 16)
+        {
+            parent.updateHash ();
+            stack.pop_back ();
+            continue;
+        }
+
+        SHAMapTreeNode& child = getStaleChild (parent, branch);
+
+        if (child.isHashStale ())
+        {
+            // Come back to this branch once the child is hashed
+            stack.back ().branch = branch;
+            SHAMapHashPool::Frame const frame = { &child, 0 };
+            stack.push_back (frame);
+            continue;
+        }
+
+        parent.setChildHashDeferred (branch, child.getNodeHash ());
+        stack.back ().branch = branch + 1;
+    }
+}
+
+void SHAMap::updateHashes ()
+{
+    if (!root->isHashStale ())
+        return;
+
+    // The subtrees below the root share no nodes, so each stale branch
+    // of the root can be hashed on its own thread.
+    std::vector <SHAMapTreeNode*> subtrees;
+    int const branches = root->getStaleBranches ();
+
+    for (int i = 0; i < 16; ++i)
+    {
+        if (branches & (1 << i))
+        {
+            SHAMapTreeNode& child = getStaleChild (*root, i);
+
+            if (child.isHashStale ())
+                subtrees.push_back (&child);
+        }
+    }
+
+    SHAMapHashPool::Stack stack;
+
+    if ((mStaleNodes >= PARALLEL_HASH_NODES) && (subtrees.size () > 1) &&
+        (SHAMapHashPool::getInstance ().getThreadCount () > 1))
+    {
+        SHAMapHashPool::getInstance ().run (subtrees.size (),
+            [this, &subtrees] (std::size_t i, SHAMapHashPool::Stack& stack)
+            {
+                updateSubtreeHash (*subtrees[i], stack);
+            });
+    }
+    else
+    {
+        for (auto subtree : subtrees)
+            updateSubtreeHash (*subtree, stack);
+    }
+
+    updateSubtreeHash (*root, stack);
+    mStaleNodes = 0;
+}
+
 SHAMapTreeNode::pointer SHAMap::getNode (const SHAMapNode& nodeID)
 {
 
@@ -1079,7 +1414,7 @@ SHAMapTreeNode::pointer SHAMap::getNode (const SHAMapNode& nodeID)
         if ((branch < 0) || node->isEmptyBranch (branch))
             return SHAMapTreeNode::pointer ();
 
-        node = getNode (node->getChildNodeID (branch), node->getChildHash (branch), false);
+        node = descend (node, branch);
         assert (node);
     }
 
@@ -1111,7 +1446,7 @@ SHAMapTreeNode* SHAMap::getNodePointer (const SHAMapNode& nodeID)
         if ((branch < 0) || node->isEmptyBranch (branch))
             return NULL;
 
-        node = getNodePointer (node->getChildNodeID (branch), node->getChildHash (branch));
+        node = descendPointer (node, branch);
         assert (node);
     }
 
@@ -1138,7 +1473,7 @@ bool SHAMap::getPath (uint256 const& index, std::vector< Blob >& nodes, SHANodeF
         if (inNode->isEmptyBranch (branch)) // paths leads to empty branch
             return false;
 
-        inNode = getNodePointer (inNode->getChildNodeID (branch), inNode->getChildHash (branch));
+        inNode = descendPointer (inNode, branch);
         assert (inNode);
     }
 
@@ -1291,7 +1626,539 @@ public:
         unexpected (sMap.getHash () == mapHash, "bad snapshot");
 
         unexpected (map2->getHash () != mapHash, "bad snapshot");
+
+        beginTestCase ("deferred hashes");
+
+        // The same changes applied with and without dirty tracking
+        // must produce the same tree.
+        {
+            SHAMap eager (smtFREE, fullBelowCache);
+            SHAMap deferred (smtFREE, fullBelowCache);
+            std::vector <uint256> tags;
+            Random r (1);
+
+            for (int pass = 0; pass < 4; ++pass)
+            {
+                deferred.armDirty ();
+
+                for (int i = 0; i < 2000; ++i)
+                {
+                    if (!tags.empty () && (r.nextInt (3) == 0))
+                    {
+                        int const n (r.nextInt (tags.size ()));
+                        unexpected (!eager.delItem (tags[n]), "no delete");
+                        unexpected (!deferred.delItem (tags[n]), "no delete");
+                        tags.erase (tags.begin () + n);
+                    }
+                    else
+                    {
+                        uint256 tag;
+                        r.fillBitsRandomly (tag.begin (), tag.size ());
+                        SHAMapItem item (tag, IntToVUC (i));
+                        unexpected (!eager.addItem (item, false, false), "no add");
+                        unexpected (!deferred.addItem (item, false, false), "no add");
+                        tags.push_back (tag);
+                    }
+                }
+
+                boost::shared_ptr <SHAMap::NodeMap> dirty (deferred.disarmDirty ());
+
+                unexpected (eager.getHash () != deferred.getHash (), "bad deferred hash");
+
+                for (SHAMap::NodeMap::iterator it = dirty->begin (); it != dirty->end (); ++it)
+                    unexpected (it->second->isHashStale (), "stale dirty node");
+            }
+        }
+
+        beginTestCase ("child links");
+
+        // Inner nodes link to the children the map modified. A snapshot
+        // of a map that is still being modified must not share them.
+        {
+            std::vector <uint256> tags (500);
+            Random r (2);
+            SHAMap original (smtFREE, fullBelowCache);
+
+            for (std::size_t i = 0; i < tags.size (); ++i)
+            {
+                r.fillBitsRandomly (tags[i].begin (), tags[i].size ());
+                unexpected (!original.addItem (SHAMapItem (tags[i], IntToVUC (1)), false, false), "no add");
+            }
+
+            SHAMap::pointer copy = original.snapShot (true);
+
+            for (std::size_t i = 0; i < tags.size (); ++i)
+            {
+                if (i % 2)
+                    unexpected (!original.updateGiveItem (boost::make_shared <SHAMapItem> (
+                        tags[i], IntToVUC (2)), false, false), "no update");
+                else
+                    unexpected (!copy->delItem (tags[i]), "no delete");
+            }
+
+            SHAMap expectOriginal (smtFREE, fullBelowCache);
+            SHAMap expectCopy (smtFREE, fullBelowCache);
+
+            for (std::size_t i = 0; i < tags.size (); ++i)
+            {
+                int const v ((i % 2) ? 2 : 1);
+                expectOriginal.addItem (SHAMapItem (tags[i], IntToVUC (v)), false, false);
+
+                SHAMapItem::pointer item (original.peekItem (tags[i]));
+                unexpected (!item || (item->peekData () != IntToVUC (v)), "bad item");
+
+                item = copy->peekItem (tags[i]);
+
+                if (i % 2)
+                {
+                    expectCopy.addItem (SHAMapItem (tags[i], IntToVUC (1)), false, false);
+                    unexpected (!item || (item->peekData () != IntToVUC (1)), "bad item");
+                }
+                else
+                {
+                    unexpected (!!item, "deleted item present");
+                }
+            }
+
+            unexpected (original.getHash () != expectOriginal.getHash (), "bad linked hash");
+            unexpected (copy->getHash () != expectCopy.getHash (), "bad linked hash");
+        }
     }
 };
 
 static SHAMapTests shaMapTests;
+
+//------------------------------------------------------------------------------
+
+/** Compares eager hashing with hashing deferred until disarmDirty.
+
+    A map of account state leaves is built, then every leaf is updated
+    once with hashes maintained on each change and once with the hashes
+    computed in a single pass when dirty tracking is disarmed.
+*/
+class SHAMapHashTimingTests : public UnitTest
+{
+public:
+    SHAMapHashTimingTests () : UnitTest ("SHAMapHashTiming", "ripple", runManual)
+    {
+    }
+
+    static Blob makeData (Random& r)
+    {
+        Blob data (64);
+        r.fillBitsRandomly (&data[0], data.size ());
+        return data;
+    }
+
+    static void updateAll (SHAMap& map, std::vector <uint256> const& tags,
+        Random& r)
+    {
+        for (auto const& tag : tags)
+        {
+            SHAMapItem::pointer item (boost::make_shared <SHAMapItem> (
+                tag, makeData (r)));
+            map.updateGiveItem (item, false, false);
+        }
+    }
+
+    void testLeaves (int leaves)
+    {
+        FullBelowCache fullBelowCache ("test.full_below",
+            get_seconds_clock ());
+
+        Random r (leaves);
+        std::vector <uint256> tags (leaves);
+
+        SHAMap map (smtFREE, fullBelowCache);
+        map.armDirty ();
+
+        for (auto& tag : tags)
+        {
+            r.fillBitsRandomly (tag.begin (), tag.size ());
+            map.addGiveItem (boost::make_shared <SHAMapItem> (
+                tag, makeData (r)), false, false);
+        }
+
+        map.disarmDirty ();
+        map.getHash ();
+
+        SHAMap::pointer eager (map.snapShot (true));
+        SHAMap::pointer deferred (map.snapShot (true));
+
+        Random r1 (leaves + 1);
+        int64 start (Time::getHighResolutionTicks ());
+        updateAll (*eager, tags, r1);
+        uint256 const eagerHash (eager->getHash ());
+        double const eagerTime (Time::highResolutionTicksToSeconds (
+            Time::getHighResolutionTicks () - start));
+
+        Random r2 (leaves + 1);
+        start = Time::getHighResolutionTicks ();
+        deferred->armDirty ();
+        updateAll (*deferred, tags, r2);
+        deferred->disarmDirty ();
+        uint256 const deferredHash (deferred->getHash ());
+        double const deferredTime (Time::highResolutionTicksToSeconds (
+            Time::getHighResolutionTicks () - start));
+
+        expect (eagerHash == deferredHash, "hash mismatch");
+
+        String s;
+        s << String (leaves) << " leaves: eager " <<
+            String (eagerTime * 1000, 1) << "ms, deferred " <<
+            String (deferredTime * 1000, 1) << "ms";
+        logMessage (s);
+    }
+
+    void runTest ()
+    {
+        beginTestCase ("update");
+
+        testLeaves (10000);
+        testLeaves (100000);
+        testLeaves (1000000);
+    }
+};
+
+static SHAMapHashTimingTests shaMapHashTimingTests;
+
+//------------------------------------------------------------------------------
+
+/** Reports the memory used by tree nodes and times lookups and walks.
+
+    The memory figures are computed from the node counts: each node is a
+    SHAMapTreeNode and every node except the root occupies one child slot
+    in its parent. The previous layout, with sixteen hashes in every node
+    and no links, is shown for comparison.
+*/
+class SHAMapLayoutTests : public UnitTest
+{
+public:
+    SHAMapLayoutTests () : UnitTest ("SHAMapLayout", "ripple", runManual)
+    {
+    }
+
+    enum
+    {
+        accounts = 1000000,
+        itemSize = 100
+    };
+
+    void runTest ()
+    {
+        beginTestCase ("layout");
+
+        FullBelowCache fullBelowCache ("test.full_below",
+            get_seconds_clock ());
+
+        Random r (accounts);
+        std::vector <uint256> tags (accounts);
+        SHAMap map (smtFREE, fullBelowCache);
+
+        map.armDirty ();
+
+        for (auto& tag : tags)
+        {
+            r.fillBitsRandomly (tag.begin (), tag.size ());
+            Blob data (itemSize);
+            r.fillBitsRandomly (&data[0], data.size ());
+            map.addGiveItem (boost::make_shared <SHAMapItem> (tag, data), false, false);
+        }
+
+        map.disarmDirty ();
+
+        std::size_t const nodes (map.size ());
+        std::size_t const inner (nodes - accounts);
+
+        double const linked (double (nodes) * sizeof (SHAMapTreeNode) +
+            double (nodes - 1) * sizeof (SHAMapTreeNode::Child));
+        double const flat (double (nodes) * (sizeof (SHAMapTreeNode) -
+            sizeof (std::unique_ptr <SHAMapTreeNode::Child []>) + 16 * sizeof (uint256)));
+        double const scale (1000000.0 / accounts / (1024 * 1024));
+
+        {
+            String s;
+            s << String (int64 (accounts)) << " accounts, " <<
+                String (int64 (inner)) << " inner nodes";
+            logMessage (s);
+        }
+
+        {
+            String s;
+            s << "node memory per million accounts: " <<
+                String (linked * scale, 1) << "MB, was " <<
+                String (flat * scale, 1) << "MB";
+            logMessage (s);
+        }
+
+        // Look every item up in random order
+        for (std::size_t i = tags.size () - 1; i > 0; --i)
+            std::swap (tags[i], tags[r.nextInt (int (i + 1))]);
+
+        int64 start (Time::getHighResolutionTicks ());
+
+        for (auto const& tag : tags)
+            expect (!!map.peekItem (tag), "missing item");
+
+        double const lookup (Time::highResolutionTicksToSeconds (
+            Time::getHighResolutionTicks () - start));
+
+        // Walk the items in order
+        start = Time::getHighResolutionTicks ();
+        int walked (0);
+
+        for (SHAMapItem::pointer item (map.peekFirstItem ()); item;
+                item = map.peekNextItem (item->getTag ()))
+            ++walked;
+
+        double const walk (Time::highResolutionTicksToSeconds (
+            Time::getHighResolutionTicks () - start));
+
+        expect (walked == accounts, "bad walk");
+
+        String s;
+        s << "lookup " << String (lookup * 1e9 / accounts, 1) << "ns, " <<
+            "walk " << String (walk * 1e9 / accounts, 1) << "ns per item";
+        logMessage (s);
+    }
+};
+
+static SHAMapLayoutTests shaMapLayoutTests;
+
+//------------------------------------------------------------------------------
+
+/** Takes many snapshots of a large map and changes each one.
+
+    Each snapshot shares the tree of the map it was taken from, so taking
+    one is constant time and changing an item copies only the nodes on the
+    path to it.
+*/
+class SHAMapSnapshotTests : public UnitTest
+{
+public:
+    SHAMapSnapshotTests () : UnitTest ("SHAMapSnapshot", "ripple", runManual)
+    {
+    }
+
+    enum
+    {
+        accounts = 1000000,
+        snapshots = 10000
+    };
+
+    void runTest ()
+    {
+        beginTestCase ("snapshots");
+
+        FullBelowCache fullBelowCache ("test.full_below",
+            get_seconds_clock ());
+
+        Random r (snapshots);
+        std::vector <uint256> tags (accounts);
+        SHAMap map (smtFREE, fullBelowCache);
+
+        map.armDirty ();
+
+        for (auto& tag : tags)
+        {
+            r.fillBitsRandomly (tag.begin (), tag.size ());
+            Blob data (100);
+            r.fillBitsRandomly (&data[0], data.size ());
+            map.addGiveItem (boost::make_shared <SHAMapItem> (tag, data), false, false);
+        }
+
+        map.disarmDirty ();
+        uint256 const hash (map.getHash ());
+
+        std::vector <SHAMap::pointer> maps;
+        maps.reserve (snapshots);
+
+        double snapTime (0);
+        double changeTime (0);
+        std::size_t copied (0);
+
+        for (int i = 0; i < snapshots; ++i)
+        {
+            int64 start (Time::getHighResolutionTicks ());
+            SHAMap::pointer snap (map.snapShot (true));
+            int64 const snapped (Time::getHighResolutionTicks ());
+
+            Blob data (100);
+            r.fillBitsRandomly (&data[0], data.size ());
+            snap->updateGiveItem (boost::make_shared <SHAMapItem> (
+                tags[r.nextInt (accounts)], data), false, false);
+            snap->getHash ();
+
+            int64 const changed (Time::getHighResolutionTicks ());
+
+            snapTime += Time::highResolutionTicksToSeconds (snapped - start);
+            changeTime += Time::highResolutionTicksToSeconds (changed - snapped);
+            copied += snap->size ();
+            maps.push_back (snap);
+        }
+
+        expect (map.getHash () == hash, "original map changed");
+
+        String s;
+        s << String (snapshots) << " snapshots of " << String (accounts) <<
+            " items: snapshot " << String (snapTime * 1e6 / snapshots, 2) <<
+            "us, change " << String (changeTime * 1e6 / snapshots, 2) <<
+            "us, " << String (double (copied) / snapshots, 1) <<
+            " nodes per snapshot, at most " << String (copied *
+                (sizeof (SHAMapTreeNode) + sizeof (SHAMapTreeNode::Child) * 16) /
+                    (1024.0 * 1024.0), 1) << "MB held by all snapshots";
+        logMessage (s);
+    }
+};
+
+static SHAMapSnapshotTests shaMapSnapshotTests;
+
+//------------------------------------------------------------------------------
+
+/** Walks a large map whose nodes are only in the node store.
+
+    Every node is flushed to the node store and the caches are purged, so
+    each walk starts cold. The walk is done once fetching one node at a
+    time, and once with walkMap, which fetches the children of a group of
+    inner nodes in a single batch.
+*/
+class SHAMapColdWalkTests : public UnitTest
+{
+public:
+    SHAMapColdWalkTests () : UnitTest ("SHAMapColdWalk", "ripple", runManual)
+    {
+    }
+
+    enum
+    {
+        accounts = 1000000
+    };
+
+    // Drop everything cached in memory from the tree node cache and the
+    // node store, then restore the configured sizes.
+    static void purgeCaches ()
+    {
+        SHAMap::setTreeCache (0, 0);
+        getApp ().getNodeStore ().tune (0, 0);
+
+        // Expired entries are weakly held for one more sweep
+        for (int i = 0; i < 2; ++i)
+        {
+            SHAMap::sweep ();
+            getApp ().getNodeStore ().sweep ();
+        }
+
+        SHAMap::setTreeCache (getConfig ().getSize (siTreeCacheSize),
+            getConfig ().getSize (siTreeCacheAge));
+        getApp ().getNodeStore ().tune (getConfig ().getSize (siNodeCacheSize),
+            getConfig ().getSize (siNodeCacheAge));
+    }
+
+    // Visit every node, fetching each one by itself
+    static std::size_t walkSingly (SHAMap& map, SHAMapTreeNode::pointer const& root)
+    {
+        std::size_t count (1);
+        std::stack <SHAMapTreeNode::pointer> stack;
+        stack.push (root);
+
+        while (!stack.empty ())
+        {
+            SHAMapTreeNode::pointer node (stack.top ());
+            stack.pop ();
+
+            for (int i = 0; i < 16; ++i)
+            {
+                if (!node->isEmptyBranch (i))
+                {
+                    SHAMapTreeNode::pointer child (map.fetchNodeExternalNT (
+                        node->getChildNodeID (i), node->getChildHash (i)));
+
+                    if (child)
+                    {
+                        ++count;
+
+                        if (child->isInner ())
+                            stack.push (child);
+                    }
+                }
+            }
+        }
+
+        return count;
+    }
+
+    void runTest ()
+    {
+        beginTestCase ("cold walk");
+
+        FullBelowCache fullBelowCache ("test.full_below",
+            get_seconds_clock ());
+
+        uint256 hash;
+        std::size_t nodes;
+
+        {
+            Random r (accounts);
+            SHAMap map (smtFREE, fullBelowCache);
+
+            map.armDirty ();
+
+            for (int i = 0; i < accounts; ++i)
+            {
+                uint256 tag;
+                r.fillBitsRandomly (tag.begin (), tag.size ());
+                Blob data (100);
+                r.fillBitsRandomly (&data[0], data.size ());
+                map.addGiveItem (boost::make_shared <SHAMapItem> (tag, data), false, false);
+            }
+
+            boost::shared_ptr <SHAMap::NodeMap> dirty (map.disarmDirty ());
+            SHAMap::flushDirty (*dirty, dirty->size (), hotACCOUNT_NODE, 1);
+
+            hash = map.getHash ();
+            nodes = map.size ();
+        }
+
+        // Let the batch writer finish before reading anything back
+        while (getApp ().getNodeStore ().getWriteLoad () > 0)
+            Thread::sleep (100);
+
+        double single;
+        {
+            purgeCaches ();
+            SHAMap map (smtFREE, fullBelowCache);
+
+            int64 const start (Time::getHighResolutionTicks ());
+            expect (map.fetchRoot (hash, nullptr), "missing root");
+            std::size_t const count (walkSingly (map,
+                map.fetchNodeExternalNT (SHAMapNode (), hash)));
+            single = Time::highResolutionTicksToSeconds (
+                Time::getHighResolutionTicks () - start);
+
+            expect (count == nodes, "single walk missed nodes");
+        }
+
+        double batched;
+        {
+            purgeCaches ();
+            SHAMap map (smtFREE, fullBelowCache);
+
+            int64 const start (Time::getHighResolutionTicks ());
+            expect (map.fetchRoot (hash, nullptr), "missing root");
+            std::vector <SHAMapMissingNode> missing;
+            map.walkMap (missing, 1);
+            batched = Time::highResolutionTicksToSeconds (
+                Time::getHighResolutionTicks () - start);
+
+            expect (missing.empty (), "batched walk missed nodes");
+            expect (map.size () == nodes, "batched walk missed nodes");
+        }
+
+        String s;
+        s << String (int64 (nodes)) << " nodes: one at a time " <<
+            String (single, 2) << "s, batched " << String (batched, 2) << "s";
+        logMessage (s);
+    }
+};
+
+static SHAMapColdWalkTests shaMapColdWalkTests;
@@ -78,7 +78,11 @@ private:
 public:
     enum
     {
-        STATE_MAP_BUCKETS = 1024
+        STATE_MAP_BUCKETS = 1024,
+
+        // Deferred hashes are computed on several threads when at least
+        // this many inner nodes are stale
+        PARALLEL_HASH_NODES = 1024
     };
 
     static char const* getCountedObjectName () { return "SHAMap"; }
@@ -111,6 +115,8 @@ public:
     }
 
     // Returns a new map that's a snapshot of this one. Force CoW
+    // The tree is shared, so this takes constant time and each map copies
+    // only the nodes on the path to an item it changes.
     SHAMap::pointer snapShot (bool isMutable);
 
     // Remove nodes from memory
@@ -121,6 +127,12 @@ public:
         mLedgerSeq = lseq;
     }
 
+    // Nodes missing from the node store are looked for in this ledger's shard
+    void setShardSeq (uint32 lseq)
+    {
+        mShardSeq = lseq;
+    }
+
     bool hasNode (const SHAMapNode & id);
     bool fetchRoot (uint256 const & hash, SHAMapSyncFilter * filter);
 
@@ -130,14 +142,8 @@ public:
     bool addItem (const SHAMapItem & i, bool isTransaction, bool hasMeta);
     bool updateItem (const SHAMapItem & i, bool isTransaction, bool hasMeta);
     SHAMapItem getItem (uint256 const & id);
-    uint256 getHash () const
-    {
-        return root->getNodeHash ();
-    }
-    uint256 getHash ()
-    {
-        return root->getNodeHash ();
-    }
+    uint256 getHash () const;
+    uint256 getHash ();
 
     // save a copy if you have a temporary anyway
     bool updateGiveItem (SHAMapItem::ref, bool isTransaction, bool hasMeta);
@@ -206,6 +212,11 @@ public:
     // return value: true=successfully completed, false=too different
     bool compare (SHAMap::ref otherMap, Delta & differences, int maxCount);
 
+    /** Begin saving dirty nodes.
+        Until disarmDirty is called, inner node hashes are not updated as
+        items change. They are computed once, in parallel, when the hash
+        of the map is requested or the dirty nodes are collected.
+    */
     int armDirty ();
     static int flushDirty (NodeMap & dirtyMap, int maxNodes, NodeObjectType t, uint32 seq);
     boost::shared_ptr<NodeMap> disarmDirty ();
@@ -273,9 +284,9 @@ public:
     typedef std::pair<uint256, SHAMapNode> TNIndex;
 
 private:
-    static TaggedCache <TNIndex, SHAMapTreeNode> treeNodeCache;
+    static ShardedTaggedCache <TNIndex, SHAMapTreeNode> treeNodeCache;
 
-    void dirtyUp (std::stack<SHAMapTreeNode::pointer>& stack, uint256 const & target, uint256 prevHash);
+    void dirtyUp (std::stack<SHAMapTreeNode::pointer>& stack, uint256 const & target, SHAMapTreeNode::pointer child);
     std::stack<SHAMapTreeNode::pointer> getStack (uint256 const & id, bool include_nonmatching_leaf);
     SHAMapTreeNode::pointer walkTo (uint256 const & id, bool modify);
     SHAMapTreeNode* walkToPointer (uint256 const & id);
@@ -290,6 +301,16 @@ private:
     SHAMapTreeNode* getNodePointerNT (const SHAMapNode & id, uint256 const & hash);
     SHAMapTreeNode* getNodePointer (const SHAMapNode & id, uint256 const & hash, SHAMapSyncFilter * filter);
     SHAMapTreeNode* getNodePointerNT (const SHAMapNode & id, uint256 const & hash, SHAMapSyncFilter * filter);
+
+    SHAMapTreeNode::pointer makeSharedNode (SHAMapNode const& id,
+        uint256 const& hash, NodeObject::ref object);
+    void prefetchChildren (std::vector <SHAMapTreeNode*> const& parents,
+        bool skipFullBelow);
+
+    // follow the link to a child, or look it up by ID and hash
+    SHAMapTreeNode::pointer descend (SHAMapTreeNode::ref parent, int branch);
+    SHAMapTreeNode* descendPointer (SHAMapTreeNode* parent, int branch);
+
     SHAMapTreeNode* firstBelow (SHAMapTreeNode*);
     SHAMapTreeNode* lastBelow (SHAMapTreeNode*);
 
@@ -302,6 +323,13 @@ private:
     bool walkBranch (SHAMapTreeNode * node, SHAMapItem::ref otherMapItem, bool isFirstMap,
                      Delta & differences, int & maxCount);
 
+    // deferred hashing, the caller must hold the write lock
+    bool setChildHash (SHAMapTreeNode::ref node, int branch, uint256 const & hash);
+    bool setChildStale (SHAMapTreeNode::ref node, int branch);
+    SHAMapTreeNode& getStaleChild (SHAMapTreeNode & node, int branch);
+    void updateSubtreeHash (SHAMapTreeNode & node, SHAMapHashPool::Stack & stack);
+    void updateHashes ();
+
     void visitLeavesInternal (std::function<void (SHAMapItem::ref item)>& function);
 
 private:
@@ -314,8 +342,11 @@ private:
     FullBelowCache& m_fullBelowCache;
     uint32 mSeq;
     uint32 mLedgerSeq; // sequence number of ledger this is part of
+    uint32 mShardSeq;  // sequence number of ledger whose shard has our nodes
     SyncUnorderedMapType< SHAMapNode, SHAMapTreeNode::pointer > mTNByID;
     boost::shared_ptr<NodeMap> mDirtyNodes;
+    bool mDeferHashes;
+    int mStaleNodes;
     SHAMapTreeNode::pointer root;
     SHAMapState mState;
     SHAMapType mType;
@@ -57,7 +57,7 @@ bool SHAMap::walkBranch (SHAMapTreeNode* node, SHAMapItem::ref otherMapItem, boo
             // This is an inner node, add all non-empty branches
             for (int i = 0; i < 16; ++i)
                 if (!node->isEmptyBranch (i))
-                    nodeStack.push (getNodePointer (node->getChildNodeID (i), node->getChildHash (i)));
+                    nodeStack.push (descendPointer (node, i));
         }
         else
         {
@@ -138,12 +138,17 @@ bool SHAMap::compare (SHAMap::ref otherMap, Delta& differences, int maxCount)
 
     std::stack<SHAMapDeltaNode> nodeStack; // track nodes we've pushed
 
+    // getHash may take the write lock to compute deferred hashes, so
+    // both are read before taking the read lock
+    uint256 const ourHash (getHash ());
+    uint256 const otherHash (otherMap->getHash ());
+
     ScopedReadLockType sl (mLock);
 
-    if (getHash () == otherMap->getHash ())
+    if (ourHash == otherHash)
         return true;
 
-    nodeStack.push (SHAMapDeltaNode (SHAMapNode (), getHash (), otherMap->getHash ()));
+    nodeStack.push (SHAMapDeltaNode (SHAMapNode (), ourHash, otherHash));
 
     while (!nodeStack.empty ())
     {
@@ -206,7 +211,7 @@ bool SHAMap::compare (SHAMap::ref otherMap, Delta& differences, int maxCount)
                     if (otherNode->isEmptyBranch (i))
                     {
                         // We have a branch, the other tree does not
-                        SHAMapTreeNode* iNode = getNodePointer (ourNode->getChildNodeID (i), ourNode->getChildHash (i));
+                        SHAMapTreeNode* iNode = descendPointer (ourNode, i);
 
                         if (!walkBranch (iNode, SHAMapItem::pointer (), true, differences, maxCount))
                             return false;
@@ -214,8 +219,7 @@ bool SHAMap::compare (SHAMap::ref otherMap, Delta& differences, int maxCount)
                     else if (ourNode->isEmptyBranch (i))
                     {
                         // The other tree has a branch, we do not
-                        SHAMapTreeNode* iNode =
-                            otherMap->getNodePointer (otherNode->getChildNodeID (i), otherNode->getChildHash (i));
+                        SHAMapTreeNode* iNode = otherMap->descendPointer (otherNode, i);
 
                         if (!otherMap->walkBranch (iNode, SHAMapItem::pointer (), false, differences, maxCount))
                             return false;
@@ -234,6 +238,9 @@ bool SHAMap::compare (SHAMap::ref otherMap, Delta& differences, int maxCount)
 
 void SHAMap::walkMap (std::vector<SHAMapMissingNode>& missingNodes, int maxMissing)
 {
+    // Number of inner nodes whose children are fetched together
+    static std::size_t const walkGroupSize = 64;
+
     std::stack<SHAMapTreeNode::pointer> nodeStack;
 
     ScopedReadLockType sl (mLock);
@@ -243,28 +250,45 @@ void SHAMap::walkMap (std::vector<SHAMapMissingNode>& missingNodes, int maxMissi
 
     nodeStack.push (root);
 
+    std::vector<SHAMapTreeNode::pointer> group;
+    std::vector<SHAMapTreeNode*> parents;
+
     while (!nodeStack.empty ())
     {
-        SHAMapTreeNode::pointer node = nodeStack.top ();
-        nodeStack.pop ();
+        // Take a group of inner nodes and bring in all of their
+        // children with one batched fetch before descending
+        group.clear ();
+        parents.clear ();
 
-        for (int i = 0; i < 16; ++i)
-            if (!node->isEmptyBranch (i))
-            {
-                try
-                {
-                    SHAMapTreeNode::pointer d = getNode (node->getChildNodeID (i), node->getChildHash (i), false);
+        while (!nodeStack.empty () && (group.size () < walkGroupSize))
+        {
+            group.push_back (nodeStack.top ());
+            parents.push_back (group.back ().get ());
+            nodeStack.pop ();
+        }
 
-                    if (d->isInner ())
-                        nodeStack.push (d);
-                }
-                catch (SHAMapMissingNode& n)
+        prefetchChildren (parents, false);
+
+        for (auto const& node : group)
+        {
+            for (int i = 0; i < 16; ++i)
+                if (!node->isEmptyBranch (i))
                 {
-                    missingNodes.push_back (n);
+                    try
+                    {
+                        SHAMapTreeNode::pointer d = descend (node, i);
+
+                        if (d->isInner ())
+                            nodeStack.push (d);
+                    }
+                    catch (SHAMapMissingNode& n)
+                    {
+                        missingNodes.push_back (n);
 
-                    if (--maxMissing <= 0)
-                        return;
+                        if (--maxMissing <= 0)
+                            return;
+                    }
                 }
-            }
+        }
     }
 }
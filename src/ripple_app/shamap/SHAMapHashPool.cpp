@@ -0,0 +1,127 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+SHAMapHashPool& SHAMapHashPool::getInstance ()
+{
+    static SHAMapHashPool pool (std::max (1,
+        static_cast <int> (std::thread::hardware_concurrency ())));
+
+    return pool;
+}
+
+SHAMapHashPool::SHAMapHashPool (int threads)
+    : m_work (nullptr)
+    , m_count (0)
+    , m_next (0)
+    , m_active (0)
+    , m_pass (0)
+    , m_stop (false)
+{
+    for (int i = 0; i < threads; ++i)
+        m_threads.emplace_back (&SHAMapHashPool::runThread, this);
+}
+
+SHAMapHashPool::~SHAMapHashPool ()
+{
+    {
+        std::lock_guard <std::mutex> lock (m_mutex);
+        m_stop = true;
+    }
+
+    m_wake.notify_all ();
+
+    for (auto& thread : m_threads)
+        thread.join ();
+}
+
+int SHAMapHashPool::getThreadCount () const
+{
+    return static_cast <int> (m_threads.size ());
+}
+
+void SHAMapHashPool::run (std::size_t count, Work const& work)
+{
+    std::lock_guard <std::mutex> runLock (m_runMutex);
+    std::exception_ptr error;
+
+    {
+        std::unique_lock <std::mutex> lock (m_mutex);
+
+        m_work = &work;
+        m_count = count;
+        m_next = 0;
+        m_active = getThreadCount ();
+        m_error = nullptr;
+        ++m_pass;
+
+        m_wake.notify_all ();
+        m_done.wait (lock, [this] { return m_active == 0; });
+
+        m_work = nullptr;
+        error = m_error;
+        m_error = nullptr;
+    }
+
+    if (error)
+        std::rethrow_exception (error);
+}
+
+void SHAMapHashPool::runThread ()
+{
+    Thread::setCurrentThreadName ("SHAMapHash");
+
+    Stack stack;
+    uint64 pass (0);
+
+    std::unique_lock <std::mutex> lock (m_mutex);
+
+    for (;;)
+    {
+        m_wake.wait (lock, [this, pass] { return m_stop || m_pass != pass; });
+
+        if (m_stop)
+            return;
+
+        pass = m_pass;
+
+        while (m_next < m_count)
+        {
+            std::size_t const index (m_next++);
+
+            lock.unlock ();
+
+            try
+            {
+                (*m_work) (index, stack);
+            }
+            catch (...)
+            {
+                lock.lock ();
+                if (! m_error)
+                    m_error = std::current_exception ();
+                lock.unlock ();
+            }
+
+            lock.lock ();
+        }
+
+        if (--m_active == 0)
+            m_done.notify_all ();
+    }
+}
@@ -0,0 +1,82 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_SHAMAPHASHPOOL_H
+#define RIPPLE_SHAMAPHASHPOOL_H
+
+namespace ripple {
+
+/** Threads which compute the deferred hashes of large SHAMap updates.
+
+    The threads are started on first use and last for the life of the
+    process, so a ledger close pays nothing to start them. Each thread
+    keeps the stack it walks subtrees with, so its storage is reused from
+    one pass to the next.
+*/
+class SHAMapHashPool : public Uncopyable
+{
+public:
+    // A node whose stale branches are being hashed, and the next branch
+    struct Frame
+    {
+        SHAMapTreeNode* node;
+        int branch;
+    };
+
+    typedef std::vector <Frame> Stack;
+
+    typedef std::function <void (std::size_t index, Stack& stack)> Work;
+
+    /** Return the pool shared by every SHAMap. */
+    static SHAMapHashPool& getInstance ();
+
+    ~SHAMapHashPool ();
+
+    /** Return the number of threads in the pool. */
+    int getThreadCount () const;
+
+    /** Call the work once for each index below the count.
+        The calls are spread over the pool's threads, and this returns once
+        all of them have finished. Passes from different maps take turns.
+        If any call throws, the first exception is rethrown here.
+    */
+    void run (std::size_t count, Work const& work);
+
+private:
+    explicit SHAMapHashPool (int threads);
+
+    void runThread ();
+
+    std::mutex m_runMutex;          // Held for the duration of a pass
+    std::mutex m_mutex;             // Protects everything below
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    std::vector <std::thread> m_threads;
+    Work const* m_work;
+    std::size_t m_count;
+    std::size_t m_next;
+    int m_active;                   // Threads which haven't finished the pass
+    uint64 m_pass;
+    std::exception_ptr m_error;
+    bool m_stop;
+};
+
+}
+
+#endif
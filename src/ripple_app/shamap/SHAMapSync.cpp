@@ -57,7 +57,7 @@ void SHAMap::visitLeavesInternal (std::function<void (SHAMapItem::ref item)>& fu
             }
             else
             {
-                SHAMapTreeNode* child = getNodePointer (node->getChildNodeID (pos), node->getChildHash (pos));
+                SHAMapTreeNode* child = descendPointer (node, pos);
                 if (child->isLeaf ())
                 {
                     function (child->peekItem ());
@@ -140,6 +140,12 @@ void SHAMap::getMissingNodes (std::vector<SHAMapNode>& nodeIDs, std::vector<uint
 
     do
     {
+        if (currentChild == 0)
+        {
+            // Starting a new inner node, ask for its children together
+            prefetchChildren (std::vector<SHAMapTreeNode*> (1, node), true);
+        }
+
         while (currentChild < 16)
         {
             int branch = (firstChild + ++currentChild) % 16;
@@ -260,7 +266,7 @@ bool SHAMap::getNodeFat (const SHAMapNode& wanted, std::vector<SHAMapNode>& node
         for (int i = 0; i < 16; ++i)
             if (!node->isEmptyBranch (i))
             {
-                nextNode = getNodePointer (node->getChildNodeID (i), node->getChildHash (i));
+                nextNode = descendPointer (node, i);
                 ++count;
                 if (fatLeaves || nextNode->isInner ())
                 {
@@ -489,7 +495,7 @@ bool SHAMap::deepCompare (SHAMap& other)
                 }
                 else
                 {
-                    SHAMapTreeNode::pointer next = getNode (node->getChildNodeID (i), node->getChildHash (i), false);
+                    SHAMapTreeNode::pointer next = descend (node, i);
 
                     if (!next)
                     {
@@ -524,7 +530,7 @@ bool SHAMap::hasInnerNode (const SHAMapNode& nodeID, uint256 const& nodeHash)
         if (node->isEmptyBranch (branch))
             return false;
 
-        node = getNodePointer (node->getChildNodeID (branch), node->getChildHash (branch));
+        node = descendPointer (node, branch);
     }
 
     return node->getNodeHash () == nodeHash;
@@ -626,6 +632,8 @@ void SHAMap::getFetchPack (SHAMap* have, bool includeLeaves, int max,
         --max;
 
         // 2) push non-matching child inner nodes
+        prefetchChildren (std::vector<SHAMapTreeNode*> (1, node), false);
+
         for (int i = 0; i < 16; ++i)
         {
             if (!node->isEmptyBranch (i))
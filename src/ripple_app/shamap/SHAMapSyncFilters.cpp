@@ -124,3 +124,33 @@ bool TransactionStateSF::haveNode (SHAMapNode const& id,
 {
     return getApp().getOPs ().getFetchPack (nodeHash, nodeData);
 }
+
+//------------------------------------------------------------------------------
+
+ShardSF::ShardSF (NodeStore::ShardStore& shards, uint32 ledgerSeq)
+    : m_shards (shards)
+    , mLedgerSeq (ledgerSeq)
+{
+}
+
+void ShardSF::gotNode (bool fromFilter,
+                       SHAMapNode const& id,
+                       uint256 const& nodeHash,
+                       Blob& nodeData,
+                       SHAMapTreeNode::TNType)
+{
+    // The node came from the shard, there is nothing to store
+}
+
+bool ShardSF::haveNode (SHAMapNode const& id,
+                        uint256 const& nodeHash,
+                        Blob& nodeData)
+{
+    NodeObject::pointer const object (m_shards.fetch (nodeHash, mLedgerSeq));
+
+    if (!object)
+        return false;
+
+    nodeData.assign (object->getData (), object->getData () + object->getSize ());
+    return true;
+}
@@ -92,4 +92,26 @@ private:
     uint32 mLedgerSeq;
 };
 
+// This class is only needed on check functions
+// sync filter for the nodes of a ledger stored in a shard
+class ShardSF : public SHAMapSyncFilter
+{
+public:
+    ShardSF (NodeStore::ShardStore& shards, uint32 ledgerSeq);
+
+    void gotNode (bool fromFilter,
+                  SHAMapNode const& id,
+                  uint256 const& nodeHash,
+                  Blob& nodeData,
+                  SHAMapTreeNode::TNType);
+
+    bool haveNode (SHAMapNode const& id,
+                   uint256 const& nodeHash,
+                   Blob& nodeData);
+
+private:
+    NodeStore::ShardStore& m_shards;
+    uint32 mLedgerSeq;
+};
+
 #endif
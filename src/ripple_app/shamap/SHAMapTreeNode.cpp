@@ -17,6 +17,8 @@
 */
 //==============================================================================
 
+uint256 const SHAMapTreeNode::smEmptyHash;
+
 SHAMapTreeNode::SHAMapTreeNode (uint32 seq, const SHAMapNode& nodeID)
     : SHAMapNode (nodeID)
     , mHash (uint64(0))
@@ -24,21 +26,34 @@ SHAMapTreeNode::SHAMapTreeNode (uint32 seq, const SHAMapNode& nodeID)
     , mAccessSeq (seq)
     , mType (tnERROR)
     , mIsBranch (0)
+    , mStaleBranches (0)
+    , mHashStale (false)
     , mFullBelow (false)
 {
 }
 
 SHAMapTreeNode::SHAMapTreeNode (const SHAMapTreeNode& node, uint32 seq) : SHAMapNode (node),
-    mHash (node.mHash), mSeq (seq), mType (node.mType), mIsBranch (node.mIsBranch), mFullBelow (false)
+    mHash (node.mHash), mSeq (seq), mType (node.mType), mIsBranch (node.mIsBranch),
+    mStaleBranches (node.mStaleBranches), mHashStale (node.mHashStale), mFullBelow (false)
 {
     if (node.mItem)
+    {
         mItem = node.mItem;
-    else
-        memcpy (mHashes, node.mHashes, sizeof (mHashes));
+    }
+    else if (mIsBranch != 0)
+    {
+        // The links are kept, the children are shared until they are modified
+        int const count = countBranches (mIsBranch);
+        mChildren.reset (new Child [count]);
+
+        for (int i = 0; i < count; ++i)
+            mChildren[i] = node.mChildren[i];
+    }
 }
 
 SHAMapTreeNode::SHAMapTreeNode (const SHAMapNode& node, SHAMapItem::ref item, TNType type, uint32 seq) :
-    SHAMapNode (node), mItem (item), mSeq (seq), mType (type), mIsBranch (0), mFullBelow (false)
+    SHAMapNode (node), mItem (item), mSeq (seq), mType (type), mIsBranch (0),
+    mStaleBranches (0), mHashStale (false), mFullBelow (false)
 {
     assert (item->peekData ().size () >= 12);
     updateHash ();
@@ -46,7 +61,8 @@ SHAMapTreeNode::SHAMapTreeNode (const SHAMapNode& node, SHAMapItem::ref item, TN
 
 SHAMapTreeNode::SHAMapTreeNode (const SHAMapNode& id, Blob const& rawNode, uint32 seq,
                                 SHANodeFormat format, uint256 const& hash, bool hashValid) :
-    SHAMapNode (id), mSeq (seq), mType (tnERROR), mIsBranch (0), mFullBelow (false)
+    SHAMapNode (id), mSeq (seq), mType (tnERROR), mIsBranch (0),
+    mStaleBranches (0), mHashStale (false), mFullBelow (false)
 {
     if (format == snfWIRE)
     {
@@ -91,19 +107,19 @@ SHAMapTreeNode::SHAMapTreeNode (const SHAMapNode& id, Blob const& rawNode, uint3
             if (len != 512)
                 throw std::runtime_error ("invalid FI node");
 
-            for (int i = 0; i < 16; ++i)
-            {
-                s.get256 (mHashes[i], i * 32);
+            uint256 hashes[16];
 
-                if (mHashes[i].isNonZero ())
-                    mIsBranch |= (1 << i);
-            }
+            for (int i = 0; i < 16; ++i)
+                s.get256 (hashes[i], i * 32);
 
+            setChildHashes (hashes);
             mType = tnINNER;
         }
         else if (type == 3)
         {
             // compressed inner
+            uint256 hashes[16];
+
             for (int i = 0; i < (len / 33); ++i)
             {
                 int pos;
@@ -111,12 +127,10 @@ SHAMapTreeNode::SHAMapTreeNode (const SHAMapNode& id, Blob const& rawNode, uint3
 
                 if ((pos < 0) || (pos >= 16)) throw std::runtime_error ("invalid CI node");
 
-                s.get256 (mHashes[pos], i * 33);
-
-                if (mHashes[pos].isNonZero ())
-                    mIsBranch |= (1 << pos);
+                s.get256 (hashes[pos], i * 33);
             }
 
+            setChildHashes (hashes);
             mType = tnINNER;
         }
         else if (type == 4)
@@ -182,14 +196,12 @@ SHAMapTreeNode::SHAMapTreeNode (const SHAMapNode& id, Blob const& rawNode, uint3
             if (s.getLength () != 512)
                 throw std::runtime_error ("invalid PIN node");
 
-            for (int i = 0; i < 16; ++i)
-            {
-                s.get256 (mHashes[i], i * 32);
+            uint256 hashes[16];
 
-                if (mHashes[i].isNonZero ())
-                    mIsBranch |= (1 << i);
-            }
+            for (int i = 0; i < 16; ++i)
+                s.get256 (hashes[i], i * 32);
 
+            setChildHashes (hashes);
             mType = tnINNER;
         }
         else if (prefix == HashPrefix::txNode)
@@ -231,19 +243,28 @@ SHAMapTreeNode::SHAMapTreeNode (const SHAMapNode& id, Blob const& rawNode, uint3
 
 bool SHAMapTreeNode::updateHash ()
 {
+    assert (mStaleBranches == 0);
+    mHashStale = false;
+
     uint256 nh;
 
     if (mType == tnINNER)
     {
         if (mIsBranch != 0)
         {
-            nh = Serializer::getPrefixHash (HashPrefix::innerNode, reinterpret_cast<unsigned char*> (mHashes), sizeof (mHashes));
+            uint256 hashes[16];
+
+            for (int i = 0, j = 0; i < 16; ++i)
+                if (!isEmptyBranch (i))
+                    hashes[i] = mChildren[j++].hash;
+
+            nh = Serializer::getPrefixHash (HashPrefix::innerNode, reinterpret_cast<unsigned char*> (hashes), sizeof (hashes));
 #if RIPPLE_VERIFY_NODEOBJECT_KEYS
             Serializer s;
             s.add32 (HashPrefix::innerNode);
 
             for (int i = 0; i < 16; ++i)
-                s.add256 (mHashes[i]);
+                s.add256 (hashes[i]);
 
             assert (nh == s.getSHA512Half ());
 #endif
@@ -257,19 +278,11 @@ bool SHAMapTreeNode::updateHash ()
     }
     else if (mType == tnACCOUNT_STATE)
     {
-        Serializer s (mItem->peekSerializer ().getDataLength () + (256 + 32) / 8);
-        s.add32 (HashPrefix::leafNode);
-        s.addRaw (mItem->peekData ());
-        s.add256 (mItem->getTag ());
-        nh = s.getSHA512Half ();
+        nh = Serializer::getPrefixHash (HashPrefix::leafNode, mItem->peekData (), mItem->getTag ());
     }
     else if (mType == tnTRANSACTION_MD)
     {
-        Serializer s (mItem->peekSerializer ().getDataLength () + (256 + 32) / 8);
-        s.add32 (HashPrefix::txNode);
-        s.addRaw (mItem->peekData ());
-        s.add256 (mItem->getTag ());
-        nh = s.getSHA512Half ();
+        nh = Serializer::getPrefixHash (HashPrefix::txNode, mItem->peekData (), mItem->getTag ());
     }
     else
         assert (false);
@@ -301,7 +314,7 @@ void SHAMapTreeNode::addRaw (Serializer& s, SHANodeFormat format)
             s.add32 (HashPrefix::innerNode);
 
             for (int i = 0; i < 16; ++i)
-                s.add256 (mHashes[i]);
+                s.add256 (getChildHash (i));
         }
         else
         {
@@ -311,7 +324,7 @@ void SHAMapTreeNode::addRaw (Serializer& s, SHANodeFormat format)
                 for (int i = 0; i < 16; ++i)
                     if (!isEmptyBranch (i))
                     {
-                        s.add256 (mHashes[i]);
+                        s.add256 (getChildHash (i));
                         s.add8 (i);
                     }
 
@@ -320,7 +333,7 @@ void SHAMapTreeNode::addRaw (Serializer& s, SHANodeFormat format)
             else
             {
                 for (int i = 0; i < 16; ++i)
-                    s.add256 (mHashes[i]);
+                    s.add256 (getChildHash (i));
 
                 s.add8 (2);
             }
@@ -377,6 +390,9 @@ bool SHAMapTreeNode::setItem (SHAMapItem::ref i, TNType type)
 {
     mType = type;
     mItem = i;
+    mChildren.reset ();
+    mIsBranch = 0;
+    mStaleBranches = 0;
     assert (isLeaf ());
     assert (mSeq != 0);
     return updateHash ();
@@ -390,20 +406,16 @@ bool SHAMapTreeNode::isEmpty () const
 int SHAMapTreeNode::getBranchCount () const
 {
     assert (isInner ());
-    int count = 0;
-
-    for (int i = 0; i < 16; ++i)
-        if (!isEmptyBranch (i))
-            ++count;
-
-    return count;
+    return countBranches (mIsBranch);
 }
 
 void SHAMapTreeNode::makeInner ()
 {
     mItem.reset ();
+    mChildren.reset ();
     mIsBranch = 0;
-    memset (mHashes, 0, sizeof (mHashes));
+    mStaleBranches = 0;
+    mHashStale = false;
     mType = tnINNER;
     mHash.zero ();
 }
@@ -429,7 +441,7 @@ std::string SHAMapTreeNode::getString () const
                 ret += "\nb";
                 ret += lexicalCastThrow <std::string> (i);
                 ret += " = ";
-                ret += mHashes[i].GetHex ();
+                ret += getChildHash (i).GetHex ();
             }
     }
 
@@ -461,16 +473,115 @@ bool SHAMapTreeNode::setChildHash (int m, uint256 const& hash)
     assert (mType == tnINNER);
     assert (mSeq != 0);
 
-    if (mHashes[m] == hash)
+    if (getChildHash (m) == hash)
         return false;
 
-    mHashes[m] = hash;
+    setBranch (m, hash.isNonZero ());
 
     if (hash.isNonZero ())
-        mIsBranch |= (1 << m);
-    else
-        mIsBranch &= ~ (1 << m);
+        mChildren[getChildIndex (m)].hash = hash;
 
     return updateHash ();
 }
 
+void SHAMapTreeNode::setChildHashDeferred (int m, uint256 const& hash)
+{
+    assert ((m >= 0) && (m < 16));
+    assert (mType == tnINNER);
+    assert (mSeq != 0);
+
+    mStaleBranches &= ~ (1 << m);
+    setBranch (m, hash.isNonZero ());
+
+    if (hash.isNonZero ())
+        mChildren[getChildIndex (m)].hash = hash;
+
+    mHashStale = true;
+}
+
+void SHAMapTreeNode::setChildStale (int m)
+{
+    assert ((m >= 0) && (m < 16));
+    assert (mType == tnINNER);
+    assert (mSeq != 0);
+
+    mStaleBranches |= (1 << m);
+    setBranch (m, true);
+    mHashStale = true;
+}
+
+void SHAMapTreeNode::setChild (int m, SHAMapTreeNode::ref child)
+{
+    assert ((m >= 0) && (m < 16));
+    assert (mType == tnINNER);
+    assert (!isEmptyBranch (m));
+    assert (!child || (*child == getChildNodeID (m)));
+
+    mChildren[getChildIndex (m)].node = child;
+}
+
+void SHAMapTreeNode::setBranch (int m, bool present)
+{
+    // Add or remove the slot for branch m, keeping the rest in branch order
+    int const bit = 1 << m;
+
+    if (((mIsBranch & bit) != 0) == present)
+        return;
+
+    int const count = countBranches (mIsBranch);
+    int const index = getChildIndex (m);
+    std::unique_ptr <Child []> children;
+
+    if (present)
+    {
+        children.reset (new Child [count + 1]);
+
+        for (int i = 0; i < index; ++i)
+            children[i] = std::move (mChildren[i]);
+
+        for (int i = index; i < count; ++i)
+            children[i + 1] = std::move (mChildren[i]);
+
+        mIsBranch |= bit;
+    }
+    else
+    {
+        if (count > 1)
+            children.reset (new Child [count - 1]);
+
+        for (int i = 0; i < index; ++i)
+            children[i] = std::move (mChildren[i]);
+
+        for (int i = index + 1; i < count; ++i)
+            children[i - 1] = std::move (mChildren[i]);
+
+        mIsBranch &= ~bit;
+    }
+
+    mChildren = std::move (children);
+}
+
+void SHAMapTreeNode::setChildHashes (uint256 const (&hashes)[16])
+{
+    assert (mIsBranch == 0);
+
+    int count = 0;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        if (hashes[i].isNonZero ())
+        {
+            mIsBranch |= (1 << i);
+            ++count;
+        }
+    }
+
+    if (count != 0)
+    {
+        mChildren.reset (new Child [count]);
+
+        for (int i = 0, j = 0; i < 16; ++i)
+            if (hashes[i].isNonZero ())
+                mChildren[j++].hash = hashes[i];
+    }
+}
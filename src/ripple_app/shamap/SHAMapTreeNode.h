@@ -50,6 +50,18 @@ public:
         tnACCOUNT_STATE     = 4
     };
 
+    /** A non-empty branch of an inner node.
+        The node pointer links directly to the child so that descending the
+        tree does not need a lookup by node ID. It is only set on nodes the
+        owning map has modified, otherwise it is null and the child must be
+        located by ID and hash.
+    */
+    struct Child
+    {
+        uint256 hash;
+        pointer node;
+    };
+
 public:
     SHAMapTreeNode (uint32 seq, const SHAMapNode & nodeID); // empty node
     SHAMapTreeNode (const SHAMapTreeNode & node, uint32 seq); // copy node from older tree
@@ -81,6 +93,7 @@ public:
     }
     uint256 const& getNodeHash () const
     {
+        assert (! mHashStale);
         return mHash;
     }
     TNType getType () const
@@ -121,6 +134,25 @@ public:
         return !mItem;
     }
     bool setChildHash (int m, uint256 const & hash);
+
+    /** Set a child hash without recomputing this node's hash.
+        The node is marked stale until SHAMap computes its hash.
+    */
+    void setChildHashDeferred (int m, uint256 const & hash);
+
+    /** Note that the child on branch m changed but its hash is not known yet.
+        SHAMap fills in the hash when it computes the deferred hashes.
+    */
+    void setChildStale (int m);
+
+    bool isHashStale () const
+    {
+        return mHashStale;
+    }
+    int getStaleBranches () const
+    {
+        return mStaleBranches;
+    }
     bool isEmptyBranch (int m) const
     {
         return (mIsBranch & (1 << m)) == 0;
@@ -131,9 +163,36 @@ public:
     uint256 const& getChildHash (int m) const
     {
         assert ((m >= 0) && (m < 16) && (mType == tnINNER));
-        return mHashes[m];
+
+        if (isEmptyBranch (m))
+            return smEmptyHash;
+
+        return mChildren[getChildIndex (m)].hash;
+    }
+
+    /** Return the linked child on branch m, or nullptr if it is not linked. */
+    SHAMapTreeNode* peekChild (int m) const
+    {
+        assert ((m >= 0) && (m < 16) && (mType == tnINNER));
+
+        if (isEmptyBranch (m))
+            return nullptr;
+
+        return mChildren[getChildIndex (m)].node.get ();
+    }
+    SHAMapTreeNode::pointer getChild (int m) const
+    {
+        assert ((m >= 0) && (m < 16) && (mType == tnINNER));
+
+        if (isEmptyBranch (m))
+            return SHAMapTreeNode::pointer ();
+
+        return mChildren[getChildIndex (m)].node;
     }
 
+    /** Link the child on branch m, which must not be empty. */
+    void setChild (int m, SHAMapTreeNode::ref child);
+
     // item node function
     bool hasItem () const
     {
@@ -174,14 +233,32 @@ private:
     // VFALCO TODO remove the use of friend
     friend class SHAMap;
 
+    static uint256 const smEmptyHash;
+
     uint256             mHash;
-    uint256             mHashes[16];
+    std::unique_ptr <Child []> mChildren; // one per bit in mIsBranch, in branch order
     SHAMapItem::pointer mItem;
     uint32              mSeq, mAccessSeq;
     TNType              mType;
     int                 mIsBranch;
+    int                 mStaleBranches; // children whose hash is not in mChildren yet
+    bool                mHashStale;     // mHash does not reflect mChildren
     bool                mFullBelow;
 
+    static int countBranches (int branches)
+    {
+        branches = branches - ((branches >> 1) & 0x5555);
+        branches = (branches & 0x3333) + ((branches >> 2) & 0x3333);
+        branches = (branches + (branches >> 4)) & 0x0F0F;
+        return (branches + (branches >> 8)) & 0x1F;
+    }
+    int getChildIndex (int m) const
+    {
+        return countBranches (mIsBranch & ((1 << m) - 1));
+    }
+    void setBranch (int m, bool present);
+    void setChildHashes (uint256 const (&hashes)[16]);
+
     bool updateHash ();
 };
 
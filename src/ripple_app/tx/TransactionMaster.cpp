@@ -17,9 +17,9 @@
 */
 //==============================================================================
 
-TransactionMaster::TransactionMaster ()
+TransactionMaster::TransactionMaster (insight::Collector::ptr const& collector)
     : mCache ("TransactionCache", 65536, 1800, get_seconds_clock (),
-        LogPartition::getJournal <TaggedCacheLog> ())
+        LogPartition::getJournal <TaggedCacheLog> (), collector)
 {
 }
 
@@ -107,6 +107,11 @@ bool TransactionMaster::canonicalize (Transaction::pointer* pTransaction)
     return false;
 }
 
+void TransactionMaster::setSweepInterval (std::chrono::seconds interval)
+{
+    mCache.setSweepInterval (interval);
+}
+
 void TransactionMaster::sweep (void)
 {
     mCache.sweep ();
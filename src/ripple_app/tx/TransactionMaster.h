@@ -25,7 +25,8 @@
 class TransactionMaster : LeakChecked <TransactionMaster>
 {
 public:
-    TransactionMaster ();
+    explicit TransactionMaster (insight::Collector::ptr const& collector =
+        insight::NullCollector::New ());
 
     Transaction::pointer            fetch (uint256 const& , bool checkDisk);
     SerializedTransaction::pointer  fetch (SHAMapItem::ref item, SHAMapTreeNode:: TNType type,
@@ -34,6 +35,7 @@ public:
     // return value: true = we had the transaction already
     bool inLedger (uint256 const& hash, uint32 ledger);
     bool canonicalize (Transaction::pointer* pTransaction);
+    void setSweepInterval (std::chrono::seconds interval);
     void sweep (void);
 
 private:
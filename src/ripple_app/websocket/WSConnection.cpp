@@ -103,12 +103,12 @@ void WSConnection::returnMessage (message_ptr ptr)
         m_receiveQueue.push_front(ptr);
 }
 
-Json::Value WSConnection::invokeCommand (Json::Value& jvRequest)
+std::string WSConnection::invokeCommand (Json::Value& jvRequest)
 {
     if (getConsumer().disconnect ())
     {
         disconnect ();
-        return rpcError (rpcSLOW_DOWN);
+        return Json::FastWriter ().write (rpcError (rpcSLOW_DOWN));
     }
 
     // Requests without "command" are invalid.
@@ -129,13 +129,15 @@ Json::Value WSConnection::invokeCommand (Json::Value& jvRequest)
 
         getConsumer().charge (Resource::feeInvalidRPC);
 
-        return jvResult;
+        return Json::FastWriter ().write (jvResult);
     }
 
     Resource::Charge loadType = Resource::feeReferenceRPC;
     RPCHandler  mRPCHandler (&this->m_netOPs, boost::dynamic_pointer_cast<InfoSub> (this->shared_from_this ()));
     Json::Value jvResult (Json::objectValue);
 
+    mRPCHandler.deferLargeResults ();
+
     Config::Role const role = m_isPublic
             ? Config::GUEST     // Don't check on the public interface.
             : getConfig ().getAdminRole (
@@ -180,5 +182,32 @@ Json::Value WSConnection::invokeCommand (Json::Value& jvRequest)
 
     jvResult["type"]        = "response";
 
-    return jvResult;
+    // The message can't be sent in pieces, but writing a full ledger
+    // into it directly saves building the ledger as a Json::Value.
+    std::string message;
+    Json::StreamWriter writer ([&message] (char const* data, std::size_t bytes)
+    {
+        message.append (data, bytes);
+    });
+
+    writer.startObject ();
+    Json::Value::Members const names (jvResult.getMemberNames ());
+    for (auto const& name : names)
+    {
+        if (name == "result")
+        {
+            writer.startObject (name);
+            writer.members (jvResult[name]);
+            mRPCHandler.writeDeferred (writer);
+            writer.end ();
+        }
+        else
+        {
+            writer.member (name, jvResult[name]);
+        }
+    }
+    writer.end ();
+    writer.flush ();
+
+    return message;
 }
@@ -51,7 +51,7 @@ public:
     void rcvMessage (message_ptr msg, bool& msgRejected, bool& runQueue);
     message_ptr getMessage ();
     void returnMessage (message_ptr ptr);
-    Json::Value invokeCommand (Json::Value& jvRequest);
+    std::string invokeCommand (Json::Value& jvRequest);
 
 protected:
     Resource::Manager& m_resourceManager;
@@ -132,12 +132,12 @@ public:
             m_serverHandler.send (ptr, jvObj, broadcast);
     }
 
-    void send (const Json::Value& jvObj, const std::string& sObj, bool broadcast)
+    void send (const Json::Value& jvObj, Message const& message, bool broadcast)
     {
         connection_ptr ptr = m_connection.lock ();
 
         if (ptr)
-            m_serverHandler.send (ptr, sObj, broadcast);
+            m_serverHandler.send (ptr, message, broadcast);
     }
 
     void disconnect ()
@@ -118,6 +118,11 @@ public:
         }
     }
 
+    static void ssendm (connection_ptr cpClient, InfoSub::Message const& message, bool broadcast)
+    {
+        ssendb (cpClient, *message, broadcast);
+    }
+
     void send (connection_ptr cpClient, message_ptr mpMessage)
     {
         cpClient->get_strand ().post (BIND_TYPE (
@@ -130,6 +135,14 @@ public:
                                           &WSServerHandler<endpoint_type>::ssendb, cpClient, strMessage, broadcast));
     }
 
+    // The message is shared with the other connections it is published to,
+    // only the pointer is copied into the handler.
+    void send (connection_ptr cpClient, InfoSub::Message const& message, bool broadcast)
+    {
+        cpClient->get_strand ().post (BIND_TYPE (
+                                          &WSServerHandler<endpoint_type>::ssendm, cpClient, message, broadcast));
+    }
+
     void send (connection_ptr cpClient, const Json::Value& jvObj, bool broadcast)
     {
         Json::FastWriter    jfwWriter;
@@ -358,6 +358,26 @@ void Config::load ()
 
             insightSettings = parseKeyValueSection (secConfig, SECTION_INSIGHT);
 
+            smtTmp = SectionEntries (secConfig, SECTION_JOB_PERCENTILES);
+
+            if (smtTmp)
+            {
+                JOB_PERCENTILES.clear ();
+
+                BOOST_FOREACH (std::string const& strPercentile, *smtTmp)
+                {
+                    // LexicalCast does not handle floating point
+                    char* end;
+                    double const percentile (std::strtod (strPercentile.c_str (), &end));
+
+                    if (end == strPercentile.c_str () || *end != 0 ||
+                        percentile < 0 || percentile > 100)
+                        throw std::runtime_error (boost::str (boost::format ("Invalid [" SECTION_JOB_PERCENTILES "] value: %s") % strPercentile));
+
+                    JOB_PERCENTILES.push_back (percentile);
+                }
+            }
+
             //---------------------------------------
             //
             // VFALCO BEGIN CLEAN
@@ -371,6 +391,9 @@ void Config::load ()
             importNodeDatabase = parseKeyValueSection (
                 secConfig, ConfigSection::importNodeDatabase ());
 
+            shardDatabase = parseKeyValueSection (
+                secConfig, ConfigSection::shardDatabase ());
+
             if (SectionSingleB (secConfig, SECTION_PEER_PORT, strTemp))
                 peerListeningPort = lexicalCastThrow <int> (strTemp);
 
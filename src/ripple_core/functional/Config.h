@@ -289,6 +289,11 @@ public:
     /** Parameters for the insight collection module */
     StringPairArray insightSettings;
 
+    /** Percentiles of job latency reported by the JobQueue.
+        Empty means use the JobQueue's defaults.
+    */
+    std::vector <double> JOB_PERCENTILES;
+
     /** Parameters for the main NodeStore database.
 
         This is 1 or more strings of the form <key>=<value>
@@ -321,6 +326,14 @@ public:
     bool doImport;
     StringPairArray importNodeDatabase;
 
+    /** Parameters for the store of ledger history split into shards.
+        If this is empty, there is no shard store.
+        The format is the same as that for @ref nodeDatabase
+
+        @see ShardStore
+    */
+    StringPairArray shardDatabase;
+
     //
     //
     //--------------------------------------------------------------------------
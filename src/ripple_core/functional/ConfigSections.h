@@ -31,6 +31,7 @@ struct ConfigSection
     static String nodeDatabase ()                 { return "node_db"; }
     static String tempNodeDatabase ()             { return "temp_db"; }
     static String importNodeDatabase ()           { return "import_db"; }
+    static String shardDatabase ()                { return "shard_db"; }
 };
 
 // VFALCO TODO Rename and replace these macros with variables.
@@ -51,6 +52,7 @@ struct ConfigSection
 #define SECTION_INSIGHT                 "insight"
 #define SECTION_IPS                     "ips"
 #define SECTION_IPS_FIXED               "ips_fixed"
+#define SECTION_JOB_PERCENTILES         "job_percentiles"
 #define SECTION_NETWORK_QUORUM          "network_quorum"
 #define SECTION_NODE_SEED               "node_seed"
 #define SECTION_NODE_SIZE               "node_size"
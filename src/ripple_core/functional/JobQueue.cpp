@@ -22,7 +22,13 @@
 #include "beast/beast/make_unique.h"
 #include "beast/beast/chrono/chrono_util.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <deque>
+#include <limits>
+#include <sstream>
+#include <thread>
 
 namespace ripple {
 
@@ -84,21 +90,80 @@ public:
                 m_execute.find (type)->second.notify (ms);
         }
 
+        /** Create a gauge for each percentile of each job type's latency.
+            This replaces any gauges created previously.
+        */
+        void make_percentile_gauges (std::vector <double> const& percentiles)
+        {
+            m_wait_percentiles.clear ();
+            m_run_percentiles.clear ();
+
+            for (auto const& entry : m_labels)
+            {
+                JobGauges& wait (m_wait_percentiles [entry.first]);
+                JobGauges& run (m_run_percentiles [entry.first]);
+
+                for (double const percentile : percentiles)
+                {
+                    std::string const name (percentileName (percentile, '_'));
+                    wait.push_back (m_collector->make_gauge (
+                        entry.second + "_q_" + name));
+                    run.push_back (m_collector->make_gauge (
+                        entry.second + "_" + name));
+                }
+            }
+        }
+
+        /** Update the percentile gauges for one job type. */
+        void on_collect (JobType type, std::vector <double> const& percentiles,
+            LatencyHistogram const& wait, LatencyHistogram const& run) const
+        {
+            auto const waitGauges (m_wait_percentiles.find (type));
+            auto const runGauges (m_run_percentiles.find (type));
+
+            if (waitGauges == m_wait_percentiles.end ())
+                return;
+
+            for (std::size_t i = 0; i < percentiles.size (); ++i)
+            {
+                waitGauges->second [i].set (wait.percentile (percentiles [i]));
+                runGauges->second [i].set (run.percentile (percentiles [i]));
+            }
+        }
+
     private:
         void add (JobType type, std::string const& label)
         {
+            m_labels.emplace (type, label);
             m_dequeue.emplace (type, m_collector->make_event (label + "_q"));
             m_execute.emplace (type, m_collector->make_event (label));
         }
 
         typedef std::unordered_map <JobType, insight::Event,
             std::hash <int>> JobEvents;
+        typedef std::vector <insight::Gauge> JobGauges;
+        typedef std::unordered_map <JobType, JobGauges,
+            std::hash <int>> JobPercentiles;
 
         insight::Collector::ptr m_collector;
+        std::unordered_map <JobType, std::string, std::hash <int>> m_labels;
         JobEvents m_dequeue;
         JobEvents m_execute;
+        JobPercentiles m_wait_percentiles;
+        JobPercentiles m_run_percentiles;
     };
 
+    // Returns a name for a percentile such as "p99.9", with the decimal
+    // point replaced by the given character.
+    static std::string percentileName (double percentile, char point)
+    {
+        std::ostringstream ss;
+        ss << "p" << percentile;
+        std::string name (ss.str ());
+        std::replace (name.begin (), name.end (), '.', point);
+        return name;
+    }
+
     //--------------------------------------------------------------------------
 
     struct Count
@@ -125,7 +190,8 @@ public:
         int deferred;    // Number of jobs we didn't signal due to limits
     };
 
-    typedef std::set <Job> JobSet;
+    // Waiting jobs of a single type, in the order they were added
+    typedef std::deque <Job> JobQueueType;
     typedef std::map <JobType, Count> MapType;
     typedef CriticalSection::ScopedLockType ScopedLock;
 
@@ -133,7 +199,15 @@ public:
     Stats m_stats;
     CriticalSection m_mutex;
     uint64 m_lastJob;
-    JobSet m_jobSet;
+
+    // One queue per job type. Since the type determines the priority,
+    // the next job to run is found by scanning the types from highest to
+    // lowest instead of searching a single ordered set of every job.
+    JobQueueType m_jobQueues [NUM_JOB_TYPES];
+
+    // Total number of jobs in m_jobQueues
+    int m_waitingCount;
+
     MapType m_jobCounts;
 
     // The number of jobs running through processTask()
@@ -141,6 +215,14 @@ public:
 
     Workers m_workers;
     LoadMonitor m_loads [NUM_JOB_TYPES];
+
+    // Time spent waiting in the queue and running, by job type.
+    // These are recorded without holding m_mutex.
+    LatencyHistogram m_waitLatency [NUM_JOB_TYPES];
+    LatencyHistogram m_runLatency [NUM_JOB_TYPES];
+
+    // The percentiles of latency to report
+    std::vector <double> m_percentiles;
     CancelCallback m_cancelCallback;
 
     //--------------------------------------------------------------------------
@@ -151,6 +233,7 @@ public:
         , m_journal (journal)
         , m_stats (collector)
         , m_lastJob (0)
+        , m_waitingCount (0)
         , m_processCount (0)
         , m_workers (*this, "JobQueue", 0)
         , m_cancelCallback (boost::bind (&Stoppable::isStopping, this))
@@ -162,6 +245,11 @@ public:
         {
             ScopedLock lock (m_mutex);
 
+            double const defaultPercentiles [] = { 50, 90, 99, 99.9 };
+            m_percentiles.assign (std::begin (defaultPercentiles),
+                std::end (defaultPercentiles));
+            m_stats.make_percentile_gauges (m_percentiles);
+
             // Initialize the job counts.
             // The 'limit' field in particular will be set based on the limit
             for (int i = 0; i < NUM_JOB_TYPES; ++i)
@@ -171,6 +259,13 @@ public:
             }
         }
 
+        // Report the latency of recent jobs rather than since startup
+        for (int i = 0; i < NUM_JOB_TYPES; ++i)
+        {
+            m_waitLatency [i].setWindow (std::chrono::minutes (1));
+            m_runLatency [i].setWindow (std::chrono::minutes (1));
+        }
+
         m_loads [ jtPUBOLDLEDGER  ].setTargetLatency (10000, 15000);
         m_loads [ jtVALIDATION_ut ].setTargetLatency (2000, 5000);
         m_loads [ jtPROOFWORK     ].setTargetLatency (2000, 5000);
@@ -200,7 +295,11 @@ public:
     void collect ()
     {
         ScopedLock lock (m_mutex);
-        m_stats.job_count = m_jobSet.size ();
+        m_stats.job_count = m_waitingCount;
+
+        for (int i = 0; i < NUM_JOB_TYPES; ++i)
+            m_stats.on_collect (static_cast <JobType> (i), m_percentiles,
+                m_waitLatency [i], m_runLatency [i]);
     }
 
     void addJob (JobType type, std::string const& name,
@@ -227,7 +326,7 @@ public:
             ScopedLock lock (m_mutex);
             bassert (! isStopped() && (
                 m_processCount>0 ||
-                ! m_jobSet.empty () ||
+                m_waitingCount > 0 ||
                 ! areChildrenStopped()));
         }
 
@@ -244,10 +343,11 @@ public:
         {
             ScopedLock lock (m_mutex);
 
-            std::pair <std::set <Job>::iterator, bool> result (
-                m_jobSet.insert (Job (type, name, ++m_lastJob,
-                    m_loads[type], jobFunc, m_cancelCallback)));
-            queueJob (*result.first, lock);
+            JobQueueType& queue (m_jobQueues [type]);
+            queue.push_back (Job (type, name, ++m_lastJob,
+                m_loads[type], jobFunc, m_cancelCallback));
+            ++m_waitingCount;
+            queueJob (queue.back (), lock);
         }
     }
 
@@ -344,6 +444,14 @@ public:
         m_workers.setNumberOfThreads (c);
     }
 
+    void setLatencyPercentiles (std::vector <double> const& percentiles)
+    {
+        ScopedLock lock (m_mutex);
+
+        m_percentiles = percentiles;
+        m_stats.make_percentile_gauges (m_percentiles);
+    }
+
 
     LoadEvent::pointer getLoadEvent (JobType t, const std::string& name)
     {
@@ -402,7 +510,8 @@ public:
             }
 
             if ((stats.count != 0) || (jobCount != 0) ||
-                (stats.latencyPeak != 0) || (threadCount != 0))
+                (stats.latencyPeak != 0) || (threadCount != 0) ||
+                (m_runLatency [i].count () != 0))
             {
                 Json::Value& pri = priorities.append (Json::objectValue);
 
@@ -425,6 +534,12 @@ public:
 
                 if (threadCount != 0)
                     pri["in_progress"] = threadCount;
+
+                if (m_runLatency [i].count () != 0)
+                {
+                    pri["wait_us"] = getLatencyJson (m_waitLatency [i]);
+                    pri["run_us"] = getLatencyJson (m_runLatency [i]);
+                }
             }
         }
 
@@ -450,7 +565,7 @@ private:
         if (isStopping() &&
             areChildrenStopped() &&
             (m_processCount == 0) &&
-            m_jobSet.empty())
+            (m_waitingCount == 0))
         {
             stopped();
         }
@@ -462,7 +577,7 @@ private:
     //
     // Pre-conditions:
     //  The JobType must be valid.
-    //  The Job must exist in mJobSet.
+    //  The Job must exist in the queue for its type.
     //  The Job must not have previously been queued.
     //
     // Post-conditions:
@@ -476,7 +591,7 @@ private:
     {
         JobType const type (job.getType ());
         assert (type != jtINVALID);
-        assert (m_jobSet.find (job) != m_jobSet.end ());
+        assert (! m_jobQueues [type].empty ());
 
         Count& count (m_jobCounts [type]);
 
@@ -498,15 +613,15 @@ private:
     // Returns the next Job we should run now.
     //
     // RunnableJob:
-    //  A Job in the JobSet whose slots count for its type is greater than zero.
+    //  A waiting Job whose slots count for its type is greater than zero.
     //
     // Pre-conditions:
-    //  mJobSet must not be empty.
-    //  mJobSet holds at least one RunnableJob
+    //  At least one Job is waiting.
+    //  At least one waiting Job is a RunnableJob.
     //
     // Post-conditions:
-    //  job is a valid Job object.
-    //  job is removed from mJobQueue.
+    //  job is the oldest Job of the highest priority runnable type.
+    //  job is removed from the queue for its type.
     //  Waiting job count of it's type is decremented
     //  Running job count of it's type is incremented
     //
@@ -515,12 +630,16 @@ private:
     //
     void getNextJob (Job& job, ScopedLock const& lock)
     {
-        bassert (! m_jobSet.empty ());
+        bassert (m_waitingCount > 0);
 
-        JobSet::const_iterator iter;
-        for (iter = m_jobSet.begin (); iter != m_jobSet.end (); ++iter)
+        // Higher job types have higher priority
+        int i;
+        for (i = NUM_JOB_TYPES - 1; i >= 0; --i)
         {
-            Count& count (m_jobCounts [iter->getType ()]);
+            if (m_jobQueues [i].empty ())
+                continue;
+
+            Count& count (m_jobCounts [static_cast <JobType> (i)]);
 
             bassert (count.running <= getJobLimit (count.type));
 
@@ -532,15 +651,17 @@ private:
             }
         }
 
-        bassert (iter != m_jobSet.end ());
+        bassert (i >= 0);
 
-        JobType const type = iter->getType ();
+        JobType const type = static_cast <JobType> (i);
         Count& count (m_jobCounts [type]);
+        JobQueueType& queue (m_jobQueues [i]);
 
         bassert (type != jtINVALID);
 
-        job = *iter;
-        m_jobSet.erase (iter);
+        job = std::move (queue.front ());
+        queue.pop_front ();
+        --m_waitingCount;
 
         --count.waiting;
         ++count.running;
@@ -551,7 +672,7 @@ private:
     // Indicates that a running Job has completed its task.
     //
     // Pre-conditions:
-    //  Job must not exist in mJobSet.
+    //  Job must not be waiting in a queue.
     //  The JobType must not be invalid.
     //
     // Post-conditions:
@@ -565,7 +686,6 @@ private:
     {
         JobType const type = job.getType ();
 
-        bassert (m_jobSet.find (job) == m_jobSet.end ());
         bassert (type != jtINVALID);
 
         Count& count (m_jobCounts [type]);
@@ -582,12 +702,30 @@ private:
         --count.running;
     }
 
+    // Returns the configured percentiles of a latency histogram
+    // Requirements:
+    //  Caller owns the job queue lock
+    Json::Value getLatencyJson (LatencyHistogram const& latency)
+    {
+        Json::Value ret (Json::objectValue);
+
+        for (double const percentile : m_percentiles)
+            ret [percentileName (percentile, '.')] = static_cast <Json::UInt> (
+                std::min <uint64> (latency.percentile (percentile),
+                    std::numeric_limits <Json::UInt>::max ()));
+
+        ret["max"] = static_cast <Json::UInt> (std::min <uint64> (
+            latency.max (), std::numeric_limits <Json::UInt>::max ()));
+
+        return ret;
+    }
+
     //------------------------------------------------------------------------------
     //
     // Runs the next appropriate waiting Job.
     //
     // Pre-conditions:
-    //  A RunnableJob must exist in the JobSet
+    //  A RunnableJob must be waiting
     //
     // Post-conditions:
     //  The chosen RunnableJob will have Job::doJob() called.
@@ -619,11 +757,17 @@ private:
             Job::clock_type::time_point const start_time (
                 Job::clock_type::now());
 
-            m_stats.on_dequeue (type, start_time - job.queue_time ());
+            Job::clock_type::duration const waited (
+                start_time - job.queue_time ());
+            m_waitLatency [type].record (waited);
+            m_stats.on_dequeue (type, waited);
 
             job.doJob ();
 
-            m_stats.on_execute (type, Job::clock_type::now() - start_time);
+            Job::clock_type::duration const ran (
+                Job::clock_type::now() - start_time);
+            m_runLatency [type].record (ran);
+            m_stats.on_execute (type, ran);
         }
         else
         {
@@ -830,4 +974,95 @@ std::unique_ptr <JobQueue> make_JobQueue (
     return std::make_unique <JobQueueImp> (collector, parent, journal);
 }
 
+//------------------------------------------------------------------------------
+
+/** Measures JobQueue enqueue/dequeue throughput and queue latency.
+
+    Each round uses the same number of producer threads as worker threads.
+    The producers add trivial jobs as fast as they can, and each job records
+    the time it spent waiting in the queue.
+*/
+class JobQueueTimingTests : public UnitTest
+{
+public:
+    enum
+    {
+        jobsPerProducer = 20000
+    };
+
+    typedef Job::clock_type clock_type;
+
+    void testThreads (int threads)
+    {
+        std::size_t const total (threads * jobsPerProducer);
+
+        std::vector <int64> latency (total);
+        std::atomic <std::size_t> completed (0);
+
+        RootStoppable root ("JobQueueTiming");
+        std::unique_ptr <JobQueue> jobQueue (make_JobQueue (
+            insight::NullCollector::New (), root, Journal ()));
+        jobQueue->setThreadCount (threads, false);
+        root.prepare ();
+        root.start ();
+
+        auto const job ([&] (Job& j)
+        {
+            std::size_t const n (completed++);
+            latency [n] = std::chrono::duration_cast <std::chrono::microseconds> (
+                clock_type::now () - j.queue_time ()).count ();
+        });
+
+        clock_type::time_point const start (clock_type::now ());
+
+        std::vector <std::thread> producers;
+        for (int i = 0; i < threads; ++i)
+        {
+            producers.emplace_back ([&]
+            {
+                for (int n = 0; n < jobsPerProducer; ++n)
+                    jobQueue->addJob (jtTRANSACTION, "timing", job);
+            });
+        }
+
+        for (auto& producer : producers)
+            producer.join ();
+
+        while (completed < total)
+            std::this_thread::yield ();
+
+        auto const elapsed (std::chrono::duration_cast <std::chrono::microseconds> (
+            clock_type::now () - start).count ());
+
+        root.stop ();
+
+        std::sort (latency.begin (), latency.end ());
+
+        String s;
+        s << String (threads) << " threads: " <<
+            String (int64 (total * 1000000.0 / elapsed)) << " jobs/s" <<
+            ", wait p50 " << String (latency [total / 2]) << "us" <<
+            ", p99 " << String (latency [total * 99 / 100]) << "us" <<
+            ", p999 " << String (latency [total * 999 / 1000]) << "us" <<
+            ", max " << String (latency.back ()) << "us";
+        logMessage (s);
+    }
+
+    void runTest ()
+    {
+        beginTestCase ("throughput");
+
+        for (int threads = 1; threads <= 64; threads *= 2)
+            testThreads (threads);
+
+        pass ();
+    }
+
+    JobQueueTimingTests () : UnitTest ("JobQueueTiming", "ripple", runManual)
+    {
+    }
+};
+
+static JobQueueTimingTests jobQueueTimingTests;
+
 }
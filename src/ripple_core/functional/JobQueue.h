@@ -54,6 +54,12 @@ public:
 
     virtual void setThreadCount (int c, bool const standaloneMode) = 0;
 
+    /** Set the latency percentiles reported for each job type.
+        These are used by getJson and the insight collector.
+        @param percentiles Values from 0 to 100 inclusive.
+    */
+    virtual void setLatencyPercentiles (std::vector <double> const& percentiles) = 0;
+
     // VFALCO TODO Rename these to newLoadEventMeasurement or something similar
     //             since they create the object.
     //
@@ -0,0 +1,303 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+LatencyHistogram::LatencyHistogram ()
+    : m_current (0)
+    , m_window (0)
+    , m_rotated (clock_type::now ().time_since_epoch ().count ())
+{
+    clear ();
+}
+
+void LatencyHistogram::setWindow (clock_type::duration window)
+{
+    m_window.store (window.count (), std::memory_order_relaxed);
+}
+
+void LatencyHistogram::rotate ()
+{
+    int const current (m_current.load (std::memory_order_relaxed));
+    clear (m_generations [1 - current]);
+    m_current.store (1 - current, std::memory_order_relaxed);
+    m_rotated.store (clock_type::now ().time_since_epoch ().count (),
+        std::memory_order_relaxed);
+}
+
+void LatencyHistogram::record (uint64 microseconds)
+{
+    if (m_window.load (std::memory_order_relaxed) != 0)
+        expire (clock_type::now ().time_since_epoch ().count ());
+
+    Generation& g (m_generations [m_current.load (std::memory_order_relaxed)]);
+
+    g.buckets [bucketIndex (microseconds)].fetch_add (
+        1, std::memory_order_relaxed);
+    g.count.fetch_add (1, std::memory_order_relaxed);
+
+    uint64 current (g.max.load (std::memory_order_relaxed));
+    while (microseconds > current && ! g.max.compare_exchange_weak (
+        current, microseconds, std::memory_order_relaxed))
+    {
+    }
+}
+
+uint64 LatencyHistogram::count () const
+{
+    Generation const* reported [2];
+    std::size_t const n (getReported (reported));
+
+    uint64 total (0);
+    for (std::size_t i = 0; i < n; ++i)
+        total += reported [i]->count.load (std::memory_order_relaxed);
+    return total;
+}
+
+uint64 LatencyHistogram::max () const
+{
+    Generation const* reported [2];
+    std::size_t const n (getReported (reported));
+
+    uint64 largest (0);
+    for (std::size_t i = 0; i < n; ++i)
+        largest = std::max (largest,
+            reported [i]->max.load (std::memory_order_relaxed));
+    return largest;
+}
+
+uint64 LatencyHistogram::percentile (double percentile) const
+{
+    Generation const* reported [2];
+    std::size_t const n (getReported (reported));
+
+    uint64 counts [bucketCount];
+    uint64 total (0);
+    uint64 largest (0);
+
+    for (std::size_t i = 0; i < bucketCount; ++i)
+        counts [i] = 0;
+
+    for (std::size_t j = 0; j < n; ++j)
+    {
+        for (std::size_t i = 0; i < bucketCount; ++i)
+        {
+            uint64 const count (reported [j]->buckets [i].load (
+                std::memory_order_relaxed));
+            counts [i] += count;
+            total += count;
+        }
+        largest = std::max (largest,
+            reported [j]->max.load (std::memory_order_relaxed));
+    }
+
+    if (total == 0)
+        return 0;
+
+    percentile = std::min (std::max (percentile, 0.0), 100.0);
+
+    uint64 const rank (std::max <uint64> (1, static_cast <uint64> (
+        std::ceil (percentile * total / 100))));
+
+    uint64 seen (0);
+    for (std::size_t i = 0; i < bucketCount; ++i)
+    {
+        seen += counts [i];
+        if (seen >= rank)
+            return std::min (bucketUpperBound (i), largest);
+    }
+
+    return largest;
+}
+
+void LatencyHistogram::clear ()
+{
+    clear (m_generations [0]);
+    clear (m_generations [1]);
+}
+
+void LatencyHistogram::clear (Generation& generation)
+{
+    for (std::size_t i = 0; i < bucketCount; ++i)
+        generation.buckets [i].store (0, std::memory_order_relaxed);
+    generation.count.store (0, std::memory_order_relaxed);
+    generation.max.store (0, std::memory_order_relaxed);
+}
+
+// Moves recording to the older generation once a window has passed
+void LatencyHistogram::expire (clock_type::rep now)
+{
+    clock_type::rep const window (m_window.load (std::memory_order_relaxed));
+    clock_type::rep rotated (m_rotated.load (std::memory_order_relaxed));
+
+    if (now - rotated < window)
+        return;
+
+    // Only one of the threads which see the window pass rotates
+    if (! m_rotated.compare_exchange_strong (rotated, now,
+            std::memory_order_relaxed))
+        return;
+
+    int const current (m_current.load (std::memory_order_relaxed));
+
+    // Nothing was recorded for a whole window, so both are too old
+    if (now - rotated >= 2 * window)
+        clear (m_generations [current]);
+
+    clear (m_generations [1 - current]);
+    m_current.store (1 - current, std::memory_order_relaxed);
+}
+
+// Returns the generations which hold recent enough samples
+std::size_t LatencyHistogram::getReported (
+    Generation const* (&reported) [2]) const
+{
+    int const current (m_current.load (std::memory_order_relaxed));
+    clock_type::rep const window (m_window.load (std::memory_order_relaxed));
+
+    if (window == 0)
+    {
+        reported [0] = &m_generations [current];
+        reported [1] = &m_generations [1 - current];
+        return 2;
+    }
+
+    clock_type::rep const age (clock_type::now ().time_since_epoch ().count () -
+        m_rotated.load (std::memory_order_relaxed));
+
+    if (age >= 2 * window)
+        return 0;
+
+    reported [0] = &m_generations [current];
+    if (age >= window)
+        return 1;
+
+    reported [1] = &m_generations [1 - current];
+    return 2;
+}
+
+std::size_t LatencyHistogram::bucketIndex (uint64 value)
+{
+    if (value < linearBuckets)
+        return static_cast <std::size_t> (value);
+
+    // Keep the leading bit and the next four bits of the value
+    std::size_t shift (1);
+    while ((value >> shift) >= 2 * subBuckets)
+        ++shift;
+
+    if (shift > maxShift)
+        return bucketCount - 1;
+
+    return linearBuckets + (shift - 1) * subBuckets +
+        static_cast <std::size_t> ((value >> shift) - subBuckets);
+}
+
+uint64 LatencyHistogram::bucketUpperBound (std::size_t index)
+{
+    if (index < linearBuckets)
+        return index;
+
+    std::size_t const shift ((index - linearBuckets) / subBuckets + 1);
+    uint64 const mantissa ((index - linearBuckets) % subBuckets + subBuckets);
+
+    return ((mantissa + 1) << shift) - 1;
+}
+
+//------------------------------------------------------------------------------
+
+class LatencyHistogramTests : public UnitTest
+{
+public:
+    LatencyHistogramTests () : UnitTest ("LatencyHistogram", "ripple")
+    {
+    }
+
+    void runTest ()
+    {
+        beginTestCase ("buckets");
+
+        {
+            LatencyHistogram h;
+            expect (h.count () == 0);
+            expect (h.percentile (99) == 0);
+
+            // Small values are exact
+            for (uint64 i = 1; i <= 20; ++i)
+                h.record (i);
+            expect (h.count () == 20);
+            expect (h.max () == 20);
+            expect (h.percentile (50) == 10);
+            expect (h.percentile (100) == 20);
+            expect (h.percentile (0) == 1);
+        }
+
+        beginTestCase ("relative error");
+
+        {
+            LatencyHistogram h;
+            Random r (42);
+            std::vector <uint64> values;
+            for (int i = 0; i < 10000; ++i)
+            {
+                uint64 const v (r.nextInt (1000000));
+                values.push_back (v);
+                h.record (v);
+            }
+            std::sort (values.begin (), values.end ());
+
+            double const percentiles [] = { 50, 90, 99, 99.9 };
+            for (double p : percentiles)
+            {
+                uint64 const exact (values [static_cast <std::size_t> (
+                    std::ceil (p * values.size () / 100)) - 1]);
+                uint64 const reported (h.percentile (p));
+                expect (reported >= exact);
+                expect (reported <= exact + exact / 16 + 1);
+            }
+        }
+
+        beginTestCase ("durations");
+
+        {
+            LatencyHistogram h;
+            h.record (std::chrono::milliseconds (5));
+            expect (h.max () == 5000);
+            h.clear ();
+            expect (h.count () == 0);
+            expect (h.max () == 0);
+        }
+
+        beginTestCase ("window");
+
+        {
+            LatencyHistogram h;
+            h.setWindow (std::chrono::hours (1));
+            h.record (100);
+            h.rotate ();
+            h.record (5);
+            expect (h.count () == 2, "Should report the older generation");
+            expect (h.max () == 100);
+            h.rotate ();
+            expect (h.count () == 1, "Should discard the oldest generation");
+            expect (h.max () == 5);
+            expect (h.percentile (100) == 5);
+        }
+    }
+};
+
+static LatencyHistogramTests latencyHistogramTests;
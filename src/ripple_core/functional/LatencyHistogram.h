@@ -0,0 +1,112 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_LATENCYHISTOGRAM_H_INCLUDED
+#define RIPPLE_LATENCYHISTOGRAM_H_INCLUDED
+
+/** A histogram of latencies with bounded relative error.
+
+    Values are recorded in microseconds. In the style of HdrHistogram,
+    values below 32 have a bucket each and every higher power of two is
+    split into 16 linear sub-buckets, so a reported percentile is never
+    more than 1/16th above the true value. Memory use is fixed.
+
+    Recording uses only relaxed atomic operations so that it is cheap
+    enough to leave on in production. Readers see a consistent enough
+    snapshot for reporting but not an atomic one.
+
+    Samples may be limited to a recent window. They are then recorded
+    into one of two generations, and once a window has passed the older
+    generation is discarded and recording moves to it. Reports cover
+    between one and two windows of the most recent samples.
+*/
+class LatencyHistogram
+{
+public:
+    typedef std::chrono::steady_clock clock_type;
+
+    LatencyHistogram ();
+
+    /** Set the length of a generation.
+        @param window The length, or zero to keep every sample.
+    */
+    void setWindow (clock_type::duration window);
+
+    /** Start a new generation now, discarding the older one. */
+    void rotate ();
+
+    /** Record one sample. */
+    template <class Rep, class Period>
+    void record (std::chrono::duration <Rep, Period> const& elapsed)
+    {
+        auto const us (std::chrono::duration_cast <
+            std::chrono::microseconds> (elapsed).count ());
+        record (static_cast <uint64> ((us > 0) ? us : 0));
+    }
+
+    /** Record one sample, in microseconds. */
+    void record (uint64 microseconds);
+
+    /** Returns the number of samples recorded. */
+    uint64 count () const;
+
+    /** Returns the largest sample recorded, in microseconds. */
+    uint64 max () const;
+
+    /** Returns the value at or below which the given percentage of
+        samples fall, in microseconds.
+        @param percentile A value from 0 to 100 inclusive.
+    */
+    uint64 percentile (double percentile) const;
+
+    /** Discard all samples. */
+    void clear ();
+
+private:
+    enum
+    {
+        linearBuckets = 32,
+        subBuckets = 16,
+        maxShift = 30,
+        bucketCount = linearBuckets + maxShift * subBuckets
+    };
+
+    struct Generation
+    {
+        std::atomic <uint64> buckets [bucketCount];
+        std::atomic <uint64> count;
+        std::atomic <uint64> max;
+    };
+
+    static std::size_t bucketIndex (uint64 value);
+    static uint64 bucketUpperBound (std::size_t index);
+    static void clear (Generation& generation);
+
+    void expire (clock_type::rep now);
+    std::size_t getReported (Generation const* (&reported) [2]) const;
+
+    Generation m_generations [2];
+    std::atomic <int> m_current;
+
+    // In ticks of clock_type
+    std::atomic <clock_type::rep> m_window;
+    std::atomic <clock_type::rep> m_rotated;
+};
+
+#endif
@@ -17,9 +17,24 @@
 */
 //==============================================================================
 
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
+#if BEAST_WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 // backend support
 #include "../ripple_hyperleveldb/ripple_hyperleveldb.h"
 #include "../ripple_leveldb/ripple_leveldb.h"
@@ -29,11 +44,18 @@
 
 #include "../../ripple/common/seconds_clock.h"
 #include "../../ripple/common/TaggedCache.h"
+#include "../../ripple/common/ShardedTaggedCache.h"
 
 #include "impl/Tuning.h"
+#include "impl/KeyOrder.h"
 #  include "impl/DecodedBlob.h"
 #  include "impl/EncodedBlob.h"
+#  include "impl/SlabAllocator.h"
+#  include "impl/LZ4.h"
+#  include "impl/CompressedCache.h"
 #  include "impl/BatchWriter.h"
+# include "backend/AppendFactory.h"
+#include "backend/AppendFactory.cpp"
 # include "backend/HyperDBFactory.h"
 #include "backend/HyperDBFactory.cpp"
 # include "backend/LevelDBFactory.h"
@@ -47,19 +69,27 @@
 
 #include "impl/Backend.cpp"
 #include "impl/BatchWriter.cpp"
+#include "impl/CompressedCache.cpp"
 # include "impl/DatabaseImp.h"
+# include "impl/ShardStoreImp.h"
 #include "impl/Database.cpp"
 #include "impl/DummyScheduler.cpp"
 #include "impl/DecodedBlob.cpp"
 #include "impl/EncodedBlob.cpp"
 #include "impl/Factory.cpp"
+#include "impl/LZ4.cpp"
 #include "impl/Manager.cpp"
 #include "impl/NodeObject.cpp"
 #include "impl/Scheduler.cpp"
+#include "impl/ShardStore.cpp"
+#include "impl/SlabAllocator.cpp"
 #include "impl/Task.cpp"
 
 # include "tests/TestBase.h"
 #include "tests/BackendTests.cpp"
 #include "tests/BasicTests.cpp"
+#include "tests/BenchmarkTests.cpp"
+#include "tests/CacheTests.cpp"
 #include "tests/DatabaseTests.cpp"
+#include "tests/ShardStoreTests.cpp"
 #include "tests/TimingTests.cpp"
@@ -29,6 +29,7 @@
 #include "api/DummyScheduler.h"
 #include "api/Factory.h"
 #include "api/Database.h"
+#include "api/ShardStore.h"
 #include "api/Manager.h"
 
 #endif
@@ -58,6 +58,18 @@ public:
     */
     virtual Status fetch (void const* key, NodeObject::Ptr* pObject) = 0;
 
+    /** Fetch a group of objects.
+        The objects are returned in the same order as the keys. An object
+        which is not found or can't be decoded is returned as `nullptr`.
+        The default implementation calls fetch for each key, backends
+        override it when they can order or share the work of the reads.
+        @note This will be called concurrently.
+        @param keys Pointers to the key data.
+        @param pObjects [out] The fetched objects, one per key.
+    */
+    virtual void fetchBatch (std::vector <void const*> const& keys,
+        Batch* pObjects);
+
     /** Store a single object.
         Depending on the implementation this may happen immediately
         or deferred using a scheduled task.
@@ -84,6 +96,18 @@ public:
 
     /** Estimate the number of write operations pending. */
     virtual int getWriteLoad () = 0;
+
+    /** Wait until everything passed to store has been written.
+        The default implementation returns at once, for backends which
+        write synchronously.
+    */
+    virtual void waitForWriting ();
+
+    /** Retrieve the counters which describe the writing done so far.
+        The default implementation returns all zeroes, for backends
+        which don't batch their writes.
+    */
+    virtual WriteStats getWriteStats ();
 };
 
 }
@@ -62,6 +62,46 @@ public:
     */
     virtual NodeObject::pointer fetch (uint256 const& hash) = 0;
 
+    /** Fetch an object without adding it to the caches.
+        This is for copying large amounts of cold data, which would
+        otherwise push the working set out of the caches. An object which
+        is already cached is still returned from there.
+
+        @note This can be called concurrently.
+        @param hash The key of the object to retrieve.
+        @return The object, or nullptr if it couldn't be retrieved.
+    */
+    virtual NodeObject::pointer fetchUncached (uint256 const& hash) = 0;
+
+    /** Fetch a group of objects.
+        This is equivalent to calling fetch for each hash, but objects
+        which are not in the cache are retrieved from the backend with a
+        single call, letting it order and overlap the reads.
+
+        @note This can be called concurrently.
+        @param hashes The keys of the objects to retrieve.
+        @return The objects in the same order as the hashes, with `nullptr`
+                for any that couldn't be retrieved.
+    */
+    virtual Batch fetchBatch (std::vector <uint256> const& hashes) = 0;
+
+    /** Retrieve the most recently used objects in the cache.
+        This is used to save the cache so that it can be warmed on restart.
+
+        @param limit The most objects to return.
+        @return The objects, roughly most recently used first.
+    */
+    virtual Batch getRecentObjects (std::size_t limit) = 0;
+
+    /** Place objects in the cache without storing them.
+        A later store of the same object is not passed to the backend,
+        so the objects must be ones which the backend already holds.
+
+        @note This can be called concurrently.
+        @param objects The objects to cache.
+    */
+    virtual void warm (Batch const& objects) = 0;
+
     /** Store the object.
 
         The caller's Blob parameter is overwritten.
@@ -91,18 +131,83 @@ public:
     /** Import objects from another database. */
     virtual void import (Database& sourceDatabase) = 0;
 
+    /** Start moving the database onto a new backend.
+        Until endRotation is called, new objects are written to the given
+        backend and fetches look in it first, then in the backend being
+        retired. Objects found only in the retiring backend are copied
+        forward as they are fetched.
+
+        @note This can be called concurrently with fetch and store, but
+              not while a rotation is already in progress.
+        @param backend The backend which replaces the current one.
+    */
+    virtual void beginRotation (std::unique_ptr <Backend> backend) = 0;
+
+    /** Copy objects to the new backend.
+        Objects the retiring backend doesn't hold are looked up through
+        the caches and the new backend, and written to the new backend
+        if found. Hashes found nowhere are ignored.
+
+        @note This can be called concurrently.
+        @param hashes The keys of the objects to keep.
+        @return The objects in the same order as the hashes, with
+                `nullptr` for any that weren't found.
+    */
+    virtual Batch copyForward (std::vector <uint256> const& hashes) = 0;
+
+    /** Finish a rotation and close the retiring backend.
+        When this returns nothing refers to the old backend, so its files
+        may be removed.
+    */
+    virtual void endRotation () = 0;
+
+    /** Counters which describe the progress of a rotation. */
+    struct RotationStats
+    {
+        // `true` between beginRotation and endRotation
+        bool rotating;
+
+        // Objects written forward by copyForward
+        std::size_t copied;
+
+        // Objects written forward because they were fetched
+        std::size_t carried;
+    };
+
+    /** Retrieve the rotation counters.
+        The counters are reset when a rotation begins.
+    */
+    virtual RotationStats getRotationStats () = 0;
+
     /** Retrieve the estimated number of pending write operations.
-        This is used for diagnostics.
+        This is used for diagnostics and to pace background work.
     */
     virtual int getWriteLoad () = 0;
 
+    /** Retrieve the counters which describe the backend's writing.
+        This is used for diagnostics.
+    */
+    virtual WriteStats getWriteStats () = 0;
+
     // VFALCO TODO Document this.
     virtual float getCacheHitRate () = 0;
 
+    /** Retrieve the hit rate of the compressed cache.
+        Only fetches which miss the cache returned by getCacheHitRate reach
+        the compressed cache, so this is the percentage of those misses
+        which were found without going to the backend.
+    */
+    virtual float getCompressedCacheHitRate () = 0;
+
     // VFALCO TODO Document this.
     //        TODO Document the parameter meanings.
     virtual void tune (int size, int age) = 0;
 
+    /** Spread sweeps of the cache over an interval.
+        @see TaggedCache::setSweepInterval
+    */
+    virtual void setSweepInterval (std::chrono::seconds interval) = 0;
+
     // VFALCO TODO Document this.
     virtual void sweep () = 0;
 };
@@ -41,6 +41,9 @@ public:
     */
     virtual Factory* find (std::string const& name) const = 0;
 
+    /** Return the names of all the factories, in the order they were added. */
+    virtual std::vector <String> getFactoryNames () const = 0;
+
     /** Create a backend. */
     virtual std::unique_ptr <Backend> make_Backend (Parameters const& parameters,
         Scheduler& scheduler, Journal journal) = 0;
@@ -52,7 +55,7 @@ public:
         backends also require a 'path' field.
         
         Some choices for 'type' are:
-            HyperLevelDB, LevelDBFactory, SQLite, MDB
+            Append, HyperLevelDB, LevelDBFactory, SQLite, MDB
 
         If the fastBackendParameter is omitted or empty, no ephemeral database
         is used. If the scheduler parameter is omited or unspecified, a
@@ -65,13 +68,36 @@ public:
         @param scheduler The scheduler to use for performing asynchronous tasks.
         @param backendParameters The parameter string for the persistent backend.
         @param fastBackendParameters [optional] The parameter string for the ephemeral backend.
+        @param collector [optional] Where the cache reports its metrics.
 
         @return The opened database.
     */
     virtual std::unique_ptr <Database> make_Database (std::string const& name,
         Scheduler& scheduler, Journal journal,
             Parameters const& backendParameters,
-                Parameters fastBackendParameters = Parameters ()) = 0;
+                Parameters fastBackendParameters = Parameters (),
+                    insight::Collector::ptr const& collector =
+                        insight::NullCollector::New ()) = 0;
+
+    /** Construct a store for ledger history split into shards.
+
+        The parameters are key value pairs. The 'type' key chooses the
+        backend used for each shard and 'path' is the directory holding
+        the shards. These are optional:
+
+            ledgers_per_shard   The number of ledgers in each shard.
+            final_path          The directory finalized shards are moved to.
+
+        @note If a directory cannot be created, an exception is thrown.
+
+        @param name A diagnostic label for the store.
+        @param scheduler The scheduler to use for performing asynchronous tasks.
+        @param parameters The parameter string for the shard store.
+
+        @return The opened store.
+    */
+    virtual std::unique_ptr <ShardStore> make_ShardStore (std::string const& name,
+        Scheduler& scheduler, Journal journal, Parameters const& parameters) = 0;
 };
 
 //------------------------------------------------------------------------------
@@ -24,6 +24,10 @@
 
 namespace ripple {
 
+namespace NodeStore {
+struct EncodedBlob;
+}
+
 /** The types of node objects. */
 enum NodeObjectType
 {
@@ -42,8 +46,12 @@ enum NodeObjectType
     - The ledger index in which it appears
     - The SHA 256 hash
 
+    The object and its data are a single block from the node object
+    allocator, with the data stored in its database format so it can be
+    written without copying.
+
     @note No checking is performed to make sure the hash matches the data.
-    @see SHAMap
+    @see SHAMap, EncodedBlob
 */
 class NodeObject : public CountedObject <NodeObject>
 {
@@ -76,33 +84,29 @@ public:
     typedef boost::shared_ptr <NodeObject> pointer;
     typedef pointer const& ref;
 
-private:
-    // This hack is used to make the constructor effectively private
-    // except for when we use it in the call to make_shared.
-    // There's no portable way to make make_shared<> a friend work.
-    struct PrivateAccess { };
-public:
-    // This constructor is private, use createObject instead.
-    NodeObject (NodeObjectType type,
-                LedgerIndex ledgerIndex,
-                Blob& data,
-                uint256 const& hash,
-                PrivateAccess);
-
     /** Create an object from fields.
 
-        The caller's variable is modified during this call. The
-        underlying storage for the Blob is taken over by the NodeObject.
-
         @param type The type of object.
         @param ledgerIndex The ledger in which this object appears.
-        @param data A buffer containing the payload. The caller's variable
-                    is overwritten.
+        @param data A buffer containing the payload, which is copied.
         @param hash The 256-bit hash of the payload data.
     */
     static Ptr createObject (NodeObjectType type,
                              LedgerIndex ledgerIndex,
-                             Blob& data,
+                             Blob const& data,
+                             uint256 const& hash);
+
+    /** Create an object from fields.
+
+        This is used to decode objects straight from a backend's buffer.
+
+        @param data The payload, which is copied.
+        @param bytes The size of the payload.
+    */
+    static Ptr createObject (NodeObjectType type,
+                             LedgerIndex ledgerIndex,
+                             void const* data,
+                             std::size_t bytes,
                              uint256 const& hash);
 
     /** Retrieve the type of this object.
@@ -120,7 +124,11 @@ public:
 
     /** Retrieve the binary data.
     */
-    Blob const& getData () const;
+    unsigned char const* getData () const;
+
+    /** Retrieve the size of the binary data.
+    */
+    std::size_t getSize () const;
 
     /** See if this object has the same data as another object.
     */
@@ -142,10 +150,21 @@ public:
     };
 
 private:
-    NodeObjectType mType;
+    friend struct NodeStore::EncodedBlob;
+
+    struct Deleter;
+
+    NodeObject (std::size_t bytes, uint256 const& hash);
+
+    // The size of the block holding an object with this much data
+    static std::size_t getBlockBytes (std::size_t bytes);
+
+    // The object in its database format follows the members
+    unsigned char* getEncoded () const;
+
+    // The type and ledger index are kept in the database format header
     uint256 mHash;
-    LedgerIndex mLedgerIndex;
-    Blob mData;
+    uint32 mDataBytes;
 };
 
 }
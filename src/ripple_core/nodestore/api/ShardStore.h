@@ -0,0 +1,108 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_SHARDSTORE_H_INCLUDED
+#define RIPPLE_NODESTORE_SHARDSTORE_H_INCLUDED
+
+namespace ripple {
+namespace NodeStore {
+
+/** Persistency for ledger history, split into shards by ledger sequence.
+
+    Each shard covers a fixed range of ledger sequence numbers and holds
+    every object reachable from those ledgers in a backend of its own.
+    Objects which ledgers in other shards also use are stored again, so
+    each shard is self-contained and can be backed up, repaired or moved
+    on its own.
+
+    Shard N holds ledgers N * L + 1 through (N + 1) * L, where L is the
+    number of ledgers per shard. Once all of them are stored the shard is
+    finalized: it is closed, moved to the directory for finalized shards
+    if one is configured, and never written again.
+
+    @see Database
+*/
+class ShardStore
+{
+public:
+    /** Destroy the shard store.
+        Pending writes are flushed and files closed before this returns.
+    */
+    virtual ~ShardStore () = 0;
+
+    /** Retrieve the name associated with this store.
+        This is used for diagnostics.
+    */
+    virtual String getName () const = 0;
+
+    /** Return the number of ledgers in each shard. */
+    virtual uint32 getLedgersPerShard () const = 0;
+
+    /** Return the index of the shard which holds a ledger. */
+    virtual uint32 getShardIndex (uint32 ledgerSeq) const = 0;
+
+    /** Fetch an object from the shard which holds a ledger.
+
+        @note This can be called concurrently.
+        @param hash The key of the object to retrieve.
+        @param ledgerSeq The sequence of a ledger the object belongs to.
+        @return The object, or nullptr if the shard doesn't have it.
+    */
+    virtual NodeObject::pointer fetch (uint256 const& hash,
+        uint32 ledgerSeq) = 0;
+
+    /** Store an object in the shard which holds a ledger.
+        Objects for finalized shards are ignored.
+
+        @note This can be called concurrently.
+        @param object The object to store.
+        @param ledgerSeq The sequence of a ledger the object belongs to.
+    */
+    virtual void store (NodeObject::ref object, uint32 ledgerSeq) = 0;
+
+    /** Record that a ledger and everything reachable from it is stored.
+        This waits for the shard's pending writes. When it completes the
+        shard's range of ledgers, the shard is finalized.
+    */
+    virtual void setStored (uint32 ledgerSeq) = 0;
+
+    /** Returns `true` if a ledger and everything reachable from it is stored. */
+    virtual bool hasLedger (uint32 ledgerSeq) = 0;
+
+    /** Return the largest sequence below the given one which isn't stored.
+        @return The sequence, or RangeSet::absent if there is none.
+    */
+    virtual uint32 prevMissing (uint32 ledgerSeq) = 0;
+
+    /** Return the stored ledgers, in the form "1-16384,20000-32768". */
+    virtual std::string getCompleteLedgers () = 0;
+
+    /** Return the indexes of the finalized shards, in ascending order. */
+    virtual std::vector <uint32> getFinalShards () = 0;
+
+    /** Retrieve the estimated number of pending write operations.
+        This is used for diagnostics and to pace background work.
+    */
+    virtual int getWriteLoad () = 0;
+};
+
+}
+}
+
+#endif
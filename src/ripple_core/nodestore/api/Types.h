@@ -45,6 +45,38 @@ enum Status
 /** A batch of NodeObjects to write at once. */
 typedef std::vector <NodeObject::Ptr> Batch;
 
+/** Counters which describe the writing done by a backend. */
+struct WriteStats
+{
+    WriteStats ()
+        : batches (0)
+        , objects (0)
+        , stalls (0)
+        , lastMicroseconds (0)
+        , totalMicroseconds (0)
+        , maxMicroseconds (0)
+    {
+    }
+
+    // Batches written
+    std::size_t batches;
+
+    // Objects written
+    std::size_t objects;
+
+    // Stores which had to wait because too many objects were pending
+    std::size_t stalls;
+
+    // Time taken to write the most recent batch
+    uint64 lastMicroseconds;
+
+    // Time taken to write all of the batches
+    uint64 totalMicroseconds;
+
+    // Time taken to write the slowest batch
+    uint64 maxMicroseconds;
+};
+
 /** A list of key/value parameter pairs passed to the backend. */
 // VFALCO TODO Use std::string, pair, vector
 typedef StringPairArray Parameters;
@@ -0,0 +1,947 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+namespace ripple {
+namespace NodeStore {
+
+/*  Storage for the append-only backend.
+
+    The store owns a directory containing numbered segment files and a single
+    index file. All integers are stored little endian.
+
+    Segment file "segment.NNNNNN", numbered from 1
+
+        0...7       "RPLSEGMT"
+        8...11      uint32      Format version
+        12...15     uint32      Key size in bytes
+        16...end    Records, back to back
+
+    Record
+
+        0...3       uint32      Size of the value in bytes, never zero
+        4...        key         The key of the object
+        ...         value       The EncodedBlob of the object
+
+    Index file "index"
+
+        0...7       "RPLINDEX"
+        8...11      uint32      Format version
+        12...15     uint32      Key size in bytes
+        16...19     uint32      1 if the index was closed cleanly
+        20...23     uint32      Unused
+        24...31     uint64      Number of buckets, a power of two
+        32...39     uint64      Number of entries
+        40...43     uint32      Number of segments
+        44...63                 Unused
+        64...end    Buckets
+
+    Bucket
+
+        0...7       uint64      The first eight bytes of the key
+        8...15      uint64      Segment number << 40 | record offset,
+                                or zero if the bucket is empty
+
+    Keys are hashes of their objects, so their leading bytes are already
+    uniformly distributed and are used directly to choose the bucket.
+    Collisions are resolved with linear probing and the table is doubled
+    when it becomes half full. Keeping the leading key bytes in the bucket
+    lets the table be resized without touching the segments, and rejects
+    nearly every probe that is not a match.
+
+    The index can always be recreated from the segments. It is marked dirty
+    while the store is open and rebuilt by scanning the segments if it was
+    not closed cleanly. Records are written a batch at a time: first their
+    keys and values, then their sizes, so that a record whose size is zero
+    reads as the end of the segment.
+
+    Writes to the mapped files reach the disk whenever the system chooses,
+    which survives the process crashing but not the system. With the sync
+    option each batch's contents are flushed before its sizes are written,
+    and the sizes before the batch is indexed, so that after a power loss
+    the segments end at the last complete batch. Without it a power loss
+    can leave a record whose size was saved but whose contents were not.
+*/
+class AppendStore : public Uncopyable
+{
+public:
+    enum
+    {
+        currentVersion = 1,
+
+        segmentHeaderBytes = 16,
+        indexHeaderBytes = 64,
+        bucketBytes = 16,
+        recordHeaderBytes = 4,
+
+        offsetBits = 40,
+
+        minimumBuckets = 65536
+    };
+
+    /** A key and value to append. */
+    struct Record
+    {
+        void const* key;
+        void const* value;
+        int valueBytes;
+    };
+
+    AppendStore (File const& path, size_t keyBytes, int64 segmentBytes,
+        bool sync, Journal journal)
+        : m_journal (journal)
+        , m_path (path)
+        , m_keyBytes (keyBytes)
+        , m_segmentBytes (segmentBytes)
+        , m_sync (sync)
+        , m_buckets (0)
+        , m_count (0)
+    {
+        if (m_keyBytes < 8)
+            Throw (std::runtime_error ("AppendFactory keys are too short"));
+
+        Result const result (m_path.createDirectory ());
+        if (result.failed ())
+            Throw (std::runtime_error (std::string (
+                "Unable to create AppendFactory directory: ") +
+                    result.getErrorMessage ().toStdString ()));
+
+        bool const clean (openIndex ());
+
+        if (! clean)
+        {
+            if (segmentFile (1).existsAsFile () && m_journal.warning)
+                m_journal.warning << "Rebuilding index in " <<
+                    m_path.getFullPathName ();
+
+            m_index.reset ();
+            m_buckets = minimumBuckets;
+            m_count = 0;
+            m_index = createIndex (indexFile (), m_buckets);
+        }
+
+        for (uint32 n = 1; segmentFile (n).existsAsFile (); ++n)
+            openSegment (n, clean);
+
+        if (clean && m_segments.size () != get32 (indexData () + 40))
+            Throw (std::runtime_error (
+                "AppendFactory index does not match the segments"));
+
+        if (m_segments.empty ())
+            createSegment ();
+        else
+            reserveSegment (*m_segments.back ());
+
+        writeIndexHeader (false);
+    }
+
+    ~AppendStore ()
+    {
+        // Give back the unused space reserved at the end of each segment
+        for (auto& segment : m_segments)
+        {
+            segment->map.reset ();
+            setFileSize (segment->file, segment->tail);
+        }
+
+        writeIndexHeader (true);
+    }
+
+    /** Locate the value stored for a key.
+        The returned pointer refers to the mapped segment and remains valid
+        for the lifetime of the store.
+        @return `true` if the key was found.
+    */
+    bool fetch (void const* key, void const** value, int* valueBytes)
+    {
+        std::lock_guard <std::mutex> lock (m_mutex);
+
+        uint8 const* const record (findRecord (key));
+
+        if (record == nullptr)
+            return false;
+
+        *value = record + recordHeaderBytes + m_keyBytes;
+        *valueBytes = get32 (record);
+        return true;
+    }
+
+    /** Locate the values stored for a group of keys.
+        Each result holds the value and its size, or `nullptr` if the key
+        was not found.
+        @see fetch
+    */
+    void fetchBatch (std::vector <void const*> const& keys,
+        std::vector <std::pair <void const*, int>>* values)
+    {
+        values->assign (keys.size (), std::make_pair (nullptr, 0));
+
+        std::lock_guard <std::mutex> lock (m_mutex);
+
+        for (std::size_t i = 0; i < keys.size (); ++i)
+        {
+            uint8 const* const record (findRecord (keys [i]));
+
+            if (record != nullptr)
+                (*values) [i] = std::make_pair (
+                    record + recordHeaderBytes + m_keyBytes, get32 (record));
+        }
+    }
+
+    /** Append values whose keys are not already present.
+        The values are visible to fetch once this returns.
+        @note This can be called concurrently. Batches are written one
+              at a time. Fetches wait while records are copied and
+              indexed, but not while they are flushed or the index grows.
+    */
+    void insert (std::vector <Record> const& records)
+    {
+        std::lock_guard <std::mutex> writeLock (m_writeMutex);
+
+        // Where each new record went, and the keys already placed
+        std::vector <Placed> placed;
+        std::unordered_multimap <uint64, std::size_t> pending;
+        placed.reserve (records.size ());
+
+        {
+            std::lock_guard <std::mutex> lock (m_mutex);
+
+            for (auto const& record : records)
+            {
+                int64 const recordBytes (
+                    recordHeaderBytes + m_keyBytes + record.valueBytes);
+
+                if (record.valueBytes <= 0 ||
+                        segmentHeaderBytes + recordBytes > m_segmentBytes)
+                    Throw (std::runtime_error (
+                        "AppendFactory record size is invalid"));
+
+                if (findRecord (record.key) != nullptr ||
+                        isPending (pending, placed, record.key))
+                    continue;
+
+                Segment* segment (m_segments.back ().get ());
+
+                if (segment->tail + recordBytes > segment->map->getSize ())
+                    segment = &createSegment ();
+
+                // The size stays zero until the contents are written
+                uint8* const data (segment->data () + segment->tail);
+                memcpy (data + recordHeaderBytes, record.key, m_keyBytes);
+                memcpy (data + recordHeaderBytes + m_keyBytes,
+                    record.value, record.valueBytes);
+
+                Placed const p = { segment, uint32 (m_segments.size ()),
+                    segment->tail, record.valueBytes };
+                pending.insert (std::make_pair (get64 (record.key),
+                    placed.size ()));
+                placed.push_back (p);
+
+                segment->tail += recordBytes;
+            }
+        }
+
+        if (placed.empty ())
+            return;
+
+        // Nothing refers to the new records yet, so fetches can go on
+        // while they are made durable.
+        flush (placed);
+
+        for (auto const& p : placed)
+            put32 (p.segment->data () + p.offset, p.valueBytes);
+
+        flush (placed);
+
+        reserveBuckets (m_count + placed.size ());
+
+        {
+            std::lock_guard <std::mutex> lock (m_mutex);
+
+            for (auto const& p : placed)
+                insertBucket (p.segment->data () + p.offset + recordHeaderBytes,
+                    p.number, p.offset);
+        }
+    }
+
+    /** Call a function for each record, in the order they were appended.
+        The function is called with the key, value, and value size.
+        @note This must not be called concurrently with insert.
+    */
+    template <class Function>
+    void visit (Function f)
+    {
+        for (auto const& segment : m_segments)
+        {
+            advise (*segment->map, true);
+
+            uint8 const* const data (segment->data ());
+
+            for (int64 offset (segmentHeaderBytes); offset < segment->tail;)
+            {
+                uint8 const* const record (data + offset);
+                int const valueBytes (get32 (record));
+
+                f (record + recordHeaderBytes,
+                    record + recordHeaderBytes + m_keyBytes, valueBytes);
+
+                offset += recordHeaderBytes + m_keyBytes + valueBytes;
+            }
+
+            advise (*segment->map, false);
+        }
+    }
+
+private:
+    struct Segment
+    {
+        File file;
+        std::unique_ptr <MemoryMappedFile> map;
+
+        // Offset one past the last record
+        int64 tail;
+
+        uint8* data () const
+        {
+            return static_cast <uint8*> (map->getData ());
+        }
+    };
+
+    // A record written by the batch being inserted
+    struct Placed
+    {
+        Segment* segment;
+        uint32 number;
+        int64 offset;
+        int valueBytes;
+    };
+
+    static uint32 get32 (void const* p)
+    {
+        uint32 v;
+        memcpy (&v, p, sizeof (v));
+        return ByteOrder::swapIfBigEndian (v);
+    }
+
+    static uint64 get64 (void const* p)
+    {
+        uint64 v;
+        memcpy (&v, p, sizeof (v));
+        return ByteOrder::swapIfBigEndian (v);
+    }
+
+    static void put32 (void* p, uint32 v)
+    {
+        v = ByteOrder::swapIfBigEndian (v);
+        memcpy (p, &v, sizeof (v));
+    }
+
+    static void put64 (void* p, uint64 v)
+    {
+        v = ByteOrder::swapIfBigEndian (v);
+        memcpy (p, &v, sizeof (v));
+    }
+
+    // Grow or shrink a file. Growing leaves a sparse, zero filled tail.
+    static void setFileSize (File const& file, int64 bytes)
+    {
+        FileOutputStream out (file);
+
+        bool ok (! out.failedToOpen ());
+
+        if (ok && file.getSize () < bytes)
+        {
+            ok = out.setPosition (bytes - 1) && out.writeByte (0);
+            out.flush ();
+        }
+        else if (ok)
+        {
+            ok = out.setPosition (bytes) && out.truncate ().wasOk ();
+        }
+
+        if (! ok || out.getStatus ().failed ())
+            Throw (std::runtime_error (std::string (
+                "Unable to resize ") + file.getFullPathName ().toStdString ()));
+    }
+
+    // MemoryMappedFile asks for sequential read-ahead, which wastes most of
+    // each disk read when fetching by key. Random access is the default
+    // and sequential is requested only while visiting.
+    static void advise (MemoryMappedFile& map, bool sequential)
+    {
+    #if ! BEAST_WIN32
+        madvise (map.getData (), map.getSize (),
+            sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+    #endif
+    }
+
+    // Write the records of a batch in each segment they went to to disk
+    void flush (std::vector <Placed> const& placed) const
+    {
+        if (! m_sync)
+            return;
+
+        for (std::size_t i = 0; i < placed.size ();)
+        {
+            Segment const& segment (*placed [i].segment);
+            int64 const begin (placed [i].offset);
+
+            while (i < placed.size () && placed [i].segment == &segment)
+                ++i;
+
+            Placed const& last (placed [i - 1]);
+            syncFile (*segment.map, begin, last.offset +
+                recordHeaderBytes + m_keyBytes + last.valueBytes);
+        }
+    }
+
+    static void syncFile (MemoryMappedFile& map, int64 begin, int64 end)
+    {
+    #if ! BEAST_WIN32
+        static int64 const pageBytes (sysconf (_SC_PAGESIZE));
+        int64 const start (begin - begin % pageBytes);
+
+        if (msync (static_cast <uint8*> (map.getData ()) + start,
+                end - start, MS_SYNC) != 0)
+            Throw (std::runtime_error ("Unable to sync AppendFactory segment"));
+    #endif
+    }
+
+    bool isPending (std::unordered_multimap <uint64, std::size_t> const& pending,
+        std::vector <Placed> const& placed, void const* key) const
+    {
+        auto const range (pending.equal_range (get64 (key)));
+
+        for (auto it (range.first); it != range.second; ++it)
+        {
+            Placed const& p (placed [it->second]);
+
+            if (memcmp (p.segment->data () + p.offset + recordHeaderBytes,
+                    key, m_keyBytes) == 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    static std::unique_ptr <MemoryMappedFile> mapFile (File const& file)
+    {
+        std::unique_ptr <MemoryMappedFile> map (std::make_unique <
+            MemoryMappedFile> (file, MemoryMappedFile::readWrite));
+
+        if (map->getData () == nullptr)
+            Throw (std::runtime_error (std::string (
+                "Unable to map ") + file.getFullPathName ().toStdString ()));
+
+        advise (*map, false);
+        return map;
+    }
+
+    File indexFile () const
+    {
+        return m_path.getChildFile ("index");
+    }
+
+    File segmentFile (uint32 n) const
+    {
+        return m_path.getChildFile ("segment." + String (n).paddedLeft ('0', 6));
+    }
+
+    uint8* indexData () const
+    {
+        return static_cast <uint8*> (m_index->getData ());
+    }
+
+    //--------------------------------------------------------------------------
+
+    // Returns true if a cleanly closed index was opened
+    bool openIndex ()
+    {
+        File const file (indexFile ());
+
+        if (file.getSize () < indexHeaderBytes)
+            return false;
+
+        m_index = mapFile (file);
+
+        uint8 const* const header (indexData ());
+
+        if (memcmp (header, "RPLINDEX", 8) != 0 ||
+            get32 (header + 8) != currentVersion ||
+            get32 (header + 12) != m_keyBytes ||
+            get32 (header + 16) != 1)
+            return false;
+
+        m_buckets = get64 (header + 24);
+        m_count = get64 (header + 32);
+
+        return m_index->getSize () == indexHeaderBytes + m_buckets * bucketBytes;
+    }
+
+    std::unique_ptr <MemoryMappedFile> createIndex (File const& file,
+        uint64 buckets) const
+    {
+        file.deleteFile ();
+        setFileSize (file, indexHeaderBytes + buckets * bucketBytes);
+
+        std::unique_ptr <MemoryMappedFile> map (mapFile (file));
+
+        uint8* const header (static_cast <uint8*> (map->getData ()));
+        memcpy (header, "RPLINDEX", 8);
+        put32 (header + 8, currentVersion);
+        put32 (header + 12, m_keyBytes);
+        put64 (header + 24, buckets);
+
+        return map;
+    }
+
+    void writeIndexHeader (bool clean)
+    {
+        uint8* const header (indexData ());
+        put64 (header + 24, m_buckets);
+        put64 (header + 32, m_count);
+        put32 (header + 40, m_segments.size ());
+        put32 (header + 16, clean ? 1 : 0);
+    }
+
+    uint8 const* findRecord (void const* key) const
+    {
+        uint64 const prefix (get64 (key));
+        uint64 const mask (m_buckets - 1);
+        uint8 const* const buckets (indexData () + indexHeaderBytes);
+
+        for (uint64 i (prefix & mask);; i = (i + 1) & mask)
+        {
+            uint8 const* const bucket (buckets + i * bucketBytes);
+            uint64 const location (get64 (bucket + 8));
+
+            if (location == 0)
+                return nullptr;
+
+            if (get64 (bucket) == prefix)
+            {
+                Segment const& segment (*m_segments [(location >> offsetBits) - 1]);
+                uint8 const* const record (segment.data () +
+                    (location & ((uint64 (1) << offsetBits) - 1)));
+
+                if (memcmp (record + recordHeaderBytes, key, m_keyBytes) == 0)
+                    return record;
+            }
+        }
+    }
+
+    static void placeBucket (uint8* buckets, uint64 mask,
+        uint64 prefix, uint64 location)
+    {
+        for (uint64 i (prefix & mask);; i = (i + 1) & mask)
+        {
+            uint8* const bucket (buckets + i * bucketBytes);
+
+            if (get64 (bucket + 8) == 0)
+            {
+                put64 (bucket, prefix);
+                put64 (bucket + 8, location);
+                return;
+            }
+        }
+    }
+
+    // Requires room for the entry, see reserveBuckets
+    void insertBucket (void const* key, uint64 segment, uint64 offset)
+    {
+        placeBucket (indexData () + indexHeaderBytes, m_buckets - 1,
+            get64 (key), (segment << offsetBits) | offset);
+
+        ++m_count;
+    }
+
+    // Double the index until it can hold a number of entries while staying
+    // at most half full. The entries are copied to the new table while
+    // fetches go on using the old one, which is safe because only the
+    // caller changes the index. Fetches wait only for the swap.
+    void reserveBuckets (uint64 count)
+    {
+        uint64 buckets (m_buckets);
+
+        while (count * 2 > buckets)
+            buckets *= 2;
+
+        if (buckets == m_buckets)
+            return;
+
+        File const file (m_path.getChildFile ("index.new"));
+        std::unique_ptr <MemoryMappedFile> index (createIndex (file, buckets));
+
+        uint8 const* const from (indexData () + indexHeaderBytes);
+        uint8* const to (static_cast <uint8*> (index->getData ()) + indexHeaderBytes);
+
+        for (uint64 i = 0; i < m_buckets; ++i)
+        {
+            uint8 const* const bucket (from + i * bucketBytes);
+            uint64 const location (get64 (bucket + 8));
+
+            if (location != 0)
+                placeBucket (to, buckets - 1, get64 (bucket), location);
+        }
+
+        {
+            // The new mapping stays valid when the file is renamed
+            std::lock_guard <std::mutex> lock (m_mutex);
+            m_index.swap (index);
+            m_buckets = buckets;
+            writeIndexHeader (false);
+        }
+
+        if (! file.moveFileTo (indexFile ()))
+            Throw (std::runtime_error ("Unable to replace AppendFactory index"));
+    }
+
+    //--------------------------------------------------------------------------
+
+    Segment& createSegment ()
+    {
+        uint32 const n (m_segments.size () + 1);
+
+        if (n >= (uint32 (1) << (64 - offsetBits)))
+            Throw (std::runtime_error ("AppendFactory has too many segments"));
+
+        std::unique_ptr <Segment> segment (std::make_unique <Segment> ());
+        segment->file = segmentFile (n);
+        segment->file.deleteFile ();
+        setFileSize (segment->file, m_segmentBytes);
+        segment->map = mapFile (segment->file);
+        segment->tail = segmentHeaderBytes;
+
+        uint8* const header (segment->data ());
+        memcpy (header, "RPLSEGMT", 8);
+        put32 (header + 8, currentVersion);
+        put32 (header + 12, m_keyBytes);
+
+        m_segments.push_back (std::move (segment));
+        return *m_segments.back ();
+    }
+
+    void openSegment (uint32 n, bool clean)
+    {
+        std::unique_ptr <Segment> segment (std::make_unique <Segment> ());
+        segment->file = segmentFile (n);
+        segment->map = mapFile (segment->file);
+
+        int64 const size (segment->map->getSize ());
+        uint8 const* const data (segment->data ());
+
+        if (size < segmentHeaderBytes ||
+            memcmp (data, "RPLSEGMT", 8) != 0 ||
+            get32 (data + 8) != currentVersion ||
+            get32 (data + 12) != m_keyBytes)
+            Throw (std::runtime_error (std::string ("Bad AppendFactory segment ") +
+                segment->file.getFullPathName ().toStdString ()));
+
+        m_segments.push_back (std::move (segment));
+        Segment& s (*m_segments.back ());
+
+        if (clean)
+        {
+            s.tail = size;
+            return;
+        }
+
+        // Recover the records and rebuild their index entries
+        int64 offset (segmentHeaderBytes);
+
+        while (offset + recordHeaderBytes + int64 (m_keyBytes) <= size)
+        {
+            uint8 const* const record (data + offset);
+            int64 const valueBytes (get32 (record));
+            int64 const next (offset + recordHeaderBytes + m_keyBytes + valueBytes);
+
+            if (valueBytes == 0 || next > size)
+                break;
+
+            void const* const key (record + recordHeaderBytes);
+
+            if (findRecord (key) == nullptr)
+            {
+                reserveBuckets (m_count + 1);
+                insertBucket (key, n, offset);
+            }
+
+            offset = next;
+        }
+
+        s.tail = offset;
+    }
+
+    // Make room to append to a segment which was opened at its used size
+    void reserveSegment (Segment& segment)
+    {
+        if (segment.map->getSize () >= m_segmentBytes)
+            return;
+
+        segment.map.reset ();
+        setFileSize (segment.file, m_segmentBytes);
+        segment.map = mapFile (segment.file);
+    }
+
+private:
+    Journal m_journal;
+    File const m_path;
+    size_t const m_keyBytes;
+    int64 const m_segmentBytes;
+    bool const m_sync;
+
+    // Held while a batch is inserted
+    std::mutex m_writeMutex;
+
+    // Held while the index or list of segments is used or changed
+    std::mutex m_mutex;
+    std::vector <std::unique_ptr <Segment>> m_segments;
+    std::unique_ptr <MemoryMappedFile> m_index;
+    uint64 m_buckets;
+    uint64 m_count;
+};
+
+//------------------------------------------------------------------------------
+
+class AppendBackend
+    : public Backend
+    , public BatchWriter::Callback
+    , public LeakChecked <AppendBackend>
+{
+public:
+    enum
+    {
+        defaultSegmentMegabytes = 1024
+    };
+
+    Journal m_journal;
+    size_t const m_keyBytes;
+    Scheduler& m_scheduler;
+    std::string m_name;
+    AppendStore m_store;
+
+    // Declared last so pending writes are flushed before the store closes
+    BatchWriter m_batch;
+
+    AppendBackend (size_t keyBytes, Parameters const& keyValues,
+        Scheduler& scheduler, Journal journal)
+        : m_journal (journal)
+        , m_keyBytes (keyBytes)
+        , m_scheduler (scheduler)
+        , m_name (keyValues ["path"].toStdString ())
+        , m_store (getPath (m_name), keyBytes, getSegmentBytes (keyValues),
+            getSync (keyValues), journal)
+        , m_batch (*this, scheduler, keyValues)
+    {
+    }
+
+    static File getPath (std::string const& name)
+    {
+        if (name.empty ())
+            Throw (std::runtime_error ("Missing path in AppendFactory backend"));
+
+        return File::getCurrentWorkingDirectory ().getChildFile (name);
+    }
+
+    static int64 getSegmentBytes (Parameters const& keyValues)
+    {
+        int64 megabytes (defaultSegmentMegabytes);
+
+        if (! keyValues ["segment_mb"].isEmpty ())
+            megabytes = keyValues ["segment_mb"].getLargeIntValue ();
+
+        if (megabytes < 1)
+            Throw (std::runtime_error ("Bad segment_mb in AppendFactory backend"));
+
+        return megabytes * 1024 * 1024;
+    }
+
+    static bool getSync (Parameters const& keyValues)
+    {
+        String const sync (keyValues ["sync"]);
+
+        if (sync.isEmpty () || sync.equalsIgnoreCase ("batch"))
+            return true;
+
+        if (sync.equalsIgnoreCase ("none"))
+            return false;
+
+        Throw (std::runtime_error ("Bad sync in AppendFactory backend"));
+        return false;
+    }
+
+    std::string getName ()
+    {
+        return m_name;
+    }
+
+    //--------------------------------------------------------------------------
+
+    Status fetch (void const* key, NodeObject::Ptr* pObject)
+    {
+        pObject->reset ();
+
+        void const* value;
+        int valueBytes;
+
+        if (! m_store.fetch (key, &value, &valueBytes))
+            return notFound;
+
+        // Decode directly from the mapped segment
+        DecodedBlob decoded (key, value, valueBytes);
+
+        if (! decoded.wasOk ())
+            return dataCorrupt;
+
+        *pObject = decoded.createObject ();
+        return ok;
+    }
+
+    void fetchBatch (std::vector <void const*> const& keys, Batch* pObjects)
+    {
+        pObjects->assign (keys.size (), NodeObject::Ptr ());
+
+        std::vector <std::pair <void const*, int>> values;
+        m_store.fetchBatch (keys, &values);
+
+        // Decode in file order so the pages are read in sequence
+        std::vector <std::size_t> order;
+        order.reserve (keys.size ());
+        for (std::size_t i = 0; i < values.size (); ++i)
+            if (values [i].first != nullptr)
+                order.push_back (i);
+
+        std::sort (order.begin (), order.end (),
+            [&values] (std::size_t lhs, std::size_t rhs)
+            {
+                return std::less <void const*> () (
+                    values [lhs].first, values [rhs].first);
+            });
+
+        for (std::size_t const i : order)
+        {
+            DecodedBlob decoded (keys [i], values [i].first, values [i].second);
+
+            if (decoded.wasOk ())
+            {
+                (*pObjects) [i] = decoded.createObject ();
+            }
+            else
+            {
+                WriteLog (lsFATAL, NodeObject) << "Corrupt NodeObject #" <<
+                    uint256::fromVoid (keys [i]);
+            }
+        }
+    }
+
+    void store (NodeObject::ref object)
+    {
+        m_batch.store (object);
+    }
+
+    void storeBatch (Batch const& batch)
+    {
+        // The encoded data lives in the objects, which the batch holds
+        EncodedBlob encoded;
+        std::vector <AppendStore::Record> records;
+        records.reserve (batch.size ());
+
+        BOOST_FOREACH (NodeObject::ref object, batch)
+        {
+            encoded.prepare (object);
+
+            AppendStore::Record const record = { encoded.getKey (),
+                encoded.getData (), int (encoded.getSize ()) };
+            records.push_back (record);
+        }
+
+        m_store.insert (records);
+    }
+
+    void visitAll (VisitCallback& callback)
+    {
+        m_store.visit ([&](void const* key, void const* value, int valueBytes)
+        {
+            DecodedBlob decoded (key, value, valueBytes);
+
+            if (decoded.wasOk ())
+            {
+                NodeObject::Ptr object (decoded.createObject ());
+
+                callback.visitObject (object);
+            }
+            else
+            {
+                WriteLog (lsFATAL, NodeObject) << "Corrupt NodeObject #" << uint256::fromVoid (key);
+            }
+        });
+    }
+
+    int getWriteLoad ()
+    {
+        return m_batch.getWriteLoad ();
+    }
+
+    WriteStats getWriteStats ()
+    {
+        return m_batch.getWriteStats ();
+    }
+
+    void waitForWriting ()
+    {
+        m_batch.waitForWriting ();
+    }
+
+    //--------------------------------------------------------------------------
+
+    void writeBatch (Batch const& batch)
+    {
+        storeBatch (batch);
+    }
+};
+
+//------------------------------------------------------------------------------
+
+class AppendFactory : public Factory
+{
+public:
+    String getName () const
+    {
+        return "Append";
+    }
+
+    std::unique_ptr <Backend> createInstance (
+        size_t keyBytes,
+        Parameters const& keyValues,
+        Scheduler& scheduler,
+        Journal journal)
+    {
+        return std::make_unique <AppendBackend> (
+            keyBytes, keyValues, scheduler, journal);
+    }
+};
+
+//------------------------------------------------------------------------------
+
+std::unique_ptr <Factory> make_AppendFactory ()
+{
+    return std::make_unique <AppendFactory> ();
+}
+
+}
+}
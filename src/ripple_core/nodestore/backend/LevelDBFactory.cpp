@@ -39,7 +39,7 @@ public:
         : m_journal (journal)
         , m_keyBytes (keyBytes)
         , m_scheduler (scheduler)
-        , m_batch (*this, scheduler)
+        , m_batch (*this, scheduler, keyValues)
         , m_name (keyValues ["path"].toStdString ())
     {
         if (m_name.empty())
@@ -133,6 +133,37 @@ public:
         return status;
     }
 
+    void fetchBatch (std::vector <void const*> const& keys, Batch* pObjects)
+    {
+        pObjects->assign (keys.size (), NodeObject::Ptr ());
+
+        // Looking the keys up in order keeps the reads which land in
+        // the same table, and often the same block, together.
+        leveldb::ReadOptions const options;
+        std::string string;
+
+        for (std::size_t const i : sortedKeyOrder (keys, m_keyBytes))
+        {
+            leveldb::Slice const slice (
+                static_cast <char const*> (keys [i]), m_keyBytes);
+
+            if (! m_db->Get (options, slice, &string).ok ())
+                continue;
+
+            DecodedBlob decoded (keys [i], string.data (), string.size ());
+
+            if (decoded.wasOk ())
+            {
+                (*pObjects) [i] = decoded.createObject ();
+            }
+            else
+            {
+                WriteLog (lsFATAL, NodeObject) << "Corrupt NodeObject #" <<
+                    uint256::fromVoid (keys [i]);
+            }
+        }
+    }
+
     void store (NodeObject::ref object)
     {
         m_batch.store (object);
@@ -200,6 +231,16 @@ public:
         return m_batch.getWriteLoad ();
     }
 
+    WriteStats getWriteStats ()
+    {
+        return m_batch.getWriteStats ();
+    }
+
+    void waitForWriting ()
+    {
+        m_batch.waitForWriting ();
+    }
+
     //--------------------------------------------------------------------------
 
     void writeBatch (Batch const& batch)
@@ -87,7 +87,7 @@ public:
         : m_journal (journal)
         , m_keyBytes (keyBytes)
         , m_scheduler (scheduler)
-        , m_batch (*this, scheduler)
+        , m_batch (*this, scheduler, keyValues)
         , m_name (keyValues ["path"].toStdString ())
     {
         if (m_name.empty())
@@ -202,6 +202,42 @@ public:
         return status;
     }
 
+    void fetchBatch (std::vector <void const*> const& keys, Batch* pObjects)
+    {
+        pObjects->assign (keys.size (), NodeObject::Ptr ());
+
+        rocksdb::ReadOptions const options;
+        std::vector <rocksdb::Slice> slices;
+        slices.reserve (keys.size ());
+
+        BOOST_FOREACH (void const* key, keys)
+            slices.push_back (rocksdb::Slice (
+                static_cast <char const*> (key), m_keyBytes));
+
+        // One version of the database serves the whole group
+        std::vector <std::string> values;
+        std::vector <rocksdb::Status> const statuses (
+            m_db->MultiGet (options, slices, &values));
+
+        for (std::size_t i = 0; i < keys.size (); ++i)
+        {
+            if (! statuses [i].ok ())
+                continue;
+
+            DecodedBlob decoded (keys [i], values [i].data (), values [i].size ());
+
+            if (decoded.wasOk ())
+            {
+                (*pObjects) [i] = decoded.createObject ();
+            }
+            else
+            {
+                WriteLog (lsFATAL, NodeObject) << "Corrupt NodeObject #" <<
+                    uint256::fromVoid (keys [i]);
+            }
+        }
+    }
+
     void store (NodeObject::ref object)
     {
         m_batch.store (object);
@@ -269,6 +305,16 @@ public:
         return m_batch.getWriteLoad ();
     }
 
+    WriteStats getWriteStats ()
+    {
+        return m_batch.getWriteStats ();
+    }
+
+    void waitForWriting ()
+    {
+        m_batch.waitForWriting ();
+    }
+
     //--------------------------------------------------------------------------
 
     void writeBatch (Batch const& batch)
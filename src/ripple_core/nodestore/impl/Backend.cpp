@@ -24,5 +24,29 @@ Backend::~Backend ()
 {
 }
 
+WriteStats Backend::getWriteStats ()
+{
+    return WriteStats ();
+}
+
+void Backend::waitForWriting ()
+{
+}
+
+void Backend::fetchBatch (std::vector <void const*> const& keys,
+    Batch* pObjects)
+{
+    pObjects->assign (keys.size (), NodeObject::Ptr ());
+
+    for (std::size_t i = 0; i < keys.size (); ++i)
+    {
+        if (fetch (keys [i], &(*pObjects) [i]) == dataCorrupt)
+        {
+            WriteLog (lsFATAL, NodeObject) << "Corrupt NodeObject #" <<
+                uint256::fromVoid (keys [i]);
+        }
+    }
+}
+
 }
 }
@@ -20,13 +20,20 @@
 namespace ripple {
 namespace NodeStore {
 
-BatchWriter::BatchWriter (Callback& callback, Scheduler& scheduler)
+BatchWriter::BatchWriter (Callback& callback, Scheduler& scheduler,
+    Parameters const& keyValues)
     : m_callback (callback)
     , m_scheduler (scheduler)
+    , m_batchSize (std::max (std::size_t (1), getParameter (
+        keyValues, "batch_size", batchWriteSizeDefault)))
+    , m_latency (std::chrono::milliseconds (getParameter (
+        keyValues, "batch_latency_ms", batchWriteLatencyDefault)))
+    , m_queueLimit (std::max (m_batchSize, getParameter (
+        keyValues, "write_queue_limit", writeQueueLimitDefault)))
     , mWriteLoad (0)
     , mWritePending (false)
+    , mWriting (false)
 {
-    mWriteSet.reserve (batchWritePreallocationSize);
 }
 
 BatchWriter::~BatchWriter ()
@@ -34,9 +41,39 @@ BatchWriter::~BatchWriter ()
     waitForWriting ();
 }
 
+std::size_t BatchWriter::getParameter (Parameters const& keyValues,
+    String const& key, int defaultValue)
+{
+    String const value (keyValues [key]);
+
+    if (value.isEmpty ())
+        return defaultValue;
+
+    return std::max (0, value.getIntValue ());
+}
+
 void BatchWriter::store (NodeObject::ref object)
 {
-    LockType::scoped_lock sl (mWriteMutex);
+    ScopedLockType lock (mWriteMutex);
+
+    if (mWriteSet.size () >= m_queueLimit)
+    {
+        ++mStats.stalls;
+
+        do
+        {
+            // The scheduled task might be waiting for a thread which is
+            // blocked here like us, so write rather than wait for it.
+            if (! mWriting)
+                writeOne (lock);
+            else
+                mWriteCondition.wait (lock);
+        }
+        while (mWriteSet.size () >= m_queueLimit);
+    }
+
+    if (mWriteSet.empty ())
+        mWriteSetTime = clock_type::now ();
 
     mWriteSet.push_back (object);
 
@@ -44,15 +81,30 @@ void BatchWriter::store (NodeObject::ref object)
     {
         mWritePending = true;
 
+        // A synchronous scheduler runs the task right here
+        lock.unlock ();
+
         m_scheduler.scheduleTask (*this);
     }
+    else if (mWriteSet.size () == m_batchSize)
+    {
+        // Wake a writer waiting to fill out the batch
+        mWriteCondition.notify_all ();
+    }
 }
 
 int BatchWriter::getWriteLoad ()
 {
-    LockType::scoped_lock sl (mWriteMutex);
+    ScopedLockType lock (mWriteMutex);
+
+    return mWriteLoad + static_cast <int> (mWriteSet.size ());
+}
+
+WriteStats BatchWriter::getWriteStats ()
+{
+    ScopedLockType lock (mWriteMutex);
 
-    return std::max (mWriteLoad, static_cast<int> (mWriteSet.size ()));
+    return mStats;
 }
 
 void BatchWriter::performScheduledTask ()
@@ -62,40 +114,85 @@ void BatchWriter::performScheduledTask ()
 
 void BatchWriter::writeBatch ()
 {
+    ScopedLockType lock (mWriteMutex);
+
     for (;;)
     {
-        std::vector< boost::shared_ptr<NodeObject> > set;
+        // A stalled store may be writing in our place
+        while (mWriting)
+            mWriteCondition.wait (lock);
 
-        set.reserve (batchWritePreallocationSize);
+        if (mWriteSet.empty ())
+            break;
 
+        if (mWriteSet.size () < m_batchSize &&
+            m_latency > clock_type::duration::zero ())
         {
-            LockType::scoped_lock sl (mWriteMutex);
-
-            mWriteSet.swap (set);
-            assert (mWriteSet.empty ());
-            mWriteLoad = set.size ();
+            // Give the batch until the latency target to fill up
+            clock_type::time_point const deadline (mWriteSetTime + m_latency);
 
-            if (set.empty ())
+            while (mWriteSet.size () < m_batchSize && ! mWriting &&
+                mWriteCondition.wait_until (lock, deadline) != std::cv_status::timeout)
             {
-                mWritePending = false;
-                mWriteCondition.notify_all ();
-
-                // VFALCO NOTE Fix this function to not return from the middle
-                return;
             }
 
+            if (mWriting || mWriteSet.empty ())
+                continue;
         }
 
-        m_callback.writeBatch (set);
+        writeOne (lock);
     }
+
+    mWritePending = false;
+    mWriteCondition.notify_all ();
+}
+
+void BatchWriter::writeOne (ScopedLockType& lock)
+{
+    std::size_t const count (std::min (mWriteSet.size (), m_batchSize));
+
+    Batch set (mWriteSet.begin (), mWriteSet.begin () + count);
+    mWriteSet.erase (mWriteSet.begin (), mWriteSet.begin () + count);
+
+    // Anything left over is a backlog, it shouldn't wait again
+    if (! mWriteSet.empty ())
+        mWriteSetTime = clock_type::now () - m_latency;
+
+    mWriting = true;
+    mWriteLoad = count;
+
+    lock.unlock ();
+
+    clock_type::time_point const start (clock_type::now ());
+
+    m_callback.writeBatch (set);
+
+    uint64 const elapsed (std::chrono::duration_cast <std::chrono::microseconds> (
+        clock_type::now () - start).count ());
+
+    // Release the objects before taking the lock again
+    set.clear ();
+
+    lock.lock ();
+
+    mWriting = false;
+    mWriteLoad = 0;
+
+    ++mStats.batches;
+    mStats.objects += count;
+    mStats.lastMicroseconds = elapsed;
+    mStats.totalMicroseconds += elapsed;
+    mStats.maxMicroseconds = std::max (mStats.maxMicroseconds, elapsed);
+
+    mWriteCondition.notify_all ();
 }
 
 void BatchWriter::waitForWriting ()
 {
-    LockType::scoped_lock sl (mWriteMutex);
+    ScopedLockType lock (mWriteMutex);
 
     while (mWritePending)
-        mWriteCondition.wait (sl);
+        mWriteCondition.wait (lock);
 }
 
 }
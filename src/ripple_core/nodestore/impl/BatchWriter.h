@@ -29,6 +29,12 @@ namespace NodeStore {
     class it not required. A backend can implement its own write batching,
     or skip write batching if doing so yields a performance benefit.
 
+    Objects stored while a batch is being written are committed together
+    in the next one, up to a limit on the batch size. If a latency target
+    is set, a partial batch waits up to that long for more objects before
+    it is written. Once too many objects are pending, store blocks until
+    the writer catches up, so a backlog can't grow without bound.
+
     @see Scheduler
 */
 // VFALCO NOTE I'm not entirely happy having placed this here,
@@ -44,8 +50,16 @@ public:
         virtual void writeBatch (Batch const& batch) = 0;
     };
 
-    /** Create a batch writer. */
-    BatchWriter (Callback& callback, Scheduler& scheduler);
+    /** Create a batch writer.
+
+        These keys are used from the backend parameters:
+
+            batch_size          The most objects written in one batch.
+            batch_latency_ms    How long a partial batch waits for more.
+            write_queue_limit   The pending objects at which store blocks.
+    */
+    BatchWriter (Callback& callback, Scheduler& scheduler,
+        Parameters const& keyValues = Parameters ());
 
     /** Destroy a batch writer.
 
@@ -56,29 +70,47 @@ public:
     /** Store the object.
 
         This will add to the batch and initiate a scheduled task to
-        write the batch out.
+        write the batch out. If the limit on pending objects is reached,
+        this waits for room, or writes a batch itself if nothing else is.
     */
     void store (NodeObject::Ptr const& object);
 
     /** Get an estimate of the amount of writing I/O pending. */
     int getWriteLoad ();
 
+    /** Get the counters which describe the writing done so far. */
+    WriteStats getWriteStats ();
+
+    /** Wait until everything stored so far has been written. */
+    void waitForWriting ();
+
 private:
+    typedef std::mutex LockType;
+    typedef std::condition_variable CondvarType;
+    typedef std::unique_lock <LockType> ScopedLockType;
+    typedef std::chrono::steady_clock clock_type;
+
+    static std::size_t getParameter (Parameters const& keyValues,
+        String const& key, int defaultValue);
+
     void performScheduledTask ();
     void writeBatch ();
-    void waitForWriting ();
+    void writeOne (ScopedLockType& lock);
 
 private:
-    typedef boost::recursive_mutex LockType;
-    typedef boost::condition_variable_any CondvarType;
-
     Callback& m_callback;
     Scheduler& m_scheduler;
+    std::size_t const m_batchSize;
+    clock_type::duration const m_latency;
+    std::size_t const m_queueLimit;
     LockType mWriteMutex;
     CondvarType mWriteCondition;
     int mWriteLoad;
     bool mWritePending;
-    Batch mWriteSet;
+    bool mWriting;
+    std::deque <NodeObject::Ptr> mWriteSet;
+    clock_type::time_point mWriteSetTime;
+    WriteStats mStats;
 };
 
 }
@@ -0,0 +1,390 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+namespace ripple {
+namespace NodeStore {
+
+/*  Each entry in the arena is laid out as
+
+        key             32 bytes
+        size             4 bytes, of the object's data
+        stored           4 bytes, of the data which follows
+        ledger index     4 bytes
+        type             1 byte
+        data        stored bytes
+
+    Data which doesn't shrink is stored as is, with stored equal to size.
+    Entries are contiguous and never split across the end of the arena;
+    when one doesn't fit, the head starts over at the beginning and `wrap`
+    marks where the entries before it end.
+
+    The index is a table of buckets using linear probing. Each bucket holds
+    four bytes of the key, and the offset of the entry plus one, or zero if
+    the bucket is empty. Keys are hashes, so their bytes are already random:
+    the first byte picks the partition and the key bytes in the bucket pick
+    where probing starts. The table is never resized, instead the number of
+    entries is limited to half the buckets.
+*/
+struct CompressedCache::Partition
+{
+    enum
+    {
+        headerBytes = 45,
+
+        // One bucket for every this many bytes of arena
+        bytesPerBucket = 64
+    };
+
+    struct Bucket
+    {
+        uint32 tag;
+        uint32 location;
+    };
+
+    explicit Partition (std::size_t bytes)
+        : m_arena (new uint8 [bytes])
+        , m_capacity (bytes)
+        , m_head (0)
+        , m_tail (0)
+        , m_wrap (bytes)
+        , m_count (0)
+    {
+        std::size_t buckets (16);
+        while (buckets * bytesPerBucket < bytes)
+            buckets *= 2;
+
+        m_buckets.resize (buckets);
+        m_mask = buckets - 1;
+    }
+
+    bool contains (uint256 const& hash) const
+    {
+        return find (hash) != nullptr;
+    }
+
+    // Returns the object, or nullptr if it is missing or damaged
+    NodeObject::Ptr read (uint256 const& hash)
+    {
+        uint8 const* const entry (find (hash));
+        if (entry == nullptr)
+            return nullptr;
+
+        uint32 size;
+        uint32 stored;
+        LedgerIndex ledgerIndex;
+        memcpy (&size, entry + 32, 4);
+        memcpy (&stored, entry + 36, 4);
+        memcpy (&ledgerIndex, entry + 40, 4);
+        NodeObjectType const type (static_cast <NodeObjectType> (entry [44]));
+
+        Blob data (size);
+
+        if (stored == size)
+        {
+            memcpy (data.data (), entry + headerBytes, size);
+        }
+        else if (LZ4::decompress (entry + headerBytes, stored,
+            data.data (), size) != size)
+        {
+            return nullptr;
+        }
+
+        return NodeObject::createObject (type, ledgerIndex, data, hash);
+    }
+
+    void write (NodeObject::Ptr const& object,
+        void const* data, std::size_t stored)
+    {
+        // Keep the table at most half full
+        while ((m_count + 1) * 2 > m_buckets.size ())
+            evict ();
+
+        std::size_t const offset (allocate (headerBytes + stored));
+        uint8* const entry (&m_arena [offset]);
+
+        uint32 const size32 (static_cast <uint32> (object->getSize ()));
+        uint32 const stored32 (static_cast <uint32> (stored));
+        LedgerIndex const ledgerIndex (object->getIndex ());
+        memcpy (entry, object->getHash ().begin (), 32);
+        memcpy (entry + 32, &size32, 4);
+        memcpy (entry + 36, &stored32, 4);
+        memcpy (entry + 40, &ledgerIndex, 4);
+        entry [44] = static_cast <uint8> (object->getType ());
+        memcpy (entry + headerBytes, data, stored);
+
+        m_head = offset + headerBytes + stored;
+        ++m_count;
+
+        uint32 const tag (tagOf (entry));
+        for (std::size_t i (tag & m_mask);; i = (i + 1) & m_mask)
+        {
+            if (m_buckets [i].location == 0)
+            {
+                m_buckets [i].tag = tag;
+                m_buckets [i].location = static_cast <uint32> (offset + 1);
+                break;
+            }
+        }
+    }
+
+    std::size_t size () const
+    {
+        return m_count;
+    }
+
+private:
+    static uint32 tagOf (void const* key)
+    {
+        uint32 tag;
+        memcpy (&tag, static_cast <uint8 const*> (key) + 8, 4);
+        return tag;
+    }
+
+    uint8 const* find (uint256 const& hash) const
+    {
+        uint32 const tag (tagOf (hash.begin ()));
+        for (std::size_t i (tag & m_mask);; i = (i + 1) & m_mask)
+        {
+            Bucket const& bucket (m_buckets [i]);
+
+            if (bucket.location == 0)
+                return nullptr;
+
+            if (bucket.tag == tag)
+            {
+                uint8 const* const entry (&m_arena [bucket.location - 1]);
+                if (memcmp (entry, hash.begin (), 32) == 0)
+                    return entry;
+            }
+        }
+    }
+
+    // Returns the offset of a free run of bytes, evicting to make room
+    std::size_t allocate (std::size_t bytes)
+    {
+        for (;;)
+        {
+            if (m_count == 0)
+            {
+                m_head = 0;
+                m_tail = 0;
+                m_wrap = m_capacity;
+            }
+
+            if (m_head > m_tail || m_count == 0)
+            {
+                // Entries are in [tail, head)
+                if (m_capacity - m_head >= bytes)
+                    return m_head;
+
+                // Start over at the beginning, behind the oldest entry
+                m_wrap = m_head;
+                m_head = 0;
+            }
+            else if (m_tail - m_head >= bytes)
+            {
+                // Entries are in [tail, wrap) and [0, head)
+                return m_head;
+            }
+            else
+            {
+                evict ();
+            }
+        }
+    }
+
+    // Removes the oldest entry
+    void evict ()
+    {
+        uint8 const* const entry (&m_arena [m_tail]);
+        uint32 stored;
+        memcpy (&stored, entry + 36, 4);
+
+        erase (tagOf (entry), static_cast <uint32> (m_tail + 1));
+
+        m_tail += headerBytes + stored;
+        --m_count;
+
+        if (m_tail == m_wrap)
+        {
+            m_tail = 0;
+            m_wrap = m_capacity;
+        }
+    }
+
+    // Empties a bucket, moving later buckets in the same run back so that
+    // probing never stops early.
+    void erase (uint32 tag, uint32 location)
+    {
+        std::size_t i (tag & m_mask);
+        while (m_buckets [i].location != location)
+            i = (i + 1) & m_mask;
+
+        for (std::size_t j (i);;)
+        {
+            m_buckets [i].location = 0;
+
+            for (;;)
+            {
+                j = (j + 1) & m_mask;
+
+                if (m_buckets [j].location == 0)
+                    return;
+
+                // Move it if i lies between where it belongs and where it is
+                std::size_t const home (m_buckets [j].tag & m_mask);
+                if (((j - home) & m_mask) >= ((j - i) & m_mask))
+                {
+                    m_buckets [i] = m_buckets [j];
+                    i = j;
+                    break;
+                }
+            }
+        }
+    }
+
+public:
+    std::mutex mutex;
+
+private:
+    std::unique_ptr <uint8 []> m_arena;
+    std::size_t const m_capacity;
+    std::size_t m_head;
+    std::size_t m_tail;
+    std::size_t m_wrap;
+    std::size_t m_count;
+    std::vector <Bucket> m_buckets;
+    std::size_t m_mask;
+};
+
+//------------------------------------------------------------------------------
+
+CompressedCache::CompressedCache (std::size_t bytes, std::size_t partitions)
+    : m_maxEntryBytes (0)
+    , m_hits (0)
+    , m_misses (0)
+{
+    // Offsets in the index are 32 bits
+    std::size_t const partitionBytes (std::min <std::size_t> (
+        bytes / partitions, 0xFFFFFFFF));
+
+    // An entry may take at most a quarter of its partition, so one large
+    // object can't flush everything else out.
+    m_maxEntryBytes = partitionBytes / 4;
+
+    if (m_maxEntryBytes > Partition::headerBytes)
+    {
+        m_partitions.reserve (partitions);
+        for (std::size_t i = 0; i < partitions; ++i)
+            m_partitions.push_back (std::make_unique <Partition> (
+                partitionBytes));
+    }
+}
+
+CompressedCache::~CompressedCache ()
+{
+}
+
+void CompressedCache::insert (NodeObject::Ptr const& object)
+{
+    if (! isEnabled ())
+        return;
+
+    uint256 const& hash (object->getHash ());
+    unsigned char const* const data (object->getData ());
+    std::size_t const bytes (object->getSize ());
+
+    if ((Partition::headerBytes + bytes) > m_maxEntryBytes)
+        return;
+
+    Partition& p (partition (hash));
+
+    {
+        std::lock_guard <std::mutex> lock (p.mutex);
+        if (p.contains (hash))
+            return;
+    }
+
+    // Compress outside the lock
+    MemoryBlock buffer (LZ4::compressBound (bytes));
+    std::size_t stored (LZ4::compress (data, bytes,
+        buffer.getData ()));
+    void const* payload (buffer.getData ());
+
+    if (stored >= bytes)
+    {
+        stored = bytes;
+        payload = data;
+    }
+
+    std::lock_guard <std::mutex> lock (p.mutex);
+
+    // Someone else may have inserted it while we were compressing
+    if (! p.contains (hash))
+        p.write (object, payload, stored);
+}
+
+NodeObject::Ptr CompressedCache::fetch (uint256 const& hash)
+{
+    if (! isEnabled ())
+        return nullptr;
+
+    Partition& p (partition (hash));
+
+    NodeObject::Ptr object;
+
+    {
+        std::lock_guard <std::mutex> lock (p.mutex);
+        object = p.read (hash);
+    }
+
+    if (object != nullptr)
+        ++m_hits;
+    else
+        ++m_misses;
+
+    return object;
+}
+
+float CompressedCache::getHitRate ()
+{
+    std::size_t const hits (m_hits);
+    std::size_t const misses (m_misses);
+    return (static_cast <float> (hits) * 100) / (1.0f + hits + misses);
+}
+
+std::size_t CompressedCache::getCount ()
+{
+    std::size_t count (0);
+    for (auto& p : m_partitions)
+    {
+        std::lock_guard <std::mutex> lock (p->mutex);
+        count += p->size ();
+    }
+    return count;
+}
+
+CompressedCache::Partition& CompressedCache::partition (uint256 const& hash)
+{
+    // Keys are hashes already, any of their bits will do
+    return *m_partitions [hash.begin () [0] % m_partitions.size ()];
+}
+
+}
+}
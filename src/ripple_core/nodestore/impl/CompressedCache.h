@@ -0,0 +1,96 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_COMPRESSEDCACHE_H_INCLUDED
+#define RIPPLE_NODESTORE_COMPRESSEDCACHE_H_INCLUDED
+
+namespace ripple {
+namespace NodeStore {
+
+/** A cache of recently used node objects, held compressed.
+
+    This is the second tier behind the cache of decoded objects. Entries
+    hold the object's data compressed with LZ4, so several times as many
+    objects fit in the same memory, and a hit costs a decompression instead
+    of a backend read.
+
+    The cache is split into independently locked partitions by key. Each
+    partition owns a fixed size arena used as a ring: new entries are
+    appended at the head and the oldest are evicted from the tail to make
+    room. Memory use is fixed when the cache is created, the index adds an
+    eighth to the size of the arenas, and entries are never allocated
+    individually.
+
+    @see DatabaseImp, LZ4
+*/
+class CompressedCache : public Uncopyable
+{
+public:
+    enum
+    {
+        defaultPartitions = 16
+    };
+
+    /** Create the cache.
+        @param bytes The total size of the arenas. Zero disables the cache.
+    */
+    explicit CompressedCache (std::size_t bytes,
+        std::size_t partitions = defaultPartitions);
+
+    ~CompressedCache ();
+
+    /** Returns `true` if the cache holds anything at all. */
+    bool isEnabled () const noexcept
+    {
+        return ! m_partitions.empty ();
+    }
+
+    /** Add an object.
+        Objects already present, or too large for the arena, are ignored.
+        @note This can be called concurrently.
+    */
+    void insert (NodeObject::Ptr const& object);
+
+    /** Retrieve a freshly decoded copy of an object.
+        @note This can be called concurrently.
+        @return The object, or nullptr if it isn't cached.
+    */
+    NodeObject::Ptr fetch (uint256 const& hash);
+
+    /** Returns the percentage of fetches which were found. */
+    float getHitRate ();
+
+    /** Returns the number of objects held. */
+    std::size_t getCount ();
+
+private:
+    struct Partition;
+
+    Partition& partition (uint256 const& hash);
+
+    std::vector <std::unique_ptr <Partition>> m_partitions;
+    std::size_t m_maxEntryBytes;
+    std::atomic <std::size_t> m_hits;
+    std::atomic <std::size_t> m_misses;
+};
+
+}
+}
+
+#endif
@@ -30,24 +30,53 @@ class DatabaseImp
 public:
     Journal m_journal;
     Scheduler& m_scheduler;
-    // Persistent key/value storage.
+    // Persistent key/value storage. While rotating, this is the new
+    // backend and m_archive is the one being retired.
     std::unique_ptr <Backend> m_backend;
+    std::unique_ptr <Backend> m_archive;
+    // Set while a rotation may change the backends. Readers only take
+    // m_backendMutex when it is set.
+    std::atomic <bool> m_rotating;
+    // Readers using m_backend without the mutex.
+    std::atomic <int> mutable m_steadyReaders;
+    std::mutex mutable m_backendMutex;
+    // Readers which took the mutex, rotations wait for them to finish.
+    std::size_t mutable m_rotationReaders;
+    std::condition_variable mutable m_rotationReleased;
+    std::atomic <std::size_t> m_rotationCopied;
+    std::atomic <std::size_t> m_rotationCarried;
     // Larger key/value storage, but not necessarily persistent.
     std::unique_ptr <Backend> m_fastBackend;
-    TaggedCache <uint256, NodeObject> m_cache;
+    ShardedTaggedCache <uint256, NodeObject> m_cache;
+    // Second tier holding many more objects than m_cache, compressed.
+    // Objects are only compressed when they expire from m_cache.
+    CompressedCache m_compressed;
 
     DatabaseImp (std::string const& name,
                  Scheduler& scheduler,
                  std::unique_ptr <Backend> backend,
                  std::unique_ptr <Backend> fastBackend,
-                 Journal journal)
+                 std::size_t compressedCacheBytes,
+                 Journal journal,
+                 insight::Collector::ptr const& collector)
         : m_journal (journal)
         , m_scheduler (scheduler)
         , m_backend (std::move (backend))
+        , m_rotating (false)
+        , m_steadyReaders (0)
+        , m_rotationReaders (0)
+        , m_rotationCopied (0)
+        , m_rotationCarried (0)
         , m_fastBackend (std::move (fastBackend))
         , m_cache ("NodeStore", cacheTargetSize, cacheTargetSeconds,
-            get_seconds_clock (), LogPartition::getJournal <TaggedCacheLog> ())
+            get_seconds_clock (), LogPartition::getJournal <TaggedCacheLog> (),
+                collector)
+        , m_compressed (compressedCacheBytes)
     {
+        if (m_compressed.isEnabled ())
+            m_cache.setExpireHandler (std::bind (
+                &CompressedCache::insert, &m_compressed,
+                    std::placeholders::_1));
     }
 
     ~DatabaseImp ()
@@ -56,7 +85,84 @@ public:
 
     String getName () const
     {
-        return m_backend->getName ();
+        return getBackends ().current->getName ();
+    }
+
+    /** The backends in use by one operation.
+        While this exists, a rotation can't swap or close either of them.
+    */
+    class Backends : public Uncopyable
+    {
+    public:
+        Backends (DatabaseImp const& owner, bool steady)
+            : current (nullptr)
+            , archive (nullptr)
+            , m_owner (&owner)
+            , m_steady (steady)
+        {
+        }
+
+        Backends (Backends&& other)
+            : current (other.current)
+            , archive (other.archive)
+            , m_owner (other.m_owner)
+            , m_steady (other.m_steady)
+        {
+            other.m_owner = nullptr;
+        }
+
+        ~Backends ()
+        {
+            if (m_owner != nullptr)
+                m_owner->releaseBackends (m_steady);
+        }
+
+        Backend* current;
+        Backend* archive;
+
+    private:
+        DatabaseImp const* m_owner;
+        bool m_steady;
+    };
+
+    Backends getBackends () const
+    {
+        // Outside of a rotation the backend can't change, so a counter
+        // is enough. beginRotation sets the flag before it waits for the
+        // counter to drain, so one of the two always sees the other.
+        if (! m_rotating.load ())
+        {
+            ++m_steadyReaders;
+
+            if (! m_rotating.load ())
+            {
+                Backends backends (*this, true);
+                backends.current = m_backend.get ();
+                return backends;
+            }
+
+            --m_steadyReaders;
+        }
+
+        std::lock_guard <std::mutex> lock (m_backendMutex);
+        Backends backends (*this, false);
+        backends.current = m_backend.get ();
+        backends.archive = m_archive.get ();
+        ++m_rotationReaders;
+        return backends;
+    }
+
+    void releaseBackends (bool steady) const
+    {
+        if (steady)
+        {
+            --m_steadyReaders;
+            return;
+        }
+
+        std::lock_guard <std::mutex> lock (m_backendMutex);
+        if (--m_rotationReaders == 0)
+            m_rotationReleased.notify_all ();
     }
 
     //------------------------------------------------------------------------------
@@ -67,6 +173,15 @@ public:
         //
         NodeObject::Ptr obj = m_cache.fetch (hash);
 
+        if (obj == nullptr)
+        {
+            // Decompressing a copy is much cheaper than any backend read
+            obj = m_compressed.fetch (hash);
+
+            if (obj != nullptr)
+                m_cache.canonicalize (hash, obj);
+        }
+
         if (obj == nullptr)
         {
             // There's still a chance it could be in one of the databases.
@@ -99,7 +214,21 @@ public:
                     //
                     //LoadEvent::autoptr event (getApp().getJobQueue ().getLoadEventAP (jtHO_READ, "HOS::retrieve"));
 
-                    obj = fetchInternal (*m_backend, hash);
+                    Backends const backends (getBackends ());
+
+                    obj = fetchInternal (*backends.current, hash);
+
+                    if (obj == nullptr && backends.archive != nullptr)
+                    {
+                        obj = fetchInternal (*backends.archive, hash);
+
+                        // Anything still in use has to survive the rotation
+                        if (obj != nullptr)
+                        {
+                            backends.current->store (obj);
+                            ++m_rotationCarried;
+                        }
+                    }
                 }
 
             }
@@ -126,14 +255,148 @@ public:
                 }
             }
         }
-        else
+
+        return obj;
+    }
+
+    NodeObject::Ptr fetchUncached (uint256 const& hash)
+    {
+        // A recent object may still be waiting to be written
+        NodeObject::Ptr obj = m_cache.fetch (hash);
+
+        if (obj == nullptr)
+            obj = m_compressed.fetch (hash);
+
+        if (obj == nullptr && m_fastBackend != nullptr)
+            obj = fetchInternal (*m_fastBackend, hash);
+
+        if (obj == nullptr)
         {
-            // found it!
+            Backends const backends (getBackends ());
+
+            obj = fetchInternal (*backends.current, hash);
+
+            if (obj == nullptr && backends.archive != nullptr)
+                obj = fetchInternal (*backends.archive, hash);
         }
 
         return obj;
     }
 
+    Batch fetchBatch (std::vector <uint256> const& hashes)
+    {
+        Batch objects (hashes.size ());
+
+        // Collect the keys which are not already cached
+        std::vector <std::size_t> missing;
+        for (std::size_t i = 0; i < hashes.size (); ++i)
+        {
+            objects [i] = m_cache.fetch (hashes [i]);
+
+            if (objects [i] == nullptr)
+            {
+                objects [i] = m_compressed.fetch (hashes [i]);
+
+                if (objects [i] != nullptr)
+                    m_cache.canonicalize (hashes [i], objects [i]);
+                else
+                    missing.push_back (i);
+            }
+        }
+
+        if (missing.empty ())
+            return objects;
+
+        if (m_fastBackend != nullptr)
+        {
+            fetchBatchInternal (*m_fastBackend, hashes, missing, objects);
+
+            // Remove the ones we found, they don't need storing again
+            missing.erase (std::remove_if (missing.begin (), missing.end (),
+                [&objects] (std::size_t i) { return objects [i] != nullptr; }),
+                    missing.end ());
+        }
+
+        if (! missing.empty ())
+        {
+            Backends const backends (getBackends ());
+
+            fetchBatchInternal (*backends.current, hashes, missing, objects);
+
+            if (backends.archive != nullptr)
+            {
+                std::vector <std::size_t> archived;
+                for (std::size_t const i : missing)
+                    if (objects [i] == nullptr)
+                        archived.push_back (i);
+
+                if (! archived.empty ())
+                {
+                    fetchBatchInternal (*backends.archive,
+                        hashes, archived, objects);
+
+                    for (std::size_t const i : archived)
+                    {
+                        if (objects [i] != nullptr)
+                        {
+                            backends.current->store (objects [i]);
+                            ++m_rotationCarried;
+                        }
+                    }
+                }
+            }
+
+            if (m_fastBackend != nullptr)
+            {
+                for (std::size_t const i : missing)
+                    if (objects [i] != nullptr)
+                        m_fastBackend->store (objects [i]);
+            }
+        }
+
+        return objects;
+    }
+
+    /** Fetch the objects at the given positions from a backend.
+        Objects which are found are canonicalized and placed in the result.
+    */
+    void fetchBatchInternal (Backend& backend,
+        std::vector <uint256> const& hashes,
+            std::vector <std::size_t> const& positions, Batch& objects)
+    {
+        std::vector <void const*> keys;
+        keys.reserve (positions.size ());
+        for (std::size_t const i : positions)
+            keys.push_back (hashes [i].begin ());
+
+        Batch found;
+        backend.fetchBatch (keys, &found);
+
+        for (std::size_t j = 0; j < positions.size (); ++j)
+        {
+            if (found [j] != nullptr)
+            {
+                std::size_t const i (positions [j]);
+                objects [i] = found [j];
+                m_cache.canonicalize (hashes [i], objects [i]);
+            }
+        }
+    }
+
+    Batch getRecentObjects (std::size_t limit)
+    {
+        return m_cache.getRecent (limit);
+    }
+
+    void warm (Batch const& objects)
+    {
+        for (auto const& object : objects)
+        {
+            NodeObject::Ptr copy (object);
+            m_cache.canonicalize (copy->getHash (), copy);
+        }
+    }
+
     NodeObject::Ptr fetchInternal (Backend& backend,
         uint256 const& hash)
     {
@@ -170,6 +433,8 @@ public:
     {
         bool const keyFoundAndObjectCached = m_cache.refreshIfPresent (hash);
 
+        Backends const backends (getBackends ());
+
         // VFALCO NOTE What happens if the key is found, but the object
         //             fell out of the cache? We will end up passing it
         //             to the backend anyway.
@@ -185,13 +450,21 @@ public:
 
             if (!m_cache.canonicalize (hash, object))
             {
-                m_backend->store (object);
+                backends.current->store (object);
 
                 if (m_fastBackend)
                     m_fastBackend->store (object);
             }
 
         }
+        else if (backends.archive != nullptr)
+        {
+            // The cached copy may only be in the backend being retired
+            NodeObject::Ptr const object (m_cache.fetch (hash));
+
+            if (object != nullptr)
+                backends.current->store (object);
+        }
     }
 
     //------------------------------------------------------------------------------
@@ -201,12 +474,22 @@ public:
         return m_cache.getHitRate ();
     }
 
+    float getCompressedCacheHitRate ()
+    {
+        return m_compressed.getHitRate ();
+    }
+
     void tune (int size, int age)
     {
         m_cache.setTargetSize (size);
         m_cache.setTargetAge (age);
     }
 
+    void setSweepInterval (std::chrono::seconds interval)
+    {
+        m_cache.setSweepInterval (interval);
+    }
+
     void sweep ()
     {
         m_cache.sweep ();
@@ -214,14 +497,19 @@ public:
 
     int getWriteLoad ()
     {
-        return m_backend->getWriteLoad ();
+        return getBackends ().current->getWriteLoad ();
+    }
+
+    WriteStats getWriteStats ()
+    {
+        return getBackends ().current->getWriteStats ();
     }
 
     //------------------------------------------------------------------------------
 
     void visitAll (VisitCallback& callback)
     {
-        m_backend->visitAll (callback);
+        getBackends ().current->visitAll (callback);
     }
 
     void import (Database& sourceDatabase)
@@ -261,10 +549,132 @@ public:
 
         //--------------------------------------------------------------------------
 
-        ImportVisitCallback callback (*m_backend);
+        Backends const backends (getBackends ());
+        ImportVisitCallback callback (*backends.current);
 
         sourceDatabase.visitAll (callback);
     }
+
+    //------------------------------------------------------------------------------
+
+    void beginRotation (std::unique_ptr <Backend> backend)
+    {
+        {
+            std::unique_lock <std::mutex> lock (m_backendMutex);
+
+            bassert (m_archive == nullptr);
+
+            // Send new readers through the mutex, then wait for the ones
+            // already using the backend. They don't take the mutex, so
+            // holding it here doesn't keep them from finishing.
+            m_rotating = true;
+            while (m_steadyReaders.load () != 0)
+                std::this_thread::yield ();
+
+            m_rotationReleased.wait (lock, [this] {
+                return m_rotationReaders == 0; });
+
+            m_archive = std::move (m_backend);
+            m_backend = std::move (backend);
+            m_rotationCopied = 0;
+            m_rotationCarried = 0;
+        }
+
+        // Objects still queued for the old backend are written now, so
+        // copyForward finds them there. Nothing new is stored to it.
+        m_archive->waitForWriting ();
+    }
+
+    Batch copyForward (std::vector <uint256> const& hashes)
+    {
+        Batch found;
+        std::vector <uint256> newer;
+
+        {
+            Backends const backends (getBackends ());
+
+            if (backends.archive == nullptr)
+                return Batch (hashes.size ());
+
+            // The objects are read straight from the backend, going through
+            // the caches would push out the working set for mostly cold data.
+            std::vector <void const*> keys;
+            keys.reserve (hashes.size ());
+            for (auto const& hash : hashes)
+                keys.push_back (hash.begin ());
+
+            backends.archive->fetchBatch (keys, &found);
+
+            std::size_t copied (0);
+            for (std::size_t i = 0; i < hashes.size (); ++i)
+            {
+                if (found [i] != nullptr)
+                {
+                    backends.current->store (found [i]);
+                    ++copied;
+                }
+                else
+                {
+                    newer.push_back (hashes [i]);
+                }
+            }
+
+            m_rotationCopied += copied;
+        }
+
+        // Objects stored since the rotation began are usually in the new
+        // backend already, but one served from a cache might not be.
+        if (! newer.empty ())
+        {
+            Batch const fetched (fetchBatch (newer));
+
+            Backends const backends (getBackends ());
+
+            std::size_t copied (0);
+            for (std::size_t i = 0, j = 0; i < hashes.size (); ++i)
+            {
+                if (found [i] == nullptr)
+                {
+                    found [i] = fetched [j++];
+
+                    if (found [i] != nullptr)
+                    {
+                        backends.current->store (found [i]);
+                        ++copied;
+                    }
+                }
+            }
+
+            m_rotationCopied += copied;
+        }
+
+        return found;
+    }
+
+    void endRotation ()
+    {
+        std::unique_ptr <Backend> archive;
+
+        {
+            std::unique_lock <std::mutex> lock (m_backendMutex);
+            archive.swap (m_archive);
+
+            // Wait for fetches still reading from it
+            m_rotationReleased.wait (lock, [this] {
+                return m_rotationReaders == 0; });
+
+            m_rotating = false;
+        }
+    }
+
+    RotationStats getRotationStats ()
+    {
+        RotationStats stats;
+        stats.rotating = m_rotating.load ();
+        stats.copied = m_rotationCopied;
+        stats.carried = m_rotationCarried;
+        return stats;
+    }
 };
 
 }
@@ -82,12 +82,8 @@ NodeObject::Ptr DecodedBlob::createObject ()
 
     if (m_success)
     {
-        Blob data (m_dataBytes);
-
-        memcpy (data.data (), m_objectData, m_dataBytes);
-
-        object = NodeObject::createObject (
-            m_objectType, m_ledgerIndex, data, uint256::fromVoid (m_key));
+        object = NodeObject::createObject (m_objectType, m_ledgerIndex,
+            m_objectData, m_dataBytes, uint256::fromVoid (m_key));
     }
 
     return object;
@@ -20,32 +20,27 @@
 namespace ripple {
 namespace NodeStore {
 
-void EncodedBlob::prepare (NodeObject::Ptr const& object)
+void EncodedBlob::writeHeader (void* dest, NodeObjectType type,
+    LedgerIndex ledgerIndex)
 {
-    m_key = object->getHash ().begin ();
-
-    // This is how many bytes we need in the flat data
-    m_size = object->getData ().size () + 9;
-
-    m_data.ensureSize (m_size);
-
     // These sizes must be the same!
-    static_bassert (sizeof (uint32) == sizeof (object->getIndex ()));
+    static_bassert (sizeof (uint32) == sizeof (ledgerIndex));
 
-    {
-        uint32* buf = static_cast <uint32*> (m_data.getData ());
+    unsigned char* const buf (static_cast <unsigned char*> (dest));
 
-        buf [0] = ByteOrder::swapIfLittleEndian (object->getIndex ());
-        buf [1] = ByteOrder::swapIfLittleEndian (object->getIndex ());
-    }
+    uint32 const index (ByteOrder::swapIfLittleEndian (ledgerIndex));
+    memcpy (&buf [0], &index, sizeof (index));
+    memcpy (&buf [4], &index, sizeof (index));
 
-    {
-        unsigned char* buf = static_cast <unsigned char*> (m_data.getData ());
-
-        buf [8] = static_cast <unsigned char> (object->getType ());
+    buf [8] = static_cast <unsigned char> (type);
+}
 
-        memcpy (&buf [9], object->getData ().data (), object->getData ().size ());
-    }
+void EncodedBlob::prepare (NodeObject::Ptr const& object)
+{
+    m_object = object;
+    m_key = object->getHash ().begin ();
+    m_data = object->getEncoded ();
+    m_size = object->getSize () + headerBytes;
 }
 
 }
@@ -24,20 +24,34 @@ namespace ripple {
 namespace NodeStore {
 
 /** Utility for producing flattened node objects.
+
+    NodeObject keeps its data in this format, so preparing a blob only
+    refers to the object, which is kept alive until the next prepare.
+
     @note This defines the database format of a NodeObject!
 */
-// VFALCO TODO Make allocator aware and use short_alloc
 struct EncodedBlob
 {
 public:
+    enum
+    {
+        // Bytes preceding the object's data
+        headerBytes = 9
+    };
+
+    /** Write the header for an object. */
+    static void writeHeader (void* dest, NodeObjectType type,
+        LedgerIndex ledgerIndex);
+
     void prepare (NodeObject::Ptr const& object);
     void const* getKey () const noexcept { return m_key; }
     size_t getSize () const noexcept { return m_size; }
-    void const* getData () const noexcept { return m_data.getData (); }
+    void const* getData () const noexcept { return m_data; }
 
 private:
+    NodeObject::Ptr m_object;
     void const* m_key;
-    MemoryBlock m_data;
+    void const* m_data;
     size_t m_size;
 };
 
@@ -0,0 +1,50 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_KEYORDER_H_INCLUDED
+#define RIPPLE_NODESTORE_KEYORDER_H_INCLUDED
+
+namespace ripple {
+namespace NodeStore {
+
+/** Return the positions of a group of keys, in ascending key order.
+    Ordered backends use this to read a batch in the order it is stored,
+    so that keys which land in the same table are looked up together.
+*/
+inline std::vector <std::size_t> sortedKeyOrder (
+    std::vector <void const*> const& keys, std::size_t keyBytes)
+{
+    std::vector <std::size_t> order (keys.size ());
+
+    for (std::size_t i = 0; i < order.size (); ++i)
+        order [i] = i;
+
+    std::sort (order.begin (), order.end (),
+        [&keys, keyBytes] (std::size_t lhs, std::size_t rhs)
+        {
+            return memcmp (keys [lhs], keys [rhs], keyBytes) < 0;
+        });
+
+    return order;
+}
+
+}
+}
+
+#endif
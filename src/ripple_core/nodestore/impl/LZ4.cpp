@@ -0,0 +1,292 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+namespace ripple {
+namespace NodeStore {
+namespace LZ4 {
+
+namespace detail {
+
+enum
+{
+    // Shortest match which can be encoded
+    minMatch = 4
+
+    // The block always ends with at least this many literals
+    ,lastLiterals = 5
+
+    // No match may start within this many bytes of the end
+    ,matchFindLimit = 12
+
+    // Furthest back reference which can be encoded
+    ,maxOffset = 65535
+
+    // The hash table holds at most 1 << maxHashLog positions
+    ,maxHashLog = 12
+
+    // Small inputs use a smaller table, which is quicker to clear
+    ,minHashLog = 8
+
+    // Unsuccessful searches speed up the scan after 1 << skipStrength tries
+    ,skipStrength = 6
+};
+
+inline uint32 read32 (uint8 const* p)
+{
+    uint32 v;
+    memcpy (&v, p, sizeof (v));
+    return v;
+}
+
+inline uint64 read64 (uint8 const* p)
+{
+    uint64 v;
+    memcpy (&v, p, sizeof (v));
+    return v;
+}
+
+inline uint32 hashSequence (uint32 sequence, int hashLog)
+{
+    return (sequence * 2654435761U) >> (32 - hashLog);
+}
+
+// Writes a length which doesn't fit in the token
+inline uint8* writeLength (uint8* out, std::size_t length)
+{
+    for (; length >= 255; length -= 255)
+        *out++ = 255;
+    *out++ = static_cast <uint8> (length);
+    return out;
+}
+
+inline uint8* writeLiterals (uint8* out, uint8* token,
+    uint8 const* literals, std::size_t length)
+{
+    if (length >= 15)
+    {
+        *token = 15 << 4;
+        out = writeLength (out, length - 15);
+    }
+    else
+    {
+        *token = static_cast <uint8> (length << 4);
+    }
+
+    memcpy (out, literals, length);
+    return out + length;
+}
+
+}
+
+//------------------------------------------------------------------------------
+
+std::size_t compressBound (std::size_t bytes)
+{
+    return bytes + (bytes / 255) + 16;
+}
+
+std::size_t compress (void const* source, std::size_t bytes, void* dest)
+{
+    using namespace detail;
+
+    uint8 const* const in = static_cast <uint8 const*> (source);
+    uint8 const* const end = in + bytes;
+    uint8* const out = static_cast <uint8*> (dest);
+
+    uint8 const* ip = in;
+    uint8 const* anchor = in;
+    uint8* op = out;
+
+    if (bytes > matchFindLimit)
+    {
+        uint8 const* const matchLimit = end - lastLiterals;
+        uint8 const* const searchLimit = end - matchFindLimit;
+
+        // About one slot for every two bytes of input
+        int hashLog (minHashLog);
+        while (hashLog < maxHashLog && (std::size_t (2) << hashLog) < bytes)
+            ++hashLog;
+
+        // Positions are offsets from the start of the input. The table
+        // starts out pointing at the first byte, a false match there
+        // is caught when the bytes are compared.
+        uint32 table [1 << maxHashLog];
+        memset (table, 0, sizeof (uint32) << hashLog);
+
+        unsigned attempts (1 << skipStrength);
+
+        ++ip;
+
+        while (ip < searchLimit)
+        {
+            uint32 const sequence (read32 (ip));
+            uint32& slot (table [hashSequence (sequence, hashLog)]);
+            uint8 const* ref = in + slot;
+            slot = static_cast <uint32> (ip - in);
+
+            if ((ip - ref) > maxOffset || ref >= ip ||
+                read32 (ref) != sequence)
+            {
+                ip += attempts++ >> skipStrength;
+                continue;
+            }
+
+            attempts = 1 << skipStrength;
+
+            // Extend the match backwards over pending literals
+            while (ip > anchor && ref > in && ip [-1] == ref [-1])
+            {
+                --ip;
+                --ref;
+            }
+
+            uint8 const* matchEnd = ip + minMatch;
+            uint8 const* refEnd = ref + minMatch;
+            while ((matchEnd + 8) <= matchLimit &&
+                read64 (matchEnd) == read64 (refEnd))
+            {
+                matchEnd += 8;
+                refEnd += 8;
+            }
+            while (matchEnd < matchLimit && *matchEnd == *refEnd)
+            {
+                ++matchEnd;
+                ++refEnd;
+            }
+
+            uint8* const token = op++;
+            op = writeLiterals (op, token, anchor, ip - anchor);
+
+            std::size_t const offset (ip - ref);
+            *op++ = static_cast <uint8> (offset);
+            *op++ = static_cast <uint8> (offset >> 8);
+
+            std::size_t const length ((matchEnd - ip) - minMatch);
+            if (length >= 15)
+            {
+                *token |= 15;
+                op = writeLength (op, length - 15);
+            }
+            else
+            {
+                *token |= static_cast <uint8> (length);
+            }
+
+            ip = matchEnd;
+            anchor = ip;
+        }
+    }
+
+    // The last sequence is literals only
+    uint8* const token = op++;
+    op = writeLiterals (op, token, anchor, end - anchor);
+
+    return op - out;
+}
+
+std::size_t decompress (void const* source, std::size_t bytes,
+    void* dest, std::size_t capacity)
+{
+    using namespace detail;
+
+    uint8 const* ip = static_cast <uint8 const*> (source);
+    uint8 const* const end = ip + bytes;
+    uint8* const out = static_cast <uint8*> (dest);
+    uint8* op = out;
+    uint8* const outEnd = out + capacity;
+
+    for (;;)
+    {
+        if (ip >= end)
+            return 0;
+
+        unsigned const token (*ip++);
+
+        std::size_t literals (token >> 4);
+        if (literals == 15)
+        {
+            uint8 b;
+            do
+            {
+                if (ip >= end)
+                    return 0;
+                b = *ip++;
+                literals += b;
+            }
+            while (b == 255);
+        }
+
+        if (literals > std::size_t (end - ip) ||
+            literals > std::size_t (outEnd - op))
+            return 0;
+
+        memcpy (op, ip, literals);
+        ip += literals;
+        op += literals;
+
+        // The last sequence has no match
+        if (ip == end)
+            break;
+
+        if ((end - ip) < 2)
+            return 0;
+
+        std::size_t const offset (ip [0] | (ip [1] << 8));
+        ip += 2;
+
+        if (offset == 0 || offset > std::size_t (op - out))
+            return 0;
+
+        std::size_t length (token & 15);
+        if (length == 15)
+        {
+            uint8 b;
+            do
+            {
+                if (ip >= end)
+                    return 0;
+                b = *ip++;
+                length += b;
+            }
+            while (b == 255);
+        }
+        length += minMatch;
+
+        if (length > std::size_t (outEnd - op))
+            return 0;
+
+        // A match which overlaps the output repeats with a period of the
+        // offset, so it is copied in chunks which double each time.
+        uint8 const* const match = op - offset;
+        while (length > 0)
+        {
+            std::size_t const chunk (std::min (length,
+                std::size_t (op - match)));
+            memcpy (op, match, chunk);
+            op += chunk;
+            length -= chunk;
+        }
+    }
+
+    return op - out;
+}
+
+}
+}
+}
@@ -0,0 +1,63 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_LZ4_H_INCLUDED
+#define RIPPLE_NODESTORE_LZ4_H_INCLUDED
+
+namespace ripple {
+namespace NodeStore {
+
+/** Fast compression for node objects held in memory.
+
+    The output is the LZ4 block format: a run of sequences, each holding
+    literal bytes followed by a back reference to a match of four or more
+    bytes within the previous 64KB. Only the block format is produced, there
+    is no framing, so the caller has to remember the uncompressed size.
+
+    The compressor favors speed over ratio. Node objects are mostly hashes
+    which don't compress, what's left is runs of zero bytes in inner nodes
+    with empty branches and repeated fields in serialized ledger entries.
+*/
+namespace LZ4
+{
+
+/** Returns the largest possible compressed size of an input. */
+std::size_t compressBound (std::size_t bytes);
+
+/** Compress a block of memory.
+    @param dest Must have room for compressBound (bytes) bytes.
+    @return The number of bytes written to dest.
+*/
+std::size_t compress (void const* source, std::size_t bytes, void* dest);
+
+/** Decompress a block of memory.
+    Malformed input is detected, it never reads or writes out of bounds.
+    @param capacity The number of bytes available at dest.
+    @return The number of bytes written to dest, or zero if the input is
+            malformed or doesn't fit.
+*/
+std::size_t decompress (void const* source, std::size_t bytes,
+    void* dest, std::size_t capacity);
+
+}
+
+}
+}
+
+#endif
@@ -49,6 +49,7 @@ public:
         //addFactory (make_SqliteFactory ());
 
         add_factory (make_LevelDBFactory ());
+        add_factory (make_AppendFactory ());
 
         add_factory (make_MemoryFactory ());
         add_factory (make_NullFactory ());
@@ -71,6 +72,16 @@ public:
         return nullptr;
     }
 
+    std::vector <String> getFactoryNames () const
+    {
+        std::vector <String> names;
+        names.reserve (m_list.size ());
+        for (List::const_iterator iter (m_list.begin ());
+            iter != m_list.end (); ++iter)
+            names.push_back ((*iter)->getName ());
+        return names;
+    }
+
     static void missing_backend ()
     {
         fatal_error (
@@ -111,7 +122,8 @@ public:
     std::unique_ptr <Database> make_Database (std::string const& name,
         Scheduler& scheduler, Journal journal,
             Parameters const& backendParameters,
-                Parameters fastBackendParameters)
+                Parameters fastBackendParameters,
+                    insight::Collector::ptr const& collector)
     {
         std::unique_ptr <Backend> backend (make_Backend (
             backendParameters, scheduler, journal));
@@ -121,8 +133,27 @@ public:
                 ? make_Backend (fastBackendParameters, scheduler, journal)
                 : nullptr);
 
+        String const compressedCache (
+            backendParameters ["compressed_cache_mb"]);
+
+        std::size_t const compressedCacheBytes (std::size_t (1024 * 1024) *
+            (compressedCache.isEmpty () ? int (compressedCacheMegabytesDefault)
+                : std::max (0, compressedCache.getIntValue ())));
+
         return std::make_unique <DatabaseImp> (name, scheduler,
-            std::move (backend), std::move (fastBackend), journal);
+            std::move (backend), std::move (fastBackend),
+                compressedCacheBytes, journal, collector);
+    }
+
+    std::unique_ptr <ShardStore> make_ShardStore (std::string const& name,
+        Scheduler& scheduler, Journal journal, Parameters const& parameters)
+    {
+        if (parameters ["type"].isEmpty () || find (
+            parameters ["type"].toStdString ()) == nullptr)
+            throw std::runtime_error ("Unknown backend type for the shard store");
+
+        return std::make_unique <ShardStoreImp> (name, *this, scheduler,
+            parameters, journal);
     }
 };
 
@@ -23,35 +23,68 @@ SETUP_LOG (NodeObject)
 
 //------------------------------------------------------------------------------
 
-NodeObject::NodeObject (
+struct NodeObject::Deleter
+{
+    void operator() (NodeObject* object) const
+    {
+        std::size_t const bytes (getBlockBytes (object->mDataBytes));
+        object->~NodeObject ();
+        NodeStore::SlabAllocator::getInstance ().deallocate (object, bytes);
+    }
+};
+
+NodeObject::NodeObject (std::size_t bytes, uint256 const& hash)
+    : mHash (hash)
+    , mDataBytes (static_cast <uint32> (bytes))
+{
+}
+
+NodeObject::Ptr NodeObject::createObject (
     NodeObjectType type,
     LedgerIndex ledgerIndex,
-    Blob& data,
-    uint256 const& hash,
-    PrivateAccess)
-    : mType (type)
-    , mHash (hash)
-    , mLedgerIndex (ledgerIndex)
+    Blob const& data,
+    uint256 const & hash)
 {
-    // Take over the caller's buffer
-    mData.swap (data);
+    return createObject (type, ledgerIndex, data.data (), data.size (), hash);
 }
 
 NodeObject::Ptr NodeObject::createObject (
     NodeObjectType type,
     LedgerIndex ledgerIndex,
-    Blob& data,
-    uint256 const & hash)
+    void const* data,
+    std::size_t bytes,
+    uint256 const& hash)
+{
+    using NodeStore::EncodedBlob;
+    using NodeStore::SlabAllocator;
+
+    void* const block (SlabAllocator::getInstance ().allocate (
+        getBlockBytes (bytes)));
+
+    NodeObject* const object (new (block) NodeObject (bytes, hash));
+
+    unsigned char* const encoded (object->getEncoded ());
+    EncodedBlob::writeHeader (encoded, type, ledgerIndex);
+    memcpy (encoded + EncodedBlob::headerBytes, data, bytes);
+
+    // The deleter is called if the reference count can't be allocated
+    return Ptr (object, Deleter (), SlabAllocator::Allocator <NodeObject> ());
+}
+
+std::size_t NodeObject::getBlockBytes (std::size_t bytes)
+{
+    return sizeof (NodeObject) + NodeStore::EncodedBlob::headerBytes + bytes;
+}
+
+unsigned char* NodeObject::getEncoded () const
 {
-    // The boost::ref is important or
-    // else it will be passed by  value!
-    return boost::make_shared <NodeObject> (
-        type, ledgerIndex, boost::ref (data), hash, PrivateAccess ());
+    return reinterpret_cast <unsigned char*> (
+        const_cast <NodeObject*> (this) + 1);
 }
 
 NodeObjectType NodeObject::getType () const
 {
-    return mType;
+    return static_cast <NodeObjectType> (getEncoded () [8]);
 }
 
 uint256 const& NodeObject::getHash () const
@@ -61,26 +94,36 @@ uint256 const& NodeObject::getHash () const
 
 LedgerIndex NodeObject::getIndex () const
 {
-    return mLedgerIndex;
+    uint32 index;
+    memcpy (&index, getEncoded (), sizeof (index));
+    return ByteOrder::swapIfLittleEndian (index);
 }
 
-Blob const& NodeObject::getData () const
+unsigned char const* NodeObject::getData () const
 {
-    return mData;
+    return getEncoded () + NodeStore::EncodedBlob::headerBytes;
+}
+
+std::size_t NodeObject::getSize () const
+{
+    return mDataBytes;
 }
 
 bool NodeObject::isCloneOf (NodeObject::Ptr const& other) const
 {
-    if (mType != other->mType)
+    if (getType () != other->getType ())
         return false;
 
     if (mHash != other->mHash)
         return false;
 
-    if (mLedgerIndex != other->mLedgerIndex)
+    if (getIndex () != other->getIndex ())
+        return false;
+
+    if (mDataBytes != other->mDataBytes)
         return false;
 
-    if (mData != other->mData)
+    if (memcmp (getData (), other->getData (), mDataBytes) != 0)
         return false;
 
     return true;
@@ -0,0 +1,548 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_SHARDSTOREIMP_H_INCLUDED
+#define RIPPLE_NODESTORE_SHARDSTOREIMP_H_INCLUDED
+
+namespace ripple {
+namespace NodeStore {
+
+/*  Each shard is a directory named after its index. It holds the backend
+    in the "nodes" subdirectory, and either a "ledgers" file listing the
+    ledgers stored so far or, once finalized, an empty "final" file.
+*/
+class ShardStoreImp
+    : public ShardStore
+    , public LeakChecked <ShardStoreImp>
+{
+public:
+    typedef std::list <uint32> OpenList;
+
+    struct Shard
+    {
+        Shard ()
+            : final (false)
+            , users (0)
+        {
+        }
+
+        // Nonexistent while the shard is being finalized
+        File directory;
+
+        // Ledgers stored, empty once the shard is finalized
+        RangeSet stored;
+
+        bool final;
+
+        // Opened on first use, closed when it's the least recently used
+        // of too many open shards and nothing is using it
+        std::shared_ptr <Backend> backend;
+
+        // Operations holding the backend
+        int users;
+
+        // Position in the list of open shards, valid while it's open
+        OpenList::iterator open;
+    };
+
+    typedef std::map <uint32, Shard> Shards;
+
+    String const m_name;
+    Manager& m_manager;
+    Scheduler& m_scheduler;
+    Parameters const m_parameters;
+    Journal m_journal;
+    File const m_path;
+    File const m_finalPath;
+    uint32 const m_ledgersPerShard;
+    std::size_t const m_openLimit;
+    std::mutex mutable m_mutex;
+    std::condition_variable m_released;
+    Shards m_shards;
+    // Shards with an open backend, least recently used first
+    OpenList m_open;
+    RangeSet m_complete;
+
+    ShardStoreImp (std::string const& name,
+                   Manager& manager,
+                   Scheduler& scheduler,
+                   Parameters const& parameters,
+                   Journal journal)
+        : m_name (name)
+        , m_manager (manager)
+        , m_scheduler (scheduler)
+        , m_parameters (parameters)
+        , m_journal (journal)
+        , m_path (getDirectory (parameters ["path"]))
+        , m_finalPath (getDirectory (parameters ["final_path"]))
+        , m_ledgersPerShard (parameters ["ledgers_per_shard"].isEmpty ()
+            ? uint32 (ledgersPerShardDefault)
+            : uint32 (std::max (1, parameters ["ledgers_per_shard"].getIntValue ())))
+        , m_openLimit (parameters ["open_shards"].isEmpty ()
+            ? std::size_t (openShardsDefault)
+            : std::size_t (std::max (1, parameters ["open_shards"].getIntValue ())))
+    {
+        if (m_path == File::nonexistent ())
+            throw std::runtime_error ("Missing path for the shard store");
+
+        createDirectory (m_path);
+        findShards (m_path);
+
+        if (m_finalPath != File::nonexistent ())
+        {
+            createDirectory (m_finalPath);
+            findShards (m_finalPath);
+        }
+
+        m_journal.info << "Found " << m_shards.size () << " shards holding ledgers " <<
+            m_complete.toString ();
+    }
+
+    ~ShardStoreImp ()
+    {
+    }
+
+    String getName () const
+    {
+        return m_name;
+    }
+
+    uint32 getLedgersPerShard () const
+    {
+        return m_ledgersPerShard;
+    }
+
+    uint32 getShardIndex (uint32 ledgerSeq) const
+    {
+        return (ledgerSeq == 0) ? 0 : ((ledgerSeq - 1) / m_ledgersPerShard);
+    }
+
+    uint32 getFirstLedger (uint32 index) const
+    {
+        return 1 + index * m_ledgersPerShard;
+    }
+
+    uint32 getLastLedger (uint32 index) const
+    {
+        return (index + 1) * m_ledgersPerShard;
+    }
+
+    //--------------------------------------------------------------------------
+
+    static File getDirectory (String const& path)
+    {
+        if (path.isEmpty ())
+            return File::nonexistent ();
+
+        return File::getCurrentWorkingDirectory ().getChildFile (path);
+    }
+
+    static void createDirectory (File const& directory)
+    {
+        Result const result (directory.createDirectory ());
+
+        if (result.failed ())
+            throw std::runtime_error ("Unable to create " +
+                directory.getFullPathName ().toStdString () + ": " +
+                    result.getErrorMessage ().toStdString ());
+    }
+
+    // Parse the output of RangeSet::toString
+    static void parseRanges (String const& text, RangeSet& ranges)
+    {
+        StringArray tokens;
+        tokens.addTokens (text, ",", String::empty);
+
+        for (int i = 0; i < tokens.size (); ++i)
+        {
+            String const token (tokens [i].trim ());
+            int const dash (token.indexOfChar ('-'));
+
+            if (token.isEmpty () || ! token.containsOnly ("0123456789-"))
+                continue;
+
+            if (dash < 0)
+                ranges.setValue (uint32 (token.getLargeIntValue ()));
+            else
+                ranges.setRange (uint32 (token.substring (0, dash).getLargeIntValue ()),
+                    uint32 (token.substring (dash + 1).getLargeIntValue ()));
+        }
+    }
+
+    // Add the shards found in a directory
+    void findShards (File const& path)
+    {
+        Array <File> directories;
+        path.findChildFiles (directories, File::findDirectories, false);
+
+        for (int i = 0; i < directories.size (); ++i)
+        {
+            File const& directory (directories [i]);
+            String const name (directory.getFileName ());
+
+            if (! name.containsOnly ("0123456789"))
+                continue;
+
+            uint32 const index (uint32 (name.getLargeIntValue ()));
+            Shard& shard (m_shards [index]);
+
+            // A move to the directory for finalized shards was interrupted
+            // before the original was removed, keep the moved copy.
+            if (shard.final)
+                shard.directory.deleteRecursively ();
+
+            shard.directory = directory;
+
+            if (directory.getChildFile ("final").existsAsFile ())
+            {
+                shard.final = true;
+                shard.stored = RangeSet ();
+                m_complete.setRange (getFirstLedger (index), getLastLedger (index));
+            }
+            else
+            {
+                parseRanges (directory.getChildFile ("ledgers").loadFileAsString (),
+                    shard.stored);
+
+                for (uint32 seq (shard.stored.getFirst ()); seq != RangeSet::absent;
+                    seq = shard.stored.getNext (seq))
+                    m_complete.setValue (seq);
+            }
+        }
+    }
+
+    /** A shard's backend held for one operation.
+        While this exists the backend stays open.
+    */
+    class BackendUse : public Uncopyable
+    {
+    public:
+        BackendUse (ShardStoreImp& owner, uint32 index,
+            std::shared_ptr <Backend> const& backend)
+            : m_owner (&owner)
+            , m_index (index)
+            , m_backend (backend)
+        {
+        }
+
+        BackendUse (BackendUse&& other)
+            : m_owner (other.m_owner)
+            , m_index (other.m_index)
+            , m_backend (std::move (other.m_backend))
+        {
+            other.m_backend.reset ();
+        }
+
+        ~BackendUse ()
+        {
+            if (m_backend != nullptr)
+                m_owner->release (m_index);
+        }
+
+        Backend* get () const
+        {
+            return m_backend.get ();
+        }
+
+        Backend* operator-> () const
+        {
+            return m_backend.get ();
+        }
+
+    private:
+        ShardStoreImp* m_owner;
+        uint32 m_index;
+        std::shared_ptr <Backend> m_backend;
+    };
+
+    // Return the backend for a shard, opening it if needed
+    BackendUse getBackend (uint32 index, bool forWrite)
+    {
+        std::vector <std::shared_ptr <Backend>> closed;
+        std::lock_guard <std::mutex> lock (m_mutex);
+
+        Shards::iterator iter (m_shards.find (index));
+
+        if (iter == m_shards.end ())
+        {
+            if (! forWrite)
+                return BackendUse (*this, index, nullptr);
+
+            iter = m_shards.insert (std::make_pair (index, Shard ())).first;
+            iter->second.directory = m_path.getChildFile (String (index));
+        }
+
+        Shard& shard (iter->second);
+
+        if ((forWrite && shard.final) || shard.directory == File::nonexistent ())
+            return BackendUse (*this, index, nullptr);
+
+        if (shard.backend == nullptr)
+        {
+            createDirectory (shard.directory);
+
+            Parameters parameters (m_parameters);
+            parameters.set ("path", shard.directory.getChildFile (
+                "nodes").getFullPathName ());
+
+            shard.backend = m_manager.make_Backend (
+                parameters, m_scheduler, m_journal);
+            shard.open = m_open.insert (m_open.end (), index);
+        }
+        else
+        {
+            m_open.splice (m_open.end (), m_open, shard.open);
+        }
+
+        ++shard.users;
+
+        closeIdle (closed);
+
+        return BackendUse (*this, index, shard.backend);
+    }
+
+    void release (uint32 index)
+    {
+        // Closing flushes the backend, so do it after unlocking
+        std::vector <std::shared_ptr <Backend>> closed;
+        std::lock_guard <std::mutex> lock (m_mutex);
+
+        Shard& shard (m_shards [index]);
+
+        bassert (shard.users > 0);
+        if (--shard.users == 0)
+        {
+            m_released.notify_all ();
+            closeIdle (closed);
+        }
+    }
+
+    // Close the least recently used shards nothing is using, down to the limit
+    void closeIdle (std::vector <std::shared_ptr <Backend>>& closed)
+    {
+        for (OpenList::iterator iter (m_open.begin ());
+            m_open.size () > m_openLimit && iter != m_open.end ();)
+        {
+            Shard& shard (m_shards [*iter]);
+
+            if (shard.users == 0)
+            {
+                closed.push_back (std::move (shard.backend));
+                shard.backend.reset ();
+                iter = m_open.erase (iter);
+            }
+            else
+            {
+                ++iter;
+            }
+        }
+    }
+
+    //--------------------------------------------------------------------------
+
+    NodeObject::pointer fetch (uint256 const& hash, uint32 ledgerSeq)
+    {
+        NodeObject::Ptr object;
+
+        BackendUse const backend (getBackend (getShardIndex (ledgerSeq), false));
+
+        if (backend.get () == nullptr)
+            return object;
+
+        Status const status = backend->fetch (hash.begin (), &object);
+
+        switch (status)
+        {
+        case ok:
+        case notFound:
+            break;
+
+        case dataCorrupt:
+            m_journal.fatal << "Corrupt NodeObject #" << hash << " in shard " <<
+                getShardIndex (ledgerSeq);
+            break;
+
+        default:
+            m_journal.warning << "Unknown status=" << status;
+            break;
+        }
+
+        return object;
+    }
+
+    void store (NodeObject::ref object, uint32 ledgerSeq)
+    {
+        BackendUse const backend (getBackend (getShardIndex (ledgerSeq), true));
+
+        if (backend.get () != nullptr)
+            backend->store (object);
+    }
+
+    void setStored (uint32 ledgerSeq)
+    {
+        uint32 const index (getShardIndex (ledgerSeq));
+
+        {
+            BackendUse const backend (getBackend (index, true));
+
+            if (backend.get () == nullptr)
+                return;
+
+            // The ledger's objects must reach the backend before it is recorded
+            backend->waitForWriting ();
+        }
+
+        File directory;
+        std::shared_ptr <Backend> backend;
+
+        {
+            std::unique_lock <std::mutex> lock (m_mutex);
+
+            Shard& shard (m_shards [index]);
+
+            if (shard.final)
+                return;
+
+            shard.stored.setValue (ledgerSeq);
+            m_complete.setValue (ledgerSeq);
+
+            if (shard.stored.prevMissing (getLastLedger (index) + 1) >=
+                getFirstLedger (index))
+            {
+                shard.directory.getChildFile ("ledgers").replaceWithText (
+                    shard.stored.toString ());
+                return;
+            }
+
+            // Complete, nothing may write or open it from now on
+            directory = shard.directory;
+            shard.directory = File::nonexistent ();
+            shard.final = true;
+            shard.stored = RangeSet ();
+
+            // Wait for fetches in progress
+            m_released.wait (lock, [&shard] { return shard.users == 0; });
+
+            if (shard.backend != nullptr)
+            {
+                backend = std::move (shard.backend);
+                shard.backend.reset ();
+                m_open.erase (shard.open);
+            }
+        }
+
+        finalize (index, std::move (backend), directory);
+    }
+
+    void finalize (uint32 index, std::shared_ptr <Backend> backend,
+        File const& directory)
+    {
+        // Close it to flush everything
+        backend.reset ();
+
+        directory.getChildFile ("final").create ();
+        directory.getChildFile ("ledgers").deleteFile ();
+
+        File destination (directory);
+
+        if (m_finalPath != File::nonexistent ())
+        {
+            File const target (m_finalPath.getChildFile (String (index)));
+
+            if (moveShard (directory, target))
+                destination = target;
+            else
+                m_journal.warning << "Unable to move shard " << index <<
+                    " to " << target.getFullPathName ();
+        }
+
+        {
+            std::lock_guard <std::mutex> lock (m_mutex);
+            m_shards [index].directory = destination;
+        }
+
+        m_journal.info << "Finalized shard " << index << " in " <<
+            destination.getFullPathName ();
+    }
+
+    static bool moveShard (File const& from, File const& to)
+    {
+        if (from.moveFileTo (to))
+            return true;
+
+        // On another volume, copy under a name which isn't a shard's so a
+        // partial copy is never mistaken for one
+        File const temp (to.getSiblingFile (to.getFileName () + ".partial"));
+        temp.deleteRecursively ();
+
+        return from.copyDirectoryTo (temp) && temp.moveFileTo (to) &&
+            from.deleteRecursively ();
+    }
+
+    bool hasLedger (uint32 ledgerSeq)
+    {
+        std::lock_guard <std::mutex> lock (m_mutex);
+        return m_complete.hasValue (ledgerSeq);
+    }
+
+    uint32 prevMissing (uint32 ledgerSeq)
+    {
+        std::lock_guard <std::mutex> lock (m_mutex);
+        return m_complete.prevMissing (ledgerSeq);
+    }
+
+    std::string getCompleteLedgers ()
+    {
+        std::lock_guard <std::mutex> lock (m_mutex);
+        return m_complete.toString ();
+    }
+
+    std::vector <uint32> getFinalShards ()
+    {
+        std::vector <uint32> result;
+
+        std::lock_guard <std::mutex> lock (m_mutex);
+
+        for (Shards::const_iterator iter (m_shards.begin ());
+            iter != m_shards.end (); ++iter)
+            if (iter->second.final)
+                result.push_back (iter->first);
+
+        return result;
+    }
+
+    int getWriteLoad ()
+    {
+        int load (0);
+
+        std::lock_guard <std::mutex> lock (m_mutex);
+
+        for (Shards::const_iterator iter (m_shards.begin ());
+            iter != m_shards.end (); ++iter)
+            if (iter->second.backend != nullptr)
+                load += iter->second.backend->getWriteLoad ();
+
+        return load;
+    }
+};
+
+}
+}
+
+#endif
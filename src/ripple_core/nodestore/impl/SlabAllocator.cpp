@@ -0,0 +1,402 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+namespace ripple {
+namespace NodeStore {
+
+struct SlabAllocator::FreeBlock
+{
+    FreeBlock* next;
+};
+
+// Sits at the start of each slab
+struct SlabAllocator::Slab
+{
+    // Blocks in this slab which were freed
+    FreeBlock* freeList;
+    // The part of the slab not carved into blocks yet
+    uint8* carve;
+    uint8* end;
+    // Blocks handed to threads
+    std::size_t used;
+    // Links in the list of the size class which holds the slab
+    Slab* prev;
+    Slab* next;
+
+    bool isFull (std::size_t blockBytes) const
+    {
+        return freeList == nullptr && std::size_t (end - carve) < blockBytes;
+    }
+
+    // Blocks start after the header, keeping their alignment
+    static std::size_t headerBytes ()
+    {
+        return (sizeof (Slab) + granularity - 1) &
+            ~std::size_t (granularity - 1);
+    }
+
+    static Slab* fromBlock (void* p)
+    {
+        return reinterpret_cast <Slab*> (
+            reinterpret_cast <std::uintptr_t> (p) & ~std::uintptr_t (slabBytes - 1));
+    }
+};
+
+struct SlabAllocator::SlabList
+{
+    SlabList ()
+        : head (nullptr)
+        , tail (nullptr)
+    {
+    }
+
+    void push_front (Slab* slab)
+    {
+        slab->prev = nullptr;
+        slab->next = head;
+        if (head != nullptr)
+            head->prev = slab;
+        else
+            tail = slab;
+        head = slab;
+    }
+
+    void push_back (Slab* slab)
+    {
+        slab->prev = tail;
+        slab->next = nullptr;
+        if (tail != nullptr)
+            tail->next = slab;
+        else
+            head = slab;
+        tail = slab;
+    }
+
+    void remove (Slab* slab)
+    {
+        if (slab->prev != nullptr)
+            slab->prev->next = slab->next;
+        else
+            head = slab->next;
+        if (slab->next != nullptr)
+            slab->next->prev = slab->prev;
+        else
+            tail = slab->prev;
+    }
+
+    Slab* head;
+    Slab* tail;
+};
+
+//------------------------------------------------------------------------------
+
+namespace {
+
+void* allocateSlab ()
+{
+#if BEAST_WIN32
+    void* p (_aligned_malloc (SlabAllocator::slabBytes,
+        SlabAllocator::slabBytes));
+#else
+    void* p (nullptr);
+    if (posix_memalign (&p, SlabAllocator::slabBytes,
+            SlabAllocator::slabBytes) != 0)
+        p = nullptr;
+#endif
+    if (p == nullptr)
+        throw std::bad_alloc ();
+    return p;
+}
+
+void freeSlab (void* p)
+{
+#if BEAST_WIN32
+    _aligned_free (p);
+#else
+    free (p);
+#endif
+}
+
+}
+
+//------------------------------------------------------------------------------
+
+struct SlabAllocator::SizeClass
+{
+    explicit SizeClass (std::size_t blockBytes_)
+        : blockBytes (blockBytes_)
+        , batchBlocks (std::max <std::size_t> (1, batchBytes / blockBytes_))
+        , emptySlabs (0)
+    {
+    }
+
+    ~SizeClass ()
+    {
+        for (SlabList* list : { &available, &full })
+        {
+            while (list->head != nullptr)
+            {
+                Slab* const slab (list->head);
+                list->remove (slab);
+                freeSlab (slab);
+            }
+        }
+    }
+
+    std::size_t const blockBytes;
+    std::size_t const batchBlocks;
+    std::mutex mutex;
+    // Slabs with free blocks, the empty ones at the back
+    SlabList available;
+    SlabList full;
+    std::size_t emptySlabs;
+};
+
+// The blocks of one size class held by a thread
+struct SlabAllocator::Bin
+{
+    FreeBlock* head;
+    std::size_t count;
+};
+
+struct SlabAllocator::ThreadCache
+{
+    explicit ThreadCache (SlabAllocator& owner_)
+        : owner (owner_)
+    {
+        for (Bin& bin : bins)
+        {
+            bin.head = nullptr;
+            bin.count = 0;
+        }
+    }
+
+    SlabAllocator& owner;
+    Bin bins [maxBlockBytes / granularity];
+};
+
+//------------------------------------------------------------------------------
+
+SlabAllocator::SlabAllocator ()
+    : m_reserved (0)
+    , m_used (0)
+    , m_cache (&SlabAllocator::releaseThreadCache)
+{
+    m_classes.reserve (maxBlockBytes / granularity);
+    for (std::size_t bytes = granularity; bytes <= maxBlockBytes;
+        bytes += granularity)
+    {
+        m_classes.push_back (std::make_unique <SizeClass> (bytes));
+    }
+}
+
+SlabAllocator::~SlabAllocator ()
+{
+}
+
+SlabAllocator& SlabAllocator::getInstance ()
+{
+    static SlabAllocator* const instance (new SlabAllocator);
+    return *instance;
+}
+
+void* SlabAllocator::allocate (std::size_t bytes)
+{
+    if (bytes == 0)
+        bytes = 1;
+
+    if (bytes > maxBlockBytes)
+    {
+        m_reserved += bytes;
+        m_used += bytes;
+        return ::operator new (bytes);
+    }
+
+    std::size_t const index ((bytes - 1) / granularity);
+    Bin& bin (getThreadCache ().bins [index]);
+
+    if (bin.head == nullptr)
+        fill (*m_classes [index], bin);
+
+    FreeBlock* const block (bin.head);
+    bin.head = block->next;
+    --bin.count;
+    return block;
+}
+
+void SlabAllocator::deallocate (void* p, std::size_t bytes)
+{
+    if (p == nullptr)
+        return;
+
+    if (bytes == 0)
+        bytes = 1;
+
+    if (bytes > maxBlockBytes)
+    {
+        m_reserved -= bytes;
+        m_used -= bytes;
+        ::operator delete (p);
+        return;
+    }
+
+    std::size_t const index ((bytes - 1) / granularity);
+    SizeClass& c (*m_classes [index]);
+    Bin& bin (getThreadCache ().bins [index]);
+
+    FreeBlock* const block (static_cast <FreeBlock*> (p));
+    block->next = bin.head;
+    bin.head = block;
+
+    // Keep a batch for the next allocations and return the rest
+    if (++bin.count >= 2 * c.batchBlocks)
+        drain (c, bin, c.batchBlocks);
+}
+
+SlabAllocator::Stats SlabAllocator::getStats ()
+{
+    Stats stats;
+    stats.reserved = m_reserved;
+    stats.used = m_used;
+    return stats;
+}
+
+//------------------------------------------------------------------------------
+
+SlabAllocator::ThreadCache& SlabAllocator::getThreadCache ()
+{
+    ThreadCache* cache (m_cache.get ());
+
+    if (cache == nullptr)
+    {
+        cache = new ThreadCache (*this);
+        m_cache.reset (cache);
+    }
+
+    return *cache;
+}
+
+void SlabAllocator::releaseThreadCache (ThreadCache* cache)
+{
+    SlabAllocator& owner (cache->owner);
+
+    for (std::size_t index = 0; index < owner.m_classes.size (); ++index)
+    {
+        Bin& bin (cache->bins [index]);
+        if (bin.count > 0)
+            owner.drain (*owner.m_classes [index], bin, bin.count);
+    }
+
+    delete cache;
+}
+
+void SlabAllocator::fill (SizeClass& c, Bin& bin)
+{
+    std::lock_guard <std::mutex> lock (c.mutex);
+
+    for (std::size_t n = 0; n < c.batchBlocks; ++n)
+    {
+        Slab* slab (c.available.head);
+
+        if (slab == nullptr)
+        {
+            uint8* const p (static_cast <uint8*> (allocateSlab ()));
+            slab = reinterpret_cast <Slab*> (p);
+            slab->freeList = nullptr;
+            slab->carve = p + Slab::headerBytes ();
+            slab->end = p + slabBytes;
+            slab->used = 0;
+            c.available.push_front (slab);
+            ++c.emptySlabs;
+            m_reserved += slabBytes;
+        }
+
+        FreeBlock* block;
+        if (slab->freeList != nullptr)
+        {
+            block = slab->freeList;
+            slab->freeList = block->next;
+        }
+        else
+        {
+            block = reinterpret_cast <FreeBlock*> (slab->carve);
+            slab->carve += c.blockBytes;
+        }
+
+        if (slab->used++ == 0)
+            --c.emptySlabs;
+
+        if (slab->isFull (c.blockBytes))
+        {
+            c.available.remove (slab);
+            c.full.push_front (slab);
+        }
+
+        block->next = bin.head;
+        bin.head = block;
+        ++bin.count;
+    }
+
+    m_used += c.batchBlocks * c.blockBytes;
+}
+
+void SlabAllocator::drain (SizeClass& c, Bin& bin, std::size_t n)
+{
+    std::lock_guard <std::mutex> lock (c.mutex);
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        FreeBlock* const block (bin.head);
+        bin.head = block->next;
+        --bin.count;
+
+        Slab* const slab (Slab::fromBlock (block));
+
+        if (slab->isFull (c.blockBytes))
+        {
+            c.full.remove (slab);
+            c.available.push_front (slab);
+        }
+
+        block->next = slab->freeList;
+        slab->freeList = block;
+
+        if (--slab->used == 0)
+        {
+            c.available.remove (slab);
+
+            if (c.emptySlabs < emptySlabsKept)
+            {
+                // Used last, so that it stays empty if the class shrinks
+                c.available.push_back (slab);
+                ++c.emptySlabs;
+            }
+            else
+            {
+                freeSlab (slab);
+                m_reserved -= slabBytes;
+            }
+        }
+    }
+
+    m_used -= n * c.blockBytes;
+}
+
+}
+}
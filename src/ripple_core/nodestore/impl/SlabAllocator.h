@@ -0,0 +1,192 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_SLABALLOCATOR_H_INCLUDED
+#define RIPPLE_NODESTORE_SLABALLOCATOR_H_INCLUDED
+
+namespace ripple {
+namespace NodeStore {
+
+/** Size class allocator for node objects.
+
+    Requests are rounded up to a multiple of the granularity and served
+    from slabs holding blocks of that size. There is no per-block header,
+    and blocks of one size are packed together instead of being scattered
+    through the heap. Requests too large for any size class go to the
+    system heap.
+
+    Each thread keeps a few blocks of every size class it uses, so most
+    requests take no lock. The thread moves blocks to and from the shared
+    slabs in batches, and returns what it holds when it exits.
+
+    Slabs are aligned to their size, so a freed block finds its slab from
+    its address. A slab whose blocks are all free is released to the system
+    once its size class already has enough empty slabs in reserve, which
+    keeps a class hovering around a slab boundary from churning the heap.
+
+    @note This can be called concurrently.
+*/
+class SlabAllocator : public Uncopyable
+{
+public:
+    enum
+    {
+        // Block sizes are a multiple of this, which is also the alignment
+        granularity = 16,
+
+        // Largest block served from a slab
+        maxBlockBytes = 4096,
+
+        // Size and alignment of each slab carved into blocks
+        slabBytes = 64 * 1024,
+
+        // Bytes of each size class moved to or from a thread at once
+        batchBytes = 4 * 1024,
+
+        // Empty slabs each size class keeps instead of releasing
+        emptySlabsKept = 2
+    };
+
+    SlabAllocator ();
+
+    /** Destroy the allocator.
+        No other thread may still hold blocks from it in its cache.
+    */
+    ~SlabAllocator ();
+
+    /** Returns the allocator used for node objects.
+        It is never destroyed, since objects may still be released while
+        other statics are destroyed.
+    */
+    static SlabAllocator& getInstance ();
+
+    /** Allocate a block of at least the given size. */
+    void* allocate (std::size_t bytes);
+
+    /** Free a block.
+        @param bytes The size passed when the block was allocated.
+    */
+    void deallocate (void* p, std::size_t bytes);
+
+    struct Stats
+    {
+        // Bytes obtained for slabs and large blocks
+        std::size_t reserved;
+
+        // Bytes in blocks which are allocated or held by threads
+        std::size_t used;
+    };
+
+    /** Retrieve memory usage. This is used for diagnostics. */
+    Stats getStats ();
+
+    //--------------------------------------------------------------------------
+
+    /** A standard allocator drawing from the node object allocator. */
+    template <class T>
+    struct Allocator
+    {
+        typedef T value_type;
+        typedef T* pointer;
+        typedef T const* const_pointer;
+        typedef T& reference;
+        typedef T const& const_reference;
+        typedef std::size_t size_type;
+        typedef std::ptrdiff_t difference_type;
+
+        template <class U>
+        struct rebind
+        {
+            typedef Allocator <U> other;
+        };
+
+        Allocator ()
+        {
+        }
+
+        template <class U>
+        Allocator (Allocator <U> const&)
+        {
+        }
+
+        T* allocate (std::size_t n, void const* = nullptr)
+        {
+            return static_cast <T*> (getInstance ().allocate (n * sizeof (T)));
+        }
+
+        void deallocate (T* p, std::size_t n)
+        {
+            getInstance ().deallocate (p, n * sizeof (T));
+        }
+
+        std::size_t max_size () const
+        {
+            return std::size_t (-1) / sizeof (T);
+        }
+
+        template <class U, class... Args>
+        void construct (U* p, Args&&... args)
+        {
+            new (p) U (std::forward <Args> (args)...);
+        }
+
+        template <class U>
+        void destroy (U* p)
+        {
+            p->~U ();
+        }
+
+        template <class U>
+        bool operator== (Allocator <U> const&) const
+        {
+            return true;
+        }
+
+        template <class U>
+        bool operator!= (Allocator <U> const&) const
+        {
+            return false;
+        }
+    };
+
+private:
+    struct FreeBlock;
+    struct Slab;
+    struct SlabList;
+    struct SizeClass;
+    struct Bin;
+    struct ThreadCache;
+
+    ThreadCache& getThreadCache ();
+    static void releaseThreadCache (ThreadCache* cache);
+    void fill (SizeClass& c, Bin& bin);
+    void drain (SizeClass& c, Bin& bin, std::size_t n);
+
+    std::vector <std::unique_ptr <SizeClass>> m_classes;
+    std::atomic <std::size_t> m_reserved;
+    std::atomic <std::size_t> m_used;
+
+    // Declared last so that the destroying thread's cache is returned first
+    boost::thread_specific_ptr <ThreadCache> m_cache;
+};
+
+}
+}
+
+#endif
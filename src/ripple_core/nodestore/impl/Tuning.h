@@ -30,6 +30,25 @@ enum
 
     // Expiration time for cached nodes
     ,cacheTargetSeconds = 300
+
+    // Default size of the compressed cache, in megabytes. It only pays
+    // for itself over backends with expensive reads, so it is off.
+    ,compressedCacheMegabytesDefault = 0
+
+    // Default limit on the number of objects written by one batch
+    ,batchWriteSizeDefault = 1024
+
+    // Default time a partial batch waits for more objects, in milliseconds
+    ,batchWriteLatencyDefault = 0
+
+    // Default number of pending objects at which stores start to block
+    ,writeQueueLimitDefault = 65536
+
+    // Default number of ledgers in each shard of the shard store
+    ,ledgersPerShardDefault = 16384
+
+    // Default number of shards whose backends are kept open at once
+    ,openShardsDefault = 8
 };
 
 }
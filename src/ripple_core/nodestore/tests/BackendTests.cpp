@@ -66,6 +66,25 @@ public:
                 fetchCopyOfBatch (*backend, &copy, batch);
                 expect (areBatchesEqual (batch, copy), "Should be equal");
             }
+
+            {
+                // Read it back with a single batched fetch, including a
+                // key which is not present
+                Batch missing;
+                createPredictableBatch (missing, numObjectsToTest, 1, seedValue);
+
+                std::vector <void const*> keys;
+                for (auto const& object : batch)
+                    keys.push_back (object->getHash ().begin ());
+                keys.push_back (missing [0]->getHash ().begin ());
+
+                Batch copy;
+                backend->fetchBatch (keys, &copy);
+                expect (copy.size () == keys.size (), "Should be one per key");
+                expect (copy.back () == nullptr, "Should not be found");
+                copy.pop_back ();
+                expect (areBatchesEqual (batch, copy), "Should be equal");
+            }
         }
 
         {
@@ -83,6 +102,99 @@ public:
         }
     }
 
+    // Make sure the append backend recovers when its index is lost
+    void testAppendRecovery (int64 const seedValue, int numObjectsToTest = 2000)
+    {
+        std::unique_ptr <Manager> manager (make_Manager ());
+
+        DummyScheduler scheduler;
+
+        beginTestCase ("Append index recovery");
+
+        StringPairArray params;
+        File const path (File::createTempFile ("node_db"));
+        params.set ("type", "append");
+        params.set ("path", path.getFullPathName ());
+        params.set ("segment_mb", "1");
+
+        Batch batch;
+        createPredictableBatch (batch, 0, numObjectsToTest, seedValue);
+
+        Journal j ((journal ()));
+
+        {
+            std::unique_ptr <Backend> backend (manager->make_Backend (
+                params, scheduler, j));
+
+            backend->storeBatch (batch);
+        }
+
+        // Small segments force the batch to span several files
+        expect (path.getChildFile ("segment.000002").existsAsFile (),
+            "Should use several segments");
+        expect (path.getChildFile ("index").deleteFile ());
+
+        {
+            std::unique_ptr <Backend> backend (manager->make_Backend (
+                params, scheduler, j));
+
+            Batch copy;
+            fetchCopyOfBatch (*backend, &copy, batch);
+            expect (areBatchesEqual (batch, copy), "Should be equal");
+
+            // Storing again must not duplicate anything
+            backend->storeBatch (batch);
+
+            struct Counter : VisitCallback
+            {
+                int count;
+                Counter () : count (0) { }
+                void visitObject (NodeObject::Ptr const&) { ++count; }
+            };
+
+            Counter counter;
+            backend->visitAll (counter);
+            expect (counter.count == numObjectsToTest, "Should visit each object once");
+        }
+    }
+
+    // Make sure objects written one at a time through a small write
+    // queue all arrive, and are counted.
+    void testBatchWriter (String type, int64 const seedValue, int numObjectsToTest = 2000)
+    {
+        std::unique_ptr <Manager> manager (make_Manager ());
+
+        DummyScheduler scheduler;
+
+        beginTestCase (String ("BatchWriter type=") + type);
+
+        StringPairArray params;
+        File const path (File::createTempFile ("node_db"));
+        params.set ("type", type);
+        params.set ("path", path.getFullPathName ());
+        params.set ("batch_size", "64");
+        params.set ("write_queue_limit", "16");
+
+        Batch batch;
+        createPredictableBatch (batch, 0, numObjectsToTest, seedValue);
+
+        Journal j ((journal ()));
+
+        std::unique_ptr <Backend> backend (manager->make_Backend (
+            params, scheduler, j));
+
+        storeBatch (*backend, batch);
+
+        WriteStats const stats (backend->getWriteStats ());
+        expect (stats.objects == numObjectsToTest, "Should count each object");
+        expect (stats.batches > 0, "Should count batches");
+        expect (stats.maxMicroseconds >= stats.lastMicroseconds);
+
+        Batch copy;
+        fetchCopyOfBatch (*backend, &copy, batch);
+        expect (areBatchesEqual (batch, copy), "Should be equal");
+    }
+
     //--------------------------------------------------------------------------
 
     void runTest ()
@@ -91,6 +203,12 @@ public:
 
         testBackend ("leveldb", seedValue);
 
+        testBackend ("append", seedValue);
+
+        testAppendRecovery (seedValue);
+
+        testBatchWriter ("leveldb", seedValue);
+
     #ifdef RIPPLE_ENABLE_SQLITE_BACKEND_TESTS
         testBackend ("sqlite", seedValue);
     #endif
@@ -74,6 +74,32 @@ public:
         }
     }
 
+    // Checks that freed slabs go back to the system
+    void testAllocator ()
+    {
+        beginTestCase ("allocator");
+
+        SlabAllocator allocator;
+        std::size_t const bytes (100);
+
+        std::vector <void*> blocks;
+        for (int i = 0; i < 10000; ++i)
+        {
+            blocks.push_back (allocator.allocate (bytes));
+            memset (blocks.back (), i, bytes);
+        }
+
+        SlabAllocator::Stats const peak (allocator.getStats ());
+        expect (peak.used >= blocks.size () * bytes, "Should count used bytes");
+
+        for (void* p : blocks)
+            allocator.deallocate (p, bytes);
+
+        SlabAllocator::Stats const after (allocator.getStats ());
+        expect (after.reserved < peak.reserved / 2, "Should release empty slabs");
+        expect (after.used < peak.used, "Should count freed bytes");
+    }
+
     void runTest ()
     {
         int64 const seedValue = 50;
@@ -81,6 +107,8 @@ public:
         testBatches (seedValue);
 
         testBlobs (seedValue);
+
+        testAllocator ();
     }
 };
 
@@ -0,0 +1,569 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+namespace ripple {
+namespace NodeStore {
+
+/** Benchmarks the backends with workloads shaped like ledger history.
+
+    Run it with --unittest=NodeStoreBenchmark. It is configured through the
+    RIPPLE_NODESTORE_BENCHMARK environment variable, which holds key/value
+    pairs in the same '|' delimited format as the [node_db] section:
+
+        objects         Objects written before the reads (default 1000000)
+        reads           Objects read by each read workload (default 1000000)
+        ledger_size     Objects in each simulated ledger (default 256)
+        backends        Comma separated types (default every registered one)
+        path            Directory for the databases (default temp directory)
+        output          File to append the results to
+        seed            Seed for generating the objects (default 50)
+
+    Each result is one line of JSON holding the backend, the workload, the
+    number of timed operations and of objects, the objects per second, and
+    the 50th, 99th and 99.9th percentile operation latency in nanoseconds.
+    The on-disk size is reported the same way once the writes are done.
+*/
+class BenchmarkTests : public TestBase
+{
+public:
+    enum
+    {
+        // Roughly the size of a serialized inner node
+        innerNodeBytes = 516,
+
+        // Reads for each store in the mixed workload
+        mixedReadsPerWrite = 10
+    };
+
+    typedef std::chrono::high_resolution_clock clock_type;
+
+    BenchmarkTests ()
+        : TestBase ("NodeStoreBenchmark", UnitTest::runManual)
+    {
+    }
+
+    //--------------------------------------------------------------------------
+
+    // Creates objects resembling the nodes of ledger trees. Half are inner
+    // nodes and the rest are small leaves, grouped into ledgers by index.
+    //
+    class LedgerObjectFactory
+    {
+    public:
+        LedgerObjectFactory (int64 seedValue, int64 ledgerSize)
+            : m_seedValue (seedValue)
+            , m_ledgerSize (ledgerSize)
+        {
+        }
+
+        uint256 getHash (int64 index) const
+        {
+            Random r (m_seedValue + index);
+
+            uint256 hash;
+            r.fillBitsRandomly (hash.begin (), hash.size ());
+
+            return hash;
+        }
+
+        NodeObject::Ptr createObject (int64 index) const
+        {
+            Random r (m_seedValue + index);
+
+            // The hash comes first so getHash can stop there
+            uint256 hash;
+            r.fillBitsRandomly (hash.begin (), hash.size ());
+
+            NodeObjectType type (hotACCOUNT_NODE);
+            int bytes;
+            int const kind (r.nextInt (16));
+
+            if (kind < 8)
+            {
+                bytes = innerNodeBytes;
+            }
+            else if (kind < 14)
+            {
+                bytes = 64 + r.nextInt (192);
+            }
+            else
+            {
+                type = hotTRANSACTION_NODE;
+                bytes = 128 + r.nextInt (384);
+            }
+
+            Blob data (bytes);
+            r.fillBitsRandomly (data.data (), bytes);
+
+            return NodeObject::createObject (type,
+                LedgerIndex (1 + index / m_ledgerSize), data, hash);
+        }
+
+        // Create the objects of one ledger, stopping at the given count
+        void createLedger (Batch& batch, int64 ledger, int64 count) const
+        {
+            int64 const last (std::min (count, (ledger + 1) * m_ledgerSize));
+
+            batch.clear ();
+            batch.reserve (m_ledgerSize);
+
+            for (int64 index = ledger * m_ledgerSize; index < last; ++index)
+                batch.push_back (createObject (index));
+        }
+
+        // Get the hashes of one ledger, stopping at the given count
+        void getLedgerHashes (std::vector <uint256>& hashes,
+            int64 ledger, int64 count) const
+        {
+            int64 const last (std::min (count, (ledger + 1) * m_ledgerSize));
+
+            hashes.clear ();
+            hashes.reserve (m_ledgerSize);
+
+            for (int64 index = ledger * m_ledgerSize; index < last; ++index)
+                hashes.push_back (getHash (index));
+        }
+
+    private:
+        int64 const m_seedValue;
+        int64 const m_ledgerSize;
+    };
+
+    //--------------------------------------------------------------------------
+
+    // Runs tasks on a thread of its own so the batch writer groups
+    // stores together the way it does in the server.
+    //
+    class ThreadScheduler : public Scheduler
+    {
+    public:
+        ThreadScheduler ()
+            : m_stop (false)
+            , m_thread (&ThreadScheduler::run, this)
+        {
+        }
+
+        ~ThreadScheduler ()
+        {
+            {
+                std::lock_guard <std::mutex> lock (m_mutex);
+                m_stop = true;
+            }
+            m_cond.notify_one ();
+            m_thread.join ();
+        }
+
+        void scheduleTask (Task& task)
+        {
+            {
+                std::lock_guard <std::mutex> lock (m_mutex);
+                m_tasks.push_back (&task);
+            }
+            m_cond.notify_one ();
+        }
+
+    private:
+        void run ()
+        {
+            std::unique_lock <std::mutex> lock (m_mutex);
+
+            for (;;)
+            {
+                while (m_tasks.empty () && ! m_stop)
+                    m_cond.wait (lock);
+
+                if (m_tasks.empty ())
+                    break;
+
+                Task* const task (m_tasks.front ());
+                m_tasks.pop_front ();
+
+                lock.unlock ();
+                task->performScheduledTask ();
+                lock.lock ();
+            }
+        }
+
+        std::mutex m_mutex;
+        std::condition_variable m_cond;
+        std::deque <Task*> m_tasks;
+        bool m_stop;
+        std::thread m_thread;
+    };
+
+    //--------------------------------------------------------------------------
+
+    // Picks the index of one of count objects. The n-th newest object is
+    // picked with probability proportional to 1/n, so recent objects are
+    // reused far more often than old ones.
+    static int64 pickIndex (Random& r, int64 count)
+    {
+        int64 const age (static_cast <int64> (
+            std::pow (double (count), r.nextDouble ())) - 1);
+
+        return count - 1 - std::min (age, count - 1);
+    }
+
+    static uint64 getNanoseconds (clock_type::duration elapsed)
+    {
+        return std::chrono::duration_cast <std::chrono::nanoseconds> (
+            elapsed).count ();
+    }
+
+    static double getSeconds (clock_type::duration elapsed)
+    {
+        return std::chrono::duration_cast <std::chrono::duration <double>> (
+            elapsed).count ();
+    }
+
+    static int64 getParameter (Parameters const& config,
+        String const& key, int64 defaultValue)
+    {
+        String const value (config [key]);
+
+        if (value.isEmpty ())
+            return defaultValue;
+
+        return std::max (int64 (1), value.getLargeIntValue ());
+    }
+
+    // Total size of the files a backend uses
+    static int64 getDiskSize (File const& path)
+    {
+        if (! path.isDirectory ())
+            return path.getSize ();
+
+        Array <File> files;
+        path.findChildFiles (files, File::findFiles, true);
+
+        int64 bytes (0);
+        for (int i = 0; i < files.size (); ++i)
+            bytes += files [i].getSize ();
+
+        return bytes;
+    }
+
+    void emit (Json::Value const& result)
+    {
+        std::string const s (Json::FastWriter ().write (result));
+
+        logMessage (String (s).trimEnd ());
+
+        if (m_output != File::nonexistent ())
+            m_output.appendText (s);
+    }
+
+    void report (String const& type, String const& workload, int64 objects,
+        clock_type::duration elapsed, LatencyHistogram const& latency)
+    {
+        double const seconds (getSeconds (elapsed));
+
+        Json::Value result (Json::objectValue);
+        result ["backend"] = type.toStdString ();
+        result ["workload"] = workload.toStdString ();
+        result ["operations"] = double (latency.count ());
+        result ["objects"] = double (objects);
+        result ["seconds"] = seconds;
+        result ["objects_per_second"] = (seconds > 0) ? (objects / seconds) : 0.0;
+        result ["p50_ns"] = double (latency.percentile (50));
+        result ["p99_ns"] = double (latency.percentile (99));
+        result ["p999_ns"] = double (latency.percentile (99.9));
+        result ["max_ns"] = double (latency.max ());
+
+        emit (result);
+    }
+
+    //--------------------------------------------------------------------------
+
+    void benchmarkBackend (Manager& manager, String const& type,
+        Parameters const& config)
+    {
+        beginTestCase (String ("Benchmarking backend '") + type + "'");
+
+        if (manager.find (type.toStdString ()) == nullptr)
+        {
+            fail (String ("Unknown backend type '") + type + "'");
+            return;
+        }
+
+        int64 const numObjects (getParameter (config, "objects", 1000000));
+        int64 const numReads (getParameter (config, "reads", 1000000));
+        int64 const ledgerSize (getParameter (config, "ledger_size", 256));
+        int64 const seedValue (getParameter (config, "seed", 50));
+
+        int64 const numLedgers ((numObjects + ledgerSize - 1) / ledgerSize);
+
+        File const path (config ["path"].isEmpty ()
+            ? File::createTempFile ("node_db")
+            : File (config ["path"]).getNonexistentChildFile (
+                String ("node_db_") + type, String::empty, false));
+
+        StringPairArray params;
+        params.set ("type", type);
+        params.set ("path", path.getFullPathName ());
+
+        LedgerObjectFactory const factory (seedValue, ledgerSize);
+        Journal j ((journal ()));
+
+        {
+            // Declared first so it outlives the backend's writes
+            ThreadScheduler scheduler;
+
+            std::unique_ptr <Backend> backend (manager.make_Backend (
+                params, scheduler, j));
+
+            // Bulk write, one ledger at a time
+            {
+                LatencyHistogram latency;
+                clock_type::duration elapsed (clock_type::duration::zero ());
+
+                Batch batch;
+                for (int64 ledger = 0; ledger < numLedgers; ++ledger)
+                {
+                    factory.createLedger (batch, ledger, numObjects);
+
+                    clock_type::time_point const start (clock_type::now ());
+                    backend->storeBatch (batch);
+                    clock_type::duration const d (clock_type::now () - start);
+
+                    latency.record (getNanoseconds (d));
+                    elapsed += d;
+                }
+
+                report (type, "write", numObjects, elapsed, latency);
+            }
+
+            // Reads with power law reuse of recent objects
+            {
+                Random r (seedValue);
+                LatencyHistogram latency;
+                clock_type::duration elapsed (clock_type::duration::zero ());
+                int64 found (0);
+
+                for (int64 i = 0; i < numReads; ++i)
+                {
+                    uint256 const hash (factory.getHash (
+                        pickIndex (r, numObjects)));
+
+                    NodeObject::Ptr object;
+
+                    clock_type::time_point const start (clock_type::now ());
+                    Status const status (backend->fetch (hash.cbegin (), &object));
+                    clock_type::duration const d (clock_type::now () - start);
+
+                    latency.record (getNanoseconds (d));
+                    elapsed += d;
+
+                    if (status == ok)
+                        ++found;
+                }
+
+                expect (found == numReads, "Should find every object");
+
+                report (type, "read", numReads, elapsed, latency);
+            }
+
+            // New objects stored one at a time, mixed with reads
+            {
+                Random r (seedValue + 1);
+                LatencyHistogram latency;
+                clock_type::duration elapsed (clock_type::duration::zero ());
+                int64 const numStores (std::max (int64 (1),
+                    numReads / mixedReadsPerWrite));
+
+                for (int64 i = 0; i < numStores; ++i)
+                {
+                    NodeObject::Ptr const object (
+                        factory.createObject (numObjects + i));
+
+                    clock_type::time_point start (clock_type::now ());
+                    backend->store (object);
+                    clock_type::duration d (clock_type::now () - start);
+
+                    latency.record (getNanoseconds (d));
+                    elapsed += d;
+
+                    // Only the bulk written objects are sure to be stored
+                    for (int n = 0; n < mixedReadsPerWrite; ++n)
+                    {
+                        uint256 const hash (factory.getHash (
+                            pickIndex (r, numObjects)));
+
+                        NodeObject::Ptr copy;
+
+                        start = clock_type::now ();
+                        backend->fetch (hash.cbegin (), &copy);
+                        d = clock_type::now () - start;
+
+                        latency.record (getNanoseconds (d));
+                        elapsed += d;
+                    }
+                }
+
+                report (type, "mixed", numStores * (1 + mixedReadsPerWrite),
+                    elapsed, latency);
+            }
+        }
+
+        // The backend is closed so everything written is on disk
+        {
+            Json::Value result (Json::objectValue);
+            result ["backend"] = type.toStdString ();
+            result ["workload"] = "size";
+            result ["bytes"] = double (getDiskSize (path));
+            emit (result);
+        }
+
+        {
+            ThreadScheduler scheduler;
+
+            // Re-open the backend so nothing is cached by it
+            std::unique_ptr <Backend> backend (manager.make_Backend (
+                params, scheduler, j));
+
+            int64 const numWalked (std::min (numLedgers,
+                (numReads + ledgerSize - 1) / ledgerSize));
+
+            // Walk ledgers newest first, fetching each with one call
+            {
+                LatencyHistogram latency;
+                clock_type::duration elapsed (clock_type::duration::zero ());
+                int64 objects (0);
+                int64 found (0);
+
+                std::vector <uint256> hashes;
+                std::vector <void const*> keys;
+                Batch copy;
+
+                for (int64 n = 0; n < numWalked; ++n)
+                {
+                    factory.getLedgerHashes (hashes,
+                        numLedgers - 1 - n, numObjects);
+
+                    keys.clear ();
+                    for (auto const& hash : hashes)
+                        keys.push_back (hash.cbegin ());
+
+                    clock_type::time_point const start (clock_type::now ());
+                    backend->fetchBatch (keys, &copy);
+                    clock_type::duration const d (clock_type::now () - start);
+
+                    latency.record (getNanoseconds (d));
+                    elapsed += d;
+
+                    objects += keys.size ();
+                    found += std::count_if (copy.begin (), copy.end (),
+                        [](NodeObject::Ptr const& object)
+                            { return object != nullptr; });
+                }
+
+                expect (found == objects, "Should find every object");
+
+                report (type, "walk", objects, elapsed, latency);
+            }
+
+            // Build fetch packs for ledgers picked by the same power law,
+            // fetching each object in turn and appending it to the pack
+            {
+                Random r (seedValue + 2);
+                LatencyHistogram latency;
+                clock_type::duration elapsed (clock_type::duration::zero ());
+                int64 objects (0);
+
+                std::vector <uint256> hashes;
+                Blob pack;
+
+                for (int64 n = 0; n < numWalked; ++n)
+                {
+                    factory.getLedgerHashes (hashes,
+                        pickIndex (r, numLedgers), numObjects);
+
+                    pack.clear ();
+
+                    clock_type::time_point const start (clock_type::now ());
+                    for (auto const& hash : hashes)
+                    {
+                        NodeObject::Ptr object;
+
+                        if (backend->fetch (hash.cbegin (), &object) == ok &&
+                            object != nullptr)
+                        {
+                            pack.insert (pack.end (), hash.begin (), hash.end ());
+                            pack.insert (pack.end (), object->getData (),
+                                object->getData () + object->getSize ());
+                        }
+                    }
+                    clock_type::duration const d (clock_type::now () - start);
+
+                    latency.record (getNanoseconds (d));
+                    elapsed += d;
+
+                    objects += hashes.size ();
+                }
+
+                report (type, "fetchpack", objects, elapsed, latency);
+            }
+        }
+
+        path.deleteRecursively ();
+    }
+
+    //--------------------------------------------------------------------------
+
+    void runTest ()
+    {
+        Parameters const config (parseDelimitedKeyValueString (
+            strGetEnv ("RIPPLE_NODESTORE_BENCHMARK")));
+
+        m_output = config ["output"].isEmpty () ? File::nonexistent ()
+            : File (config ["output"]);
+
+        std::unique_ptr <Manager> manager (make_Manager ());
+
+        StringArray types;
+
+        if (config ["backends"].isEmpty ())
+        {
+            std::vector <String> const names (manager->getFactoryNames ());
+
+            // These keep nothing once closed, so the cold reads can't work
+            for (auto const& name : names)
+                if (name.compareIgnoreCase ("none") != 0 &&
+                    name.compareIgnoreCase ("memory") != 0)
+                    types.add (name);
+        }
+        else
+        {
+            types.addTokens (config ["backends"], ",", String::empty);
+            types.trim ();
+            types.removeEmptyStrings ();
+        }
+
+        for (int i = 0; i < types.size (); ++i)
+            benchmarkBackend (*manager, types [i], config);
+    }
+
+private:
+    File m_output;
+};
+
+static BenchmarkTests benchmarkTests;
+
+}
+}
@@ -0,0 +1,339 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+namespace ripple {
+namespace NodeStore {
+
+// Tests the compressed second cache tier and its codec
+//
+class CacheTests : public TestBase
+{
+public:
+    CacheTests () : TestBase ("NodeStoreCache")
+    {
+    }
+
+    // Creates an object shaped like an inner node, a few child
+    // hashes with the rest of the slots zero.
+    static NodeObject::Ptr createSparseObject (Random& r)
+    {
+        uint256 hash;
+        r.fillBitsRandomly (hash.begin (), hash.size ());
+
+        Blob data (16 * 32 + 4, 0);
+        for (int slot = 0; slot < 16; ++slot)
+            if (r.nextInt (4) == 0)
+                r.fillBitsRandomly (&data [4 + 32 * slot], 32);
+
+        return NodeObject::createObject (hotACCOUNT_NODE,
+            1 + r.nextInt (1024 * 1024), data, hash);
+    }
+
+    bool roundTrip (Blob const& data)
+    {
+        MemoryBlock compressed (LZ4::compressBound (data.size ()));
+        std::size_t const bytes (LZ4::compress (data.data (), data.size (),
+            compressed.getData ()));
+
+        if (bytes > LZ4::compressBound (data.size ()))
+            return false;
+
+        Blob copy (data.size () + 1);
+        std::size_t const size (LZ4::decompress (compressed.getData (),
+            bytes, copy.data (), copy.size ()));
+
+        copy.resize (size);
+        return copy == data;
+    }
+
+    void testCodec (int64 const seedValue)
+    {
+        beginTestCase ("codec");
+
+        Random r (seedValue);
+
+        expect (roundTrip (Blob ()), "Should handle empty input");
+        expect (roundTrip (Blob (1, 7)), "Should handle tiny input");
+        expect (roundTrip (Blob (100000, 0)), "Should handle long runs");
+
+        for (int i = 0; i < 100; ++i)
+        {
+            Blob data (1 + r.nextInt (maxPayloadBytes));
+            r.fillBitsRandomly (data.data (), data.size ());
+            expect (roundTrip (data), "Should handle random input");
+        }
+
+        {
+            // Incompressible data with repeated and zeroed stretches
+            Blob data (maxPayloadBytes);
+            r.fillBitsRandomly (data.data (), data.size ());
+            std::fill (data.begin () + 100, data.begin () + 400, 0);
+            std::copy (data.begin (), data.begin () + 300,
+                data.begin () + 1000);
+
+            MemoryBlock compressed (LZ4::compressBound (data.size ()));
+            std::size_t const bytes (LZ4::compress (data.data (),
+                data.size (), compressed.getData ()));
+            expect (bytes < data.size () - 500, "Should compress");
+            expect (roundTrip (data), "Should handle mixed input");
+
+            // Truncated input must be rejected, not overrun
+            Blob copy (data.size ());
+            for (std::size_t n = 0; n < bytes; n += 7)
+                expect (LZ4::decompress (compressed.getData (), n,
+                    copy.data (), copy.size ()) != data.size (),
+                        "Should detect truncation");
+
+            // As must output which doesn't fit
+            expect (LZ4::decompress (compressed.getData (), bytes,
+                copy.data (), copy.size () - 1) == 0,
+                    "Should detect overflow");
+        }
+    }
+
+    void testCache (int64 const seedValue)
+    {
+        beginTestCase ("compressed cache");
+
+        Random r (seedValue);
+
+        Batch batch;
+        for (int i = 0; i < numObjectsToTest; ++i)
+            batch.push_back (createSparseObject (r));
+
+        {
+            CompressedCache cache (0);
+            expect (! cache.isEnabled (), "Should be disabled");
+            cache.insert (batch [0]);
+            expect (cache.fetch (batch [0]->getHash ()) == nullptr,
+                "Should not be found");
+        }
+
+        {
+            // Roomy enough for everything
+            CompressedCache cache (16 * 1024 * 1024);
+
+            for (auto const& object : batch)
+                cache.insert (object);
+            expect (cache.getCount () == batch.size (), "Should hold all");
+
+            // Inserting twice keeps one copy
+            cache.insert (batch [0]);
+            expect (cache.getCount () == batch.size (), "Should not duplicate");
+
+            Batch copy;
+            for (auto const& object : batch)
+                copy.push_back (cache.fetch (object->getHash ()));
+            expect (areBatchesEqual (batch, copy), "Should be equal");
+        }
+
+        {
+            // Much too small, so only the newest objects stay
+            CompressedCache cache (64 * 1024, 4);
+
+            for (auto const& object : batch)
+                cache.insert (object);
+
+            std::size_t const count (cache.getCount ());
+            expect (count > 0 && count < batch.size (), "Should evict");
+
+            // Inner nodes should at least halve in size
+            expect (count * 256 > 64 * 1024, "Should compress");
+
+            expect (cache.fetch (batch.front ()->getHash ()) == nullptr,
+                "Oldest should be evicted");
+
+            NodeObject::Ptr const object (
+                cache.fetch (batch.back ()->getHash ()));
+            expect (object != nullptr && batch.back ()->isCloneOf (object),
+                "Newest should be kept");
+
+            // One hit and one miss
+            expect (cache.getHitRate () > 33 && cache.getHitRate () < 34,
+                "Should count hits and misses");
+
+            // Everything not evicted must still be found
+            std::size_t found (0);
+            for (auto const& object : batch)
+            {
+                NodeObject::Ptr const copy (cache.fetch (object->getHash ()));
+                if (copy != nullptr && object->isCloneOf (copy))
+                    ++found;
+            }
+            expect (found == count, "Should find every object held");
+        }
+
+        {
+            // Random payloads don't shrink, but still round trip
+            Batch random;
+            createPredictableBatch (random, 0, numObjectsToTest, seedValue);
+
+            CompressedCache cache (16 * 1024 * 1024);
+            for (auto const& object : random)
+                cache.insert (object);
+
+            Batch copy;
+            for (auto const& object : random)
+                copy.push_back (cache.fetch (object->getHash ()));
+            expect (areBatchesEqual (random, copy), "Should be equal");
+        }
+    }
+
+    void runTest ()
+    {
+        int64 const seedValue = 50;
+
+        testCodec (seedValue);
+
+        testCache (seedValue);
+    }
+};
+
+static CacheTests cacheTests;
+
+//------------------------------------------------------------------------------
+
+// Replays a skewed trace of fetches with and without the compressed tier
+//
+class CacheReplayTests : public TestBase
+{
+public:
+    enum
+    {
+        // Objects in the database, more than the compressed tier holds
+        numObjects = 400000,
+
+        // Fetches replayed
+        numFetches = 4000000,
+
+        // The decoded tier is emptied after this many fetches
+        fetchesPerSweep = 20000,
+
+        // Size of the compressed tier
+        compressedCacheMegabytes = 64
+    };
+
+    CacheReplayTests ()
+        : TestBase ("NodeStoreCacheReplay", UnitTest::runManual)
+    {
+    }
+
+    // Ledger walks revisit the top of the tree constantly and the leaves
+    // rarely. Cubing a uniform value concentrates the trace the same way,
+    // half the fetches land on the first eighth of the objects.
+    static std::vector <uint256> createTrace (Batch const& batch,
+        int64 const seedValue)
+    {
+        Random r (seedValue);
+        std::vector <uint256> trace;
+        trace.reserve (numFetches);
+        for (int i = 0; i < numFetches; ++i)
+        {
+            double const u (r.nextDouble ());
+            trace.push_back (batch [static_cast <std::size_t> (
+                u * u * u * batch.size ())]->getHash ());
+        }
+        return trace;
+    }
+
+    void replay (String type, Batch const& batch,
+        std::vector <uint256> const& trace, int compressedMegabytes)
+    {
+        std::unique_ptr <Manager> manager (make_Manager ());
+
+        DummyScheduler scheduler;
+
+        File const node_db (File::createTempFile ("node_db"));
+        StringPairArray params;
+        params.set ("type", type);
+        params.set ("path", node_db.getFullPathName ());
+        params.set ("compressed_cache_mb", String (compressedMegabytes));
+
+        Journal j ((journal ()));
+
+        {
+            std::unique_ptr <Database> db (manager->make_Database (
+                "test", scheduler, j, params));
+            storeBatch (*db, batch);
+        }
+
+        // Re-open so both tiers start cold
+        std::unique_ptr <Database> db (manager->make_Database (
+            "test", scheduler, j, params));
+
+        // The decoded tier ages by the clock, which is far too coarse for
+        // a replay. With no age limit a sweep empties it, so it holds only
+        // what was fetched since the last sweep.
+        db->tune (0, 0);
+
+        int64 const start (Time::getHighResolutionTicks ());
+
+        for (std::size_t i = 0; i < trace.size (); ++i)
+        {
+            if (db->fetch (trace [i]) == nullptr)
+                fail ("Should be found");
+
+            if ((i % fetchesPerSweep) == 0)
+                db->sweep ();
+        }
+
+        double const elapsed (Time::highResolutionTicksToSeconds (
+            Time::getHighResolutionTicks () - start));
+
+        String s;
+        s << "  " << type << (compressedMegabytes > 0 ? " two tiers:" : " one tier: ")
+          << "  " << String (elapsed, 2) << "s"
+          << "  hit rate " << String (db->getCacheHitRate (), 1) << "%"
+          << ", compressed " << String (db->getCompressedCacheHitRate (), 1) << "%";
+        logMessage (s);
+    }
+
+    void testReplay (String type, int64 const seedValue)
+    {
+        beginTestCase (String ("Replaying fetches from '") + type + "'");
+
+        Random r (seedValue);
+        Batch batch;
+        batch.reserve (numObjects);
+        for (int i = 0; i < numObjects; ++i)
+            batch.push_back (CacheTests::createSparseObject (r));
+
+        std::vector <uint256> const trace (createTrace (batch, seedValue));
+
+        replay (type, batch, trace, 0);
+
+        replay (type, batch, trace, compressedCacheMegabytes);
+
+        pass ();
+    }
+
+    void runTest ()
+    {
+        int64 const seedValue = 50;
+
+        testReplay ("leveldb", seedValue);
+
+        testReplay ("append", seedValue);
+    }
+};
+
+static CacheReplayTests cacheReplayTests;
+
+}
+}
@@ -91,6 +91,146 @@ public:
 
     //--------------------------------------------------------------------------
 
+    // Objects saved from one cache can warm another
+    void testWarm (String type, int64 seedValue)
+    {
+        std::unique_ptr <Manager> manager (make_Manager ());
+
+        DummyScheduler scheduler;
+
+        beginTestCase (String ("warm from '") + type + "'");
+
+        File const node_db (File::createTempFile ("node_db"));
+        StringPairArray params;
+        params.set ("type", type);
+        params.set ("path", node_db.getFullPathName ());
+
+        Batch batch;
+        createPredictableBatch (batch, 0, numObjectsToTest, seedValue);
+
+        Journal j ((journal ()));
+
+        Batch recent;
+
+        {
+            std::unique_ptr <Database> db (manager->make_Database (
+                "test", scheduler, j, params));
+            storeBatch (*db, batch);
+
+            recent = db->getRecentObjects (numObjectsToTest / 2);
+            expect (recent.size () == numObjectsToTest / 2, "Should fill the limit");
+        }
+
+        std::unique_ptr <Database> db (manager->make_Database (
+            "test", scheduler, j, params));
+
+        db->warm (recent);
+
+        // Warmed objects are the cached originals, not fresh reads
+        bool cached (true);
+        for (auto const& object : recent)
+            cached = cached && (db->fetch (object->getHash ()).get () == object.get ());
+        expect (cached, "Should be served from the cache");
+
+        Batch copy;
+        fetchCopyOfBatch (*db, &copy, batch);
+        expect (areBatchesEqual (batch, copy), "Should be equal");
+    }
+
+    //--------------------------------------------------------------------------
+
+    // Objects copied or fetched during a rotation survive it, nothing
+    // else does
+    void testRotation (String type, int64 seedValue)
+    {
+        std::unique_ptr <Manager> manager (make_Manager ());
+
+        DummyScheduler scheduler;
+
+        beginTestCase (String ("rotation of '") + type + "'");
+
+        File const node_db (File::createTempFile ("node_db"));
+        StringPairArray params;
+        params.set ("type", type);
+        params.set ("path", node_db.getFullPathName ());
+        params.set ("compressed_cache_mb", "0");
+
+        File const next_db (File::createTempFile ("next_db"));
+        StringPairArray nextParams;
+        nextParams.set ("type", type);
+        nextParams.set ("path", next_db.getFullPathName ());
+
+        // Split into objects to copy, to fetch, and to drop
+        Batch batch;
+        createPredictableBatch (batch, 0, numObjectsToTest, seedValue);
+        Batch const copied (batch.begin (), batch.begin () + numObjectsToTest / 4);
+        Batch const fetched (batch.begin () + numObjectsToTest / 4,
+            batch.begin () + numObjectsToTest / 2);
+
+        Batch later;
+        createPredictableBatch (later, numObjectsToTest, numObjectsToTest / 4, seedValue);
+
+        Journal j ((journal ()));
+
+        {
+            std::unique_ptr <Database> db (manager->make_Database (
+                "test", scheduler, j, params));
+            storeBatch (*db, batch);
+        }
+
+        {
+            // Re-open the database so the cache is cold
+            std::unique_ptr <Database> db (manager->make_Database (
+                "test", scheduler, j, params));
+
+            db->beginRotation (manager->make_Backend (nextParams, scheduler, j));
+            expect (db->getRotationStats ().rotating, "Should be rotating");
+
+            storeBatch (*db, later);
+
+            Batch copy;
+            fetchCopyOfBatch (*db, &copy, fetched);
+            expect (areBatchesEqual (fetched, copy), "Should be equal");
+
+            std::vector <uint256> hashes;
+            for (auto const& object : copied)
+                hashes.push_back (object->getHash ());
+            copy = db->copyForward (hashes);
+            expect (areBatchesEqual (copied, copy), "Should copy all");
+
+            Database::RotationStats const stats (db->getRotationStats ());
+            expect (stats.copied == copied.size (), "Should count copies");
+            expect (stats.carried == fetched.size (), "Should count fetches");
+
+            // Objects stored since the rotation began come back too
+            hashes.clear ();
+            for (auto const& object : later)
+                hashes.push_back (object->getHash ());
+            copy = db->copyForward (hashes);
+            expect (areBatchesEqual (later, copy), "Should return newer objects");
+
+            db->endRotation ();
+            expect (! db->getRotationStats ().rotating, "Should be done");
+        }
+
+        // Only the new backend is needed now
+        std::unique_ptr <Database> db (manager->make_Database (
+            "test", scheduler, j, nextParams));
+
+        Batch copy;
+        fetchCopyOfBatch (*db, &copy, copied);
+        expect (areBatchesEqual (copied, copy), "Should be equal");
+        fetchCopyOfBatch (*db, &copy, fetched);
+        expect (areBatchesEqual (fetched, copy), "Should be equal");
+        fetchCopyOfBatch (*db, &copy, later);
+        expect (areBatchesEqual (later, copy), "Should be equal");
+
+        expect (db->fetch (batch.back ()->getHash ()) == nullptr,
+            "Should not be carried forward");
+    }
+
+    //--------------------------------------------------------------------------
+
     void testNodeStore (String type,
                         bool const useEphemeralDatabase,
                         bool const testPersistence,
@@ -158,6 +298,17 @@ public:
                 std::unique_ptr <Database> db (manager->make_Database (
                     "test", scheduler, j, nodeParams));
 
+                {
+                    // Read it back with one batched fetch while the cache
+                    // is still cold
+                    std::vector <uint256> hashes;
+                    for (auto const& object : batch)
+                        hashes.push_back (object->getHash ());
+
+                    Batch copy (db->fetchBatch (hashes));
+                    expect (areBatchesEqual (batch, copy), "Should be equal");
+                }
+
                 // Read it back in
                 Batch copy;
                 fetchCopyOfBatch (*db, &copy, batch);
@@ -192,6 +343,8 @@ public:
     {
         testNodeStore ("leveldb", useEphemeralDatabase, true, seedValue);
 
+        testNodeStore ("append", useEphemeralDatabase, true, seedValue);
+
     #if RIPPLE_HYPERLEVELDB_AVAILABLE
         testNodeStore ("hyperleveldb", useEphemeralDatabase, true, seedValue);
     #endif
@@ -211,6 +364,8 @@ public:
     {
         testImport ("leveldb", "leveldb", seedValue);
 
+        testImport ("append", "append", seedValue);
+
     #if RIPPLE_ROCKSDB_AVAILABLE
         testImport ("rocksdb", "rocksdb", seedValue);
     #endif
@@ -237,6 +392,12 @@ public:
         runBackendTests (true, seedValue);
 
         runImportTests (seedValue);
+
+        testWarm ("leveldb", seedValue);
+
+        testRotation ("leveldb", seedValue);
+
+        testRotation ("append", seedValue);
     }
 };
 
@@ -0,0 +1,162 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+namespace ripple {
+namespace NodeStore {
+
+// Tests the ShardStore interface
+//
+class ShardStoreTests : public TestBase
+{
+public:
+    enum
+    {
+        ledgersPerShard = 4,
+
+        // Objects are spread over ledgers 1 through 6
+        numLedgers = 6
+    };
+
+    static uint32 getLedger (int index)
+    {
+        return 1 + (index % numLedgers);
+    }
+
+    void fetchAll (ShardStore& shards, Batch const& batch)
+    {
+        int found (0);
+
+        for (int i = 0; i < batch.size (); ++i)
+        {
+            NodeObject::Ptr const object (shards.fetch (
+                batch [i]->getHash (), getLedger (i)));
+
+            if (object != nullptr && object->isCloneOf (batch [i]))
+                ++found;
+        }
+
+        expect (found == batch.size (), "Should find every object");
+    }
+
+    void testShardStore (String type, int openShards, int64 const seedValue)
+    {
+        std::unique_ptr <Manager> manager (make_Manager ());
+
+        DummyScheduler scheduler;
+
+        beginTestCase (String ("ShardStore type=") + type +
+            ", open_shards=" + String (openShards));
+
+        File const path (File::createTempFile ("node_db"));
+        File const finalPath (File::createTempFile ("node_db_final"));
+
+        StringPairArray params;
+        params.set ("type", type);
+        params.set ("path", path.getFullPathName ());
+        params.set ("final_path", finalPath.getFullPathName ());
+        params.set ("ledgers_per_shard", String (int (ledgersPerShard)));
+        params.set ("open_shards", String (openShards));
+
+        Batch batch;
+        createPredictableBatch (batch, 0, numObjectsToTest, seedValue);
+
+        Journal j ((journal ()));
+
+        {
+            std::unique_ptr <ShardStore> shards (manager->make_ShardStore (
+                "test", scheduler, j, params));
+
+            expect (shards->getShardIndex (ledgersPerShard) == 0);
+            expect (shards->getShardIndex (ledgersPerShard + 1) == 1);
+
+            for (int i = 0; i < batch.size (); ++i)
+                shards->store (batch [i], getLedger (i));
+
+            for (uint32 seq = 1; seq <= numLedgers; ++seq)
+                shards->setStored (seq);
+
+            expect (shards->getCompleteLedgers () == "1-6", "Should have ledgers 1-6");
+            expect (shards->getFinalShards () == std::vector <uint32> (1, 0),
+                "Should finalize the first shard");
+            expect (finalPath.getChildFile ("0").getChildFile ("final").existsAsFile (),
+                "Should move the finalized shard");
+            expect (! path.getChildFile ("0").exists (), "Should not leave a copy");
+
+            fetchAll (*shards, batch);
+
+            // Each shard only has objects from its own ledgers
+            expect (shards->fetch (batch [0]->getHash (), ledgersPerShard + 1) == nullptr,
+                "Should not be in the other shard");
+
+            // A finalized shard is never written again
+            Batch extra;
+            createPredictableBatch (extra, numObjectsToTest, 1, seedValue);
+            shards->store (extra [0], 1);
+            expect (shards->fetch (extra [0]->getHash (), 1) == nullptr,
+                "Should not write a finalized shard");
+        }
+
+        {
+            // Re-open the store
+            std::unique_ptr <ShardStore> shards (manager->make_ShardStore (
+                "test", scheduler, j, params));
+
+            expect (shards->getCompleteLedgers () == "1-6", "Should have ledgers 1-6");
+            expect (! shards->hasLedger (numLedgers + 1));
+            expect (shards->prevMissing (numLedgers + 1) == 0);
+
+            fetchAll (*shards, batch);
+
+            // Complete the second shard
+            shards->setStored (numLedgers + 1);
+            shards->setStored (numLedgers + 2);
+
+            expect (shards->getFinalShards ().size () == 2,
+                "Should finalize the second shard");
+
+            fetchAll (*shards, batch);
+        }
+
+        path.deleteRecursively ();
+        finalPath.deleteRecursively ();
+    }
+
+    //--------------------------------------------------------------------------
+
+    void runTest ()
+    {
+        int const seedValue = 50;
+
+        testShardStore ("leveldb", 8, seedValue);
+
+        testShardStore ("append", 8, seedValue);
+
+        // Every fetch from the other shard closes and reopens one
+        testShardStore ("leveldb", 1, seedValue);
+    }
+
+    ShardStoreTests () : TestBase ("NodeStoreShard")
+    {
+    }
+};
+
+static ShardStoreTests shardStoreTests;
+
+}
+}
@@ -155,7 +155,8 @@ public:
         {
             NodeObject::Ptr const object (batch [i]);
 
-            Blob data (object->getData ());
+            Blob data (object->getData (),
+                object->getData () + object->getSize ());
 
             db.store (object->getType (),
                       object->getIndex (),
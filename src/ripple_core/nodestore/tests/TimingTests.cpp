@@ -25,7 +25,14 @@ class TimingTests : public TestBase
 public:
     enum
     {
-        numObjectsToTest     = 10000
+        // Large enough that the data set does not fit in memory
+        numObjectsToTest     = 10000000,
+
+        // Objects are generated and written this many at a time
+        objectsPerBatch      = 10000,
+
+        // Random fetches of present and of absent keys
+        numFetchesToTest     = 100000
     };
 
     TimingTests ()
@@ -56,6 +63,28 @@ public:
         int64 m_startTime;
     };
 
+    struct Counter : VisitCallback
+    {
+        int64 count;
+
+        Counter () : count (0)
+        {
+        }
+
+        void visitObject (NodeObject::Ptr const&)
+        {
+            ++count;
+        }
+    };
+
+    void report (String label, double seconds, int64 count)
+    {
+        String s;
+        s << "  " << label << String (seconds, 2) << " seconds, " <<
+            String (int64 (count / seconds)) << " per second";
+        logMessage (s);
+    }
+
     //--------------------------------------------------------------------------
 
     void testBackend (String type, int64 const seedValue)
@@ -73,12 +102,6 @@ public:
         params.set ("type", type);
         params.set ("path", path.getFullPathName ());
 
-        // Create batches
-        NodeStore::Batch batch1;
-        createPredictableBatch (batch1, 0, numObjectsToTest, seedValue);
-        NodeStore::Batch batch2;
-        createPredictableBatch (batch2, 0, numObjectsToTest, seedValue);
-
         Journal j ((journal ()));
 
         // Open the backend
@@ -86,29 +109,68 @@ public:
             params, scheduler, j));
 
         Stopwatch t;
+        double elapsed;
 
-        // Individual write batch test
-        t.start ();
-        storeBatch (*backend, batch1);
-        s = "";
-        s << "  Single write: " << String (t.getElapsed (), 2) << " seconds";
-        logMessage (s);
+        // Bulk write test, generating each batch outside the timing
+        elapsed = 0;
+        for (int i = 0; i < numObjectsToTest; i += objectsPerBatch)
+        {
+            Batch batch;
+            createPredictableBatch (batch, i, objectsPerBatch, seedValue);
 
-        // Bulk write batch test
-        t.start ();
-        backend->storeBatch (batch2);
-        s = "";
-        s << "  Batch write:  " << String (t.getElapsed (), 2) << " seconds";
-        logMessage (s);
+            t.start ();
+            backend->storeBatch (batch);
+            elapsed += t.getElapsed ();
+        }
+        report ("Batch write:   ", elapsed, numObjectsToTest);
 
-        // Read test
-        Batch copy;
-        t.start ();
-        fetchCopyOfBatch (*backend, &copy, batch1);
-        fetchCopyOfBatch (*backend, &copy, batch2);
-        s = "";
-        s << "  Batch read:   " << String (t.getElapsed (), 2) << " seconds";
-        logMessage (s);
+        // Random read test
+        Random r (seedValue);
+        PredictableObjectFactory factory (seedValue);
+        elapsed = 0;
+        for (int i = 0; i < numFetchesToTest; i += objectsPerBatch)
+        {
+            Batch batch;
+            batch.reserve (objectsPerBatch);
+            for (int n = 0; n < objectsPerBatch; ++n)
+                batch.push_back (factory.createObject (
+                    r.nextInt (numObjectsToTest)));
+
+            t.start ();
+            for (int n = 0; n < objectsPerBatch; ++n)
+            {
+                NodeObject::Ptr object;
+                expect (backend->fetch (batch [n]->getHash ().cbegin (),
+                    &object) == ok, "Should be ok");
+            }
+            elapsed += t.getElapsed ();
+        }
+        report ("Random read:   ", elapsed, numFetchesToTest);
+
+        // Missing key test
+        {
+            std::vector <uint256> keys (numFetchesToTest);
+            for (int i = 0; i < numFetchesToTest; ++i)
+                r.fillBitsRandomly (keys [i].begin (), keys [i].size ());
+
+            t.start ();
+            for (int i = 0; i < numFetchesToTest; ++i)
+            {
+                NodeObject::Ptr object;
+                expect (backend->fetch (keys [i].cbegin (),
+                    &object) == notFound, "Should not be found");
+            }
+            report ("Missing read:  ", t.getElapsed (), numFetchesToTest);
+        }
+
+        // Sequential visit test
+        {
+            Counter counter;
+            t.start ();
+            backend->visitAll (counter);
+            report ("Visit all:     ", t.getElapsed (), counter.count);
+            expect (counter.count == numObjectsToTest, "Should visit everything");
+        }
     }
 
     //--------------------------------------------------------------------------
@@ -119,6 +181,8 @@ public:
 
         testBackend ("leveldb", seedValue);
 
+        testBackend ("append", seedValue);
+
     #if RIPPLE_HYPERLEVELDB_AVAILABLE
         testBackend ("hyperleveldb", seedValue);
     #endif
@@ -28,6 +28,7 @@
 #include "beast/modules/beast_core/system/BeforeBoost.h"
 #include <boost/algorithm/string.hpp>
 #include <boost/foreach.hpp>
+#include <boost/thread/tss.hpp>
 
 #include "nodestore/NodeStore.cpp"
 
@@ -39,6 +40,7 @@ namespace ripple {
 #include "functional/LoadFeeTrackImp.cpp"
 #include "functional/LoadEvent.cpp"
 #include "functional/LoadMonitor.cpp"
+#include "functional/LatencyHistogram.cpp"
 }
 
 #include "functional/Job.cpp"
@@ -30,6 +30,8 @@
 
 #include "nodestore/NodeStore.h"
 
+#include <atomic>
+
 namespace ripple {
 // Order matters
 # include "functional/ConfigSections.h"
@@ -37,6 +39,7 @@ namespace ripple {
 #include "functional/LoadFeeTrack.h"
 #  include "functional/LoadEvent.h"
 #  include "functional/LoadMonitor.h"
+#include "functional/LatencyHistogram.h"
 }
 
 # include "functional/Job.h"
@@ -127,6 +127,16 @@ public:
     }
 
     std::string getName () const;
+
+    /** The name as a key which Json::Value stores without copying.
+        Fields live as long as the program, so their names can be
+        shared by every Json::Value which uses them.
+    */
+    Json::StaticString getJsonName () const
+    {
+        return Json::StaticString (fieldName.c_str ());
+    }
+
     bool hasName () const
     {
         return !fieldName.empty ();
@@ -904,6 +904,96 @@ STAmount operator- (const STAmount& v1, const STAmount& v2)
         return STAmount (v1.getFName (), v1.mCurrency, v1.mIssuer, -fv, ov1, true);
 }
 
+// Portable version of mulDiv, using only 64-bit operations.
+static uint64 mulDivPortable (uint64 multiplier, uint64 multiplicand, uint64 addend, uint64 divisor)
+{
+    // Multiply in 32-bit halves to get the 128-bit product in hi:lo
+    uint64 const a0 = multiplier & 0xffffffffull, a1 = multiplier >> 32;
+    uint64 const b0 = multiplicand & 0xffffffffull, b1 = multiplicand >> 32;
+
+    uint64 const p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+    uint64 const middle = (p00 >> 32) + (p01 & 0xffffffffull) + (p10 & 0xffffffffull);
+
+    uint64 lo = (middle << 32) | (p00 & 0xffffffffull);
+    uint64 hi = p11 + (p01 >> 32) + (p10 >> 32) + (middle >> 32);
+
+    lo += addend;
+
+    if (lo < addend)
+        ++hi;
+
+    // The quotient needs more than 64 bits
+    if (hi >= divisor)
+        return std::numeric_limits <uint64>::max ();
+
+    // Divide hi:lo by the divisor using two 32-bit digit steps, as in
+    // "divlu" from Hacker's Delight. First normalize so the divisor's
+    // high bit is set, which keeps each estimated digit within two of
+    // the true value.
+    uint64 const base = 0x100000000ull;
+
+    int shift = 0;
+
+    while ((divisor & 0x8000000000000000ull) == 0)
+    {
+        divisor <<= 1;
+        ++shift;
+    }
+
+    uint64 const un32 = (shift == 0) ? hi : ((hi << shift) | (lo >> (64 - shift)));
+    uint64 const un10 = lo << shift;
+
+    uint64 const vn1 = divisor >> 32, vn0 = divisor & 0xffffffffull;
+    uint64 const un1 = un10 >> 32, un0 = un10 & 0xffffffffull;
+
+    uint64 q1 = un32 / vn1;
+    uint64 rhat = un32 - q1 * vn1;
+
+    while ((q1 >= base) || ((q1 * vn0) > ((base * rhat) + un1)))
+    {
+        --q1;
+        rhat += vn1;
+
+        if (rhat >= base)
+            break;
+    }
+
+    uint64 const un21 = (un32 * base) + un1 - (q1 * divisor);
+
+    uint64 q0 = un21 / vn1;
+    rhat = un21 - q0 * vn1;
+
+    while ((q0 >= base) || ((q0 * vn0) > ((base * rhat) + un0)))
+    {
+        --q0;
+        rhat += vn1;
+
+        if (rhat >= base)
+            break;
+    }
+
+    return (q1 * base) + q0;
+}
+
+uint64 STAmount::mulDiv (uint64 multiplier, uint64 multiplicand, uint64 addend, uint64 divisor)
+{
+    assert (divisor != 0);
+    assert (addend < divisor);
+
+#ifdef __SIZEOF_INT128__
+    typedef unsigned __int128 uint128;
+
+    uint128 const quotient = (static_cast <uint128> (multiplier) * multiplicand + addend) / divisor;
+
+    if ((quotient >> 64) != 0)
+        return std::numeric_limits <uint64>::max ();
+
+    return static_cast <uint64> (quotient);
+#else
+    return mulDivPortable (multiplier, multiplicand, addend, divisor);
+#endif
+}
+
 STAmount STAmount::divide (const STAmount& num, const STAmount& den, const uint160& uCurrencyID, const uint160& uIssuerID)
 {
     if (den.isZero ())
@@ -931,19 +1021,8 @@ STAmount STAmount::divide (const STAmount& num, const STAmount& den, const uint1
         }
 
     // Compute (numerator * 10^17) / denominator
-    CBigNum v;
-
-    if ((BN_add_word64 (&v, numVal) != 1) ||
-            (BN_mul_word64 (&v, tenTo17) != 1) ||
-            (BN_div_word64 (&v, denVal) == ((uint64) - 1)))
-    {
-        throw std::runtime_error ("internal bn error");
-    }
-
     // 10^16 <= quotient <= 10^18
-    assert (BN_num_bytes (&v) <= 64);
-
-    return STAmount (uCurrencyID, uIssuerID, v.getuint64 () + 5,
+    return STAmount (uCurrencyID, uIssuerID, mulDiv (numVal, tenTo17, 0, denVal) + 5,
                      numOffset - denOffset - 17, num.mIsNegative != den.mIsNegative);
 }
 
@@ -988,20 +1067,8 @@ STAmount STAmount::multiply (const STAmount& v1, const STAmount& v2, const uint1
     }
 
     // Compute (numerator * denominator) / 10^14 with rounding
-    // 10^16 <= result <= 10^18
-    CBigNum v;
-
-    if ((BN_add_word64 (&v, value1) != 1) ||
-            (BN_mul_word64 (&v, value2) != 1) ||
-            (BN_div_word64 (&v, tenTo14) == ((uint64) - 1)))
-    {
-        throw std::runtime_error ("internal bn error");
-    }
-
     // 10^16 <= product <= 10^18
-    assert (BN_num_bytes (&v) <= 64);
-
-    return STAmount (uCurrencyID, uIssuerID, v.getuint64 () + 7, offset1 + offset2 + 14,
+    return STAmount (uCurrencyID, uIssuerID, mulDiv (value1, value2, 0, tenTo14) + 7, offset1 + offset2 + 14,
                      v1.mIsNegative != v2.mIsNegative);
 }
 
@@ -1937,6 +2004,107 @@ public:
 
     //--------------------------------------------------------------------------
 
+    // The BIGNUM calculation which STAmount::mulDiv replaced
+    static uint64 bigNumMulDiv (uint64 multiplier, uint64 multiplicand, uint64 addend, uint64 divisor)
+    {
+        CBigNum v;
+
+        if ((BN_add_word64 (&v, multiplier) != 1) ||
+                (BN_mul_word64 (&v, multiplicand) != 1) ||
+                (BN_add_word64 (&v, addend) != 1) ||
+                (BN_div_word64 (&v, divisor) == ((uint64) - 1)))
+        {
+            throw std::runtime_error ("internal bn error");
+        }
+
+        try
+        {
+            return v.getuint64 ();
+        }
+        catch (std::runtime_error const&)
+        {
+            // 32-bit platforms throw instead of saturating
+            return std::numeric_limits <uint64>::max ();
+        }
+    }
+
+    // Returns a random value in the range used for amount mantissas
+    static uint64 randomMantissa (Random& r)
+    {
+        return STAmount::cMinValue + (static_cast <uint64> (r.nextInt64 ()) %
+            (STAmount::cMaxValue - STAmount::cMinValue + 1));
+    }
+
+    // Returns true if mulDiv and its portable version agree with BIGNUM
+    static bool mulDivMatches (uint64 multiplier, uint64 multiplicand, uint64 addend, uint64 divisor)
+    {
+        uint64 const expected (bigNumMulDiv (multiplier, multiplicand, addend, divisor));
+
+        if ((STAmount::mulDiv (multiplier, multiplicand, addend, divisor) != expected) ||
+            (mulDivPortable (multiplier, multiplicand, addend, divisor) != expected))
+        {
+            WriteLog (lsWARNING, STAmount) << "mulDiv (" << multiplier << ", " << multiplicand <<
+                ", " << addend << ", " << divisor << ") != " << expected;
+            return false;
+        }
+
+        return true;
+    }
+
+    // Compares mulDiv against BIGNUM on random operands, returning the
+    // number of mismatches.
+    static int mulDivMismatches (int iterations, int64 seed)
+    {
+        Random r (seed);
+        int mismatches (0);
+
+        for (int i = 0; i < iterations; ++i)
+        {
+            uint64 const value1 (randomMantissa (r));
+            uint64 const value2 (randomMantissa (r));
+
+            // As used by divide and divRound
+            if (! mulDivMatches (value1, tenTo17, 0, value2))
+                ++mismatches;
+            if (! mulDivMatches (value1, tenTo17, value2 - 1, value2))
+                ++mismatches;
+
+            // As used by multiply and mulRound
+            if (! mulDivMatches (value1, value2, 0, tenTo14))
+                ++mismatches;
+            if (! mulDivMatches (value1, value2, tenTo14m1, tenTo14))
+                ++mismatches;
+
+            // Arbitrary operands, including ones which overflow
+            uint64 const divisor (std::max <uint64> (1,
+                static_cast <uint64> (r.nextInt64 ()) >> r.nextInt (64)));
+            if (! mulDivMatches (static_cast <uint64> (r.nextInt64 ()),
+                    static_cast <uint64> (r.nextInt64 ()) >> r.nextInt (64),
+                        static_cast <uint64> (r.nextInt64 ()) % divisor, divisor))
+                ++mismatches;
+        }
+
+        return mismatches;
+    }
+
+    void testMulDiv ()
+    {
+        beginTestCase ("mulDiv");
+
+        uint64 const max (std::numeric_limits <uint64>::max ());
+        expect (mulDivMatches (0, 0, 0, 1));
+        expect (mulDivMatches (max, max, max - 1, max));
+        expect (mulDivMatches (max, max, 0, 1));
+        expect (mulDivMatches (max, 1, 0, 1));
+        expect (mulDivMatches (max, 2, 1, 2));
+        expect (mulDivMatches (STAmount::cMaxValue, tenTo17, 0, STAmount::cMinValue));
+        expect (mulDivMatches (STAmount::cMaxValue, STAmount::cMaxValue, tenTo14m1, tenTo14));
+
+        expect (mulDivMismatches (1000000, 0x6d756c44) == 0, "mulDiv differs from BIGNUM");
+    }
+
+    //--------------------------------------------------------------------------
+
     void runTest ()
     {
         testSetValue ();
@@ -1945,7 +2113,107 @@ public:
         testArithmetic ();
         testUnderflow ();
         testRounding ();
+        testMulDiv ();
     }
 };
 
 static STAmountTests stAmountTests;
+
+//------------------------------------------------------------------------------
+
+/** Measures STAmount multiplication and division.
+    Compares the 128-bit mulDiv against the BIGNUM code it replaced, and
+    checks that both agree over a much larger random sample.
+*/
+class STAmountTimingTests : public UnitTest
+{
+public:
+    enum
+    {
+        numOperations = 10000000
+    };
+
+    STAmountTimingTests () : UnitTest ("STAmountTiming", "ripple", runManual)
+    {
+    }
+
+    template <class Function>
+    void measure (String const& name, Function f)
+    {
+        int64 const start (Time::getHighResolutionTicks ());
+
+        uint64 sum (0);
+        for (int i = 0; i < numOperations; ++i)
+            sum += f (i);
+
+        double const elapsed (Time::highResolutionTicksToSeconds (
+            Time::getHighResolutionTicks () - start));
+
+        // Print the sum so the work cannot be optimized away
+        logMessage (name + ": " + String (int64 (numOperations / elapsed)) +
+            " ops/s (" + String::toHexString (int64 (sum)) + ")");
+    }
+
+    void runTest ()
+    {
+        beginTestCase ("timing");
+
+        // Precompute operands so only the arithmetic is timed
+        Random r (0x74696d65);
+        std::vector <uint64> values (1024);
+        for (auto& value : values)
+            value = STAmountTests::randomMantissa (r);
+
+        std::vector <STAmount> amounts;
+        for (auto const value : values)
+            amounts.push_back (STAmount (CURRENCY_ONE, ACCOUNT_ONE, value, -15));
+
+        auto const operand ([&values] (int i, int skew)
+        {
+            return values [(i + skew) & 1023];
+        });
+
+        measure ("BIGNUM multiply", [&] (int i)
+        {
+            return STAmountTests::bigNumMulDiv (operand (i, 0), operand (i, 1), 0, tenTo14);
+        });
+
+        measure ("mulDiv multiply", [&] (int i)
+        {
+            return STAmount::mulDiv (operand (i, 0), operand (i, 1), 0, tenTo14);
+        });
+
+        measure ("BIGNUM divide", [&] (int i)
+        {
+            return STAmountTests::bigNumMulDiv (operand (i, 0), tenTo17, 0, operand (i, 1));
+        });
+
+        measure ("mulDiv divide", [&] (int i)
+        {
+            return STAmount::mulDiv (operand (i, 0), tenTo17, 0, operand (i, 1));
+        });
+
+        measure ("STAmount::multiply", [&] (int i)
+        {
+            return STAmount::multiply (amounts [i & 1023], amounts [(i + 1) & 1023],
+                CURRENCY_ONE, ACCOUNT_ONE).getMantissa ();
+        });
+
+        measure ("STAmount::divide", [&] (int i)
+        {
+            return STAmount::divide (amounts [i & 1023], amounts [(i + 1) & 1023],
+                CURRENCY_ONE, ACCOUNT_ONE).getMantissa ();
+        });
+
+        measure ("STAmount::getRate", [&] (int i)
+        {
+            return STAmount::getRate (amounts [i & 1023], amounts [(i + 1) & 1023]);
+        });
+
+        // A larger differential run than the automatic test
+        expect (STAmountTests::mulDivMismatches (numOperations, 0x64696666) == 0,
+            "mulDiv differs from BIGNUM");
+    }
+};
+
+static STAmountTimingTests stAmountTimingTests;
@@ -1059,7 +1059,7 @@ Json::Value STObject::getJson (int options) const
             if (!it.getFName ().hasName ())
                 ret[lexicalCast <std::string> (index)] = it.getJson (options);
             else
-                ret[it.getName ()] = it.getJson (options);
+                ret[it.getFName ().getJsonName ()] = it.getJson (options);
         }
     }
     return ret;
@@ -1168,7 +1168,7 @@ Json::Value STArray::getJson (int p) const
             if (!object.getFName ().hasName ())
                 inner[lexicalCast <std::string> (index)] = object.getJson (p);
             else
-                inner[object.getName ()] = object.getJson (p);
+                inner[object.getFName ().getJsonName ()] = object.getJson (p);
 
             v.append (inner);
             index++;
@@ -775,6 +775,17 @@ public:
     
     static void canonicalizeRound (bool isNative, uint64& value, int& offset, bool roundUp);
 
+    /** Returns (multiplier * multiplicand + addend) / divisor.
+
+        The intermediate value has 128 bits so this cannot overflow. The
+        result saturates at the largest uint64, which is what the BIGNUM
+        implementation this replaces produced on 64-bit platforms. The
+        results must stay identical since they affect ledger contents.
+
+        @param addend Must be less than divisor.
+    */
+    static uint64 mulDiv (uint64 multiplier, uint64 multiplicand, uint64 addend, uint64 divisor);
+
 private:
     template <class Iterator>
     static bool isZeroFilled (Iterator first, int iSize)
@@ -380,6 +380,28 @@ uint256 Serializer::getPrefixHash (uint32 prefix, const unsigned char* data, int
     return j[0];
 }
 
+uint256 Serializer::getPrefixHash (uint32 prefix, Blob const& data, uint256 const& suffix)
+{
+    char be_prefix[4];
+    be_prefix[0] = static_cast<unsigned char> (prefix >> 24);
+    be_prefix[1] = static_cast<unsigned char> ((prefix >> 16) & 0xff);
+    be_prefix[2] = static_cast<unsigned char> ((prefix >> 8) & 0xff);
+    be_prefix[3] = static_cast<unsigned char> (prefix & 0xff);
+
+    uint256 j[2];
+    SHA512_CTX ctx;
+    SHA512_Init (&ctx);
+    SHA512_Update (&ctx, &be_prefix[0], 4);
+
+    if (!data.empty ())
+        SHA512_Update (&ctx, & (data.front ()), data.size ());
+
+    SHA512_Update (&ctx, suffix.begin (), suffix.size ());
+    SHA512_Final (reinterpret_cast<unsigned char*> (&j[0]), &ctx);
+
+    return j[0];
+}
+
 bool Serializer::checkSignature (int pubkeyOffset, int signatureOffset) const
 {
     Blob pubkey, signature;
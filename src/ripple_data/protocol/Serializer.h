@@ -117,6 +117,9 @@ public:
         return getPrefixHash (prefix, reinterpret_cast<const unsigned char*> (strData.data ()), strData.size ());
     }
 
+    // Hashes prefix, data and suffix without copying them into a buffer
+    static uint256 getPrefixHash (uint32 prefix, Blob const& data, uint256 const& suffix);
+
     // totality functions
     Blob const& peekData () const
     {
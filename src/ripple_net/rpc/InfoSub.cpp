@@ -61,7 +61,13 @@ Resource::Consumer& InfoSub::getConsumer()
     return m_consumer;
 }
 
-void InfoSub::send (const Json::Value& jvObj, const std::string& sObj, bool broadcast)
+InfoSub::Message InfoSub::makeMessage (Json::Value const& jvObj)
+{
+    return boost::make_shared <std::string> (
+        Json::FastWriter ().write (jvObj));
+}
+
+void InfoSub::send (const Json::Value& jvObj, Message const&, bool broadcast)
 {
     send (jvObj, broadcast);
 }
@@ -96,3 +102,185 @@ const boost::shared_ptr<PathRequest>& InfoSub::getPathRequest ()
 {
     return mPathRequest;
 }
+
+//------------------------------------------------------------------------------
+
+/** Measures publishing one event to many subscribers. */
+class InfoSubFanoutTests : public UnitTest
+{
+public:
+    enum
+    {
+        numSubscribers = 10000
+        ,numEvents = 20
+    };
+
+    struct TestSource : InfoSub::Source
+    {
+        explicit TestSource (Stoppable& parent)
+            : InfoSub::Source ("TestSource", parent)
+        {
+        }
+
+        void subAccount (InfoSub::ref, const boost::unordered_set<RippleAddress>&, uint32, bool) { }
+        void unsubAccount (uint64, const boost::unordered_set<RippleAddress>&, bool) { }
+        bool subLedger (InfoSub::ref, Json::Value&) { return true; }
+        bool unsubLedger (uint64) { return true; }
+        bool subServer (InfoSub::ref, Json::Value&) { return true; }
+        bool unsubServer (uint64) { return true; }
+        bool subBook (InfoSub::ref, RippleCurrency const&, RippleCurrency const&,
+            RippleIssuer const&, RippleIssuer const&) { return true; }
+        bool unsubBook (uint64, RippleCurrency const&, RippleCurrency const&,
+            RippleIssuer const&, RippleIssuer const&) { return true; }
+        bool subTransactions (InfoSub::ref) { return true; }
+        bool unsubTransactions (uint64) { return true; }
+        bool subRTTransactions (InfoSub::ref) { return true; }
+        bool unsubRTTransactions (uint64) { return true; }
+        InfoSub::pointer findRpcSub (const std::string&) { return InfoSub::pointer (); }
+        InfoSub::pointer addRpcSub (const std::string&, InfoSub::ref) { return InfoSub::pointer (); }
+    };
+
+    // Queues text the way a websocket connection does, without a socket
+    struct TestSubscriber : InfoSub
+    {
+        explicit TestSubscriber (Source& source)
+            : InfoSub (source, Consumer ())
+        {
+        }
+
+        void send (const Json::Value& jvObj, bool)
+        {
+            m_rendered.push_back (Json::FastWriter ().write (jvObj));
+        }
+
+        void send (const Json::Value&, Message const& message, bool)
+        {
+            m_shared.push_back (message);
+        }
+
+        std::size_t bytes () const
+        {
+            std::size_t total (0);
+            for (auto const& text : m_rendered)
+                total += text.size ();
+            for (auto const& message : m_shared)
+                total += message->size ();
+            return total;
+        }
+
+        void clear ()
+        {
+            m_rendered.clear ();
+            m_shared.clear ();
+        }
+
+        std::vector <std::string> m_rendered;
+        std::vector <Message> m_shared;
+    };
+
+    // Shaped like a validated transaction from pubValidatedTransaction
+    static Json::Value makeEvent (int n)
+    {
+        Json::Value jvObj (Json::objectValue);
+        jvObj["type"] = "transaction";
+        jvObj["engine_result"] = "tesSUCCESS";
+        jvObj["engine_result_code"] = 0;
+        jvObj["ledger_index"] = 3000000 + n;
+        jvObj["status"] = "closed";
+        jvObj["validated"] = true;
+
+        Json::Value& tx (jvObj["transaction"] = Json::Value (Json::objectValue));
+        tx["Account"] = "rHb9CJAWyB4rj91VRWn96DkukG4bwdtyTh";
+        tx["Destination"] = "r4nmQNH4Fhjfh6cHDbvVSsBv7KySbj4cBf";
+        tx["Amount"] = "1000000";
+        tx["Fee"] = "10";
+        tx["Sequence"] = n;
+        tx["TransactionType"] = "Payment";
+        tx["SigningPubKey"] = std::string (66, 'A');
+        tx["TxnSignature"] = std::string (140, 'B');
+        tx["hash"] = std::string (64, 'C');
+
+        Json::Value& nodes ((jvObj["meta"]["AffectedNodes"] =
+            Json::Value (Json::arrayValue)));
+        for (int i = 0; i < 4; ++i)
+        {
+            Json::Value& node (nodes.append (Json::Value (Json::objectValue))
+                ["ModifiedNode"]);
+            node["LedgerEntryType"] = "AccountRoot";
+            node["LedgerIndex"] = std::string (64, 'D');
+            node["FinalFields"]["Balance"] = "99999990";
+            node["FinalFields"]["Sequence"] = n + i;
+            node["PreviousFields"]["Balance"] = "100000000";
+        }
+        jvObj["meta"]["TransactionResult"] = "tesSUCCESS";
+        return jvObj;
+    }
+
+    InfoSubFanoutTests () : UnitTest ("InfoSubFanout", "ripple", runManual)
+    {
+    }
+
+    void runTest ()
+    {
+        beginTestCase ("fanout");
+
+        RootStoppable stoppable ("InfoSubFanoutTests");
+        TestSource source (stoppable);
+
+        std::vector <boost::shared_ptr <TestSubscriber> > subscribers;
+        subscribers.reserve (numSubscribers);
+        for (int i = 0; i < numSubscribers; ++i)
+            subscribers.push_back (boost::make_shared <TestSubscriber> (
+                boost::ref (source)));
+
+        std::vector <Json::Value> events;
+        for (int i = 0; i < numEvents; ++i)
+            events.push_back (makeEvent (i));
+
+        std::size_t renderedBytes (0);
+        std::size_t sharedBytes (0);
+        double renderedSeconds (0);
+        double sharedSeconds (0);
+
+        for (auto const& jvObj : events)
+        {
+            {
+                int64 const start (Time::getHighResolutionTicks ());
+                for (auto const& subscriber : subscribers)
+                    subscriber->send (jvObj, true);
+                renderedSeconds += Time::highResolutionTicksToSeconds (
+                    Time::getHighResolutionTicks () - start);
+            }
+
+            {
+                int64 const start (Time::getHighResolutionTicks ());
+                InfoSub::Message const message (InfoSub::makeMessage (jvObj));
+                for (auto const& subscriber : subscribers)
+                    subscriber->send (jvObj, message, true);
+                sharedSeconds += Time::highResolutionTicksToSeconds (
+                    Time::getHighResolutionTicks () - start);
+                sharedBytes += message->size ();
+            }
+
+            for (auto const& subscriber : subscribers)
+            {
+                expect (*subscriber->m_shared.front () ==
+                    subscriber->m_rendered.front ());
+                renderedBytes += subscriber->bytes () -
+                    subscriber->m_shared.front ()->size ();
+                subscriber->clear ();
+            }
+        }
+
+        logMessage (String (int (numSubscribers)) + " subscribers, " +
+            String (int (numEvents)) + " events");
+        logMessage ("rendered per subscriber: " +
+            String (int64 (renderedSeconds * 1000)) + " ms, " +
+            String (int64 (renderedBytes / 1024)) + " KB rendered");
+        logMessage ("rendered once:           " +
+            String (int64 (sharedSeconds * 1000)) + " ms, " +
+            String (int64 (sharedBytes / 1024)) + " KB rendered");
+    }
+};
+
+static InfoSubFanoutTests infoSubFanoutTests;
@@ -42,6 +42,12 @@ public:
 
     typedef Resource::Consumer Consumer;
 
+    /** A published message rendered to text.
+        The message is immutable once made, so one copy is shared by
+        every subscriber it is sent to.
+    */
+    typedef boost::shared_ptr <std::string const> Message;
+
 public:
     /** Abstracts the source of subscription data.
     */
@@ -103,10 +109,16 @@ public:
 
     Consumer& getConsumer();
 
+    /** Render a message for publishing to many subscribers. */
+    static Message makeMessage (Json::Value const& jvObj);
+
     virtual void send (const Json::Value & jvObj, bool broadcast) = 0;
 
-    // VFALCO NOTE Why is this virtual?
-    virtual void send (const Json::Value & jvObj, const std::string & sObj, bool broadcast);
+    /** Send a message which has already been rendered.
+        Subscribers which deliver text should use the message instead of
+        rendering the Json again. The default sends the Json.
+    */
+    virtual void send (const Json::Value & jvObj, Message const& message, bool broadcast);
 
     uint64 getSeq ();
 
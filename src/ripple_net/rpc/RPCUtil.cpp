@@ -141,6 +141,41 @@ std::string HTTPReply (int nStatus, const std::string& strMsg)
                strMsg.c_str ());
 }
 
+std::string HTTPStreamReply (int nStatus, bool bChunked)
+{
+    WriteLog (lsTRACE, RPCLog) << "HTTP Stream Reply " << nStatus;
+
+    std::string access;
+
+    if (getConfig ().RPC_ALLOW_REMOTE) access = "Access-Control-Allow-Origin: *\r\n";
+    else access = "";
+
+    return strprintf (
+               "HTTP/1.1 %d %s\r\n"
+               "Date: %s\r\n"
+               "Connection: close\r\n"
+               "%s"
+               "%s"
+               "Content-Type: application/json; charset=UTF-8\r\n"
+               "Server: " SYSTEM_NAME "-json-rpc/%s\r\n"
+               "\r\n",
+               nStatus,
+               (nStatus == 200) ? "OK" : "",
+               rfc1123Time ().c_str (),
+               access.c_str (),
+               bChunked ? "Transfer-Encoding: chunked\r\n" : "",
+               BuildInfo::getFullVersionString ());
+}
+
+std::string HTTPChunk (char const* data, std::size_t size)
+{
+    // A chunk of no size marks the end of the body
+    std::string chunk (strprintf ("%x\r\n", static_cast <unsigned int> (size)));
+    chunk.append (data, size);
+    chunk += "\r\n";
+    return chunk;
+}
+
 int ReadHTTPStatus (std::basic_istream<char>& stream)
 {
     std::string str;
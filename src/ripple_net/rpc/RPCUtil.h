@@ -36,6 +36,13 @@ extern std::string createHTTPPost (const std::string& strHost, const std::string
 
 extern std::string HTTPReply (int nStatus, const std::string& strMsg);
 
+// The headers of a reply whose body is sent as it is produced. A chunked
+// body is framed with HTTPChunk, otherwise it ends when the connection closes.
+//
+extern std::string HTTPStreamReply (int nStatus, bool bChunked);
+
+extern std::string HTTPChunk (char const* data, std::size_t size);
+
 // VFALCO TODO Create a HTTPHeaders class with a nice interface instead of the std::map
 //
 extern bool HTTPAuthorized (std::map <std::string, std::string> const& mapHeaders);
@@ -1530,16 +1530,22 @@ private:
             if (m_clusterNode)
                 flags |= SF_TRUSTED | SF_SIGGOOD;
 
-            if (getApp().getJobQueue().getJobCount(jtTRANSACTION) > 100)
+            if ((getApp().getJobQueue().getJobCount(jtTRANSACTION) > 100) ||
+                (getApp().getSigVerifier().getPendingCount() > 1000))
                 m_journal.info << "Transaction queue is full";
             else if (getApp().getLedgerMaster().getValidatedLedgerAge() > 240)
                 m_journal.info << "No new transactions until synchronized";
-            else
+            else if (isSetBit (flags, SF_SIGGOOD))
                 getApp().getJobQueue ().addJob (jtTRANSACTION,
                     "recvTransaction->checkTransaction",
                     BIND_TYPE (
                         &PeerImp::checkTransaction, P_1, flags, stx,
                         boost::weak_ptr<Peer> (shared_from_this ())));
+            else
+                getApp().getSigVerifier ().verify (stx, std::bind (
+                    &PeerImp::onTransactionVerified, std::placeholders::_1,
+                        std::placeholders::_2, flags,
+                            boost::weak_ptr<Peer> (shared_from_this ())));
 
     #ifndef TRUST_NETWORK
         }
@@ -1745,7 +1751,7 @@ private:
                     {
                         protocol::TMIndexedObject& newObj = *reply.add_objects ();
                         newObj.set_hash (hash.begin (), hash.size ());
-                        newObj.set_data (&hObj->getData ().front (), hObj->getData ().size ());
+                        newObj.set_data (hObj->getData (), hObj->getSize ());
 
                         if (obj.has_nodeid ())
                             newObj.set_index (obj.nodeid ());
@@ -2603,6 +2609,21 @@ private:
         }
     }
 
+    // Called from the SigVerifier
+    static void onTransactionVerified (SerializedTransaction::pointer stx, bool good, int flags, boost::weak_ptr<Peer> peer)
+    {
+        if (! good)
+        {
+            Peer::charge (peer, Resource::feeInvalidSignature);
+            return;
+        }
+
+        getApp().getJobQueue ().addJob (jtTRANSACTION,
+            "recvTransaction->checkTransaction",
+            BIND_TYPE (
+                &PeerImp::checkTransaction, P_1, flags | SF_SIGGOOD, stx, peer));
+    }
+
     static void checkTransaction (Job&, int flags, SerializedTransaction::pointer stx, boost::weak_ptr<Peer> peer)
     {
     #ifndef TRUST_NETWORK